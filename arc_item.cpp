@@ -0,0 +1,44 @@
+#include "arc_item.h"
+#include "render_quality.h"
+#include "clipped_dash.h"
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QPainterPath>
+
+ArcItem::ArcItem(const QPointF &center, qreal radius, qreal startAngle, qreal spanAngle,
+                 QGraphicsItem *parent)
+    : QGraphicsPathItem(parent),
+    arcCenter(center),
+    arcRadius(radius),
+    arcStartAngle(startAngle),
+    arcSpanAngle(spanAngle)
+{
+    QRectF boundingRect(center.x() - radius, center.y() - radius, 2 * radius, 2 * radius);
+    QPainterPath path;
+    path.arcMoveTo(boundingRect, startAngle); // 从圆弧起点开始，避免与原点连线
+    path.arcTo(boundingRect, startAngle, spanAngle);
+    setPath(path);
+}
+
+void ArcItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    const QPen arcPen = RenderQuality::effectivePen(pen());
+    if (ClippedDash::applies(arcPen)) {
+        if (brush().style() != Qt::NoBrush) {
+            painter->setPen(Qt::NoPen);
+            painter->setBrush(brush());
+            painter->drawPath(path());
+        }
+        // 圆弧按当前缩放展平，只为可见部分生成虚线
+        ClippedDash::drawPath(painter, arcPen, path(), ClippedDash::visibleRect(painter, option->exposedRect));
+        return;
+    }
+    if (!RenderQuality::isInteractive()) {
+        QGraphicsPathItem::paint(painter, option, widget);
+        return;
+    }
+    // 交互期间用实线绘制
+    painter->setPen(arcPen);
+    painter->setBrush(brush());
+    painter->drawPath(path());
+}
@@ -0,0 +1,32 @@
+#ifndef ARC_ITEM_H
+#define ARC_ITEM_H
+
+#include <QGraphicsPathItem>
+#include <QPointF>
+
+// 圆弧图元：保留圆心、半径和角度，供解析命中测试使用
+class ArcItem : public QGraphicsPathItem
+{
+public:
+    enum { Type = UserType + 3 }; // 自定义类型，便于 qgraphicsitem_cast 和按类型分派
+    int type() const override { return Type; }
+
+    // 角度单位为度，与 QLineF::angle() 一致（逆时针为正）
+    ArcItem(const QPointF &center, qreal radius, qreal startAngle, qreal spanAngle,
+            QGraphicsItem *parent = nullptr);
+
+    QPointF center() const { return arcCenter; }
+    qreal radius() const { return arcRadius; }
+    qreal startAngle() const { return arcStartAngle; }
+    qreal spanAngle() const { return arcSpanAngle; }
+
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget = nullptr) override;
+
+private:
+    QPointF arcCenter;
+    qreal arcRadius;
+    qreal arcStartAngle;
+    qreal arcSpanAngle;
+};
+
+#endif // ARC_ITEM_H
@@ -1,4 +1,6 @@
 #include "background_image_selector_dialog.h"
+#include "logging_categories.h"
+#include "image_store.h"
 #include <QFileDialog>
 #include <QImage>
 #include <QPixmap>
@@ -60,19 +62,18 @@ void BackgroundImageSelectorDialog::loadImageList()
 
     // 将保存的图片路径添加到列表中
     for (const QString &filePath : imagePaths) {
-        QPixmap pixmap(filePath);
-        if (!pixmap.isNull()) {
-            // 缩放图片以适应缩略图大小
-            QPixmap scaledPixmap = pixmap.scaled(100, 100, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-            QListWidgetItem *item = new QListWidgetItem(QIcon(scaledPixmap), filePath.split('/').last());
+        // 缩略图来自共享图片库，同一内容的图片只解码一次
+        const QPixmap thumbnail = ImageStore::instance()->thumbnail(filePath, QSize(100, 100));
+        if (!thumbnail.isNull()) {
+            QListWidgetItem *item = new QListWidgetItem(QIcon(thumbnail), filePath.split('/').last());
             item->setData(Qt::UserRole, filePath); // 存储完整路径
             imageListWidget->addItem(item);
         } else {
-            qDebug() << "无法加载图片（可能文件已删除或移动）:" << filePath;
+            qCDebug(lcView) << "无法加载图片（可能文件已删除或移动）:" << filePath;
             // 可以选择从列表中移除无效路径，但这里暂时保留以便用户了解
         }
     }
-    qDebug() << "加载图片列表，数量:" << imagePaths.size();
+    qCDebug(lcView) << "加载图片列表，数量:" << imagePaths.size();
 }
 
 void BackgroundImageSelectorDialog::saveImageList()
@@ -80,7 +81,7 @@ void BackgroundImageSelectorDialog::saveImageList()
     // 使用 QSettings 保存图片路径列表
     QSettings settings("MyApp", "BackgroundImages");
     settings.setValue("imagePaths", imagePaths);
-    qDebug() << "保存图片列表，数量:" << imagePaths.size();
+    qCDebug(lcView) << "保存图片列表，数量:" << imagePaths.size();
 }
 
 
@@ -94,16 +95,14 @@ void BackgroundImageSelectorDialog::onUploadButtonClicked()
                                                     QString(),
                                                     QStringLiteral("图片文件 (*.png *.jpg *.jpeg *.bmp)"));
     if (!filePath.isEmpty()) {
-        // 加载图片并显示缩略图
-        QPixmap pixmap(filePath);
-        if (!pixmap.isNull()) {
-            // 缩放图片以适应缩略图大小
-            QPixmap scaledPixmap = pixmap.scaled(100, 100, Qt::KeepAspectRatio, Qt::SmoothTransformation);
-            QListWidgetItem *item = new QListWidgetItem(QIcon(scaledPixmap), filePath.split('/').last());
+        // 加载图片并显示缩略图（来自共享图片库）
+        const QPixmap thumbnail = ImageStore::instance()->thumbnail(filePath, QSize(100, 100));
+        if (!thumbnail.isNull()) {
+            QListWidgetItem *item = new QListWidgetItem(QIcon(thumbnail), filePath.split('/').last());
             item->setData(Qt::UserRole, filePath); // 存储完整路径
             imageListWidget->addItem(item);
         } else {
-            qDebug() << "无法加载图片:" << filePath;
+            qCDebug(lcView) << "无法加载图片:" << filePath;
         }
     }
 }
@@ -0,0 +1,234 @@
+#include "baked_layer_item.h"
+#include "logging_categories.h"
+#include "render_quality.h"
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QtMath>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// 按场景坐标录制图元及其子项，子项按 Z 值排序，ItemStacksBehindParent 的子项先画
+void recordItem(QPainter *painter, QGraphicsItem *item)
+{
+    if (!item->isVisible()) {
+        return;
+    }
+    QList<QGraphicsItem*> children = item->childItems();
+    std::stable_sort(children.begin(), children.end(), [](QGraphicsItem *a, QGraphicsItem *b) {
+        return a->zValue() < b->zValue();
+    });
+    auto behindParent = [](QGraphicsItem *child) {
+        return (child->flags() & QGraphicsItem::ItemStacksBehindParent) || child->zValue() < 0;
+    };
+    for (QGraphicsItem *child : std::as_const(children)) {
+        if (behindParent(child)) {
+            recordItem(painter, child);
+        }
+    }
+    if (!(item->flags() & QGraphicsItem::ItemHasNoContents)) {
+        QStyleOptionGraphicsItem option;
+        option.exposedRect = item->boundingRect();
+        option.rect = option.exposedRect.toAlignedRect();
+        painter->save();
+        painter->setTransform(item->sceneTransform());
+        painter->setOpacity(item->effectiveOpacity());
+        item->paint(painter, &option, nullptr);
+        painter->restore();
+    }
+    for (QGraphicsItem *child : std::as_const(children)) {
+        if (!behindParent(child)) {
+            recordItem(painter, child);
+        }
+    }
+}
+
+} // namespace
+
+BakedLayerItem::BakedLayerItem(const QList<QGraphicsItem*> &items, QGraphicsItem *parent)
+    : QGraphicsItem(parent), bakedItems(items)
+{
+    setFlag(ItemUsesExtendedStyleOption);
+    record();
+}
+
+BakedLayerItem::~BakedLayerItem()
+{
+    qDeleteAll(bakedItems);
+}
+
+QList<QGraphicsItem*> BakedLayerItem::unbake()
+{
+    prepareGeometryChange();
+    const QList<QGraphicsItem*> items = bakedItems;
+    bakedItems.clear();
+    picture = QPicture();
+    bounds = QRectF();
+    bucketPixmaps.clear();
+    tiles.clear();
+    qCDebug(lcItems) << "Unbaked layer," << items.size() << "items returned.";
+    return items;
+}
+
+void BakedLayerItem::record()
+{
+    const RenderQuality::FullQualityScope fullQuality; // 烘焙内容始终是完整质量
+    QPainter painter(&picture);
+    for (QGraphicsItem *item : std::as_const(bakedItems)) {
+        recordItem(&painter, item);
+        const QRectF itemBounds = item->sceneBoundingRect().united(item->mapRectToScene(item->childrenBoundingRect()));
+        bounds = bounds.isNull() ? itemBounds : bounds.united(itemBounds);
+    }
+    painter.end();
+    qCDebug(lcItems) << "Baked" << bakedItems.size() << "items, bounds:" << bounds;
+}
+
+QRectF BakedLayerItem::boundingRect() const
+{
+    return bounds;
+}
+
+QPainterPath BakedLayerItem::shape() const
+{
+    QPainterPath path;
+    path.addRect(bounds);
+    return path;
+}
+
+bool BakedLayerItem::contains(const QPointF &point) const
+{
+    // 本图元不移动也不变换，本地坐标即场景坐标
+    for (QGraphicsItem *item : bakedItems) {
+        if (item->sceneBoundingRect().contains(point) && item->contains(item->mapFromScene(point))) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool BakedLayerItem::collidesWithPath(const QPainterPath &path, Qt::ItemSelectionMode mode) const
+{
+    const QRectF pathBounds = path.boundingRect();
+    for (QGraphicsItem *item : bakedItems) {
+        if (item->sceneBoundingRect().intersects(pathBounds) && item->collidesWithPath(item->mapFromScene(path), mode)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void BakedLayerItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(widget);
+    if (bakedItems.isEmpty()) {
+        return;
+    }
+    if (painter->device()->devType() == QInternal::Picture) {
+        painter->drawPicture(0, 0, picture); // 被再次录制时（如瓦片缓存快照）保留矢量内容
+        return;
+    }
+    const qreal levelOfDetail = option->levelOfDetailFromTransform(painter->worldTransform());
+    if (levelOfDetail <= 0.0) {
+        return;
+    }
+    // 档位向上取整到 2 的幂，位图只会被缩小绘制，不会模糊
+    const int bucket = qCeil(std::log2(levelOfDetail));
+    const qreal dpr = painter->device()->devicePixelRatioF();
+    const qreal pixelScale = std::ldexp(1.0, bucket) * dpr;
+    if (qMax(bounds.width(), bounds.height()) * pixelScale > MaxPixmapSide) {
+        paintTiles(painter, option->exposedRect & bounds, bucket, dpr); // 放大后整张位图过大，只绘制可见的瓦片
+        return;
+    }
+    const QPixmap &pixmap = pixmapForBucket(bucket, dpr);
+    painter->drawPixmap(bounds, pixmap, QRectF(pixmap.rect()));
+}
+
+const QPixmap &BakedLayerItem::pixmapForBucket(int bucket, qreal dpr)
+{
+    auto it = bucketPixmaps.find(bucket);
+    if (it != bucketPixmaps.end() && qFuzzyCompare(it->devicePixelRatio(), dpr)) {
+        return *it;
+    }
+    const qreal pixelScale = std::ldexp(1.0, bucket) * dpr;
+    QPixmap pixmap(qMax(1, qCeil(bounds.width() * pixelScale)), qMax(1, qCeil(bounds.height() * pixelScale)));
+    pixmap.fill(Qt::transparent);
+    QPainter painter(&pixmap);
+    painter.setRenderHints(QPainter::Antialiasing | QPainter::SmoothPixmapTransform);
+    painter.scale(pixelScale, pixelScale);
+    painter.translate(-bounds.topLeft());
+    painter.drawPicture(0, 0, picture);
+    painter.end();
+    pixmap.setDevicePixelRatio(dpr);
+
+    // 超出档位数量时淘汰离当前档位最远的位图
+    bucketPixmaps.remove(bucket);
+    while (bucketPixmaps.size() >= MaxCachedBuckets) {
+        auto farthest = bucketPixmaps.begin();
+        for (auto candidate = bucketPixmaps.begin(); candidate != bucketPixmaps.end(); ++candidate) {
+            if (qAbs(candidate.key() - bucket) > qAbs(farthest.key() - bucket)) {
+                farthest = candidate;
+            }
+        }
+        bucketPixmaps.erase(farthest);
+    }
+    qCDebug(lcItems) << "Baked layer pixmap for bucket" << bucket << ":" << pixmap.size();
+    return *bucketPixmaps.insert(bucket, pixmap);
+}
+
+void BakedLayerItem::paintTiles(QPainter *painter, const QRectF &exposedRect, int bucket, qreal dpr)
+{
+    if (exposedRect.isEmpty()) {
+        return;
+    }
+    if (!qFuzzyCompare(tileDpr, dpr)) {
+        tiles.clear();
+        tileDpr = dpr;
+    }
+    // 瓦片网格以 bounds 左上角为原点，每块覆盖 TileSide / pixelScale 个场景单位
+    const qreal span = TileSide / (std::ldexp(1.0, bucket) * dpr);
+    const int firstX = qMax(0, qFloor((exposedRect.left() - bounds.left()) / span));
+    const int lastX = qFloor((exposedRect.right() - bounds.left()) / span);
+    const int firstY = qMax(0, qFloor((exposedRect.top() - bounds.top()) / span));
+    const int lastY = qFloor((exposedRect.bottom() - bounds.top()) / span);
+    for (int y = firstY; y <= lastY; ++y) {
+        for (int x = firstX; x <= lastX; ++x) {
+            const QRectF target(bounds.left() + x * span, bounds.top() + y * span, span, span);
+            painter->drawPixmap(target, tilePixmap(bucket, QPoint(x, y), dpr), QRectF(0, 0, TileSide, TileSide));
+        }
+    }
+}
+
+const QPixmap &BakedLayerItem::tilePixmap(int bucket, const QPoint &tile, qreal dpr)
+{
+    const QPair<int, QPoint> key(bucket, tile);
+    auto it = tiles.find(key);
+    if (it != tiles.end()) {
+        it->lastUsed = ++tileClock;
+        return it->pixmap;
+    }
+    // 回放整份录制，光栅化时落在瓦片外的内容被裁掉；每块瓦片只生成一次
+    const qreal pixelScale = std::ldexp(1.0, bucket) * dpr;
+    const qreal span = TileSide / pixelScale;
+    QPixmap pixmap(TileSide, TileSide);
+    pixmap.fill(Qt::transparent);
+    QPainter painter(&pixmap);
+    painter.setRenderHints(QPainter::Antialiasing | QPainter::SmoothPixmapTransform);
+    painter.scale(pixelScale, pixelScale);
+    painter.translate(-(bounds.left() + tile.x() * span), -(bounds.top() + tile.y() * span));
+    painter.drawPicture(0, 0, picture);
+    painter.end();
+    pixmap.setDevicePixelRatio(dpr);
+
+    while (tiles.size() >= MaxCachedTiles) {
+        auto oldest = tiles.begin();
+        for (auto candidate = tiles.begin(); candidate != tiles.end(); ++candidate) {
+            if (candidate->lastUsed < oldest->lastUsed) {
+                oldest = candidate;
+            }
+        }
+        tiles.erase(oldest);
+    }
+    return tiles.insert(key, TileEntry{pixmap, ++tileClock})->pixmap;
+}
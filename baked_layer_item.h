@@ -0,0 +1,65 @@
+#ifndef BAKED_LAYER_ITEM_H
+#define BAKED_LAYER_ITEM_H
+
+#include <QGraphicsItem>
+#include <QPicture>
+#include <QPixmap>
+#include <QMap>
+#include <QHash>
+#include <QPair>
+#include <QPoint>
+#include <QList>
+
+// 烘焙图层：把一批静态图元录制成一份 QPicture，并按缩放档位缓存位图，由这一个图元绘制。
+// 放大到整张位图过大时，只为可见区域按固定大小的瓦片生成位图。
+// 被烘焙的图元移出场景（不再参与索引和逐帧遍历），由本图元持有；unbake() 原样交还。
+class BakedLayerItem : public QGraphicsItem
+{
+public:
+    enum { Type = UserType + 5 }; // 自定义类型，便于 qgraphicsitem_cast 和按类型分派
+    int type() const override { return Type; }
+
+    // items 需已按绘制顺序排列（自底向上）且为顶层图元；调用方负责先把它们移出场景
+    explicit BakedLayerItem(const QList<QGraphicsItem*> &items, QGraphicsItem *parent = nullptr);
+    ~BakedLayerItem() override;
+
+    // 交还被烘焙的图元（场景坐标不变，尚未加入场景），之后本图元为空
+    QList<QGraphicsItem*> unbake();
+    int itemCount() const { return bakedItems.size(); }
+    // 被烘焙的图元（按绘制顺序，场景坐标），只读访问
+    const QList<QGraphicsItem*> &items() const { return bakedItems; }
+
+    QRectF boundingRect() const override;
+    QPainterPath shape() const override; // 只返回包围盒，精确测试走 contains/collidesWithPath
+    // 命中测试转发给被烘焙的图元，只有点中实际内容才算命中
+    bool contains(const QPointF &point) const override;
+    bool collidesWithPath(const QPainterPath &path, Qt::ItemSelectionMode mode = Qt::IntersectsItemShape) const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget = nullptr) override;
+
+    static constexpr int MaxPixmapSide = 4096; // 整张位图边长上限（像素），超过时改用瓦片
+    static constexpr int MaxCachedBuckets = 3; // 最多同时缓存的缩放档位数
+    static constexpr int TileSide = 512;       // 瓦片位图边长（像素）
+    static constexpr int MaxCachedTiles = 96;  // 最多同时缓存的瓦片数（需容纳一个高分屏视口）
+
+private:
+    void record();
+    const QPixmap &pixmapForBucket(int bucket, qreal dpr);
+    void paintTiles(QPainter *painter, const QRectF &exposedRect, int bucket, qreal dpr);
+    const QPixmap &tilePixmap(int bucket, const QPoint &tile, qreal dpr);
+
+    QList<QGraphicsItem*> bakedItems;
+    QPicture picture; // 场景坐标下录制的全部内容
+    QRectF bounds;
+    // 缩放档位（以 2 为底的指数）到位图的缓存，位图按该档位的 2 的幂缩放渲染
+    QMap<int, QPixmap> bucketPixmaps;
+    // 整张位图过大时的瓦片缓存：（档位，瓦片坐标）到位图，超出数量时淘汰最久未用的
+    struct TileEntry {
+        QPixmap pixmap;
+        quint64 lastUsed = 0;
+    };
+    QHash<QPair<int, QPoint>, TileEntry> tiles;
+    qreal tileDpr = 0.0;
+    quint64 tileClock = 0;
+};
+
+#endif // BAKED_LAYER_ITEM_H
@@ -0,0 +1,499 @@
+#include "bulk_primitive_item.h"
+#include "editable_line_item.h"
+#include "editable_polyline_item.h"
+#include "custom_rect_item.h"
+#include "hit_test_kernels.h"
+#include "logging_categories.h"
+#include "render_quality.h"
+#include "clipped_dash.h"
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
+#include <QGraphicsRectItem>
+#include <QPolygonF>
+#include <QDebug>
+#include <algorithm>
+
+namespace {
+
+constexpr int BatchSize = 4096; // 每个样式缓冲的图元数上限，满了就先绘制一批
+
+// 包含边界的相交测试（QRectF::intersects 会忽略水平/竖直线段的零面积包围盒）
+bool boxIntersects(const QRectF &a, const QRectF &b)
+{
+    return a.left() <= b.right() && a.right() >= b.left() && a.top() <= b.bottom() && a.bottom() >= b.top();
+}
+
+QRectF boxOf(const QPointF *points, int count)
+{
+    qreal left = points[0].x();
+    qreal top = points[0].y();
+    qreal right = left;
+    qreal bottom = top;
+    for (int i = 1; i < count; ++i) {
+        left = qMin(left, points[i].x());
+        top = qMin(top, points[i].y());
+        right = qMax(right, points[i].x());
+        bottom = qMax(bottom, points[i].y());
+    }
+    return QRectF(QPointF(left, top), QPointF(right, bottom));
+}
+
+QRectF unitedBox(const QRectF &a, const QRectF &b)
+{
+    return QRectF(QPointF(qMin(a.left(), b.left()), qMin(a.top(), b.top())),
+                  QPointF(qMax(a.right(), b.right()), qMax(a.bottom(), b.bottom())));
+}
+
+} // namespace
+
+BulkPrimitiveItem::BulkPrimitiveItem(QGraphicsItem *parent)
+    : QGraphicsItem(parent)
+{
+    // 需要准确的 exposedRect 才能只绘制可见图元
+    setFlags(ItemIsSelectable | ItemIsMovable | ItemUsesExtendedStyleOption);
+    pointOffsets.append(0);
+}
+
+bool BulkPrimitiveItem::paintsAbove(int a, int b) const
+{
+    const quint32 styleA = styleIds.at(a);
+    const quint32 styleB = styleIds.at(b);
+    return styleA != styleB ? styleA > styleB : a > b;
+}
+
+template<typename Fn>
+void BulkPrimitiveItem::forEachCandidate(const QRectF &rect, Fn fn) const
+{
+    if (!gridValid) {
+        grid.build(bounds);
+        gridValid = true;
+    }
+    QVector<int> candidates;
+    if (grid.query(rect, candidates)) {
+        for (int i : std::as_const(candidates)) {
+            if (fn(i)) {
+                return;
+            }
+        }
+        return;
+    }
+    // 查询范围覆盖大半网格时直接遍历
+    for (int i = 0; i < kinds.size(); ++i) {
+        if (fn(i)) {
+            return;
+        }
+    }
+}
+
+int BulkPrimitiveItem::addLine(const QLineF &line, const QPen &pen)
+{
+    const QPointF points[2] = { line.p1(), line.p2() };
+    return append(Kind::Line, points, 2, styleFor(pen, Qt::NoBrush));
+}
+
+int BulkPrimitiveItem::addPolyline(const QVector<QPointF> &points, const QPen &pen, bool closed)
+{
+    if (points.isEmpty()) {
+        return -1;
+    }
+    const Kind kind = (closed && points.size() >= 3) ? Kind::ClosedPolyline : Kind::Polyline;
+    return append(kind, points.constData(), points.size(), styleFor(pen, Qt::NoBrush));
+}
+
+int BulkPrimitiveItem::addRect(const QRectF &rect, const QPen &pen, const QBrush &brush)
+{
+    const QRectF normalized = rect.normalized();
+    const QPointF points[2] = { normalized.topLeft(), normalized.bottomRight() };
+    return append(Kind::Rect, points, 2, styleFor(pen, brush));
+}
+
+void BulkPrimitiveItem::reserve(int primitiveCount, int pointCount)
+{
+    kinds.reserve(primitiveCount);
+    styleIds.reserve(primitiveCount);
+    bounds.reserve(primitiveCount);
+    pointOffsets.reserve(primitiveCount + 1);
+    pointPool.reserve(pointCount);
+}
+
+bool BulkPrimitiveItem::canPack(const QGraphicsItem *item)
+{
+    switch (item->type()) {
+    case EditableLineItem::Type:
+    case EditablePolylineItem::Type:
+        return true;
+    case QGraphicsRectItem::Type: {
+        const CustomRectItem *customRect = dynamic_cast<const CustomRectItem*>(item);
+        if (customRect && customRect->hasFillImage()) {
+            return false; // 图片填充不打包
+        }
+        // 旋转后的填充矩形无法用轴对齐矩形表示
+        const QGraphicsRectItem *rectItem = static_cast<const QGraphicsRectItem*>(item);
+        return item->sceneTransform().type() <= QTransform::TxScale || rectItem->brush().style() == Qt::NoBrush;
+    }
+    default:
+        return false;
+    }
+}
+
+bool BulkPrimitiveItem::pack(const QGraphicsItem *item)
+{
+    if (!canPack(item)) {
+        return false;
+    }
+    const QTransform sceneTransform = item->sceneTransform();
+    switch (item->type()) {
+    case EditableLineItem::Type: {
+        const EditableLineItem *lineItem = static_cast<const EditableLineItem*>(item);
+        addLine(sceneTransform.map(lineItem->line()), lineItem->pen());
+        break;
+    }
+    case EditablePolylineItem::Type: {
+        const EditablePolylineItem *polylineItem = static_cast<const EditablePolylineItem*>(item);
+        QVector<QPointF> points = polylineItem->getPoints();
+        for (QPointF &p : points) {
+            p = sceneTransform.map(p);
+        }
+        addPolyline(points, polylineItem->pen(), polylineItem->isClosed());
+        break;
+    }
+    case QGraphicsRectItem::Type: {
+        const QGraphicsRectItem *rectItem = static_cast<const QGraphicsRectItem*>(item);
+        if (sceneTransform.type() <= QTransform::TxScale) {
+            addRect(sceneTransform.mapRect(rectItem->rect()), rectItem->pen(), rectItem->brush());
+        } else {
+            // 旋转的无填充矩形按闭合折线保存
+            const QRectF rect = rectItem->rect();
+            const QVector<QPointF> corners = { sceneTransform.map(rect.topLeft()), sceneTransform.map(rect.topRight()),
+                                               sceneTransform.map(rect.bottomRight()), sceneTransform.map(rect.bottomLeft()) };
+            addPolyline(corners, rectItem->pen(), true);
+        }
+        break;
+    }
+    default:
+        return false;
+    }
+    return true;
+}
+
+QVector<QPointF> BulkPrimitiveItem::primitivePoints(int index) const
+{
+    const int first = pointOffsets.at(index);
+    return pointPool.mid(first, pointOffsets.at(index + 1) - first);
+}
+
+QGraphicsItem *BulkPrimitiveItem::takePrimitive(int index)
+{
+    if (index < 0 || index >= kinds.size()) {
+        return nullptr;
+    }
+    const QTransform sceneTransform = this->sceneTransform();
+    const Style style = styles.at(styleIds.at(index));
+    const int first = pointOffsets.at(index);
+    const int count = pointOffsets.at(index + 1) - first;
+    const QPointF *points = pointPool.constData() + first;
+
+    QGraphicsItem *item = nullptr;
+    switch (kinds.at(index)) {
+    case Kind::Line: {
+        EditableLineItem *lineItem = new EditableLineItem(sceneTransform.map(points[0]), sceneTransform.map(points[1]));
+        lineItem->setPen(style.pen);
+        item = lineItem;
+        break;
+    }
+    case Kind::Polyline:
+    case Kind::ClosedPolyline: {
+        QVector<QPointF> scenePoints;
+        scenePoints.reserve(count);
+        for (int i = 0; i < count; ++i) {
+            scenePoints.append(sceneTransform.map(points[i]));
+        }
+        EditablePolylineItem *polylineItem = new EditablePolylineItem(scenePoints);
+        polylineItem->setPen(style.pen);
+        polylineItem->setClosed(kinds.at(index) == Kind::ClosedPolyline);
+        item = polylineItem;
+        break;
+    }
+    case Kind::Rect: {
+        CustomRectItem *rectItem = new CustomRectItem(sceneTransform.mapRect(QRectF(points[0], points[1])));
+        rectItem->setPen(style.pen);
+        rectItem->setBrush(style.brush);
+        item = rectItem;
+        break;
+    }
+    }
+    item->setZValue(zValue());
+
+    // 从结构数组中移除；整体包围盒保持不变（只会偏大），不必通知场景
+    const QRectF dirty = bounds.at(index);
+    const qreal margin = styleMargin(styleIds.at(index));
+    kinds.remove(index);
+    styleIds.remove(index);
+    bounds.remove(index);
+    pointPool.remove(first, count);
+    pointOffsets.remove(index + 1);
+    for (int i = index + 1; i < pointOffsets.size(); ++i) {
+        pointOffsets[i] -= count;
+    }
+    gridValid = false;
+    update(dirty.adjusted(-margin, -margin, margin, margin));
+    qCDebug(lcItems) << "Took primitive" << index << "out of bulk item," << kinds.size() << "left.";
+    return item;
+}
+
+QVector<int> BulkPrimitiveItem::paintOrder() const
+{
+    // 与 paint 一致：按样式分组，组内保持添加顺序
+    QVector<int> order(kinds.size());
+    for (int i = 0; i < order.size(); ++i) {
+        order[i] = i;
+    }
+    std::stable_sort(order.begin(), order.end(), [this](int a, int b) {
+        return styleIds.at(a) < styleIds.at(b);
+    });
+    return order;
+}
+
+int BulkPrimitiveItem::primitiveAt(const QPointF &localPos, qreal tolerance) const
+{
+    const qreal reach = tolerance + maxMargin;
+    int best = -1;
+    forEachCandidate(QRectF(localPos.x() - reach, localPos.y() - reach, 2 * reach, 2 * reach), [&](int i) {
+        if (best >= 0 && !paintsAbove(i, best)) {
+            return false;
+        }
+        const qreal margin = tolerance + styleMargin(styleIds.at(i));
+        const QRectF probe(localPos.x() - margin, localPos.y() - margin, 2 * margin, 2 * margin);
+        if (boxIntersects(bounds.at(i), probe) && primitiveHitsRect(i, probe)) {
+            best = i;
+        }
+        return false;
+    });
+    return best;
+}
+
+QRectF BulkPrimitiveItem::boundingRect() const
+{
+    if (kinds.isEmpty()) {
+        return QRectF();
+    }
+    return totalBounds.adjusted(-maxMargin, -maxMargin, maxMargin, maxMargin);
+}
+
+QPainterPath BulkPrimitiveItem::shape() const
+{
+    QPainterPath path;
+    path.addRect(boundingRect());
+    return path;
+}
+
+bool BulkPrimitiveItem::contains(const QPointF &point) const
+{
+    return primitiveAt(point, 0.0) >= 0;
+}
+
+bool BulkPrimitiveItem::collidesWithPath(const QPainterPath &path, Qt::ItemSelectionMode mode) const
+{
+    if (mode != Qt::IntersectsItemShape) {
+        return QGraphicsItem::collidesWithPath(path, mode);
+    }
+    // 用探测路径的包围盒逐个图元求交（视图未旋转时探测区域本身就是轴对齐矩形）
+    const QRectF probe = path.boundingRect();
+    if (!boxIntersects(boundingRect(), probe)) {
+        return false;
+    }
+    bool hit = false;
+    forEachCandidate(probe.adjusted(-maxMargin, -maxMargin, maxMargin, maxMargin), [&](int i) {
+        const qreal margin = styleMargin(styleIds.at(i));
+        const QRectF rect = probe.adjusted(-margin, -margin, margin, margin);
+        hit = boxIntersects(bounds.at(i), rect) && primitiveHitsRect(i, rect);
+        return hit;
+    });
+    return hit;
+}
+
+void BulkPrimitiveItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(widget);
+    if (kinds.isEmpty()) {
+        return;
+    }
+    // 可见图元按样式分组，组内保持添加顺序
+    const QRectF clip = option->exposedRect.adjusted(-maxMargin, -maxMargin, maxMargin, maxMargin);
+    QVector<QVector<int>> visible(styles.size());
+    if (clip.contains(totalBounds)) {
+        for (int i = 0; i < kinds.size(); ++i) {
+            visible[styleIds.at(i)].append(i);
+        }
+    } else {
+        forEachCandidate(clip, [&](int i) {
+            if (boxIntersects(bounds.at(i), clip)) {
+                visible[styleIds.at(i)].append(i);
+            }
+            return false;
+        });
+    }
+    for (int style = 0; style < visible.size(); ++style) {
+        if (!visible[style].isEmpty()) {
+            paintStyle(painter, option->exposedRect, style, visible[style]);
+        }
+    }
+}
+
+void BulkPrimitiveItem::paintStyle(QPainter *painter, const QRectF &exposedRect, int style, const QVector<int> &indices) const
+{
+    const QPen pen = RenderQuality::effectivePen(styles.at(style).pen); // 交互期间虚线改为实线
+    const QBrush &brush = styles.at(style).brush;
+    // 虚线逐个图元裁剪到可见范围后生成；填充先画，轮廓不再交给光栅引擎生成虚线
+    const bool dashed = ClippedDash::applies(pen);
+    const QRectF dashVisible = dashed ? ClippedDash::visibleRect(painter, exposedRect) : QRectF();
+    painter->setPen(dashed ? QPen(Qt::NoPen) : pen);
+    painter->setBrush(brush);
+
+    // 相邻的同类直线/矩形合并为一次调用，整体仍按添加顺序提交
+    QVector<QPointF> linePoints;
+    QVector<QRectF> rects;
+    auto flush = [&]() {
+        if (!rects.isEmpty()) {
+            if (!dashed || brush.style() != Qt::NoBrush) {
+                painter->drawRects(rects.constData(), rects.size());
+            }
+            if (dashed) {
+                for (const QRectF &rect : std::as_const(rects)) {
+                    const QPointF corners[4] = { rect.topLeft(), rect.topRight(), rect.bottomRight(), rect.bottomLeft() };
+                    ClippedDash::drawPolyline(painter, pen, corners, 4, true, dashVisible);
+                }
+            }
+            rects.clear();
+        }
+        if (!linePoints.isEmpty()) {
+            if (dashed) {
+                for (int i = 0; i + 1 < linePoints.size(); i += 2) {
+                    ClippedDash::drawPolyline(painter, pen, linePoints.constData() + i, 2, false, dashVisible);
+                }
+            } else {
+                painter->drawLines(linePoints.constData(), linePoints.size() / 2);
+            }
+            linePoints.clear();
+        }
+    };
+
+    for (int index : indices) {
+        const QPointF *points = pointPool.constData() + pointOffsets.at(index);
+        switch (kinds.at(index)) {
+        case Kind::Line:
+            if (!rects.isEmpty()) {
+                flush();
+            }
+            linePoints.append(points[0]);
+            linePoints.append(points[1]);
+            if (linePoints.size() / 2 >= BatchSize) {
+                flush();
+            }
+            break;
+        case Kind::Rect:
+            if (!linePoints.isEmpty()) {
+                flush();
+            }
+            rects.append(QRectF(points[0], points[1]));
+            if (rects.size() >= BatchSize) {
+                flush();
+            }
+            break;
+        case Kind::Polyline:
+        case Kind::ClosedPolyline: {
+            flush();
+            const int count = pointOffsets.at(index + 1) - pointOffsets.at(index);
+            const bool closed = kinds.at(index) == Kind::ClosedPolyline;
+            if (dashed) {
+                if (closed && brush.style() != Qt::NoBrush) {
+                    painter->drawPolygon(points, count);
+                }
+                ClippedDash::drawPolyline(painter, pen, points, count, closed, dashVisible);
+            } else if (closed) {
+                painter->drawPolygon(points, count);
+            } else {
+                painter->drawPolyline(points, count);
+            }
+            break;
+        }
+        }
+    }
+    flush();
+}
+
+quint32 BulkPrimitiveItem::styleFor(const QPen &pen, const QBrush &brush)
+{
+    if (lastStyle < quint32(styles.size()) && styles.at(lastStyle).pen == pen && styles.at(lastStyle).brush == brush) {
+        return lastStyle;
+    }
+    for (int i = 0; i < styles.size(); ++i) {
+        if (styles.at(i).pen == pen && styles.at(i).brush == brush) {
+            lastStyle = quint32(i);
+            return lastStyle;
+        }
+    }
+    styles.append(Style{pen, brush});
+    lastStyle = quint32(styles.size() - 1);
+    return lastStyle;
+}
+
+int BulkPrimitiveItem::append(Kind kind, const QPointF *points, int count, quint32 style)
+{
+    const QRectF box = boxOf(points, count);
+    const qreal margin = styleMargin(style);
+    const bool grows = kinds.isEmpty() || margin > maxMargin || box.left() < totalBounds.left() || box.right() > totalBounds.right()
+                       || box.top() < totalBounds.top() || box.bottom() > totalBounds.bottom();
+    if (grows) {
+        prepareGeometryChange(); // 包围盒变大时才需要通知场景
+        totalBounds = kinds.isEmpty() ? box : unitedBox(totalBounds, box);
+        maxMargin = qMax(maxMargin, margin);
+    }
+
+    kinds.append(kind);
+    styleIds.append(style);
+    bounds.append(box);
+    gridValid = false;
+    for (int i = 0; i < count; ++i) {
+        pointPool.append(points[i]);
+    }
+    pointOffsets.append(quint32(pointPool.size()));
+
+    if (!grows) {
+        update(box.adjusted(-margin, -margin, margin, margin));
+    }
+    return kinds.size() - 1;
+}
+
+bool BulkPrimitiveItem::primitiveHitsRect(int index, const QRectF &rect) const
+{
+    const QPointF *points = pointPool.constData() + pointOffsets.at(index);
+    const int count = pointOffsets.at(index + 1) - pointOffsets.at(index);
+    switch (kinds.at(index)) {
+    case Kind::Line:
+        return HitTest::segmentIntersectsRect(points[0], points[1], rect);
+    case Kind::Polyline:
+        return HitTest::polylineIntersectsRect(points, count, false, rect);
+    case Kind::ClosedPolyline:
+        return HitTest::polylineIntersectsRect(points, count, true, rect);
+    case Kind::Rect: {
+        const QRectF primitive(points[0], points[1]);
+        if (!boxIntersects(primitive, rect)) {
+            return false;
+        }
+        if (styles.at(styleIds.at(index)).brush.style() != Qt::NoBrush) {
+            return true;
+        }
+        // 无填充时只有边框可拾取：探测框完全落在矩形内部则未命中
+        return !(rect.left() > primitive.left() && rect.right() < primitive.right()
+                 && rect.top() > primitive.top() && rect.bottom() < primitive.bottom());
+    }
+    }
+    return false;
+}
+
+qreal BulkPrimitiveItem::styleMargin(quint32 style) const
+{
+    return qMax<qreal>(styles.at(style).pen.widthF(), 1.0) / 2.0;
+}
+
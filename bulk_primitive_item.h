@@ -0,0 +1,95 @@
+#ifndef BULK_PRIMITIVE_ITEM_H
+#define BULK_PRIMITIVE_ITEM_H
+
+#include <QGraphicsItem>
+#include <QVector>
+#include <QPointF>
+#include <QLineF>
+#include <QRectF>
+#include <QPen>
+#include <QBrush>
+#include <QPainterPath>
+#include "primitive_grid.h"
+
+// 批量图元：把大量只读的直线、折线和矩形打包进一个图元，按结构数组紧凑存储。
+// 按样式分组绘制（样式按首次出现的顺序叠放，组内保持添加顺序），相邻的同类直线/矩形合并为一次
+// drawLines/drawRects 调用。绘制、拾取和碰撞都通过包围盒网格只访问附近的图元；拾取按绘制顺序取最上层，
+// 需要编辑时再转换回独立的可编辑图元。
+class BulkPrimitiveItem : public QGraphicsItem
+{
+public:
+    enum { Type = UserType + 4 }; // 自定义类型，便于 qgraphicsitem_cast 和按类型分派
+    int type() const override { return Type; }
+
+    enum class Kind : quint8 {
+        Line,
+        Polyline,
+        ClosedPolyline,
+        Rect
+    };
+
+    explicit BulkPrimitiveItem(QGraphicsItem *parent = nullptr);
+
+    // 追加图元（本地坐标），返回图元序号
+    int addLine(const QLineF &line, const QPen &pen);
+    int addPolyline(const QVector<QPointF> &points, const QPen &pen, bool closed = false);
+    int addRect(const QRectF &rect, const QPen &pen, const QBrush &brush = Qt::NoBrush);
+    void reserve(int primitiveCount, int pointCount);
+
+    // 可以无损打包的图元：直线、折线和没有图片填充的矩形
+    static bool canPack(const QGraphicsItem *item);
+    // 按场景坐标追加图元的几何和样式（本图元应位于场景原点且未变换）
+    bool pack(const QGraphicsItem *item);
+    // 把图元转换为可编辑图元（场景坐标，尚未加入场景）并从本图元中移除
+    QGraphicsItem *takePrimitive(int index);
+
+    int primitiveCount() const { return kinds.size(); }
+    Kind kind(int index) const { return kinds.at(index); }
+    QRectF primitiveBounds(int index) const { return bounds.at(index); }
+    // 图元的顶点（本地坐标，存储方式见下方结构数组说明）和样式，供导出等只读遍历
+    QVector<QPointF> primitivePoints(int index) const;
+    QPen primitivePen(int index) const { return styles.at(styleIds.at(index)).pen; }
+    QBrush primitiveBrush(int index) const { return styles.at(styleIds.at(index)).brush; }
+    // 全部图元按绘制顺序（自下而上）排列的序号
+    QVector<int> paintOrder() const;
+    // 本地坐标下命中的最上层图元（按绘制顺序），没有时返回 -1
+    int primitiveAt(const QPointF &localPos, qreal tolerance) const;
+
+    QRectF boundingRect() const override;
+    QPainterPath shape() const override; // 只返回包围盒，精确测试走 contains/collidesWithPath
+    bool contains(const QPointF &point) const override;
+    bool collidesWithPath(const QPainterPath &path, Qt::ItemSelectionMode mode = Qt::IntersectsItemShape) const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget = nullptr) override;
+
+private:
+    struct Style {
+        QPen pen;
+        QBrush brush;
+    };
+
+    quint32 styleFor(const QPen &pen, const QBrush &brush);
+    int append(Kind kind, const QPointF *points, int count, quint32 style);
+    bool primitiveHitsRect(int index, const QRectF &rect) const;
+    qreal styleMargin(quint32 style) const;
+    bool paintsAbove(int a, int b) const; // 图元 a 是否画在图元 b 之上
+    // 对包围盒可能与 rect 相交的图元按序号升序调用 fn，fn 返回 true 时停止
+    template<typename Fn> void forEachCandidate(const QRectF &rect, Fn fn) const;
+    void paintStyle(QPainter *painter, const QRectF &exposedRect, int style, const QVector<int> &indices) const;
+
+    // 结构数组：第 i 个图元的类型、样式、包围盒和顶点区间 [pointOffsets[i], pointOffsets[i + 1])
+    // 直线存两个端点，矩形存左上和右下两个角点，折线存全部顶点
+    QVector<Kind> kinds;
+    QVector<quint32> styleIds;
+    QVector<QRectF> bounds; // 不含画笔宽度
+    QVector<quint32> pointOffsets;
+    QVector<QPointF> pointPool;
+
+    QVector<Style> styles; // 去重后的样式表
+    quint32 lastStyle = 0; // 连续添加同一样式时免去查表
+    QRectF totalBounds;
+    mutable PrimitiveGrid grid; // 按 bounds 建立，图元增删后在下次查询时重建
+    mutable bool gridValid = false;
+    qreal maxMargin = 0.0; // 所有样式中最大的半线宽
+};
+
+#endif // BULK_PRIMITIVE_ITEM_H
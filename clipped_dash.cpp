@@ -0,0 +1,374 @@
+#include "clipped_dash.h"
+#include <QLineF>
+#include <QVector>
+#include <QtMath>
+#include <cmath>
+
+namespace {
+
+constexpr qreal MinPeriodPx = 3.0;          // 虚线周期小于此像素数时已分辨不出，按实线绘制
+constexpr qreal FlattenTolerancePx = 0.25;  // 曲线展平误差（像素）
+constexpr int MaxFlattenDepth = 24;
+
+qreal levelOfDetailOf(const QPainter *painter)
+{
+    return qMax<qreal>(qSqrt(qAbs(painter->worldTransform().determinant())), 1e-9);
+}
+
+// 包含边界的相交测试（QRectF::intersects 会忽略零宽高的矩形）
+bool boxIntersects(qreal left, qreal top, qreal right, qreal bottom, const QRectF &rect)
+{
+    return left <= rect.right() && right >= rect.left() && top <= rect.bottom() && bottom >= rect.top();
+}
+
+// Liang-Barsky 裁剪，返回线段落在矩形内的参数区间
+bool clipSegment(const QPointF &a, const QPointF &b, const QRectF &rect, qreal &t0, qreal &t1)
+{
+    const qreal dx = b.x() - a.x();
+    const qreal dy = b.y() - a.y();
+    const qreal p[4] = { -dx, dx, -dy, dy };
+    const qreal q[4] = { a.x() - rect.left(), rect.right() - a.x(),
+                         a.y() - rect.top(), rect.bottom() - a.y() };
+    t0 = 0.0;
+    t1 = 1.0;
+    for (int i = 0; i < 4; ++i) {
+        if (qFuzzyIsNull(p[i])) {
+            if (q[i] < 0) {
+                return false;
+            }
+            continue;
+        }
+        const qreal t = q[i] / p[i];
+        if (p[i] < 0) {
+            t0 = qMax(t0, t);
+        } else {
+            t1 = qMin(t1, t);
+        }
+        if (t0 > t1) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// 按画笔虚线样式沿几何行走，只有 walk() 的部分会产生输出，skip() 只推进相位
+class Dasher
+{
+public:
+    Dasher(const QPen &pen, qreal levelOfDetail)
+    {
+        // 虚线长度以线宽为单位；装饰画笔的线宽是设备像素
+        qreal unit = qMax<qreal>(pen.widthF(), 1.0);
+        if (pen.isCosmetic()) {
+            unit /= levelOfDetail;
+        }
+        const QList<qreal> dashes = pen.dashPattern();
+        pattern.reserve(dashes.size());
+        for (qreal dash : dashes) {
+            pattern.append(qMax<qreal>(dash, 0.0) * unit);
+            period += pattern.last();
+        }
+        solid = pattern.size() < 2 || period * levelOfDetail < MinPeriodPx;
+        offset = pen.dashOffset() * unit;
+    }
+
+    void beginSubpath()
+    {
+        flush();
+        if (solid) {
+            return;
+        }
+        // 每个子路径从虚线样式开头重新计算相位
+        index = 0;
+        remaining = pattern.first();
+        skip(offset);
+    }
+
+    void endSubpath() { flush(); }
+
+    // 不可见的部分：结束当前这段虚线，只推进相位
+    void skip(qreal length)
+    {
+        flush();
+        if (solid || length <= 0) {
+            return;
+        }
+        if (length < remaining) {
+            remaining -= length;
+            return;
+        }
+        length -= remaining;
+        nextEntry();
+        length = std::fmod(length, period);
+        while (length >= remaining) {
+            length -= remaining;
+            nextEntry();
+        }
+        remaining -= length;
+    }
+
+    // 可见的部分：生成落在虚线“实”段上的几何，跨顶点的虚线保持为一条折线
+    void walk(const QPointF &a, const QPointF &b)
+    {
+        const qreal length = QLineF(a, b).length();
+        if (length <= 0) {
+            return;
+        }
+        if (solid) {
+            append(a);
+            append(b);
+            return;
+        }
+        const QPointF delta = (b - a) / length;
+        qreal position = 0;
+        while (position < length) {
+            const qreal left = length - position;
+            const qreal step = qMin(remaining, left);
+            if (index % 2 == 0) {
+                append(a + delta * position);
+                append(step == left ? b : a + delta * (position + step));
+            }
+            position = step == left ? length : position + step; // 避免舍入误差导致原地循环
+            remaining -= step;
+            if (remaining <= 0) {
+                if (index % 2 == 0) {
+                    flush();
+                }
+                nextEntry();
+            }
+        }
+    }
+
+    void draw(QPainter *painter, const QPen &pen)
+    {
+        flush();
+        if (lines.isEmpty() && runs.isEmpty()) {
+            return;
+        }
+        QPen solidPen(pen);
+        solidPen.setStyle(Qt::SolidLine);
+        painter->save();
+        painter->setPen(solidPen);
+        painter->setBrush(Qt::NoBrush);
+        if (!lines.isEmpty()) {
+            painter->drawLines(lines.constData(), lines.size());
+        }
+        if (!runs.isEmpty()) {
+            painter->drawPath(runs);
+        }
+        painter->restore();
+    }
+
+private:
+    void nextEntry()
+    {
+        index = (index + 1) % pattern.size();
+        remaining = pattern.at(index);
+    }
+
+    void append(const QPointF &point)
+    {
+        if (current.isEmpty() || current.last() != point) {
+            current.append(point);
+        }
+    }
+
+    // 结束当前这段：两点的合并为一次 drawLines，折线进入路径
+    void flush()
+    {
+        if (current.size() == 2) {
+            lines.append(QLineF(current.first(), current.last()));
+        } else if (current.size() > 2) {
+            runs.moveTo(current.first());
+            for (int i = 1; i < current.size(); ++i) {
+                runs.lineTo(current.at(i));
+            }
+        }
+        current.clear();
+    }
+
+    QVector<qreal> pattern;
+    qreal period = 0;
+    qreal offset = 0;
+    bool solid = true;
+    int index = 0;
+    qreal remaining = 0;
+
+    QVector<QPointF> current;
+    QVector<QLineF> lines;
+    QPainterPath runs;
+};
+
+void feedSegment(Dasher &dasher, const QPointF &a, const QPointF &b, const QRectF &visible)
+{
+    const qreal length = QLineF(a, b).length();
+    qreal t0 = 0;
+    qreal t1 = 1;
+    if (!clipSegment(a, b, visible, t0, t1)) {
+        dasher.skip(length);
+        return;
+    }
+    if (t0 > 0) {
+        dasher.skip(length * t0);
+    }
+    const QPointF delta = b - a;
+    dasher.walk(a + delta * t0, a + delta * t1);
+    if (t1 < 1) {
+        dasher.skip(length * (1 - t1));
+    }
+}
+
+// 三次贝塞尔曲线长度：五点高斯-勒让德积分，结果只取决于控制点，相位在各次绘制间一致
+qreal cubicLength(const QPointF &p0, const QPointF &p1, const QPointF &p2, const QPointF &p3)
+{
+    static const qreal nodes[5] = { -0.9061798459386640, -0.5384693101056831, 0.0,
+                                    0.5384693101056831, 0.9061798459386640 };
+    static const qreal weights[5] = { 0.2369268850561891, 0.4786286704993665, 0.5688888888888889,
+                                      0.4786286704993665, 0.2369268850561891 };
+    qreal length = 0;
+    for (int i = 0; i < 5; ++i) {
+        const qreal t = 0.5 * (nodes[i] + 1.0);
+        const qreal u = 1.0 - t;
+        const QPointF derivative = 3 * u * u * (p1 - p0) + 6 * u * t * (p2 - p1) + 3 * t * t * (p3 - p2);
+        length += weights[i] * qSqrt(QPointF::dotProduct(derivative, derivative));
+    }
+    return 0.5 * length;
+}
+
+// 控制点到弦的最大距离
+qreal cubicFlatness(const QPointF &p0, const QPointF &p1, const QPointF &p2, const QPointF &p3)
+{
+    const QPointF chord = p3 - p0;
+    const qreal chordLength = qSqrt(QPointF::dotProduct(chord, chord));
+    if (chordLength <= 0) {
+        return qMax(QLineF(p0, p1).length(), QLineF(p0, p2).length());
+    }
+    const qreal d1 = qAbs(chord.x() * (p1.y() - p0.y()) - chord.y() * (p1.x() - p0.x())) / chordLength;
+    const qreal d2 = qAbs(chord.x() * (p2.y() - p0.y()) - chord.y() * (p2.x() - p0.x())) / chordLength;
+    return qMax(d1, d2);
+}
+
+// 不可见的子曲线只累加长度，可见的细分到足够平直后按线段处理
+void feedCubic(Dasher &dasher, const QPointF &p0, const QPointF &p1, const QPointF &p2, const QPointF &p3,
+               const QRectF &visible, qreal tolerance, int depth)
+{
+    const qreal left = qMin(qMin(p0.x(), p1.x()), qMin(p2.x(), p3.x()));
+    const qreal right = qMax(qMax(p0.x(), p1.x()), qMax(p2.x(), p3.x()));
+    const qreal top = qMin(qMin(p0.y(), p1.y()), qMin(p2.y(), p3.y()));
+    const qreal bottom = qMax(qMax(p0.y(), p1.y()), qMax(p2.y(), p3.y()));
+    if (!boxIntersects(left, top, right, bottom, visible)) {
+        dasher.skip(cubicLength(p0, p1, p2, p3));
+        return;
+    }
+    if (depth >= MaxFlattenDepth || cubicFlatness(p0, p1, p2, p3) <= tolerance) {
+        feedSegment(dasher, p0, p3, visible);
+        return;
+    }
+    // de Casteljau 二分
+    const QPointF p01 = (p0 + p1) / 2;
+    const QPointF p12 = (p1 + p2) / 2;
+    const QPointF p23 = (p2 + p3) / 2;
+    const QPointF p012 = (p01 + p12) / 2;
+    const QPointF p123 = (p12 + p23) / 2;
+    const QPointF mid = (p012 + p123) / 2;
+    feedCubic(dasher, p0, p01, p012, mid, visible, tolerance, depth + 1);
+    feedCubic(dasher, mid, p123, p23, p3, visible, tolerance, depth + 1);
+}
+
+// 可见范围按线宽和斜接外扩，保证被裁掉的虚线端点和拐角不会露出
+QRectF expandedForPen(const QRectF &visible, const QPen &pen, qreal levelOfDetail)
+{
+    qreal halfWidth = qMax<qreal>(pen.widthF(), 1.0) / 2;
+    if (pen.isCosmetic()) {
+        halfWidth /= levelOfDetail;
+    }
+    if (pen.joinStyle() == Qt::MiterJoin || pen.joinStyle() == Qt::SvgMiterJoin) {
+        halfWidth *= qMax<qreal>(pen.miterLimit(), 1.0);
+    }
+    const qreal margin = halfWidth + 1.0 / levelOfDetail;
+    return visible.adjusted(-margin, -margin, margin, margin);
+}
+
+} // namespace
+
+bool ClippedDash::applies(const QPen &pen)
+{
+    return pen.style() != Qt::SolidLine && pen.style() != Qt::NoPen;
+}
+
+QRectF ClippedDash::visibleRect(const QPainter *painter, const QRectF &exposedRect)
+{
+    QRectF rect = exposedRect;
+    // 录制到 QPicture 时回放位置未知，只能按 exposedRect
+    if (!painter->device() || painter->device()->devType() == QInternal::Picture) {
+        return rect;
+    }
+    bool invertible = false;
+    const QTransform inverse = painter->worldTransform().inverted(&invertible);
+    if (invertible) {
+        rect &= inverse.mapRect(QRectF(painter->viewport()));
+    }
+    if (painter->hasClipping()) {
+        rect &= painter->clipBoundingRect();
+    }
+    return rect;
+}
+
+void ClippedDash::drawPolyline(QPainter *painter, const QPen &pen, const QPointF *points, int count, bool closed,
+                               const QRectF &visible)
+{
+    if (count < 2 || visible.isEmpty()) {
+        return;
+    }
+    const qreal levelOfDetail = levelOfDetailOf(painter);
+    const QRectF clip = expandedForPen(visible, pen, levelOfDetail);
+    Dasher dasher(pen, levelOfDetail);
+    dasher.beginSubpath();
+    for (int i = 0; i + 1 < count; ++i) {
+        feedSegment(dasher, points[i], points[i + 1], clip);
+    }
+    if (closed && count >= 3) {
+        feedSegment(dasher, points[count - 1], points[0], clip);
+    }
+    dasher.endSubpath();
+    dasher.draw(painter, pen);
+}
+
+void ClippedDash::drawPath(QPainter *painter, const QPen &pen, const QPainterPath &path, const QRectF &visible)
+{
+    if (path.isEmpty() || visible.isEmpty()) {
+        return;
+    }
+    const qreal levelOfDetail = levelOfDetailOf(painter);
+    const QRectF clip = expandedForPen(visible, pen, levelOfDetail);
+    const qreal tolerance = FlattenTolerancePx / levelOfDetail;
+    Dasher dasher(pen, levelOfDetail);
+    QPointF current;
+    const int count = path.elementCount();
+    for (int i = 0; i < count; ++i) {
+        const QPainterPath::Element element = path.elementAt(i);
+        switch (element.type) {
+        case QPainterPath::MoveToElement:
+            dasher.endSubpath();
+            dasher.beginSubpath();
+            current = element;
+            break;
+        case QPainterPath::LineToElement:
+            feedSegment(dasher, current, element, clip);
+            current = element;
+            break;
+        case QPainterPath::CurveToElement:
+            if (i + 2 < count) {
+                const QPointF end = path.elementAt(i + 2);
+                feedCubic(dasher, current, element, path.elementAt(i + 1), end, clip, tolerance, 0);
+                current = end;
+                i += 2;
+            }
+            break;
+        case QPainterPath::CurveToDataElement:
+            break;
+        }
+    }
+    dasher.endSubpath();
+    dasher.draw(painter, pen);
+}
@@ -0,0 +1,28 @@
+#ifndef CLIPPED_DASH_H
+#define CLIPPED_DASH_H
+
+#include <QPainter>
+#include <QPainterPath>
+#include <QPen>
+#include <QPointF>
+#include <QRectF>
+
+// 先裁剪再生成虚线：光栅引擎会沿整条几何生成虚线再裁剪，放大后极慢。
+// 这里只对可见范围内的几何生成虚线，不可见部分只累加长度，虚线相位与整条绘制一致。
+// 虚线周期在屏幕上小于几个像素时直接按实线绘制可见部分。
+namespace ClippedDash {
+
+// 是否需要自行生成虚线（传入交互模式处理后的画笔）
+bool applies(const QPen &pen);
+// 当前绘制设备上可见的本地坐标范围：exposedRect 与设备范围、裁剪区域的交集
+QRectF visibleRect(const QPainter *painter, const QRectF &exposedRect);
+
+// 只画轮廓，不填充；points 与 visible 均为本地坐标
+void drawPolyline(QPainter *painter, const QPen &pen, const QPointF *points, int count, bool closed,
+                  const QRectF &visible);
+// 曲线按当前缩放展平，只细分与可见范围相交的部分
+void drawPath(QPainter *painter, const QPen &pen, const QPainterPath &path, const QRectF &visible);
+
+} // namespace ClippedDash
+
+#endif // CLIPPED_DASH_H
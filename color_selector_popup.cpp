@@ -7,6 +7,7 @@
 #include <QDebug>
 #include <QMouseEvent>
 #include "color_frame.h"
+#include "logging_categories.h"
 
 
 ColorSelectorPopup::ColorSelectorPopup(QWidget *parent) : QWidget(parent)
@@ -131,14 +132,14 @@ void ColorSelectorPopup::addCustomColor(const QColor& color)
 
 void ColorSelectorPopup::onStandardColorClicked(const QColor& color)
 {
-    qDebug() << "Standard color selected:" << color.name();
+    qCDebug(lcView) << "Standard color selected:" << color.name();
     emit colorSelected(color);
     emit closePopup(); // 请求关闭
 }
 
 void ColorSelectorPopup::onCustomColorClicked(const QColor& color)
 {
-    qDebug() << "Custom color selected:" << color.name();
+    qCDebug(lcView) << "Custom color selected:" << color.name();
     emit colorSelected(color);
     emit closePopup(); // 请求关闭
 }
@@ -147,7 +148,7 @@ void ColorSelectorPopup::onOtherColorClicked()
 {
     QColor color = QColorDialog::getColor(Qt::black, this, QStringLiteral("选择颜色"));
     if (color.isValid()) {
-        qDebug() << "Other color selected:" << color.name();
+        qCDebug(lcView) << "Other color selected:" << color.name();
         addCustomColor(color); // 添加到自定义颜色中
         emit colorSelected(color);
         emit closePopup(); // 请求关闭
@@ -157,7 +158,7 @@ void ColorSelectorPopup::onOtherColorClicked()
 void ColorSelectorPopup::onColorPickerClicked()
 {
     // TODO: 实现取色功能
-    qDebug() << "Color Picker clicked - 功能待实现";
+    qCDebug(lcView) << "Color Picker clicked - 功能待实现";
     // 暂时也弹出颜色对话框
     onOtherColorClicked();
     // emit closePopup(); // 请求关闭
@@ -165,7 +166,7 @@ void ColorSelectorPopup::onColorPickerClicked()
 
 void ColorSelectorPopup::onNoColorClicked()
 {
-    qDebug() << "Default color (Black) selected";
+    qCDebug(lcView) << "Default color (Black) selected";
     emit colorSelected(Qt::black); // 选择黑色作为默认线条颜色
     emit closePopup(); // 请求关闭
 }
@@ -9,6 +9,7 @@
 #include <QMouseEvent>
 #include "color_frame.h"
 #include "background_image_selector_dialog.h"
+#include "logging_categories.h"
 
 
 
@@ -140,14 +141,14 @@ void ColorSelectorPopupFill::addCustomColor(const QColor& color)
 
 void ColorSelectorPopupFill::onStandardColorClicked(const QColor& color)
 {
-    qDebug() << "Standard color selected:" << color.name();
+    qCDebug(lcView) << "Standard color selected:" << color.name();
     emit colorSelected(color);
     emit closePopup(); // 请求关闭
 }
 
 void ColorSelectorPopupFill::onCustomColorClicked(const QColor& color)
 {
-    qDebug() << "Custom color selected:" << color.name();
+    qCDebug(lcView) << "Custom color selected:" << color.name();
     emit colorSelected(color);
     emit closePopup(); // 请求关闭
 }
@@ -156,7 +157,7 @@ void ColorSelectorPopupFill::onOtherColorClicked()
 {
     QColor color = QColorDialog::getColor(Qt::black, this, QStringLiteral("选择颜色"));
     if (color.isValid()) {
-        qDebug() << "Other color selected:" << color.name();
+        qCDebug(lcView) << "Other color selected:" << color.name();
         addCustomColor(color); // 添加到自定义颜色中
         emit colorSelected(color);
         emit closePopup(); // 请求关闭
@@ -166,7 +167,7 @@ void ColorSelectorPopupFill::onOtherColorClicked()
 void ColorSelectorPopupFill::onColorPickerClicked()
 {
     // TODO: 实现取色功能
-    qDebug() << "Color Picker clicked - 功能待实现";
+    qCDebug(lcView) << "Color Picker clicked - 功能待实现";
     // 暂时也弹出颜色对话框
     onOtherColorClicked();
     // emit closePopup(); // 请求关闭
@@ -174,7 +175,7 @@ void ColorSelectorPopupFill::onColorPickerClicked()
 
 void ColorSelectorPopupFill::onNoColorClicked()
 {
-    qDebug() << "Default color (Black) selected";
+    qCDebug(lcView) << "Default color (Black) selected";
     emit colorSelected(Qt::black); // 选择黑色作为默认线条颜色
     emit closePopup(); // 请求关闭
 }
@@ -182,7 +183,7 @@ void ColorSelectorPopupFill::onNoColorClicked()
 
 void ColorSelectorPopupFill::onfillBackGroundColorClicked()
 {
-    qDebug() << "Fill Background Image selection triggered";
+    qCDebug(lcView) << "Fill Background Image selection triggered";
     // 创建并显示背景图片选择对话框
     BackgroundImageSelectorDialog *dialog = new BackgroundImageSelectorDialog(this);
     // 连接对话框的图片选择信号到本类的信号，以便传递给上层窗口
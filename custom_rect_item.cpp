@@ -1,25 +1,40 @@
 #include "custom_rect_item.h"
+#include "render_quality.h"
+#include "clipped_dash.h"
 #include <QPainter>
+#include <QStyleOptionGraphicsItem>
 
 CustomRectItem::CustomRectItem(const QRectF &rect, QGraphicsItem *parent)
     : QGraphicsRectItem(rect, parent)
 {
 }
 
-void CustomRectItem::setFillPixmap(const QPixmap &pixmap)
+void CustomRectItem::setFillImage(const std::shared_ptr<ImageMipChain> &image)
 {
-    fillPixmap = pixmap;
+    fillChain = image;
+    update();
 }
 
 void CustomRectItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
 {
-    // 绘制边框
-    painter->setPen(pen());
-    painter->drawRect(rect());
+    // 绘制边框（交互期间虚线改为实线），虚线边框只为可见部分生成
+    const QPen borderPen = RenderQuality::effectivePen(pen());
+    if (ClippedDash::applies(borderPen)) {
+        const QRectF r = rect();
+        const QPointF corners[4] = { r.topLeft(), r.topRight(), r.bottomRight(), r.bottomLeft() };
+        ClippedDash::drawPolyline(painter, borderPen, corners, 4, true, ClippedDash::visibleRect(painter, option->exposedRect));
+    } else {
+        painter->setPen(borderPen);
+        painter->drawRect(rect());
+    }
 
-    // 如果有填充图片，绘制拉伸后的图片
-    if (!fillPixmap.isNull()) {
-        painter->drawPixmap(rect().toRect(), fillPixmap);
+    // 如果有填充图片，按当前设备尺寸选取缩略层再拉伸；是否平滑缩放由视图的渲染提示决定。
+    // 录制到 QPicture 时（导出分带、金字塔瓦片）世界变换即回放时的缩放，同样只录制所需的层，
+    // 不把原图整张写进录制；视口瓦片缓存不录制带图片的矩形，而是直接绘制
+    if (fillChain) {
+        const QSizeF deviceSize = painter->worldTransform().mapRect(rect()).size() * painter->device()->devicePixelRatioF();
+        const QImage &level = fillChain->levelFor(deviceSize);
+        painter->drawImage(rect(), level, QRectF(level.rect()));
     } else if (brush().style() != Qt::NoBrush) {
         // 否则使用默认的刷子填充（颜色）
         painter->setBrush(brush());
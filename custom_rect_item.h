@@ -3,18 +3,22 @@
 
 #include <QGraphicsRectItem>
 #include <QWidget>
-#include <QPixmap>
+#include <memory>
+#include "image_mip_chain.h"
 
 class CustomRectItem : public QGraphicsRectItem
 {
 
 public:
     CustomRectItem(const QRectF &rect, QGraphicsItem *parent = nullptr);
-    void setFillPixmap(const QPixmap &pixmap);
+    // 填充图片按多级缩略链共享，绘制时拉伸到整个矩形
+    void setFillImage(const std::shared_ptr<ImageMipChain> &image);
+    std::shared_ptr<ImageMipChain> fillImage() const { return fillChain; }
+    bool hasFillImage() const { return fillChain != nullptr; }
 protected:
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget = nullptr) override;
 private:
-    QPixmap fillPixmap;
+    std::shared_ptr<ImageMipChain> fillChain;
 };
 
 #endif // CUSTOM_RECT_ITEM_H
@@ -1,35 +1,25 @@
 #include "editable_line_item.h"
+#include "logging_categories.h"
+#include "render_quality.h"
+#include "clipped_dash.h"
+#include <QPainter>
+#include <QStyleOptionGraphicsItem>
 #include <QGraphicsScene>
 #include <QGraphicsEllipseItem>
 #include <QCursor>
 #include <QPen>
+#include <QtMath>
+#include <QDebug>
 EditableLineItem::EditableLineItem(QPointF startPoint, QPointF endPoint, QGraphicsItem *parent)
     : QGraphicsLineItem(startPoint.x(), startPoint.y(), endPoint.x(), endPoint.y(), parent),
     rotationAngle(0),
     rotationHandleOffset(20.0)
 {
-    createHandles();
     updateHandlesPosition();
     setFlags(ItemIsSelectable | ItemIsMovable);
     setAcceptHoverEvents(true);
 }
 
-EditableLineItem::~EditableLineItem()
-{
-    if (startHandle && startHandle->parentItem() != this) {
-        delete startHandle;
-        startHandle = nullptr;
-    }
-    if (endHandle && endHandle->parentItem() != this) {
-        delete endHandle;
-        endHandle = nullptr;
-    }
-    if (rotationHandle && rotationHandle->parentItem() != this) {
-        delete rotationHandle;
-        rotationHandle = nullptr;
-    }
-}
-
 EditableLineItem* EditableLineItem::clone() const
 {
     // 创建一个新的 EditableLineItem 实例
@@ -56,7 +46,7 @@ EditableLineItem* EditableLineItem::clone() const
     // 更新新项的控制柄位置以匹配其状态
     newItem->updateHandlesPosition();
 
-    qDebug() << "Cloned an EditableLineItem.";
+    qCDebug(lcItems) << "Cloned an EditableLineItem.";
     return newItem;
 }
 void EditableLineItem::rotate(qreal angle, const QPointF& rotationCenterScene)
@@ -89,59 +79,16 @@ void EditableLineItem::rotate(qreal angle, const QPointF& rotationCenterScene)
     // 更新旋转角度
     rotationAngle = angle;
 
-    // 临时保存旋转柄的本地坐标位置
-    QPointF rotationHandleLocalPos = rotationHandle->pos();
-
-    // 更新其他控制柄位置
-    updateHandlesPosition();
+    // 旋转柄位置保持不变，确保在拖动过程中不移动
 
-    // 恢复旋转柄位置，确保在拖动过程中不移动
-    rotationHandle->setPos(rotationHandleLocalPos);
-
-    qDebug() << "Rotated line to angle:" << angle << ", New start:" << newStartLocal
+    qCDebug(lcItems) << "Rotated line to angle:" << angle << ", New start:" << newStartLocal
              << ", New end:" << newEndLocal << ", Rotation center:" << rotationCenterScene;
 }
 
 
-void EditableLineItem::createHandles()
-{
-    const qreal handleSize = 4.0;
-    const qreal handleRadius = handleSize / 2.0;
-    startHandle = new HandleItem(-handleRadius, -handleRadius, handleSize, handleSize, this);
-    startHandle->setPen(QPen(Qt::gray, 0));
-    startHandle->setBrush(Qt::gray);
-    startHandle->setFlag(QGraphicsItem::ItemIsMovable, true);
-    startHandle->setFlag(QGraphicsItem::ItemIgnoresTransformations, true);
-    startHandle->setVisible(false);
-    startHandle->setCursor(Qt::SizeAllCursor);
-
-    endHandle = new HandleItem(-handleRadius, -handleRadius, handleSize, handleSize, this);
-    endHandle->setPen(QPen(Qt::gray, 0));
-    endHandle->setBrush(Qt::gray);
-    endHandle->setFlag(QGraphicsItem::ItemIsMovable, true);
-    endHandle->setFlag(QGraphicsItem::ItemIgnoresTransformations, true);
-    endHandle->setVisible(false);
-    endHandle->setCursor(Qt::SizeAllCursor);
-
-
-    rotationHandle = new HandleItem(-handleRadius, -handleRadius, handleSize, handleSize, this);
-    rotationHandle->setPen(QPen(Qt::blue, 0));
-    rotationHandle->setBrush(Qt::blue);
-    rotationHandle->setFlag(QGraphicsItem::ItemIsMovable, true);
-    rotationHandle->setFlag(QGraphicsItem::ItemIgnoresTransformations, true);
-    rotationHandle->setVisible(false);
-    rotationHandle->setCursor(Qt::CrossCursor);
-
-    updateLine(line().p1(), line().p2());
-
-}
-
-
 void EditableLineItem::updateHandlesPosition()
 {
     QLineF lineData = line();
-    startHandle->setPos(lineData.p1());
-    endHandle->setPos(lineData.p2());
 
     // 计算线段的中点
     QPointF midPoint = (lineData.p1() + lineData.p2()) / 2.0;
@@ -165,8 +112,7 @@ void EditableLineItem::updateHandlesPosition()
     }
 
     // 将旋转端点放置在中点加上垂直偏移的位置
-    QPointF rotationPos = midPoint + perpendicularDirection;
-    rotationHandle->setPos(rotationPos);
+    rotationHandleLocal = midPoint + perpendicularDirection;
 }
 
 
@@ -175,8 +121,6 @@ QVariant EditableLineItem::itemChange(GraphicsItemChange change, const QVariant
 {
     if (change == ItemPositionChange && scene()) {
         return QVariant(); // Prevent default handling of this specific ItemPositionChange
-    } else if (change == ItemPositionHasChanged) {
-        updateHandlesPosition();
     }
     return QGraphicsLineItem::itemChange(change, value);
 }
@@ -187,38 +131,8 @@ void EditableLineItem::updateLine(QPointF newStartScene, QPointF newEndScene)
     QPointF newEndLocal = mapFromScene(newEndScene);
 
     setLine(newStartLocal.x(), newStartLocal.y(), newEndLocal.x(), newEndLocal.y());
-    startHandle->setPos(newStartLocal);
-    endHandle->setPos(newEndLocal);
-    qDebug() << "Updated line: Start=" << newStartLocal << ", End=" << newEndLocal;
-    qDebug() << "Start handle pos=" << startHandle->pos() << ", End handle pos=" << endHandle->pos();
-}
-
-
-void EditableLineItem::handleMoved()
-{
-
-}
-
-void EditableLineItem::setSelectedState(bool selected)
-{
-    startHandle->setVisible(selected);
-    endHandle->setVisible(selected);
-    rotationHandle->setVisible(selected);
-}
-
-void EditableLineItem::setStartHandle(HandleItem *handle)
-{
-
-}
-
-void EditableLineItem::setEndHandle(HandleItem *handle)
-{
-
-}
-
-void EditableLineItem::setRotationHandle(HandleItem *handle)
-{
-
+    updateHandlesPosition();
+    qCDebug(lcItems) << "Updated line: Start=" << newStartLocal << ", End=" << newEndLocal;
 }
 
 
@@ -230,3 +144,21 @@ qreal EditableLineItem::angleFromPoint(const QPointF& origin, const QPointF& poi
     QLineF line(origin, point);
     return line.angle();
 }
+
+void EditableLineItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    const QPen linePen = RenderQuality::effectivePen(pen());
+    if (ClippedDash::applies(linePen)) {
+        // 虚线只在可见部分生成，放大后不会沿整条线生成虚线
+        const QPointF ends[2] = { line().p1(), line().p2() };
+        ClippedDash::drawPolyline(painter, linePen, ends, 2, false, ClippedDash::visibleRect(painter, option->exposedRect));
+        return;
+    }
+    if (!RenderQuality::isInteractive()) {
+        QGraphicsLineItem::paint(painter, option, widget);
+        return;
+    }
+    // 交互期间用实线绘制
+    painter->setPen(linePen);
+    painter->drawLine(line());
+}
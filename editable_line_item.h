@@ -5,39 +5,33 @@
 #include <QGraphicsItem>
 #include <QPointF>
 #include <QVariant>
-#include "handle_item.h"
 
 class EditableLineItem : public QGraphicsLineItem
 {
 public:
+    enum { Type = UserType + 1 }; // 自定义类型，便于 qgraphicsitem_cast 和按类型分派
+    int type() const override { return Type; }
+
     EditableLineItem(QPointF startPoint, QPointF endPoint, QGraphicsItem *parent = nullptr);
-    ~EditableLineItem();
     void updateLine(QPointF newStart, QPointF newEnd);
     void rotate(qreal angle, const QPointF& rotationCenterScened);
-    void handleMoved();
-    void setSelectedState(bool selected); // 新增：设置选中状态，控制端点可见性
-    HandleItem* getStartHandle() const { return startHandle; } // 获取起点端点
-    HandleItem* getEndHandle() const { return endHandle; } // 获取终点端点
-    HandleItem* getRotationHandle() const { return rotationHandle; } // 获取旋转端点
-
-    void setStartHandle(HandleItem* handle); // 设置起点端点
-    void setEndHandle(HandleItem* handle);   // 设置终点端点
-    void setRotationHandle(HandleItem* handle);   // 设置旋转端点
+    // 控制点位置（本地坐标），由视图的选择覆盖层绘制和拾取
+    QPointF startHandlePos() const { return line().p1(); }
+    QPointF endHandlePos() const { return line().p2(); }
+    QPointF rotationHandlePos() const { return rotationHandleLocal; }
 
     virtual EditableLineItem* clone() const;
     qreal angleFromPoint(const QPointF& origin, const QPointF& point);
 
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget = nullptr) override;
 
 protected:
     QVariant itemChange(GraphicsItemChange change, const QVariant &value) override;
 
 private:
-    void createHandles();
     void updateHandlesPosition(); // 新增：更新端点位置
 
-    HandleItem *startHandle = nullptr;
-    HandleItem *endHandle = nullptr;
-    HandleItem *rotationHandle = nullptr;
+    QPointF rotationHandleLocal; // 旋转控制点（本地坐标）
     qreal rotationAngle;
     qreal rotationHandleOffset;
 };
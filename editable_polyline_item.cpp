@@ -1,29 +1,123 @@
 #include "editable_polyline_item.h"
+#include "logging_categories.h"
+#include "render_quality.h"
+#include "clipped_dash.h"
+#include "hit_test_kernels.h"
 #include <QPainter>
+#include <QPainterPathStroker>
 #include <QGraphicsScene>
 #include <QCursor>
+#include <QStyleOptionGraphicsItem>
 #include <QDebug>
+#include <QtMath>
+#include <cmath>
 
-EditablePolylineItem::EditablePolylineItem(const QVector<QPointF>& points, QGraphicsItem *parent)
-    : QGraphicsItem(parent), points(points), linePen(Qt::black, 1)
+namespace {
+
+// 径向距离简化：跳过与上一个保留点距离小于容差的顶点，首尾点始终保留
+QVector<QPointF> simplifyRadial(const QVector<QPointF> &source, qreal tolerance)
 {
-    createHandles();
-    updateHandlesPosition();
-    setFlags(ItemIsSelectable | ItemIsMovable);
-    setAcceptHoverEvents(true);
+    QVector<QPointF> result;
+    if (source.size() <= 2) {
+        return source;
+    }
+    const qreal tolerance2 = tolerance * tolerance;
+    result.reserve(source.size() / 2);
+    result.append(source.first());
+    QPointF last = source.first();
+    const int lastIndex = source.size() - 1;
+    for (int i = 1; i < lastIndex; ++i) {
+        const QPointF &p = source.at(i);
+        const qreal dx = p.x() - last.x();
+        const qreal dy = p.y() - last.y();
+        if (dx * dx + dy * dy >= tolerance2) {
+            result.append(p);
+            last = p;
+        }
+    }
+    result.append(source.last());
+    return result;
+}
+
+// 只绘制与裁剪矩形相交的连续线段，每段连续区间一次 drawPolyline
+void drawClippedPolyline(QPainter *painter, const QPointF *points, int count, const QRectF &clip)
+{
+    int runStart = -1;
+    for (int i = 0; i + 1 < count; ++i) {
+        const QPointF &a = points[i];
+        const QPointF &b = points[i + 1];
+        const bool visible = qMax(a.x(), b.x()) >= clip.left() && qMin(a.x(), b.x()) <= clip.right()
+                             && qMax(a.y(), b.y()) >= clip.top() && qMin(a.y(), b.y()) <= clip.bottom();
+        if (visible) {
+            if (runStart < 0) {
+                runStart = i;
+            }
+        } else if (runStart >= 0) {
+            painter->drawPolyline(points + runStart, i - runStart + 1);
+            runStart = -1;
+        }
+    }
+    if (runStart >= 0) {
+        painter->drawPolyline(points + runStart, count - runStart);
+    }
 }
 
-EditablePolylineItem::~EditablePolylineItem()
+// 路径是否为轴对齐矩形（视图拾取探测框映射到本地坐标后的形式）
+bool isAxisAlignedRect(const QPainterPath &path)
 {
-    for (HandleItem* handle : handles) {
-        if (handle && handle->parentItem() != this) {
-            delete handle;
+    const int count = path.elementCount();
+    if (count != 4 && count != 5) {
+        return false;
+    }
+    for (int i = 0; i < count; ++i) {
+        const QPainterPath::Element current = path.elementAt(i);
+        const QPainterPath::Element next = path.elementAt((i + 1) % count);
+        if (current.isCurveTo() || (current.x != next.x && current.y != next.y)) {
+            return false;
         }
     }
+    return true;
 }
+
+// 相邻线段序号合并为连续区间，每个区间一次 drawPolyline
+void drawSegmentRuns(QPainter *painter, const QVector<QPointF> &points, const QVector<int> &segments)
+{
+    int runStart = -1;
+    int runEnd = -1;
+    for (int segment : segments) {
+        if (segment + 1 >= points.size()) {
+            break; // 闭合边单独绘制
+        }
+        if (segment != runEnd) {
+            if (runStart >= 0) {
+                painter->drawPolyline(points.constData() + runStart, runEnd - runStart + 1);
+            }
+            runStart = segment;
+        }
+        runEnd = segment + 1;
+    }
+    if (runStart >= 0) {
+        painter->drawPolyline(points.constData() + runStart, runEnd - runStart + 1);
+    }
+}
+
+} // namespace
+
+EditablePolylineItem::EditablePolylineItem(const QVector<QPointF>& points, QGraphicsItem *parent)
+    : QGraphicsItem(parent), points(points), linePen(Qt::black, 1)
+{
+    // 需要准确的 exposedRect 才能只绘制可见部分
+    setFlags(ItemIsSelectable | ItemIsMovable | ItemUsesExtendedStyleOption);
+    setAcceptHoverEvents(true);
+    segments.build(this->points, isClosed_);
+    pointBounds = segments.bounds();
+}
+
 void EditablePolylineItem::setPen(const QPen &pen)
 {
+    prepareGeometryChange(); // 线宽影响包围盒
     linePen = pen;
+    shapeValid = false; // 描边宽度变化
     update();
 }
 EditablePolylineItem* EditablePolylineItem::clone() const
@@ -38,112 +132,219 @@ EditablePolylineItem* EditablePolylineItem::clone() const
     newItem->setVisible(isVisible());
     newItem->setZValue(zValue());
     newItem->setPen(linePen);
-    newItem->updateHandlesPosition();
-    qDebug() << "Cloned an EditablePolylineItem.";
+    newItem->setClosed(isClosed_);
+    qCDebug(lcItems) << "Cloned an EditablePolylineItem.";
     return newItem;
 }
 
 void EditablePolylineItem::updatePoint(int index, const QPointF& newPoint)
 {
-    if (index >= 0 && index < points.size()) {
-        points[index] = newPoint;
-        updateHandlesPosition();
+    if (index < 0 || index >= points.size()) {
+        return;
+    }
+    const qreal margin = linePen.widthF() / 2.0;
+    // 移动前后相邻两条线段的区域都需要重绘
+    QRectF dirty = segments.vertexNeighbourhood(index).adjusted(-margin, -margin, margin, margin);
+    points[index] = newPoint;
+    segments.updateVertex(points, index);
+    invalidateCaches();
+
+    const QRectF newBounds = segments.bounds();
+    if (newBounds != pointBounds) {
+        // 包围盒变化时才需要通知场景更新索引
         prepareGeometryChange();
+        pointBounds = newBounds;
         update();
-        qDebug() << "Updated polyline point at index" << index << "to" << newPoint;
+    } else {
+        dirty = dirty.united(segments.vertexNeighbourhood(index).adjusted(-margin, -margin, margin, margin));
+        update(dirty);
     }
+    qCDebug(lcItems) << "Updated polyline point at index" << index << "to" << newPoint;
 }
 
-void EditablePolylineItem::setSelectedState(bool selected)
+void EditablePolylineItem::appendPoint(const QPointF& point)
 {
-    for (HandleItem* handle : handles) {
-        handle->setVisible(selected);
+    const qreal margin = linePen.widthF() / 2.0;
+    invalidateCaches();
+    if (points.isEmpty() || !pointBounds.contains(point)) {
+        // 包围盒变大时才需要通知场景更新索引
+        // 此时旧包围盒整体会被标记为需要重绘
+        prepareGeometryChange();
+        points.append(point);
+        segments.appendVertex(points);
+        pointBounds = segments.bounds();
+        return;
+    }
+    // 闭合折线的旧闭合边会被替换，也要重绘
+    QRectF dirty = isClosed_ ? segments.segmentBounds(points.size() - 1) : QRectF();
+    points.append(point);
+    segments.appendVertex(points);
+    // 只重绘新增线段和新的闭合边
+    for (int segment = points.size() - 2; segment < segments.segmentCount(); ++segment) {
+        const QRectF segmentRect = segments.segmentBounds(segment);
+        dirty = dirty.isNull() ? segmentRect : dirty.united(segmentRect);
     }
+    update(dirty.adjusted(-margin, -margin, margin, margin));
 }
 
+QVector<int> EditablePolylineItem::verticesInRect(const QRectF &localRect) const
+{
+    QVector<int> result;
+    if (points.size() == 1) {
+        if (localRect.contains(points.first())) {
+            result.append(0);
+        }
+        return result;
+    }
+    // 顶点 i 是线段 i-1 和 i 的端点，按升序去重（顶点 0 在框内时线段 0 必然命中）
+    for (int segment : segments.segmentsInRect(localRect)) {
+        const int end = segment + 1 < points.size() ? segment + 1 : 0;
+        for (int vertex : {segment, end}) {
+            if (localRect.contains(points[vertex]) && (result.isEmpty() || result.last() < vertex)) {
+                result.append(vertex);
+            }
+        }
+    }
+    return result;
+}
 
-QRectF EditablePolylineItem::boundingRect() const
+bool EditablePolylineItem::contains(const QPointF &point) const
 {
-    if (points.isEmpty()) return QRectF();
+    // 与 shape() 的描边宽度一致
+    return segments.nearestSegment(points, point, qMax<qreal>(linePen.widthF(), 1.0) / 2.0) >= 0;
+}
 
-    QPainterPath path;
-    if (!points.isEmpty()) {
-        path.moveTo(points.first());
-        for (int i = 1; i < points.size(); ++i) {
-            path.lineTo(points[i]);
-        }
-        if (isClosed_ && points.size() >= 3) { // 如果闭合且点数足够形成多边形
-            path.lineTo(points.first()); // 将路径闭合以正确计算边界
+bool EditablePolylineItem::collidesWithPath(const QPainterPath &path, Qt::ItemSelectionMode mode) const
+{
+    if (mode != Qt::IntersectsItemShape || !isAxisAlignedRect(path)) {
+        return QGraphicsItem::collidesWithPath(path, mode);
+    }
+    // 探测框按半个线宽外扩，近似描边与矩形求交
+    const qreal margin = qMax<qreal>(linePen.widthF(), 1.0) / 2.0;
+    const QRectF hitRect = path.boundingRect().adjusted(-margin, -margin, margin, margin);
+    for (int segment : segments.segmentsInRect(hitRect)) {
+        const QPointF &end = segment + 1 < points.size() ? points[segment + 1] : points.first();
+        if (HitTest::segmentIntersectsRect(points[segment], end, hitRect)) {
+            return true;
         }
     }
+    return false;
+}
 
-    // 为画笔宽度和可能的控制柄大小添加一些边距
+QRectF EditablePolylineItem::boundingRect() const
+{
+    if (points.isEmpty()) return QRectF();
+
+    // 闭合边不会超出顶点包围盒，只需加上画笔宽度
     qreal penWidth = linePen.widthF();
-    qreal margin = penWidth / 2.0 + 4.0; // 4.0 是一个大致的控制柄边距
-    return path.boundingRect().adjusted(-margin, -margin, margin, margin);
+    qreal margin = penWidth / 2.0; // 控制点由视图覆盖层绘制，不计入边界
+    return pointBounds.adjusted(-margin, -margin, margin, margin);
 }
 
-
-void EditablePolylineItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+QPainterPath EditablePolylineItem::shape() const
 {
-    Q_UNUSED(option);
-    Q_UNUSED(widget);
+    if (!shapeValid) {
+        QPainterPathStroker stroker;
+        stroker.setWidth(qMax<qreal>(linePen.widthF(), 1.0));
+        cachedShape = points.isEmpty() ? QPainterPath() : stroker.createStroke(path());
+        shapeValid = true;
+    }
+    return cachedShape;
+}
 
-    painter->setPen(linePen); // 设置画笔
-    if (points.size() >= 2) {
-        for (int i = 0; i < points.size() - 1; ++i) {
-            painter->drawLine(points[i], points[i + 1]);
-        }
-        // 如果折线是闭合的，并且有足够的点来形成一个闭合形状，则绘制连接最后一个点和第一个点的线
-        if (isClosed_ && points.size() >= 3) {
-            qDebug() << "Painting closing segment for polyline:" << this << "from" << points.last() << "to" << points.first();
-            painter->drawLine(points.last(), points.first());
+QPainterPath EditablePolylineItem::path() const
+{
+    if (!pathValid) {
+        QPainterPath linePath;
+        if (!points.isEmpty()) {
+            linePath.reserve(points.size() + 1);
+            linePath.moveTo(points.first());
+            for (int i = 1; i < points.size(); ++i) {
+                linePath.lineTo(points[i]);
+            }
+            if (isClosed_ && points.size() >= 3) {
+                linePath.closeSubpath();
+            }
         }
+        cachedPath = linePath;
+        pathValid = true;
     }
+    return cachedPath;
 }
 
-
-QVariant EditablePolylineItem::itemChange(GraphicsItemChange change, const QVariant &value)
+void EditablePolylineItem::invalidateCaches()
 {
-    if (change == ItemPositionHasChanged) {
-        updateHandlesPosition();
-    }
-    return QGraphicsItem::itemChange(change, value);
+    pathValid = false;
+    shapeValid = false;
+    simplifiedLevels.clear();
 }
 
-void EditablePolylineItem::createHandles()
+const QVector<QPointF> &EditablePolylineItem::pointsForLevelOfDetail(qreal levelOfDetail) const
 {
-    const qreal handleSize = 4.0;
-    const qreal handleRadius = handleSize / 2.0;
+    if (points.size() < SimplifyMinPoints || levelOfDetail <= 0.0) {
+        return points;
+    }
+    // 半个像素对应的本地距离，向下取整到 2 的幂作为缩放档位
+    const int band = qFloor(std::log2(SimplifyPixelTolerance / levelOfDetail));
+    auto it = simplifiedLevels.constFind(band);
+    if (it != simplifiedLevels.constEnd()) {
+        return it->isEmpty() ? points : *it;
+    }
+    // 找到已缓存的最近更细档位
+    auto finer = simplifiedLevels.lowerBound(band);
+    if (finer != simplifiedLevels.begin()) {
+        --finer;
+    } else {
+        finer = simplifiedLevels.end();
+    }
 
-    handles.clear();
-    for (int i = 0; i < points.size(); ++i) {
-        HandleItem *handle = new HandleItem(-handleRadius, -handleRadius, handleSize, handleSize, this);
-        handle->setPen(QPen(Qt::gray, 0));
-        handle->setBrush(Qt::gray);
-        handle->setFlag(QGraphicsItem::ItemIsMovable, true);
-        handle->setFlag(QGraphicsItem::ItemIgnoresTransformations, true);
-        handle->setVisible(false);
-        handle->setCursor(Qt::SizeAllCursor);
-        handles.append(handle);
+    // 从已有的最近更细档位继续简化，避免每次都扫描全部顶点
+    const QVector<QPointF> source = (finer != simplifiedLevels.end() && !finer->isEmpty()) ? *finer : points;
+    QVector<QPointF> simplified = simplifyRadial(source, std::ldexp(1.0, band));
+    if (simplified.size() > points.size() * 3 / 4) {
+        simplified.clear(); // 效果不明显，不额外占用内存
     }
+    qCDebug(lcItems) << "Polyline simplified for band" << band << ":" << points.size() << "->" << simplified.size();
+    auto inserted = simplifiedLevels.insert(band, simplified);
+    return inserted->isEmpty() ? points : *inserted;
 }
 
-void EditablePolylineItem::updateHandlesPosition()
+
+void EditablePolylineItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
 {
-    if (handles.size() != points.size()) {
-        // 如果顶点数量变化，重新创建控制端点
-        for (HandleItem* handle : handles) {
-            if (handle && handle->parentItem() == this) {
-                delete handle;
-            }
-        }
-        handles.clear();
-        createHandles();
+    Q_UNUSED(widget);
+    if (points.size() < 2) {
+        return;
+    }
+
+    const QPen pen = RenderQuality::effectivePen(linePen); // 交互期间虚线改为实线
+    painter->setPen(pen);
+    painter->setBrush(Qt::NoBrush);
+
+    // 缩小显示时使用对应档位的简化顶点
+    const qreal levelOfDetail = option->levelOfDetailFromTransform(painter->worldTransform());
+    const QVector<QPointF> &drawPoints = pointsForLevelOfDetail(levelOfDetail);
+    if (ClippedDash::applies(pen)) {
+        // 虚线按整条折线连续计算相位，但只为可见线段生成
+        ClippedDash::drawPolyline(painter, pen, drawPoints.constData(), drawPoints.size(), isClosed_ && points.size() >= 3,
+                                  ClippedDash::visibleRect(painter, option->exposedRect));
+        return;
+    }
+
+    const qreal margin = linePen.widthF() / 2.0;
+    const QRectF clip = option->exposedRect.adjusted(-margin, -margin, margin, margin);
+    if (clip.contains(pointBounds)) {
+        painter->drawPolyline(drawPoints.constData(), drawPoints.size());
+    } else if (&drawPoints == &points) {
+        // 原始顶点通过线段索引找到可见线段，不必逐段扫描
+        drawSegmentRuns(painter, points, segments.segmentsInRect(clip));
+    } else {
+        drawClippedPolyline(painter, drawPoints.constData(), drawPoints.size(), clip);
     }
 
-    for (int i = 0; i < points.size(); ++i) {
-        handles[i]->setPos(points[i]);
+    // 如果折线是闭合的，并且有足够的点来形成一个闭合形状，则绘制连接最后一个点和第一个点的线
+    if (isClosed_ && points.size() >= 3) {
+        painter->drawLine(drawPoints.last(), drawPoints.first());
     }
 }
 
@@ -153,7 +354,9 @@ void EditablePolylineItem::setClosed(bool closed)
     if (isClosed_ == closed) return; // 如果状态未改变，则不执行任何操作
 
     isClosed_ = closed;
-    qDebug() << "Polyline " << this << " set to " << (isClosed_ ? "closed" : "open");
+    segments.build(points, isClosed_);
+    invalidateCaches();
+    qCDebug(lcItems) << "Polyline " << this << " set to " << (isClosed_ ? "closed" : "open");
 
     // 因为 boundingRect 的计算依赖于 isClosed_，所以需要调用 prepareGeometryChange
     prepareGeometryChange();
@@ -5,17 +5,22 @@
 #include <QVector>
 #include <QPointF>
 #include <QVariant>
-#include "handle_item.h"
 #include <QPen>
+#include <QMap>
+#include <QPainterPath>
+#include "segment_index.h"
 class EditablePolylineItem : public QGraphicsItem
 {
 public:
+    enum { Type = UserType + 2 }; // 自定义类型，便于 qgraphicsitem_cast 和按类型分派
+    int type() const override { return Type; }
+
     EditablePolylineItem(const QVector<QPointF>& points, QGraphicsItem *parent = nullptr);
-    ~EditablePolylineItem();
 
     void updatePoint(int index, const QPointF& newPoint);
-    void setSelectedState(bool selected); // 设置选中状态，控制端点可见性
-    QVector<HandleItem*> getHandles() const { return handles; }
+    void appendPoint(const QPointF& point); // 追加顶点（本地坐标），只重绘新增线段
+    QVector<QPointF> getPoints() const { return points; } // 顶点（本地坐标），也是控制点位置
+    int pointCount() const { return points.size(); }
     virtual EditablePolylineItem* clone() const;
     bool isClosed() const { return isClosed_; } // 获取闭合状态
     void setClosed(bool closed); //设置闭合状态
@@ -23,18 +28,36 @@ public:
     void setPen(const QPen &pen); //设置画笔
     // QGraphicsItem 接口实现
     QRectF boundingRect() const override;
+    QPainterPath shape() const override; // 按描边形状拾取，而不是包围盒（缓存）
+    QPainterPath path() const; // 折线路径（本地坐标，缓存）
+    // 点拾取和轴对齐矩形求交走线段索引，不构造整条描边路径
+    bool contains(const QPointF &point) const override;
+    bool collidesWithPath(const QPainterPath &path, Qt::ItemSelectionMode mode = Qt::IntersectsItemShape) const override;
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget) override;
 
+    // 本地坐标下距离不超过 maxDistance 的最近顶点/线段，没有时返回 -1（O(log n)）
+    int nearestVertex(const QPointF &localPos, qreal maxDistance) const { return segments.nearestVertex(points, localPos, maxDistance); }
+    int nearestSegment(const QPointF &localPos, qreal maxDistance) const { return segments.nearestSegment(points, localPos, maxDistance); }
+    QVector<int> verticesInRect(const QRectF &localRect) const; // 升序
 
-protected:
-    QVariant itemChange(GraphicsItemChange change, const QVariant &value) override;
+    static constexpr int SimplifyMinPoints = 512;       // 顶点少于该数量时不做简化
+    static constexpr qreal SimplifyPixelTolerance = 0.5; // 简化误差上限（像素）
 
 private:
-    void createHandles();
-    void updateHandlesPosition();
+    void invalidateCaches(); // 顶点、闭合状态或画笔变化后调用
+    const QVector<QPointF> &pointsForLevelOfDetail(qreal levelOfDetail) const;
 
     QVector<QPointF> points; // 折线的顶点列表
-    QVector<HandleItem*> handles; // 每个顶点的控制端点
+    SegmentIndex segments; // 线段包围盒树，随顶点增量维护
+    QRectF pointBounds; // 顶点的包围盒（不含画笔宽度），与场景索引中的包围盒一致
+
+    mutable QPainterPath cachedPath;
+    mutable QPainterPath cachedShape;
+    mutable bool pathValid = false;
+    mutable bool shapeValid = false;
+    // 各缩放档位的简化顶点，键为容差（本地坐标）以 2 为底的指数；
+    // 空数组表示该档位简化效果不明显，直接使用原始顶点
+    mutable QMap<int, QVector<QPointF>> simplifiedLevels;
     QPen linePen; // 折线的画笔样式
     bool isClosed_ = false; // 新增：折线是否闭合
 
@@ -1,4 +1,5 @@
 #include "graph_manager.h"
+#include "logging_categories.h"
 
 GraphManager::GraphManager(QWidget *parent)
     : QMainWindow{parent}
@@ -74,13 +75,13 @@ void GraphManager::addChildItem(QTreeWidgetItem *parentItem) {
 
 void GraphManager::editItem(QTreeWidgetItem *item) {
     if (!item) {
-        qDebug() << "Edit failed: No item provided";
+        qCWarning(lcManager) << "Edit failed: No item provided";
         return;
     }
     // Ensure the item is editable
     if (!(item->flags() & Qt::ItemIsEditable)) {
         item->setFlags(item->flags() | Qt::ItemIsEditable);
-        qDebug() << "Set item editable for:" << item->text(0);
+        qCDebug(lcManager) << "Set item editable for:" << item->text(0);
     }
     treeWidget->setFocus();
     treeWidget->setCurrentItem(item);
@@ -142,9 +143,9 @@ void GraphManager::saveTreeToFile() {
     if (file.open(QIODevice::WriteOnly)) {
         file.write(doc.toJson());
         file.close();
-        qDebug() << "树数据已保存到：" << getSaveFilePath();
+        qCDebug(lcManager) << "树数据已保存到：" << getSaveFilePath();
     } else {
-        qDebug() << "无法保存树数据：" << file.errorString();
+        qCWarning(lcManager) << "无法保存树数据：" << file.errorString();
     }
 }
 
@@ -162,7 +163,7 @@ QJsonObject GraphManager::itemToJson(QTreeWidgetItem *item) const {
 void GraphManager::loadTreeFromFile() {
     QFile file(getSaveFilePath());
     if (!file.exists() || file.size() == 0) {
-        qDebug() << "无保存数据，初始化默认树：" << getSaveFilePath();
+        qCDebug(lcManager) << "无保存数据，初始化默认树：" << getSaveFilePath();
         initializeDefaultTree();
         return;
     }
@@ -178,9 +179,9 @@ void GraphManager::loadTreeFromFile() {
             QTreeWidgetItem *item = jsonToItem(value.toObject());
             treeWidget->addTopLevelItem(item);
         }
-        qDebug() << "树数据已加载从：" << getSaveFilePath();
+        qCDebug(lcManager) << "树数据已加载从：" << getSaveFilePath();
     } else {
-        qDebug() << "无法加载树数据：" << file.errorString();
+        qCWarning(lcManager) << "无法加载树数据：" << file.errorString();
         initializeDefaultTree(); // 加载失败时也初始化默认树
     }
 }
@@ -1,20 +1,30 @@
 #include "graphics_tool_view.h"
 #include "editable_line_item.h"
 #include "custom_rect_item.h"
+#include "arc_item.h"
+#include "bulk_primitive_item.h"
+#include "baked_layer_item.h"
+#include "image_store.h"
+#include "hit_test_kernels.h"
+#include "scene_transaction.h"
+#include "scene_item_events.h"
+#include "render_quality.h"
+#include "logging_categories.h"
 
 #include <QMouseEvent>
 #include <QKeyEvent>
+#include <QPaintEvent>
+#include <QPainter>
 #include <QApplication>
 #include <QCursor>
 #include <QGraphicsItem>
 #include <QPainterPath>
+#include <QtMath>
 
 GraphicsToolView::GraphicsToolView(QGraphicsScene *scene, QWidget *parent)
     : QGraphicsView(scene, parent),
     isDraggingSelectionGroup(false),
     isDragging(false),
-    previewLine(nullptr),
-    draggedHandle(nullptr),
     draggedItem(nullptr),
     isShiftPressed(false),
     isCtrlPressedForCopy(false),
@@ -26,14 +36,33 @@ GraphicsToolView::GraphicsToolView(QGraphicsScene *scene, QWidget *parent)
     rubberBand(nullptr), // 初始化 rubberBand
     isSelectingWithRubberBand(false), // 初始化 isSelectingWithRubberBand
     closePolylineOnFinish(false),
-    previewClosingSegment(nullptr),
-    previewRect(nullptr),
     currentArcState(ArcDrawingState::DefineCenter),
-    previewArc(nullptr),
-    previewPolygon(nullptr),
-    drawingFillColor(Qt::transparent)
+    drawingFillColor(Qt::transparent),
+    previewLayer(this),
+    selectionOverlay(this, &selection),
+    moveSession(this, &selection),
+    pickingEngine(this, &selectionOverlay)
 {
-    setRenderHint(QPainter::Antialiasing); // 设置抗锯齿
+    setRenderHints(QPainter::Antialiasing | QPainter::SmoothPixmapTransform); // 完整质量，交互期间临时降低
+    qualityRestoreTimer = new QTimer(this);
+    qualityRestoreTimer->setSingleShot(true);
+    qualityRestoreTimer->setInterval(RenderQuality::IdleRestoreMs);
+    connect(qualityRestoreTimer, &QTimer::timeout, this, &GraphicsToolView::restoreFullQuality);
+    // 高频输入按显示帧合并后再处理
+    inputCoalescer = new InputCoalescer(this);
+    connect(inputCoalescer, &InputCoalescer::moveFrame, this,
+            [this](const QPointF &localPos, const QPointF &globalPos, Qt::MouseButtons buttons, Qt::KeyboardModifiers modifiers) {
+        QMouseEvent coalesced(QEvent::MouseMove, localPos, globalPos, Qt::NoButton, buttons, modifiers);
+        processMouseMove(&coalesced);
+    });
+    connect(inputCoalescer, &InputCoalescer::wheelFrame, this, &GraphicsToolView::applyWheelZoom);
+    tileCache = new TileRenderCache(this);
+    tileCache->setEnabled(true);
+    itemCachePolicy = new ItemCachePolicy(this);
+    // 控制点画在前景中，选择变化时需要重绘视口
+    connect(&selection, &SelectionModel::selectionChanged, this, [this]() {
+        viewport()->update();
+    });
 }
 
 // 显示颜色选择器
@@ -51,14 +80,14 @@ void GraphicsToolView::showColorSelector()
 void GraphicsToolView::onColorSelected(const QColor &color)
 {
     setDrawingColor(color);
-    qDebug() << "Color selected:" << color.name();
+    qCDebug(lcView) << "Color selected:" << color.name();
 }
 
 void GraphicsToolView::setDrawingMode(DrawingMode mode)
 {
-    qDebug() << "Mode set to:" << static_cast<int>(mode);
+    qCDebug(lcView) << "Mode set to:" << static_cast<int>(mode);
     if (currentMode == DrawingMode::Polyline && isDrawingPolyline) {
-        qDebug() << "Switching mode, finishing polyline.";
+        qCDebug(lcView) << "Switching mode, finishing polyline.";
         finishPolyline();
     }
     currentMode = mode;
@@ -72,38 +101,38 @@ void GraphicsToolView::setDrawingMode(DrawingMode mode)
     case DrawingMode::Polygon:
         setCursor(Qt::CrossCursor);
         setMouseTracking(true);
-        qDebug() << "Entering Polygon mode.";
+        qCDebug(lcView) << "Entering Polygon mode.";
         break;
     case DrawingMode::Text:
         setCursor(Qt::IBeamCursor);
         setMouseTracking(false);
-        qDebug() << "Entering Text mode.";
+        qCDebug(lcView) << "Entering Text mode.";
         break;
     case DrawingMode::Ellipse:
         setCursor(Qt::CrossCursor);
         setMouseTracking(true);
-        qDebug() << "Entering Ellipse mode.";
+        qCDebug(lcView) << "Entering Ellipse mode.";
         break;
     case DrawingMode::Rectangle:
         setCursor(Qt::CrossCursor);
         setMouseTracking(true);
-        qDebug() << "Entering Rectangle mode.";
+        qCDebug(lcView) << "Entering Rectangle mode.";
         break;
     case DrawingMode::Line:
         setCursor(Qt::CrossCursor);
         setMouseTracking(true);
-        qDebug() << "Entering Line mode.";
+        qCDebug(lcView) << "Entering Line mode.";
         break;
     case DrawingMode::Polyline:
         setCursor(Qt::CrossCursor);
         setMouseTracking(true);
-        qDebug() << "Entering Polyline mode.";
+        qCDebug(lcView) << "Entering Polyline mode.";
         break;
     case DrawingMode::Arc:
         setCursor(Qt::CrossCursor);
         setMouseTracking(true);
         currentArcState = ArcDrawingState::DefineCenter;
-        qDebug() << "Entering Arc mode.";
+        qCDebug(lcView) << "Entering Arc mode.";
         break;
     default:
         setCursor(Qt::ArrowCursor);
@@ -114,15 +143,20 @@ void GraphicsToolView::setDrawingMode(DrawingMode mode)
 
 void GraphicsToolView::mousePressEvent(QMouseEvent *event)
 {
-    qDebug() << "Mouse pressed:" << event->button();
+    qCDebug(lcView) << "Mouse pressed:" << event->button();
+    inputCoalescer->flush(); // 先处理尚未分发的移动，保证事件顺序
     bool isCtrlPressed = event->modifiers() & Qt::ControlModifier;
     if (currentMode == DrawingMode::None) {
-        qDebug() << "None mode press.";
-        QPointF scenePos = mapToScene(event->pos());
-        QGraphicsItem *itemUnderMouse = scene()->itemAt(scenePos, transform());
-        bool handleHit = checkHandleHit(scenePos); // 检查是否点中控制点
+        qCDebug(lcView) << "None mode press.";
+        // 只拾取一次，框选判断和 None 模式处理共用同一结果
+        PickResult pick = pickingEngine.pick(event->pos(), selection);
+        if (BakedLayerItem *layer = pick.item ? qgraphicsitem_cast<BakedLayerItem*>(pick.item) : nullptr) {
+            // 点中烘焙内容即开始编辑：先解冻该图层，再对还原的图元重新拾取
+            unbakeLayer(layer);
+            pick = pickingEngine.pick(event->pos(), selection);
+        }
 
-        if (event->button() == Qt::LeftButton && !itemUnderMouse && !handleHit) { // 只有在没有点中item且没有点中handle时才开始框选
+        if (event->button() == Qt::LeftButton && pick.isNull()) { // 只有在没有点中item且没有点中handle时才开始框选
             isSelectingWithRubberBand = true;
             rubberBandOrigin = event->pos();
             if (!rubberBand) {
@@ -130,18 +164,20 @@ void GraphicsToolView::mousePressEvent(QMouseEvent *event)
             }
             rubberBand->setGeometry(QRect(rubberBandOrigin, QSize()));
             rubberBand->show();
-            qDebug() << "Starting rubber band selection, origin:" << rubberBandOrigin;
+            qCDebug(lcView) << "Starting rubber band selection, origin:" << rubberBandOrigin;
             event->accept(); // 事件已处理
             return; // 开始框选，不继续执行下面的 handleNoneModePress
         }
         // 如果不是开始框选，则执行原有的None模式处理
-        handleNoneModePress(event);
+        // 选择和拖动都由视图自己处理，不再交给基类重复做一次命中测试
+        handleNoneModePress(event, pick);
+        return;
     } else if (currentMode == DrawingMode::Line) {
-        qDebug() << "Line mode press.";
+        qCDebug(lcView) << "Line mode press.";
         handleLineModePress(event);
     } else if (currentMode == DrawingMode::Polyline) {
         if (event->button() == Qt::LeftButton) {
-            qDebug() << "Polyline mode left button press.";
+            qCDebug(lcView) << "Polyline mode left button press.";
             handlePolylineModePress(event);
         }
     } else if (currentMode == DrawingMode::Rectangle) {
@@ -165,11 +201,27 @@ void GraphicsToolView::mousePressEvent(QMouseEvent *event)
 
 void GraphicsToolView::mouseMoveEvent(QMouseEvent *event)
 {
-    QPointF scenePos = mapToScene(event->pos());
-    updateCursorBasedOnPosition(scenePos);
+    // 只记录位置，实际处理在下一帧进行（取最新位置）
+    inputCoalescer->pushMove(event);
+    event->accept();
+}
+
+void GraphicsToolView::processMouseMove(QMouseEvent *event)
+{
+    // 拖动、框选和绘制过程中使用交互渲染模式
+    const bool drawingInProgress = isDragging || isDrawingPolyline
+        || (currentMode == DrawingMode::Arc && currentArcState != ArcDrawingState::DefineCenter);
+    if (event->buttons() != Qt::NoButton || drawingInProgress) {
+        beginInteractiveRender();
+    }
+
+    if (currentMode == DrawingMode::None && draggedHandleRole == HandleRole::None && !isDraggingSelectionGroup && !isSelectingWithRubberBand) {
+        updateCursorBasedOnPosition(pickingEngine.pick(event->pos(), selection));
+    }
 
     if (isSelectingWithRubberBand && rubberBand) {
         rubberBand->setGeometry(QRect(rubberBandOrigin, event->pos()).normalized());
+        updateRubberBandPreview();
         event->accept();
         return; // 框选时，不执行其他移动逻辑
     }
@@ -178,9 +230,9 @@ void GraphicsToolView::mouseMoveEvent(QMouseEvent *event)
         handleLineModeMove(event);
     } else if (currentMode == DrawingMode::Polyline && isDrawingPolyline && isDragging) {
         handlePolylineModeMove(event);
-    } else if (currentMode == DrawingMode::None && draggedHandle && draggedItem) {
+    } else if (currentMode == DrawingMode::None && draggedHandleRole != HandleRole::None && draggedItem) {
         handleHandleMove(event);
-    } else if (currentMode == DrawingMode::None && isDraggingSelectionGroup && !selectedItems.isEmpty()) {
+    } else if (currentMode == DrawingMode::None && isDraggingSelectionGroup && !selection.isEmpty()) {
         handleGroupMove(event);
     }else if (currentMode == DrawingMode::Rectangle) {
         handleRectangleModeMove(event);
@@ -197,36 +249,29 @@ void GraphicsToolView::mouseMoveEvent(QMouseEvent *event)
 
 void GraphicsToolView::mouseReleaseEvent(QMouseEvent *event)
 {
-    qDebug() << "Mouse released.";
+    qCDebug(lcView) << "Mouse released.";
+    inputCoalescer->flush(); // 释放前先应用最后的移动位置
     if (isSelectingWithRubberBand && rubberBand && event->button() == Qt::LeftButton) {
         rubberBand->hide();
         QRect selectionRectView = rubberBand->geometry();
         QRectF selectionRectScene = mapToScene(selectionRectView).boundingRect();
 
-        qDebug() << "Rubber band selection ended, selection rect (view):" << selectionRectView;
-        qDebug() << "Rubber band selection ended, selection rect (scene):" << selectionRectScene;
+        qCDebug(lcView) << "Rubber band selection ended, selection rect (view):" << selectionRectView;
+        qCDebug(lcView) << "Rubber band selection ended, selection rect (scene):" << selectionRectScene;
 
         bool isMultiSelect = event->modifiers() & Qt::ControlModifier;
+        selection.beginGesture(); // 整次框选只发出一次选择变化通知
         if (!isMultiSelect) {
             cleanupSelection(); // 非多选（Ctrl）时，先清空之前的选择
         }
 
-        QList<QGraphicsItem*> itemsInRect = scene()->items(selectionRectScene, Qt::IntersectsItemShape);
-        for (QGraphicsItem *item : itemsInRect) {
-            if (dynamic_cast<EditableLineItem*>(item) || dynamic_cast<EditablePolylineItem*>(item) ||
-                dynamic_cast<QGraphicsRectItem*>(item) || dynamic_cast<QGraphicsEllipseItem*>(item) ||
-                dynamic_cast<QGraphicsPathItem*>(item) || dynamic_cast<QGraphicsPolygonItem*>(item) ||
-                dynamic_cast<QGraphicsTextItem*>(item)) { // 只选择我们可操作的图形类型
-                if (!selectedItems.contains(item)) {
-                    selectedItems.append(item);
-                    if (EditableLineItem* el = dynamic_cast<EditableLineItem*>(item)) el->setSelectedState(true);
-                    else if (EditablePolylineItem* ep = dynamic_cast<EditablePolylineItem*>(item)) ep->setSelectedState(true);
-                    // 对于其他类型的 QGraphicsItem，它们没有 setSelectedState，选中状态由QGraphicsView管理
-                    else item->setSelected(true);
-                }
-            }
-        }
-        qDebug() << "Rubber band selected " << selectedItems.count() << " items.";
+        // 只选择我们可操作的图形类型
+        selection.addItems(HitTest::itemsInRect(scene(), selectionRectScene, &SelectionModel::isSelectableType));
+        selection.endGesture();
+        qCDebug(lcView) << "Rubber band selected " << selection.size() << " items.";
+
+        rubberBandPreview.clear();
+        viewport()->update();
 
         isSelectingWithRubberBand = false;
         event->accept(); // 事件已处理
@@ -235,7 +280,7 @@ void GraphicsToolView::mouseReleaseEvent(QMouseEvent *event)
 
     if (currentMode == DrawingMode::Line && !startPoint.isNull() && isDragging) {
         // 直线模式释放处理
-    } else if (currentMode == DrawingMode::None && draggedHandle) {
+    } else if (currentMode == DrawingMode::None && draggedHandleRole != HandleRole::None) {
         handleHandleRelease();
     } else if (currentMode == DrawingMode::None && isDraggingSelectionGroup) {
         handleGroupRelease();
@@ -254,42 +299,59 @@ void GraphicsToolView::mouseReleaseEvent(QMouseEvent *event)
 
 void GraphicsToolView::mouseDoubleClickEvent(QMouseEvent *event)
 {
-    qDebug() << "Double click event button:" << event->button() << "mode:" << static_cast<int>(currentMode) << "isPolylineDrawing:" << isDrawingPolyline;
+    inputCoalescer->flush();
+    qCDebug(lcView) << "Double click event button:" << event->button() << "mode:" << static_cast<int>(currentMode) << "isPolylineDrawing:" << isDrawingPolyline;
     if (event->button() == Qt::LeftButton && currentMode == DrawingMode::Polyline && isDrawingPolyline) {
-        qDebug() << "Polyline double click: Finishing draw.";
+        qCDebug(lcView) << "Polyline double click: Finishing draw.";
         finishPolyline();
         event->accept();
     } else if (event->button() == Qt::LeftButton && currentMode == DrawingMode::Polygon && isDrawingPolyline) {
-        qDebug() << "Polygon double click: Finishing draw.";
+        qCDebug(lcView) << "Polygon double click: Finishing draw.";
         finishPolygon();
         event->accept();
+    } else if (event->button() == Qt::LeftButton && currentMode == DrawingMode::None && unpackPrimitiveAt(event->pos())) {
+        event->accept();
     } else {
-        qDebug() << "Non-polyline/polygon double click, passing to base class.";
+        qCDebug(lcView) << "Non-polyline/polygon double click, passing to base class.";
         QGraphicsView::mouseDoubleClickEvent(event);
     }
 }
 
 void GraphicsToolView::wheelEvent(QWheelEvent *event)
 {
-    const qreal delta = event->angleDelta().y();
-    qreal scaleFactor = 1.15;
-    if (delta > 0) {
-        scale(scaleFactor, scaleFactor);
-    } else {
-        scale(1.0 / scaleFactor, 1.0 / scaleFactor);
+    // 滚轮增量在一帧内累加，之后统一缩放一次
+    inputCoalescer->pushWheel(event);
+    event->accept();
+}
+
+void GraphicsToolView::applyWheelZoom(qreal angleDelta, const QPointF &anchorPos)
+{
+    // 每个标准滚轮刻度（120）缩放 1.15 倍，高精度增量按比例得到平滑缩放
+    const qreal scaleFactor = qPow(1.15, angleDelta / 120.0);
+    if (qFuzzyCompare(scaleFactor, 1.0)) {
+        return;
     }
+    beginInteractiveRender();
+    // 缩放后把光标下的场景点移回光标位置
+    const ViewportAnchor oldAnchor = transformationAnchor();
+    setTransformationAnchor(QGraphicsView::NoAnchor);
+    const QPointF sceneAnchor = mapToScene(anchorPos.toPoint());
+    scale(scaleFactor, scaleFactor);
+    const QPointF shifted = mapToScene(anchorPos.toPoint()) - sceneAnchor;
+    translate(shifted.x(), shifted.y());
+    setTransformationAnchor(oldAnchor);
 }
 
 void GraphicsToolView::keyPressEvent(QKeyEvent *event)
 {
-    qDebug() << "Key press event:" << event->key();
+    qCDebug(lcView) << "Key press event:" << event->key();
     if (event->key() == Qt::Key_Escape) {
         if (currentMode != DrawingMode::None || isDrawingPolyline) {
-            qDebug() << "Esc to cancel drawing.";
+            qCDebug(lcView) << "Esc to cancel drawing.";
             cleanupDrawing();
             setDrawingMode(DrawingMode::None);
-        } else if (!selectedItems.isEmpty()) {
-            qDebug() << "Esc to clear selection.";
+        } else if (!selection.isEmpty()) {
+            qCDebug(lcView) << "Esc to clear selection.";
             cleanupSelection();
         }
         event->accept();
@@ -298,16 +360,16 @@ void GraphicsToolView::keyPressEvent(QKeyEvent *event)
     if (event->key() == Qt::Key_Shift) {
         if (currentMode == DrawingMode::Line) {
             isShiftPressed = true;
-            qDebug() << "Shift restricts line direction.";
+            qCDebug(lcView) << "Shift restricts line direction.";
         }
     } else if (event->key() == Qt::Key_C) {
         if (currentMode == DrawingMode::Polyline && isDrawingPolyline) {
-            qDebug() << "C attempts to close polyline.";
+            qCDebug(lcView) << "C attempts to close polyline.";
             if (polylinePoints.size() >= 2) {
                 closePolylineOnFinish = true;
                 finishPolyline();
             } else {
-                qDebug() << "Not enough points to close.";
+                qCDebug(lcView) << "Not enough points to close.";
                 closePolylineOnFinish = false;
                 finishPolyline();
             }
@@ -316,20 +378,117 @@ void GraphicsToolView::keyPressEvent(QKeyEvent *event)
         }
     }
     if(event->key() == Qt::Key_Delete){
-        qDebug()<<"Delete key pressed"<<Qt::endl;
+        qCDebug(lcView)<<"Delete key pressed"<<Qt::endl;
     }
     if (!event->isAccepted()) {
         QGraphicsView::keyPressEvent(event);
     }
 }
 
+// 框选过程中实时计算将被选中的项
+void GraphicsToolView::updateRubberBandPreview()
+{
+    if (!rubberBand || !scene()) {
+        return;
+    }
+    QRectF selectionRectScene = mapToScene(rubberBand->geometry()).boundingRect();
+    rubberBandPreview = HitTest::itemsInRect(scene(), selectionRectScene, &SelectionModel::isSelectableType);
+    viewport()->update();
+}
+
+void GraphicsToolView::drawForeground(QPainter *painter, const QRectF &rect)
+{
+    QGraphicsView::drawForeground(painter, rect);
+
+    // 高亮框选将要选中的项
+    if (!rubberBandPreview.isEmpty()) {
+        painter->save();
+        painter->setPen(QPen(QColor(0, 120, 215), 0, Qt::DashLine)); // 0 宽度为装饰画笔，不随缩放变化
+        painter->setBrush(Qt::NoBrush);
+        for (QGraphicsItem *item : std::as_const(rubberBandPreview)) {
+            const QRectF itemRect = item->sceneBoundingRect();
+            if (itemRect.intersects(rect)) {
+                painter->drawRect(itemRect);
+            }
+        }
+        painter->restore();
+    }
+
+    previewLayer.paint(painter, rect); // 绘制过程中的预览图形
+
+    // 拖动会话中选中项尚未移动，拖动位图和控制点按未提交的偏移绘制
+    moveSession.paint(painter, rect);
+    const QPointF pendingOffset = moveSession.pendingOffset();
+    if (pendingOffset.isNull()) {
+        selectionOverlay.paint(painter, rect);
+    } else {
+        painter->save();
+        painter->translate(pendingOffset);
+        selectionOverlay.paint(painter, rect.translated(-pendingOffset));
+        painter->restore();
+    }
+}
+
+void GraphicsToolView::scrollContentsBy(int dx, int dy)
+{
+    beginInteractiveRender(); // 平移视图
+    tileCache->notePan(dx, dy);
+    QGraphicsView::scrollContentsBy(dx, dy);
+}
+
+void GraphicsToolView::paintEvent(QPaintEvent *event)
+{
+    if (!tileCache->canRender()) {
+        QGraphicsView::paintEvent(event);
+        itemCachePolicy->notePainted(); // 直接绘制场景，稍后按可见图元调整缓存
+        return;
+    }
+    // 场景内容来自瓦片缓存，背景和前景照常绘制
+    QPainter painter(viewport());
+    painter.setRenderHints(renderHints());
+    painter.setClipRegion(event->region());
+    const QRectF exposedSceneRect = viewportTransform().inverted().mapRect(QRectF(event->rect()));
+    painter.setWorldTransform(viewportTransform());
+    drawBackground(&painter, exposedSceneRect);
+    painter.resetTransform();
+    tileCache->paint(&painter, event->region());
+    painter.setWorldTransform(viewportTransform());
+    drawForeground(&painter, exposedSceneRect);
+}
+
+void GraphicsToolView::setTileCacheEnabled(bool enabled)
+{
+    tileCache->setEnabled(enabled);
+    if (enabled) {
+        itemCachePolicy->clear(); // 瓦片缓存回放的是图元快照，图元自身的缓存用不上
+    }
+}
+
+void GraphicsToolView::beginInteractiveRender()
+{
+    if (!RenderQuality::isInteractive()) {
+        RenderQuality::setInteractive(true);
+        setRenderHints(QPainter::RenderHints()); // 关闭抗锯齿和平滑缩放
+        qCDebug(lcView) << "Interactive render mode on.";
+    }
+    qualityRestoreTimer->start(); // 每次交互都重新计时
+}
+
+void GraphicsToolView::restoreFullQuality()
+{
+    RenderQuality::setInteractive(false);
+    setRenderHints(QPainter::Antialiasing | QPainter::SmoothPixmapTransform); // 同时会整体重绘视口
+    itemCachePolicy->invalidateCaches(); // 交互期间重新生成的缓存位图没有抗锯齿、虚线画成了实线
+    qCDebug(lcView) << "Interactive render mode off, full quality restored.";
+}
+
 void GraphicsToolView::keyReleaseEvent(QKeyEvent *event)
 {
     if (event->key() == Qt::Key_Shift) {
         isShiftPressed = false;
-        qDebug() << "Release Shift, no line direction restriction.";
-        if (currentMode == DrawingMode::Polyline && previewLine && !polylinePoints.isEmpty()) {
-            updatePolylinePreview(previewLine->line().p2());
+        qCDebug(lcView) << "Release Shift, no line direction restriction.";
+        if (currentMode == DrawingMode::Polyline && isDrawingPolyline && !polylinePoints.isEmpty()) {
+            updatePolylinePreview(mapToScene(mapFromGlobal(QCursor::pos())));
         }
     }
     QGraphicsView::keyReleaseEvent(event);
@@ -337,47 +496,39 @@ void GraphicsToolView::keyReleaseEvent(QKeyEvent *event)
 
 void GraphicsToolView::finishPolyline()
 {
-    qDebug() << "Finishing polyline drawing, isDrawing:" << isDrawingPolyline << "points:" << polylinePoints.size();
+    qCDebug(lcView) << "Finishing polyline drawing, isDrawing:" << isDrawingPolyline << "points:" << polylinePoints.size();
     if (isDrawingPolyline) {
         if (currentPolyline && polylinePoints.size() >= 2) {
-            qDebug() << "Polyline drawing complete, points:" << polylinePoints.size();
+            qCDebug(lcView) << "Polyline drawing complete, points:" << polylinePoints.size();
             if (closePolylineOnFinish && polylinePoints.size() >= 3) {
                 currentPolyline->setClosed(true);
-                qDebug() << "Polyline set to closed.";
+                qCDebug(lcView) << "Polyline set to closed.";
             } else {
                 currentPolyline->setClosed(false);
-                qDebug() << "Polyline set to open.";
+                qCDebug(lcView) << "Polyline set to open.";
             }
             currentPolyline = nullptr;
         } else if (currentPolyline) {
-            qDebug() << "Not enough polyline points, discarding.";
-            scene()->removeItem(currentPolyline);
+            qCDebug(lcView) << "Not enough polyline points, discarding.";
+            SceneItemEvents::removeItem(scene(), currentPolyline);
             delete currentPolyline;
             currentPolyline = nullptr;
         } else {
-            qDebug() << "No polyline or not enough points.";
+            qCDebug(lcView) << "No polyline or not enough points.";
         }
 
         polylinePoints.clear();
         isDrawingPolyline = false;
         isDragging = false;
 
-        if (previewLine) {
-            scene()->removeItem(previewLine);
-            delete previewLine;
-            previewLine = nullptr;
-        }
-        if (previewClosingSegment) {
-            scene()->removeItem(previewClosingSegment);
-            delete previewClosingSegment;
-            previewClosingSegment = nullptr;
-        }
+        previewLayer.clear(PreviewLayer::SegmentSlot);
+        previewLayer.clear(PreviewLayer::ClosingSlot);
         closePolylineOnFinish = false;
 
-        qDebug() << "Polyline drawing finished, resetting to None mode.";
+        qCDebug(lcView) << "Polyline drawing finished, resetting to None mode.";
         setDrawingMode(DrawingMode::None);
     } else {
-        qDebug() << "Not in polyline drawing mode.";
+        qCDebug(lcView) << "Not in polyline drawing mode.";
     }
 }
 
@@ -397,52 +548,29 @@ void GraphicsToolView::handlePolylineModePress(QMouseEvent *event)
     if (!isDrawingPolyline) {
         polylinePoints.clear();
         if (currentPolyline) {
-            scene()->removeItem(currentPolyline);
+            SceneItemEvents::removeItem(scene(), currentPolyline);
             delete currentPolyline;
             currentPolyline = nullptr;
         }
-        if (previewLine) {
-            scene()->removeItem(previewLine);
-            delete previewLine;
-            previewLine = nullptr;
-        }
         polylinePoints.append(scenePos);
         isDrawingPolyline = true;
         isDragging = true;
-        qDebug() << "Starting new polyline at:" << scenePos;
-    } else {
-        if (polylinePoints.isEmpty() || polylinePoints.last() != scenePos) {
-            polylinePoints.append(scenePos);
-            qDebug() << "Adding polyline point at:" << scenePos;
-        }
-        if (polylinePoints.size() >= 2) {
-            if (currentPolyline) {
-                scene()->removeItem(currentPolyline);
-                delete currentPolyline;
-                currentPolyline = nullptr;
-            }
+        qCDebug(lcView) << "Starting new polyline at:" << scenePos;
+    } else if (polylinePoints.isEmpty() || polylinePoints.last() != scenePos) {
+        polylinePoints.append(scenePos);
+        qCDebug(lcView) << "Adding polyline point at:" << scenePos;
+        if (currentPolyline) {
+            // 增量追加顶点，不再每次点击都重建整条折线
+            currentPolyline->appendPoint(currentPolyline->mapFromScene(scenePos));
+        } else if (polylinePoints.size() >= 2) {
             currentPolyline = new EditablePolylineItem(polylinePoints);
-            QPen pen = currentPolyline->pen();
-            pen.setColor(drawingColor);
-            pen.setWidth(drawingPenWidth);
-            pen.setStyle(Qt::PenStyle(drawingLineStyle));
-            currentPolyline->setPen(pen);
+            currentPolyline->setPen(drawingPen());
             scene()->addItem(currentPolyline);
-            qDebug() << "Updating polyline, points:" << polylinePoints.size();
         }
+        qCDebug(lcView) << "Updating polyline, points:" << polylinePoints.size();
     }
     if (isDrawingPolyline && !polylinePoints.isEmpty()) {
-        if (previewLine) {
-            scene()->removeItem(previewLine);
-            delete previewLine;
-        }
-        previewLine = new EditableLineItem(polylinePoints.last(), scenePos);
-        QPen pen = previewLine->pen();
-        pen.setColor(drawingColor);
-        pen.setStyle(Qt::PenStyle(drawingLineStyle));
-        pen.setWidth(drawingPenWidth);
-        previewLine->setPen(pen);
-        scene()->addItem(previewLine);
+        previewLayer.setLine(PreviewLayer::SegmentSlot, QLineF(polylinePoints.last(), scenePos), drawingPen());
     }
 }
 
@@ -476,189 +604,98 @@ void GraphicsToolView::updatePolylinePreview(const QPointF& currentMousePos)
     }
 
     // 更新主预览线
-    if (previewLine) {
-        previewLine->setLine(lastPoint.x(), lastPoint.y(), effectiveMousePos.x(), effectiveMousePos.y());
-    } else {
-        previewLine = new EditableLineItem(lastPoint, effectiveMousePos);
-        QPen pen = previewLine->pen();
-        pen.setColor(drawingColor);
-        pen.setStyle(Qt::PenStyle(drawingLineStyle));
-        pen.setWidth(drawingPenWidth);
-        previewLine->setPen(pen);
-        scene()->addItem(previewLine);
-    }
-    previewLine->setVisible(true);
+    const QPen pen = drawingPen();
+    previewLayer.setLine(PreviewLayer::SegmentSlot, QLineF(lastPoint, effectiveMousePos), pen);
 
     // 更新闭合预览线段
     if (closePolylineOnFinish && polylinePoints.size() >= 1) {
-        if (!previewClosingSegment) {
-            previewClosingSegment = new EditableLineItem(effectiveMousePos, polylinePoints.first());
-            QPen pen = previewClosingSegment->pen();
-            pen.setColor(drawingColor);
-            pen.setStyle(Qt::PenStyle(drawingLineStyle));
-            pen.setWidth(drawingPenWidth);
-            previewClosingSegment->setPen(pen);
-            scene()->addItem(previewClosingSegment);
-        }
-        previewClosingSegment->setLine(effectiveMousePos.x(), effectiveMousePos.y(), polylinePoints.first().x(), polylinePoints.first().y());
-        previewClosingSegment->setVisible(true);
+        previewLayer.setLine(PreviewLayer::ClosingSlot, QLineF(effectiveMousePos, polylinePoints.first()), pen);
     } else {
-        if (previewClosingSegment) {
-            previewClosingSegment->setVisible(false);
-        }
+        previewLayer.clear(PreviewLayer::ClosingSlot);
     }
 }
-void GraphicsToolView::handleNoneModePress(QMouseEvent *event)
+void GraphicsToolView::handleNoneModePress(QMouseEvent *event, const PickResult &pick)
 {
-    QPointF scenePos = mapToScene(event->pos());
-    // QGraphicsItem *item = scene()->itemAt(scenePos, transform()); // 这行可以移除，itemUnderMouse 在 mousePressEvent 中获取
-    qreal tolerance = 10.0;
-
-    if (checkHandleHit(scenePos)) { // 优先检查是否点中控制点
+    if (pick.kind == PickResult::Kind::Handle) { // 优先处理控制点
+        draggedHandleRole = pick.handleRole;
+        draggedItem = pick.item;
+        draggedHandleIndex = pick.handleIndex;
+        EditableLineItem* editableLine = dynamic_cast<EditableLineItem*>(pick.item);
+        if (editableLine && pick.handleRole == HandleRole::Rotation) {
+            fixedRotationCenter = editableLine->mapToScene(editableLine->rotationHandlePos());
+            qCDebug(lcView) << "Rotation center fixed:" << fixedRotationCenter;
+        }
+        qCDebug(lcView) << "Selected handle of" << pick.item << "index:" << pick.handleIndex << "at" << pick.scenePos;
         event->accept();
         return;
     }
 
-    // 检查是否点中已选中的图形项以进行拖动
-    // 注意：这里需要区分是单击选中还是开始拖动。
-    // 如果是单击，则执行 handleItemSelection。
-    // 如果是按下并准备拖动已选中的项，则 checkSelectedGroupHit 应该处理。
-    // 框选的逻辑已经提前处理了。
-
-    bool groupHit = false;
-    for (QGraphicsItem* selItem : selectedItems) {
-        QRectF boundingRect = selItem->boundingRect();
-        // 稍微扩大一点边界，方便点击
-        boundingRect.adjust(-tolerance / 2, -tolerance / 2, tolerance / 2, tolerance / 2);
-        if (selItem->mapToScene(boundingRect).boundingRect().contains(scenePos)) {
-            groupHit = true;
-            break;
-        }
-    }
-
-    if (groupHit) {
+    if (pick.kind == PickResult::Kind::SelectedGroup && event->button() == Qt::LeftButton) {
         // 点中了已选中的某个项目，准备拖动组
-        if (event->button() == Qt::LeftButton) {
-            isDraggingSelectionGroup = true;
-            dragStartPosition = scenePos; // 记录拖动起始点（场景坐标）
-            lastDragPos = scenePos;        // 初始化上次拖动位置
-            this->isCtrlPressedForCopy = event->modifiers() & Qt::ControlModifier;
-            qDebug() << "Starting drag selected group:" << scenePos << "Ctrl state:" << isCtrlPressedForCopy;
-            event->accept();
-            return;
-        }
+        isDraggingSelectionGroup = true;
+        dragStartPosition = pick.scenePos; // 记录拖动起始点（场景坐标）
+        lastDragPos = pick.scenePos;        // 初始化上次拖动位置
+        this->isCtrlPressedForCopy = event->modifiers() & Qt::ControlModifier;
+        qCDebug(lcView) << "Starting drag selected group:" << pick.scenePos << "Ctrl state:" << isCtrlPressedForCopy;
+        moveSession.begin();
+        event->accept();
+        return;
     }
 
     // 如果没有点中控制点，也没有点中已选中的组（或者不是左键按下），则处理单个项目选择
-    handleItemSelection(scenePos, tolerance, event->modifiers() & Qt::ControlModifier);
+    handleItemSelection(pick, event->modifiers() & Qt::ControlModifier);
     event->accept(); // 标记事件已处理
 }
 
-
-bool GraphicsToolView::checkHandleHit(const QPointF &scenePos)
+void GraphicsToolView::handleItemSelection(const PickResult &pick, bool isMultiSelect)
 {
-    for (QGraphicsItem* item : selectedItems) {
-        if (EditableLineItem* editableLine = dynamic_cast<EditableLineItem*>(item)) {
-            HandleItem* startHandle = editableLine->getStartHandle();
-            HandleItem* endHandle = editableLine->getEndHandle();
-            HandleItem* rotationHandle = editableLine->getRotationHandle();
-            if (startHandle && startHandle->isVisible() && startHandle->sceneBoundingRect().contains(scenePos)) {
-                draggedHandle = startHandle;
-                draggedItem = item;
-                qDebug() << "Selected start handle:" << scenePos;
-                return true;
-            } else if (endHandle && endHandle->isVisible() && endHandle->sceneBoundingRect().contains(scenePos)) {
-                draggedHandle = endHandle;
-                draggedItem = item;
-                qDebug() << "Selected end handle:" << scenePos;
-                return true;
-            } else if (rotationHandle && rotationHandle->isVisible() && rotationHandle->sceneBoundingRect().contains(scenePos)) {
-                draggedHandle = rotationHandle;
-                draggedItem = item;
-                fixedRotationCenter = editableLine->mapToScene(editableLine->getRotationHandle()->pos());
-                qDebug() << "Rotation center fixed:" << fixedRotationCenter;
-                qDebug() << "Selected rotation handle:" << scenePos;
-                return true;
-            } else if (EditablePolylineItem* editablePolyline = dynamic_cast<EditablePolylineItem*>(item)) {
-                QVector<HandleItem*> handles = editablePolyline->getHandles();
-                for (int i = 0; i < handles.size(); ++i) {
-                    HandleItem* handle = handles[i];
-                    if (handle && handle->isVisible() && handle->sceneBoundingRect().contains(scenePos)) {
-                        draggedHandle = handle;
-                        draggedItem = item;
-                        draggedHandleIndex = i;
-                        qDebug() << "Selected polyline handle index:" << i << "position:" << scenePos;
-                        return true;
-                    }
-                }
-            }
+    if (pick.isNull() || !pick.item) {
+        cleanupSelection();
+        qCDebug(lcView) << "Clicked empty space, clearing selection.";
+        return;
+    }
+
+    QGraphicsItem* item = pick.item;
+    selection.beginGesture();
+    if (isMultiSelect) {
+        if (selection.add(item)) {
+            qCDebug(lcView) << "Adding item to multi-selection:" << pick.scenePos;
         }
+    } else {
+        cleanupSelection();
+        selection.add(item);
+        qCDebug(lcView) << "Selected item (single selection):" << pick.scenePos;
     }
-    return false;
+    selection.endGesture();
+    qCDebug(lcView) << "Total selected:" << selection.size();
 }
 
-bool GraphicsToolView::checkSelectedGroupHit(const QPointF &scenePos, qreal tolerance)
+void GraphicsToolView::selectAllItems()
 {
-    for (QGraphicsItem* item : selectedItems) {
-        QRectF boundingRect = item->boundingRect();
-        boundingRect.adjust(-tolerance, -tolerance, tolerance, tolerance);
-        QRectF sceneRect = item->mapToScene(boundingRect).boundingRect();
-        if (sceneRect.contains(scenePos)) {
-            isDraggingSelectionGroup = true;
-            dragStartPosition = scenePos;
-            lastDragPos = scenePos;
-            qDebug() << "Starting to drag selected group:" << scenePos;
-            return true;
-        }
+    if (!scene()) {
+        return;
     }
-    return false;
-}
-
-void GraphicsToolView::handleItemSelection(const QPointF &scenePos, qreal tolerance, bool isMultiSelect)
-{
-    QList<QGraphicsItem*> items = scene()->items();
-    bool itemSelected = false;
-    for (QGraphicsItem* item : items) {
-        QRectF boundingRect = item->boundingRect();
-        boundingRect.adjust(-tolerance, -tolerance, tolerance, tolerance);
-        QRectF sceneRect = item->mapToScene(boundingRect).boundingRect();
-        if (sceneRect.contains(scenePos)) {
-            if (isMultiSelect) {
-                if (!selectedItems.contains(item)) {
-                    selectedItems.append(item);
-                    if (EditableLineItem* editableLine = dynamic_cast<EditableLineItem*>(item)) {
-                        editableLine->setSelectedState(true);
-                    } else if (EditablePolylineItem* editablePolyline = dynamic_cast<EditablePolylineItem*>(item)) {
-                        editablePolyline->setSelectedState(true);
-                    }
-                    qDebug() << "Adding item to multi-selection:" << scenePos;
-                    qDebug() << "Total selected:" << selectedItems.size();
-                }
-            } else {
-                cleanupSelection();
-                selectedItems.append(item);
-                if (EditableLineItem* editableLine = dynamic_cast<EditableLineItem*>(item)) {
-                    editableLine->setSelectedState(true);
-                } else if (EditablePolylineItem* editablePolyline = dynamic_cast<EditablePolylineItem*>(item)) {
-                    editablePolyline->setSelectedState(true);
-                }
-                qDebug() << "Selected item (single selection):" << scenePos;
-            }
-            itemSelected = true;
-            break;
-        }
+    if (currentMode != DrawingMode::None) {
+        setDrawingMode(DrawingMode::None);
     }
-    if (!itemSelected) {
-        cleanupSelection();
-        qDebug() << "Clicked empty space, clearing selection.";
-    } else {
-        qDebug() << "Total selected:" << selectedItems.size();
+    const QList<QGraphicsItem*> allItems = scene()->items();
+    QList<QGraphicsItem*> topLevelItems;
+    topLevelItems.reserve(allItems.size());
+    for (QGraphicsItem *item : allItems) {
+        if (!item->parentItem() && SelectionModel::isSelectableType(item)) {
+            topLevelItems.append(item);
+        }
     }
+    selection.beginGesture();
+    selection.clear();
+    selection.addItems(topLevelItems);
+    selection.endGesture();
+    qCDebug(lcView) << "Selected all items:" << selection.size();
 }
 
 void GraphicsToolView::handleLineModePress(QMouseEvent *event)
 {
-    qDebug()<<"Number of selected items:"<< selectedItems.size();
+    qCDebug(lcView)<<"Number of selected items:"<< selection.size();
     if (event->button() != Qt::LeftButton) return;
     QPointF scenePos = mapToScene(event->pos());
     if (isShiftPressed && !startPoint.isNull()) {
@@ -670,24 +707,11 @@ void GraphicsToolView::handleLineModePress(QMouseEvent *event)
     if (startPoint.isNull()) {
         startPoint = scenePos;
         isDragging = true;
-        qDebug() << "Line mode: Start point:" << startPoint;
-        if (previewLine) {
-            scene()->removeItem(previewLine);
-            delete previewLine;
-            previewLine = nullptr;
-        }
-        previewLine = new EditableLineItem(startPoint, startPoint);
-        QPen pen = previewLine->pen();
-        pen.setColor(drawingColor);
-        pen.setStyle(Qt::PenStyle(drawingLineStyle));
-        pen.setWidth(drawingPenWidth);
-        previewLine->setPen(pen);
-        previewLine->setSelected(false);
-        previewLine->setFlag(QGraphicsItem::ItemIsSelectable, false);
-        scene()->addItem(previewLine);
+        qCDebug(lcView) << "Line mode: Start point:" << startPoint;
+        previewLayer.setLine(PreviewLayer::ShapeSlot, QLineF(startPoint, startPoint), drawingPen());
     } else {
         endPoint = scenePos;
-        qDebug() << "Line mode: End point:" << endPoint;
+        qCDebug(lcView) << "Line mode: End point:" << endPoint;
         EditableLineItem *line = new EditableLineItem(startPoint, endPoint);
         QPen pen = line->pen();
         pen.setColor(drawingColor);
@@ -695,37 +719,30 @@ void GraphicsToolView::handleLineModePress(QMouseEvent *event)
         pen.setWidth(drawingPenWidth);
         line->setPen(pen);
         line->setSelected(false);
-        scene()->addItem(previewLine);
-        previewLine = nullptr;
-        qDebug() << "Created line from:" << startPoint << "to" << endPoint;
+        scene()->addItem(line);
+        qCDebug(lcView) << "Created line from:" << startPoint << "to" << endPoint;
         cleanupDrawing();
-        setDrawingMode(DrawingMode::None); selectedItems.clear();
+        setDrawingMode(DrawingMode::None);
     }
 }
 
-void GraphicsToolView::updateCursorBasedOnPosition(const QPointF &scenePos)
+void GraphicsToolView::updateCursorBasedOnPosition(const PickResult &pick)
 {
-    bool isOverSelectedItem = false;
-    qreal tolerance = 10.0;
-    for (QGraphicsItem* item : selectedItems) {
-        QRectF boundingRect = item->boundingRect();
-        boundingRect.adjust(-tolerance, -tolerance, tolerance, tolerance);
-        QRectF sceneRect = item->mapToScene(boundingRect).boundingRect();
-        if (sceneRect.contains(scenePos)) {
-            isOverSelectedItem = true;
-            break;
-        }
+    if (currentMode != DrawingMode::None) {
+        return;
     }
-    if (isOverSelectedItem && currentMode == DrawingMode::None) {
+    if (pick.kind == PickResult::Kind::Handle) {
+        setCursor(pick.handleRole == HandleRole::Rotation ? Qt::CrossCursor : Qt::SizeAllCursor);
+    } else if (pick.kind == PickResult::Kind::SelectedGroup) {
         setCursor(Qt::SizeAllCursor);
-    } else if (currentMode == DrawingMode::None) {
+    } else {
         setCursor(Qt::ArrowCursor);
     }
 }
 
 void GraphicsToolView::handleLineModeMove(QMouseEvent *event)
 {
-    if (startPoint.isNull() || !isDragging || !previewLine) return;
+    if (startPoint.isNull() || !isDragging) return;
     QPointF scenePos = mapToScene(event->pos());
     if (isShiftPressed) {
         qreal dx = qAbs(scenePos.x() - startPoint.x());
@@ -733,12 +750,12 @@ void GraphicsToolView::handleLineModeMove(QMouseEvent *event)
         if (dx > dy) scenePos.setY(startPoint.y());
         else scenePos.setX(startPoint.x());
     }
-    previewLine->setLine(QLineF(startPoint, scenePos));
+    previewLayer.setLine(PreviewLayer::ShapeSlot, QLineF(startPoint, scenePos), drawingPen());
 }
 
 void GraphicsToolView::applyColorToSelectedItems(const QColor &color)
 {
-    for (QGraphicsItem* item : selectedItems) {
+    for (QGraphicsItem* item : selection.items()) {
         if (EditableLineItem* editableLine = dynamic_cast<EditableLineItem*>(item)) {
             QPen pen = editableLine->pen();
             pen.setColor(color);
@@ -757,25 +774,25 @@ void GraphicsToolView::applyColorToSelectedItems(const QColor &color)
 
 void GraphicsToolView::handleHandleMove(QMouseEvent *event)
 {
-    if (!draggedItem || !draggedHandle) {
-        qWarning() << "Invalid drag operation.";
+    if (!draggedItem || draggedHandleRole == HandleRole::None) {
+        qCWarning(lcView) << "Invalid drag operation.";
         return;
     }
     QPointF newPos = mapToScene(event->pos());
-    qDebug() << "View coordinates:" << event->pos();
-    qDebug() << "Scene position:" << newPos;
+    qCDebug(lcView) << "View coordinates:" << event->pos();
+    qCDebug(lcView) << "Scene position:" << newPos;
     if (EditableLineItem* editableLine = dynamic_cast<EditableLineItem*>(draggedItem)) {
         QLineF currentLine = editableLine->line();
         QPointF sceneP1 = editableLine->mapToScene(currentLine.p1());
         QPointF sceneP2 = editableLine->mapToScene(currentLine.p2());
-        qDebug() << "Line scene coordinates: P1=" << sceneP1 << ", P2=" << sceneP2;
-        if (draggedHandle == editableLine->getStartHandle()) {
+        qCDebug(lcView) << "Line scene coordinates: P1=" << sceneP1 << ", P2=" << sceneP2;
+        if (draggedHandleRole == HandleRole::Start) {
             editableLine->updateLine(newPos, sceneP2);
-            qDebug() << "Dragging start point to:" << newPos;
-        } else if (draggedHandle == editableLine->getEndHandle()) {
+            qCDebug(lcView) << "Dragging start point to:" << newPos;
+        } else if (draggedHandleRole == HandleRole::End) {
             editableLine->updateLine(sceneP1, newPos);
-            qDebug() << "Dragging end point to:" << newPos;
-        } else if (draggedHandle == editableLine->getRotationHandle()) {
+            qCDebug(lcView) << "Dragging end point to:" << newPos;
+        } else if (draggedHandleRole == HandleRole::Rotation) {
             QPointF midPoint = (sceneP1 + sceneP2) / 2.0;
             QPointF currentVector = midPoint - fixedRotationCenter;
             qreal currentAngle = qAtan2(currentVector.y(), currentVector.x()) * 180.0 / M_PI;
@@ -788,22 +805,26 @@ void GraphicsToolView::handleHandleMove(QMouseEvent *event)
             else if (angleDiff < -180) angleDiff += 360;
             qreal newRotation = targetAngle;
             editableLine->rotate(newRotation, fixedRotationCenter);
-            qDebug() << "Dragging rotation handle to:" << newPos << ", rotation center:" << fixedRotationCenter;
-            qDebug() << "Current angle:" << currentAngle << ", target angle:" << targetAngle << ", angle diff:" << angleDiff << ", new rotation angle:" << newRotation;
+            qCDebug(lcView) << "Dragging rotation handle to:" << newPos << ", rotation center:" << fixedRotationCenter;
+            qCDebug(lcView) << "Current angle:" << currentAngle << ", target angle:" << targetAngle << ", angle diff:" << angleDiff << ", new rotation angle:" << newRotation;
+        }
+    } else if (EditablePolylineItem* editablePolyline = dynamic_cast<EditablePolylineItem*>(draggedItem)) {
+        if (draggedHandleRole == HandleRole::Vertex) {
+            editablePolyline->updatePoint(draggedHandleIndex, editablePolyline->mapFromScene(newPos));
+            qCDebug(lcView) << "Dragging vertex" << draggedHandleIndex << "to:" << newPos;
         }
     }
+    selection.invalidateBounds();
+    viewport()->update(); // 控制点位于前景层，需随图形一起重绘
 }
 
 void GraphicsToolView::handleGroupMove(QMouseEvent *event)
 {
     QPointF currentPos = mapToScene(event->pos());
     QPointF offset = currentPos - lastDragPos;
-    for (QGraphicsItem* item : selectedItems) {
-        QPointF newItemPos = item->pos() + offset;
-        item->setPos(newItemPos);
-    }
+    moveSession.moveBy(offset); // 大量选中项时只移动缓存位图，释放时再写回位置
     lastDragPos = currentPos;
-    qDebug() << "Dragging selected group, offset:" << offset;
+    qCDebug(lcView) << "Dragging selected group, offset:" << offset;
 }
 
 void GraphicsToolView::handleLineModeRelease(QMouseEvent *event)
@@ -821,40 +842,41 @@ void GraphicsToolView::handleLineModeRelease(QMouseEvent *event)
 
 void GraphicsToolView::handleHandleRelease()
 {
-    qDebug() << "Handle released.";
-    draggedHandle = nullptr;
+    qCDebug(lcView) << "Handle released.";
+    draggedHandleRole = HandleRole::None;
+    draggedHandleIndex = -1;
     draggedItem = nullptr;
 }
 
 void GraphicsToolView::handleGroupRelease()
 {
-    qDebug() << "Selected group released.";
-    qDebug() << "Ctrl copy state:" << isCtrlPressedForCopy;
-    if (isCtrlPressedForCopy && !selectedItems.isEmpty()) {
-        qDebug() << "Ctrl copy during drag.";
+    qCDebug(lcView) << "Selected group released.";
+    // 位置写回和 Ctrl 复制合并为一次场景事务
+    SceneTransaction transaction(scene(), isCtrlPressedForCopy ? selection.size() * 2 : selection.size());
+    moveSession.commit();
+    qCDebug(lcView) << "Ctrl copy state:" << isCtrlPressedForCopy;
+    if (isCtrlPressedForCopy && !selection.isEmpty()) {
+        qCDebug(lcView) << "Ctrl copy during drag.";
         QList<QGraphicsItem*> newItems;
-        for (QGraphicsItem* item : selectedItems) {
+        for (QGraphicsItem* item : selection.items()) {
             if (EditableLineItem* editableLine = dynamic_cast<EditableLineItem*>(item)) {
                 QGraphicsItem* newItem = editableLine->clone();
                 if (newItem) {
                     newItem->setPos(item->pos() + QPointF(20, 20));
                     scene()->addItem(newItem);
                     newItems.append(newItem);
-                    qDebug() << "Copied item:" << newItem->pos();
+                    qCDebug(lcView) << "Copied item:" << newItem->pos();
                 }
             }
         }
+        selection.beginGesture();
         cleanupSelection();
-        for (QGraphicsItem* newItem : newItems) {
-            if (EditableLineItem* newEditableLine = dynamic_cast<EditableLineItem*>(newItem)) {
-                newEditableLine->setSelectedState(true);
-                selectedItems.append(newItem);
-                copiedItems.append(newItem);
-            }
-        }
-        qDebug() << "Copy complete, new selection count:" << selectedItems.size();
+        selection.addItems(newItems);
+        selection.endGesture();
+        copiedItems.append(newItems);
+        qCDebug(lcView) << "Copy complete, new selection count:" << selection.size();
     } else {
-        qDebug() << "Not copied, Ctrl state:" << isCtrlPressedForCopy << ", selected count:" << selectedItems.size();
+        qCDebug(lcView) << "Not copied, Ctrl state:" << isCtrlPressedForCopy << ", selected count:" << selection.size();
     }
     isDraggingSelectionGroup = false;
     isCtrlPressedForCopy = false;
@@ -862,89 +884,264 @@ void GraphicsToolView::handleGroupRelease()
 
 void GraphicsToolView::cleanupDrawing()
 {
-    qDebug() << "Cleaning up drawing state, mode:" << static_cast<int>(currentMode);
-    if (previewLine) {
-        scene()->removeItem(previewLine);
-        delete previewLine;
-        previewLine = nullptr;
-    }
-    if (previewClosingSegment) {
-        scene()->removeItem(previewClosingSegment);
-        delete previewClosingSegment;
-        previewClosingSegment = nullptr;
-    }
+    qCDebug(lcView) << "Cleaning up drawing state, mode:" << static_cast<int>(currentMode);
+    previewLayer.clearAll(); // 清除所有预览图形
     startPoint = QPointF();
     endPoint = QPointF();
 
     if (isDrawingPolyline || !polylinePoints.isEmpty() || currentPolyline) {
-        qDebug() << "Cleaning up polyline remnants.";
+        qCDebug(lcView) << "Cleaning up polyline remnants.";
         polylinePoints.clear();
         if (currentPolyline) {
-            scene()->removeItem(currentPolyline);
+            SceneItemEvents::removeItem(scene(), currentPolyline);
             delete currentPolyline;
             currentPolyline = nullptr;
         }
         isDrawingPolyline = false;
     }
+    currentArcState = ArcDrawingState::DefineCenter; // 圆弧绘制从定义圆心重新开始
     closePolylineOnFinish = false;
     isDragging = false;
 }
 
 void GraphicsToolView::cleanupSelection()
 {
-    qDebug() << "Cleaning up selection state.";
+    qCDebug(lcView) << "Cleaning up selection state.";
     if (isSelectingWithRubberBand && rubberBand) { // 如果正在框选，则取消
         rubberBand->hide();
         isSelectingWithRubberBand = false;
     }
-
-    for (QGraphicsItem* item : selectedItems) {
-        if (item) {
-            if (EditableLineItem* editableLine = dynamic_cast<EditableLineItem*>(item)) {
-                editableLine->setSelectedState(false);
-            }
-        }
+    if (!rubberBandPreview.isEmpty()) {
+        rubberBandPreview.clear();
+        viewport()->update();
+    }
+    if (moveSession.isActive()) { // 拖动中途清空选择时放弃本次拖动
+        moveSession.cancel();
     }
-    selectedItems.clear();
+
+    selection.clear();
     copiedItems.clear();
-    draggedHandle = nullptr;
+    draggedHandleRole = HandleRole::None;
     draggedItem = nullptr;
     isDraggingSelectionGroup = false;
 }
 
 void GraphicsToolView::copySelectedItems()
 {
-    qDebug() << "Copying selected items.";
+    qCDebug(lcView) << "Copying selected items.";
     copiedItems.clear();
-    for (QGraphicsItem* item : selectedItems) {
+    for (QGraphicsItem* item : selection.items()) {
         if (EditableLineItem* editableLine = dynamic_cast<EditableLineItem*>(item)) {
             if (item->parentItem() == nullptr || dynamic_cast<EditableLineItem*>(item->parentItem()) == nullptr) {
                 copiedItems.append(item);
             }
         }
     }
-    qDebug() << "Total copied:" << copiedItems.size();
+    qCDebug(lcView) << "Total copied:" << copiedItems.size();
 }
 void GraphicsToolView::deleteSelectedItems(){
-    qDebug()<<"Deleting items."<<Qt::endl;
-    for(auto item :selectedItems){
-        scene()->removeItem(item);
+    qCDebug(lcView)<<"Deleting items."<<Qt::endl;
+    const QVector<QGraphicsItem*> itemsToRemove = selection.items();
+    cleanupSelection(); // 先清空选择，避免保留已移出场景的项
+    SceneTransaction transaction(scene(), itemsToRemove.size());
+    for(auto item :itemsToRemove){
+        SceneItemEvents::removeItem(scene(), item);
+    }
+    transaction.commit();
+}
+bool GraphicsToolView::packSelectedItems()
+{
+    if (!scene()) {
+        return true;
+    }
+    QList<QGraphicsItem*> packable;
+    QGraphicsItem *above = nullptr;
+    const bool contiguous = collectStackedRun([this](QGraphicsItem *item) {
+        return selection.contains(item) && BulkPrimitiveItem::canPack(item);
+    }, packable, above);
+    if (packable.isEmpty()) {
+        qCDebug(lcView) << "Nothing to pack.";
+        return true;
+    }
+    // 批量图元只有一个叠放位置：被打包的图元之间夹着其他图元时，打包会改变它们的上下关系
+    if (!contiguous) {
+        qCDebug(lcView) << "Refused to pack" << packable.size() << "items: not contiguous in stacking order.";
+        return false;
+    }
+    cleanupSelection();
+
+    SceneTransaction transaction(scene(), packable.size() + 1);
+    BulkPrimitiveItem *bulk = new BulkPrimitiveItem;
+    bulk->reserve(packable.size(), packable.size() * 2);
+    const qreal z = packable.last()->zValue();
+    for (QGraphicsItem *item : std::as_const(packable)) {
+        bulk->pack(item);
+        SceneItemEvents::removeItem(scene(), item);
+        delete item; // 打包的目的就是释放逐个图元的开销
+    }
+    // 与冻结相同：取最上层图元的 Z 值，排在上方紧邻的图元之前
+    bulk->setZValue(z);
+    scene()->addItem(bulk);
+    if (above) {
+        bulk->stackBefore(above);
+    }
+    transaction.commit();
+
+    selection.beginGesture();
+    selection.add(bulk);
+    selection.endGesture();
+    qCDebug(lcView) << "Packed" << packable.size() << "items into a bulk item.";
+    return true;
+}
+
+bool GraphicsToolView::freezeItems()
+{
+    if (!scene()) {
+        return true;
+    }
+    // 有选中项时只冻结选中项，否则冻结场景中全部可编辑图元
+    const bool onlySelected = !selection.isEmpty();
+    QList<QGraphicsItem*> frozen;
+    QGraphicsItem *above = nullptr;
+    const bool contiguous = collectStackedRun([this, onlySelected](QGraphicsItem *item) {
+        return SelectionModel::isSelectableType(item) && (!onlySelected || selection.contains(item));
+    }, frozen, above);
+    if (frozen.isEmpty()) {
+        qCDebug(lcView) << "Nothing to freeze.";
+        return true;
+    }
+    // 图层只有一个叠放位置：被冻结的图元之间夹着其他图元时，烘焙会改变它们的上下关系
+    if (!contiguous) {
+        qCDebug(lcView) << "Refused to freeze" << frozen.size() << "items: not contiguous in stacking order.";
+        return false;
+    }
+    cleanupSelection();
+
+    SceneTransaction transaction(scene(), frozen.size() + 1);
+    for (QGraphicsItem *item : std::as_const(frozen)) {
+        SceneItemEvents::removeItem(scene(), item); // 移出场景后不再参与索引和逐帧遍历
+    }
+    // 取最上层图元的 Z 值；上方紧邻的图元 Z 值相同时，新图层要排在它之前
+    BakedLayerItem *layer = new BakedLayerItem(frozen);
+    layer->setZValue(frozen.last()->zValue());
+    scene()->addItem(layer);
+    if (above) {
+        layer->stackBefore(above);
+    }
+    transaction.commit();
+    qCDebug(lcView) << "Froze" << frozen.size() << "items into a baked layer.";
+    return true;
+}
+
+void GraphicsToolView::unbakeLayer(BakedLayerItem *layer)
+{
+    cleanupSelection();
+    // 交还的图元回到图层原来的叠放位置：依次排在图层上方紧邻的图元之前
+    QGraphicsItem *above = topLevelItemAbove(layer);
+    SceneTransaction transaction(scene(), layer->itemCount() + 1);
+    const QList<QGraphicsItem*> items = layer->unbake();
+    SceneItemEvents::removeItem(scene(), layer);
+    delete layer;
+    for (QGraphicsItem *item : items) {
+        scene()->addItem(item);
+        if (above) {
+            item->stackBefore(above); // Z 值不同时不起作用，此时次序已由 Z 值决定
+        }
+    }
+    transaction.commit();
+    qCDebug(lcView) << "Unbaked layer," << items.size() << "items editable again.";
+}
+
+bool GraphicsToolView::collectStackedRun(const std::function<bool(QGraphicsItem*)> &accept,
+                                         QList<QGraphicsItem*> &run, QGraphicsItem *&above) const
+{
+    run.clear();
+    above = nullptr;
+    bool contiguous = true;
+    bool runEnded = false; // 已遇到跟在这一段之后的其他图元
+    for (QGraphicsItem *item : scene()->items(Qt::AscendingOrder)) {
+        if (item->parentItem()) {
+            continue;
+        }
+        if (accept(item)) {
+            contiguous = contiguous && !runEnded;
+            run.append(item);
+        } else if (!run.isEmpty() && !runEnded) {
+            runEnded = true;
+            above = item;
+        }
+    }
+    if (!contiguous) {
+        above = nullptr;
+    }
+    return contiguous;
+}
+
+QGraphicsItem *GraphicsToolView::topLevelItemAbove(QGraphicsItem *item) const
+{
+    QGraphicsItem *previous = nullptr;
+    for (QGraphicsItem *candidate : scene()->items(Qt::DescendingOrder)) {
+        if (candidate->parentItem()) {
+            continue;
+        }
+        if (candidate == item) {
+            return previous;
+        }
+        previous = candidate;
     }
+    return nullptr;
 }
+
+bool GraphicsToolView::unpackPrimitiveAt(const QPoint &viewPos)
+{
+    const PickResult pick = pickingEngine.pick(viewPos, selection);
+    BulkPrimitiveItem *bulk = pick.item ? qgraphicsitem_cast<BulkPrimitiveItem*>(pick.item) : nullptr;
+    if (!bulk) {
+        return false;
+    }
+    // 拾取容差按当前缩放换算成本地距离
+    const QTransform deviceTransform = bulk->deviceTransform(viewportTransform());
+    const qreal scale = qMax<qreal>(qSqrt(qAbs(deviceTransform.determinant())), 1e-6);
+    const int index = bulk->primitiveAt(bulk->mapFromScene(pick.scenePos), pickingEngine.tolerance() / scale);
+    if (index < 0) {
+        return false;
+    }
+
+    cleanupSelection();
+    // 转换出的图元放在批量图元紧邻的上方，而不是最上层
+    QGraphicsItem *above = topLevelItemAbove(bulk);
+    QGraphicsItem *item = bulk->takePrimitive(index);
+    item->setZValue(bulk->zValue());
+    scene()->addItem(item);
+    if (above) {
+        item->stackBefore(above);
+    }
+    if (bulk->primitiveCount() == 0) {
+        SceneItemEvents::removeItem(scene(), bulk);
+        delete bulk;
+    }
+    selection.beginGesture();
+    selection.add(item);
+    selection.endGesture();
+    qCDebug(lcView) << "Unpacked primitive" << index << "into an editable item.";
+    return true;
+}
+
 void GraphicsToolView::pasteCopiedItems()
 {
-    qDebug() << "Pasting items.";
+    qCDebug(lcView) << "Pasting items.";
     if (copiedItems.isEmpty()) {
-        qDebug() << "No items to paste.";
+        qCDebug(lcView) << "No items to paste.";
         return;
     }
     QPointF pasteOffset(20, 20);
     QGraphicsScene* currentScene = scene();
     if (!currentScene) {
-        qDebug() << "Error: View has no scene.";
+        qCDebug(lcView) << "Error: View has no scene.";
         return;
     }
     QList<QGraphicsItem*> newlyPastedItems;
+    SceneTransaction transaction(currentScene, copiedItems.size());
     for (QGraphicsItem* item : copiedItems) {
         QGraphicsItem* newItem = nullptr;
         if (EditableLineItem* editableLine = dynamic_cast<EditableLineItem*>(item)) {
@@ -955,7 +1152,7 @@ void GraphicsToolView::pasteCopiedItems()
                 static_cast<QGraphicsRectItem*>(newItem)->setPen(rectItem->pen());
                 static_cast<QGraphicsRectItem*>(newItem)->setBrush(rectItem->brush());
             } else {
-                qDebug() << "Warning: Cannot paste this item type.";
+                qCDebug(lcView) << "Warning: Cannot paste this item type.";
             }
         }
         if (newItem) {
@@ -964,15 +1161,13 @@ void GraphicsToolView::pasteCopiedItems()
             newlyPastedItems.append(newItem);
         }
     }
+    transaction.commit();
+    selection.beginGesture();
     cleanupSelection();
-    for (QGraphicsItem* pastedItem : newlyPastedItems) {
-        if (EditableLineItem* editableLine = dynamic_cast<EditableLineItem*>(pastedItem)) {
-            editableLine->setSelectedState(true);
-            selectedItems.append(editableLine);
-            copiedItems.append(editableLine);
-        }
-    }
-    qDebug() << "Total pasted:" << selectedItems.size();
+    selection.addItems(newlyPastedItems);
+    selection.endGesture();
+    copiedItems.append(newlyPastedItems);
+    qCDebug(lcView) << "Total pasted:" << selection.size();
 }
 
 // 处理椭圆模式鼠标按下
@@ -982,28 +1177,23 @@ void GraphicsToolView::handleEllipseModePress(QMouseEvent *event)
         ellipseStartPoint = mapToScene(event->pos());
         isDragging = true;
 
-        if (previewEllipse) {
-            scene()->removeItem(previewEllipse);
-            delete previewEllipse;
-            previewEllipse = nullptr;
-        }
-        previewEllipse = new QGraphicsEllipseItem(QRectF(ellipseStartPoint, ellipseStartPoint));
         QPen pen(drawingColor, 1, Qt::DashLine);
         pen.setWidth(drawingPenWidth);
-        previewEllipse->setPen(pen);
-        scene()->addItem(previewEllipse);
-        qDebug() << "Ellipse drawing started at:" << ellipseStartPoint;
+        previewLayer.setEllipse(PreviewLayer::ShapeSlot, QRectF(ellipseStartPoint, ellipseStartPoint), pen);
+        qCDebug(lcView) << "Ellipse drawing started at:" << ellipseStartPoint;
     }
 }
 
 // 处理椭圆模式鼠标移动
 void GraphicsToolView::handleEllipseModeMove(QMouseEvent *event)
 {
-    if (isDragging && previewEllipse) {
+    if (isDragging && !previewLayer.isEmpty(PreviewLayer::ShapeSlot)) {
         QPointF currentScenePos = mapToScene(event->pos());
         QRectF newRect = QRectF(ellipseStartPoint, currentScenePos).normalized();
-        previewEllipse->setRect(newRect);
-        qDebug() << "Ellipse preview updated to:" << newRect;
+        QPen pen(drawingColor, 1, Qt::DashLine);
+        pen.setWidth(drawingPenWidth);
+        previewLayer.setEllipse(PreviewLayer::ShapeSlot, newRect, pen);
+        qCDebug(lcView) << "Ellipse preview updated to:" << newRect;
     }
 }
 
@@ -1014,11 +1204,7 @@ void GraphicsToolView::handleEllipseModeRelease(QMouseEvent *event)
         QPointF currentScenePos = mapToScene(event->pos());
         QRectF finalRect = QRectF(ellipseStartPoint, currentScenePos).normalized();
 
-        if (previewEllipse) {
-            scene()->removeItem(previewEllipse);
-            delete previewEllipse;
-            previewEllipse = nullptr;
-        }
+        previewLayer.clear(PreviewLayer::ShapeSlot);
 
         if (finalRect.width() > 0 && finalRect.height() > 0) {
             QGraphicsEllipseItem *ellipseItem = new QGraphicsEllipseItem(finalRect);
@@ -1028,9 +1214,9 @@ void GraphicsToolView::handleEllipseModeRelease(QMouseEvent *event)
             ellipseItem->setPen(pen);
             ellipseItem->setBrush(drawingFillColor);
             scene()->addItem(ellipseItem);
-            qDebug() << "Ellipse drawing finished:" << finalRect << ", color:" << drawingColor;
+            qCDebug(lcView) << "Ellipse drawing finished:" << finalRect << ", color:" << drawingColor;
         } else {
-            qDebug() << "Ellipse too small, not drawn.";
+            qCDebug(lcView) << "Ellipse too small, not drawn.";
         }
 
         isDragging = false;
@@ -1048,24 +1234,13 @@ void GraphicsToolView::handleArcModePress(QMouseEvent *event)
     if (currentArcState == ArcDrawingState::DefineCenter) {
         arcCenterPoint = scenePos;
         currentArcState = ArcDrawingState::DefineRadiusStart;
-        qDebug() << "Arc center point:" << arcCenterPoint;
-
-        if (previewArc) {
-            scene()->removeItem(previewArc);
-            delete previewArc;
-        }
-        previewArc = new QGraphicsPathItem();
-        QPen pen(drawingColor, 1, Qt::DashLine);
-        pen.setWidth(drawingPenWidth);
-        pen.setStyle(Qt::PenStyle(drawingLineStyle));
-
-        previewArc->setPen(pen);
-        scene()->addItem(previewArc);
+        qCDebug(lcView) << "Arc center point:" << arcCenterPoint;
+        previewLayer.clear(PreviewLayer::ShapeSlot); // 预览在鼠标移动时生成
 
     } else if (currentArcState == ArcDrawingState::DefineRadiusStart) {
         arcRadiusStartPoint = scenePos;
         currentArcState = ArcDrawingState::DefineEnd;
-        qDebug() << "Arc radius/start point:" << arcRadiusStartPoint;
+        qCDebug(lcView) << "Arc radius/start point:" << arcRadiusStartPoint;
     } else if (currentArcState == ArcDrawingState::DefineEnd) {
         QPointF arcEndPoint = scenePos;
         qreal radius = QLineF(arcCenterPoint, arcRadiusStartPoint).length();
@@ -1085,17 +1260,9 @@ void GraphicsToolView::handleArcModePress(QMouseEvent *event)
             spanAngleDegrees = 360.0;
         }
 
-        if (previewArc) {
-            scene()->removeItem(previewArc);
-            delete previewArc;
-            previewArc = nullptr;
-        }
-
-        QPainterPath finalPath;
-        QRectF boundingRect(arcCenterPoint.x() - radius, arcCenterPoint.y() - radius, 2 * radius, 2 * radius);
-        finalPath.arcTo(boundingRect, startAngleDegrees, spanAngleDegrees);
+        previewLayer.clear(PreviewLayer::ShapeSlot);
 
-        QGraphicsPathItem *arcItem = new QGraphicsPathItem(finalPath);
+        ArcItem *arcItem = new ArcItem(arcCenterPoint, radius, startAngleDegrees, spanAngleDegrees);
         QPen pen(drawingColor, 2);
         pen.setWidth(drawingPenWidth);
         pen.setStyle(Qt::PenStyle(drawingLineStyle));
@@ -1103,7 +1270,7 @@ void GraphicsToolView::handleArcModePress(QMouseEvent *event)
         arcItem->setPen(pen);
         scene()->addItem(arcItem);
 
-        qDebug() << "Arc drawn: Center" << arcCenterPoint << "Radius" << radius
+        qCDebug(lcView) << "Arc drawn: Center" << arcCenterPoint << "Radius" << radius
                  << "Start Angle" << startAngleDegrees << "Span Angle" << spanAngleDegrees;
 
         cleanupDrawing();
@@ -1113,8 +1280,7 @@ void GraphicsToolView::handleArcModePress(QMouseEvent *event)
 // 处理圆弧模式鼠标移动
 void GraphicsToolView::handleArcModeMove(QMouseEvent *event)
 {
-    if (!isDragging && currentArcState == ArcDrawingState::DefineCenter) return;
-    if (!previewArc) return;
+    if (currentArcState == ArcDrawingState::DefineCenter) return;
 
     QPointF currentScenePos = mapToScene(event->pos());
     QPainterPath previewPath;
@@ -1122,8 +1288,8 @@ void GraphicsToolView::handleArcModeMove(QMouseEvent *event)
     if (currentArcState == ArcDrawingState::DefineRadiusStart) {
         previewPath.moveTo(arcCenterPoint);
         previewPath.lineTo(currentScenePos);
-        previewArc->setPath(previewPath);
-        qDebug() << "Arc preview: Radius line to" << currentScenePos;
+        previewLayer.setPath(PreviewLayer::ShapeSlot, previewPath, drawingPen());
+        qCDebug(lcView) << "Arc preview: Radius line to" << currentScenePos;
     } else if (currentArcState == ArcDrawingState::DefineEnd) {
         qreal radius = QLineF(arcCenterPoint, arcRadiusStartPoint).length();
         if (radius <= 0) return;
@@ -1140,9 +1306,10 @@ void GraphicsToolView::handleArcModeMove(QMouseEvent *event)
         }
 
         QRectF boundingRect(arcCenterPoint.x() - radius, arcCenterPoint.y() - radius, 2 * radius, 2 * radius);
+        previewPath.arcMoveTo(boundingRect, startAngleDegrees); // 从圆弧起点开始，避免多出一条从原点出发的线
         previewPath.arcTo(boundingRect, startAngleDegrees, spanAngleDegrees);
-        previewArc->setPath(previewPath);
-        qDebug() << "Arc preview: End angle at" << currentScenePos << "span" << spanAngleDegrees;
+        previewLayer.setPath(PreviewLayer::ShapeSlot, previewPath, drawingPen());
+        qCDebug(lcView) << "Arc preview: End angle at" << currentScenePos << "span" << spanAngleDegrees;
     }
 }
 
@@ -1168,24 +1335,16 @@ void GraphicsToolView::handleArcModeRelease(QMouseEvent *event)
             spanAngleDegrees = 360.0;
         }
 
-        if (previewArc) {
-            scene()->removeItem(previewArc);
-            delete previewArc;
-            previewArc = nullptr;
-        }
-
-        QPainterPath finalPath;
-        QRectF boundingRect(arcCenterPoint.x() - radius, arcCenterPoint.y() - radius, 2 * radius, 2 * radius);
-        finalPath.arcTo(boundingRect, startAngleDegrees, spanAngleDegrees);
+        previewLayer.clear(PreviewLayer::ShapeSlot);
 
-        QGraphicsPathItem *arcItem = new QGraphicsPathItem(finalPath);
+        ArcItem *arcItem = new ArcItem(arcCenterPoint, radius, startAngleDegrees, spanAngleDegrees);
         QPen pen(drawingColor, 2);
         pen.setWidth(drawingPenWidth);
         pen.setStyle(Qt::PenStyle(drawingLineStyle));
 
         arcItem->setPen(pen);
         scene()->addItem(arcItem);
-        qDebug() << "Arc drawn (release): Center" << arcCenterPoint << "Radius" << radius
+        qCDebug(lcView) << "Arc drawn (release): Center" << arcCenterPoint << "Radius" << radius
                  << "Start Angle" << startAngleDegrees << "Span Angle" << spanAngleDegrees;
 
         cleanupDrawing();
@@ -1206,64 +1365,48 @@ void GraphicsToolView::handlePolygonModePress(QMouseEvent *event)
         isDrawingPolyline = true;
         isDragging = true;
 
-        if (previewPolygon) {
-            scene()->removeItem(previewPolygon);
-            delete previewPolygon;
-            previewPolygon = nullptr;
-        }
-        previewPolygon = new QGraphicsPolygonItem();
-        QPen pen(drawingColor, 1, Qt::DashLine);
-        pen.setWidth(drawingPenWidth);
-        pen.setStyle(Qt::PenStyle(drawingLineStyle));
-
-        previewPolygon->setPen(pen);
-        scene()->addItem(previewPolygon);
+        // 已确定的边放在主预览槽中，之后每次点击只追加一条边
+        previewLayer.setPath(PreviewLayer::ShapeSlot, QPainterPath(scenePos), drawingPen());
 
-        qDebug() << "Polygon drawing started at:" << scenePos;
+        qCDebug(lcView) << "Polygon drawing started at:" << scenePos;
     } else {
         polylinePoints.append(scenePos);
-        qDebug() << "Adding polygon point at:" << scenePos;
+        previewLayer.lineTo(PreviewLayer::ShapeSlot, scenePos);
+        qCDebug(lcView) << "Adding polygon point at:" << scenePos;
     }
 
-    if (polylinePoints.size() >= 1 && previewPolygon) {
-        QPolygonF currentQPolygon(polylinePoints);
-        if (isDrawingPolyline && polylinePoints.size() > 0) {
-            QPointF tempEndPoint = mapToScene(mapFromGlobal(QCursor::pos()));
-            QPolygonF previewQPolygon = currentQPolygon;
-            previewQPolygon.append(tempEndPoint);
-            if (polylinePoints.size() >=2) {
-                previewQPolygon.append(polylinePoints.first());
-            }
-            previewPolygon->setPolygon(previewQPolygon);
-        }
-    }
+    updatePolygonPreview(mapToScene(mapFromGlobal(QCursor::pos())));
 }
 
 // 处理多边形模式鼠标移动
 void GraphicsToolView::handlePolygonModeMove(QMouseEvent *event)
 {
-    if (!isDrawingPolyline || polylinePoints.isEmpty() || !previewPolygon) return;
+    if (!isDrawingPolyline || polylinePoints.isEmpty()) return;
 
     QPointF currentScenePos = mapToScene(event->pos());
-    QPolygonF currentQPolygon(polylinePoints);
-    currentQPolygon.append(currentScenePos);
+    updatePolygonPreview(currentScenePos);
+    qCDebug(lcView) << "Polygon preview updated, mouse at:" << currentScenePos;
+}
+
+// 更新多边形预览中跟随鼠标的部分：最后一个顶点 -> 鼠标 -> 第一个顶点
+void GraphicsToolView::updatePolygonPreview(const QPointF &cursorPos)
+{
+    if (!isDrawingPolyline || polylinePoints.isEmpty()) return;
 
+    QPainterPath rubberPath(polylinePoints.last());
+    rubberPath.lineTo(cursorPos);
     if (polylinePoints.size() >= 2) {
-        currentQPolygon.append(polylinePoints.first());
+        rubberPath.lineTo(polylinePoints.first());
     }
-    previewPolygon->setPolygon(currentQPolygon);
-    qDebug() << "Polygon preview updated, mouse at:" << currentScenePos;
+    previewLayer.setPath(PreviewLayer::SegmentSlot, rubberPath, drawingPen());
 }
 
 // 结束多边形绘制
 void GraphicsToolView::finishPolygon()
 {
     if (isDrawingPolyline) {
-        if (previewPolygon) {
-            scene()->removeItem(previewPolygon);
-            delete previewPolygon;
-            previewPolygon = nullptr;
-        }
+        previewLayer.clear(PreviewLayer::ShapeSlot);
+        previewLayer.clear(PreviewLayer::SegmentSlot);
 
         if (polylinePoints.size() >= 3) {
             QPolygonF finalPolygon(polylinePoints);
@@ -1276,9 +1419,9 @@ void GraphicsToolView::finishPolygon()
             QBrush brush(drawingFillColor, Qt::SolidPattern);
             polygonItem->setBrush(brush);
             scene()->addItem(polygonItem);
-            qDebug() << "Polygon drawing finished, vertices:" << polylinePoints.size();
+            qCDebug(lcView) << "Polygon drawing finished, vertices:" << polylinePoints.size();
         } else {
-            qDebug() << "Polygon less than 3 vertices, discarded.";
+            qCDebug(lcView) << "Polygon less than 3 vertices, discarded.";
         }
 
         isDrawingPolyline = false;
@@ -1306,7 +1449,7 @@ void GraphicsToolView::handleTextModePress(QMouseEvent *event)
         textItem->setFlag(QGraphicsItem::ItemIsSelectable);
 
         scene()->addItem(textItem);
-        qDebug() << "Text item added at:" << scenePos << ", text: 'Test Text'";
+        qCDebug(lcView) << "Text item added at:" << scenePos << ", text: 'Test Text'";
     }
 }
 
@@ -1317,30 +1460,19 @@ void GraphicsToolView::handleRectangleModePress(QMouseEvent *event)
         rectStartPoint = mapToScene(event->pos());
         isDragging = true;
 
-        if (previewRect) {
-            scene()->removeItem(previewRect);
-            delete previewRect;
-            previewRect = nullptr;
-        }
-        previewRect = new QGraphicsRectItem(QRectF(rectStartPoint, rectStartPoint));
-        QPen pen(drawingColor, 1, Qt::DashLine);
-        pen.setWidth(drawingPenWidth);
-        pen.setStyle(Qt::PenStyle(drawingLineStyle));
-
-        previewRect->setPen(pen);
-        scene()->addItem(previewRect);
-        qDebug() << "Rectangle drawing started at:" << rectStartPoint;
+        previewLayer.setRect(PreviewLayer::ShapeSlot, QRectF(rectStartPoint, rectStartPoint), drawingPen());
+        qCDebug(lcView) << "Rectangle drawing started at:" << rectStartPoint;
     }
 }
 
 // 处理矩形模式鼠标移动
 void GraphicsToolView::handleRectangleModeMove(QMouseEvent *event)
 {
-    if (isDragging && previewRect) {
+    if (isDragging && !previewLayer.isEmpty(PreviewLayer::ShapeSlot)) {
         QPointF currentScenePos = mapToScene(event->pos());
         QRectF newRect = QRectF(rectStartPoint, currentScenePos).normalized();
-        previewRect->setRect(newRect);
-        qDebug() << "Rectangle preview updated to:" << newRect;
+        previewLayer.setRect(PreviewLayer::ShapeSlot, newRect, drawingPen());
+        qCDebug(lcView) << "Rectangle preview updated to:" << newRect;
     }
 }
 
@@ -1348,21 +1480,17 @@ void GraphicsToolView::handleRectangleModeMove(QMouseEvent *event)
 void GraphicsToolView::handleRectangleModeRelease(QMouseEvent *event)
 {
 
-    qDebug()<<"handleRectangleModeRelease";
-    qDebug()<<fillImagePath;
+    qCDebug(lcView)<<"handleRectangleModeRelease";
+    qCDebug(lcView)<<fillImagePath;
 
-    qDebug() << "handleRectangleModeRelease";
-    qDebug() << fillImagePath << "===fillImagePath";
+    qCDebug(lcView) << "handleRectangleModeRelease";
+    qCDebug(lcView) << fillImagePath << "===fillImagePath";
 
     if (event->button() == Qt::LeftButton && isDragging) {
         QPointF currentScenePos = mapToScene(event->pos());
         QRectF finalRect = QRectF(rectStartPoint, currentScenePos).normalized();
 
-        if (previewRect) {
-            scene()->removeItem(previewRect);
-            delete previewRect;
-            previewRect = nullptr;
-        }
+        previewLayer.clear(PreviewLayer::ShapeSlot);
 
         if (finalRect.width() > 0 && finalRect.height() > 0) {
             CustomRectItem *rectItem = new CustomRectItem(finalRect); // 使用自定义矩形项
@@ -1373,17 +1501,16 @@ void GraphicsToolView::handleRectangleModeRelease(QMouseEvent *event)
 
             rectItem->setPen(pen);
             // 优先使用图片填充，如果没有则使用颜色填充
-            if (!fillImagePath.isEmpty() && !fillPixmap.isNull()) {
-                // 缩放图片到矩形大小
-                QPixmap scaledPixmap = fillPixmap.scaled(finalRect.size().toSize(), Qt::IgnoreAspectRatio, Qt::SmoothTransformation);
-                rectItem->setFillPixmap(scaledPixmap); // 设置填充图片
-                qDebug() << "Using image fill, rect size:" << finalRect.size() << "image size:" << scaledPixmap.size();
+            if (!fillImagePath.isEmpty() && fillMipChain) {
+                // 共享同一份缩略链，绘制时按缩放选层，不再为每个矩形缩放一份副本
+                rectItem->setFillImage(fillMipChain);
+                qCDebug(lcView) << "Using image fill, rect size:" << finalRect.size() << "image size:" << fillMipChain->size();
             } else {
                 rectItem->setBrush(QBrush(drawingFillColor)); // 否则使用颜色填充
             }
             scene()->addItem(rectItem);
         } else {
-            qDebug() << "Rectangle too small, not drawn.";
+            qCDebug(lcView) << "Rectangle too small, not drawn.";
         }
 
         isDragging = false;
@@ -1391,11 +1518,20 @@ void GraphicsToolView::handleRectangleModeRelease(QMouseEvent *event)
     }
 }
 
+// 当前颜色、线宽和线型组成的画笔，预览和新建图形共用
+QPen GraphicsToolView::drawingPen() const
+{
+    QPen pen(drawingColor);
+    pen.setWidth(drawingPenWidth);
+    pen.setStyle(Qt::PenStyle(drawingLineStyle));
+    return pen;
+}
+
 // 设置填充颜色
 void GraphicsToolView::setDrawingFillColor(const QColor &color)
 {
     drawingFillColor = color;
-    qDebug() << "Fill color set to:" << color.name();
+    qCDebug(lcView) << "Fill color set to:" << color.name();
 }
 
 // 获取当前填充颜色
@@ -1408,7 +1544,7 @@ QColor GraphicsToolView::currentDrawingFillColor() const
 void GraphicsToolView::setDrawingColor(const QColor &color)
 {
     drawingColor = color;
-    qDebug() << "Drawing color set to:" << color.name();
+    qCDebug(lcView) << "Drawing color set to:" << color.name();
 }
 
 // 获取当前绘图颜色
@@ -1421,13 +1557,18 @@ void GraphicsToolView::setDrawingFillImage(const QString &imagePath)
 {
     fillImagePath = imagePath;
     if (!imagePath.isEmpty()) {
-        fillPixmap.load(imagePath);
-        if (fillPixmap.isNull()) {
-            qDebug() << "Failed to load image for filling:" << imagePath;
+        // 同一内容的图片在图片库中只有一份
+        fillMipChain = ImageStore::instance()->load(imagePath);
+        if (!fillMipChain) {
+            qCDebug(lcView) << "Failed to load image for filling:" << imagePath;
             fillImagePath.clear(); // 清空路径以避免使用无效图片
+        } else if (!fillMipChain->isComplete()) {
+            // 缩略层在后台生成，完成后重绘直接绘制的视口
+            connect(fillMipChain.get(), &ImageMipChain::levelsReady, viewport(), QOverload<>::of(&QWidget::update),
+                    Qt::UniqueConnection);
         }
     } else {
-        fillPixmap = QPixmap(); // 清空图片数据
+        fillMipChain.reset();
     }
 }
 
@@ -1436,7 +1577,7 @@ void GraphicsToolView::setDrawingFillImage(const QString &imagePath)
 void GraphicsToolView::setDrawingPenWidth(int width)
 {
     drawingPenWidth = width;
-    qDebug() << "Pen width set to:" << width;
+    qCDebug(lcView) << "Pen width set to:" << width;
 }
 
 // 设置线条样式
@@ -1449,25 +1590,19 @@ void GraphicsToolView::setDrawingLineStyle(LineStyle style)
 // 对齐选定项
 void GraphicsToolView::alignSelectedItems(AlignmentType type)
 {
-    if (selectedItems.isEmpty()) {
-        qDebug() << "No items selected for alignment.";
+    if (selection.isEmpty()) {
+        qCDebug(lcView) << "No items selected for alignment.";
         return;
     }
 
-    // 计算选中项的共同边界矩形
-    QRectF unionRect;
-    for (QGraphicsItem *item : selectedItems) {
-        if (unionRect.isNull()) {
-            unionRect = item->sceneBoundingRect();
-        } else {
-            unionRect = unionRect.united(item->sceneBoundingRect());
-        }
-    }
+    // 选中项的共同边界矩形由选择模型缓存
+    const QRectF unionRect = selection.boundingRect();
 
-    qDebug() << "Alignment type:" << type;
-    qDebug() << "Bounding rect of selected items:" << unionRect;
+    qCDebug(lcView) << "Alignment type:" << type;
+    qCDebug(lcView) << "Bounding rect of selected items:" << unionRect;
 
-    for (QGraphicsItem *item : selectedItems) {
+    SceneTransaction transaction(scene(), selection.size());
+    for (QGraphicsItem *item : selection.items()) {
         // 将项的当前位置转换为场景坐标
         QPointF currentScenePos = item->scenePos();
         QRectF itemRect = item->sceneBoundingRect();
@@ -1496,7 +1631,8 @@ void GraphicsToolView::alignSelectedItems(AlignmentType type)
 
         // 设置项的新位置 (场景坐标)
         item->setPos(newScenePos);
-        qDebug() << "Item" << item << "new position:" << newScenePos;
+        qCDebug(lcView) << "Item" << item << "new position:" << newScenePos;
     }
-    scene()->update(); // 强制场景更新
+    selection.invalidateBounds();
+    transaction.commit(); // 一次重建索引并重绘
 }
@@ -10,6 +10,18 @@
 #include <QKeyEvent>
 #include "color_selector_popup.h"
 #include "editable_polyline_item.h"
+#include "picking_engine.h"
+#include "selection_model.h"
+#include "selection_overlay.h"
+#include "move_session.h"
+#include "preview_layer.h"
+#include "input_coalescer.h"
+#include "tile_render_cache.h"
+#include "item_cache_policy.h"
+#include "image_mip_chain.h"
+#include <QTimer>
+#include <memory>
+#include <functional>
 #include <QGraphicsEllipseItem> // 包含椭圆项
 #include <QGraphicsPathItem> // 用于绘制路径，包括圆弧
 #include <QPainterPath>      // 用于定义路径
@@ -20,8 +32,8 @@
 
 #include <QTime>
 
-class HandleItem; // 前向声明
 class EditableLineItem;
+class BakedLayerItem;
 class GraphicsToolView : public QGraphicsView
 {
     Q_OBJECT
@@ -63,6 +75,9 @@ public:
 
 
     void applyColorToSelectedItems(const QColor &color);
+    SelectionModel *selectionModel() { return &selection; } // 当前选择
+    void setTileCacheEnabled(bool enabled); // 场景内容改由后台渲染的瓦片缓存绘制
+    ItemCachePolicy *cachePolicy() { return itemCachePolicy; } // 直接绘制场景时的图元缓存策略
 public slots:
     void copySelectedItems();
     void pasteCopiedItems();
@@ -70,6 +85,13 @@ public slots:
     void onColorSelected(const QColor &color); // 处理颜色选择信号
 
     void deleteSelectedItems();
+    void selectAllItems(); // 全选
+    // 把选中的直线、折线和矩形打包为一个批量图元（静态图层）；
+    // 这些图元在叠放次序中不连续时拒绝打包并返回 false
+    bool packSelectedItems();
+    // 把选中项（无选中时为全部图元）烘焙为一个图层，点中其内容时自动解冻；
+    // 这些图元在叠放次序中不连续时拒绝烘焙并返回 false
+    bool freezeItems();
 public:
 
     void setDrawingFillImage(const QString &imagePath); // 设置填充图片
@@ -115,14 +137,15 @@ public:
     void keyPressEvent(QKeyEvent *event) override;
     void mouseReleaseEvent(QMouseEvent *event) override;
     void keyReleaseEvent(QKeyEvent *event) override;
+    void drawForeground(QPainter *painter, const QRectF &rect) override;
+    void scrollContentsBy(int dx, int dy) override;
+    void paintEvent(QPaintEvent *event) override;
     void handlePolylineModePress(QMouseEvent *event); // 折线模式处理
     void handlePolylineModeMove(QMouseEvent *event);  // 折线模式移动处理
     void finishPolyline(); // 结束折线绘制
-    bool checkHandleHit(const QPointF &scenePos); // 更新以支持折线端点
 
-    void handleNoneModePress(QMouseEvent *event);
-    bool checkSelectedGroupHit(const QPointF &scenePos, qreal tolerance);
-    void handleItemSelection(const QPointF &scenePos, qreal tolerance, bool isMultiSelect);
+    void handleNoneModePress(QMouseEvent *event, const PickResult &pick);
+    void handleItemSelection(const PickResult &pick, bool isMultiSelect);
     void handleLineModePress(QMouseEvent *event);
     void handleLineModeMove(QMouseEvent *event);
     void handleHandleMove(QMouseEvent *event);
@@ -131,9 +154,27 @@ public:
     void handleHandleRelease();
     void handleGroupRelease();
 
-    void updateCursorBasedOnPosition(const QPointF &scenePos);
+    void updateCursorBasedOnPosition(const PickResult &pick);
     void updatePolylinePreview(const QPointF &currentMousePos);
 private:
+    void processMouseMove(QMouseEvent *event); // 每帧一次，处理合并后的鼠标移动
+    bool unpackPrimitiveAt(const QPoint &viewPos); // 把批量图元中光标处的图元转换回可编辑图元
+    void unbakeLayer(BakedLayerItem *layer); // 把烘焙图层中的图元放回场景
+    // 按叠放次序（自底向上）取出满足 accept 的顶层图元；它们之间夹着其他顶层图元时返回 false，
+    // 否则 above 为紧邻其上的顶层图元（没有时为 nullptr）
+    bool collectStackedRun(const std::function<bool(QGraphicsItem*)> &accept,
+                           QList<QGraphicsItem*> &run, QGraphicsItem *&above) const;
+    QGraphicsItem *topLevelItemAbove(QGraphicsItem *item) const; // 叠放次序中紧邻 item 之上的顶层图元，没有时为 nullptr
+    void applyWheelZoom(qreal angleDelta, const QPointF &anchorPos); // 以光标为中心缩放
+    InputCoalescer *inputCoalescer; // 鼠标移动和滚轮事件按帧合并
+    TileRenderCache *tileCache; // 视口瓦片缓存
+    ItemCachePolicy *itemCachePolicy; // 不走瓦片缓存时为复杂图元分配缓存
+
+    // 交互渲染模式：交互期间关闭抗锯齿、平滑缩放和虚线，空闲后恢复
+    void beginInteractiveRender();
+    void restoreFullQuality();
+    QTimer *qualityRestoreTimer;
+
     QColor drawingColor; // 当前绘图颜色
     int drawingPenWidth; // 当前绘图线条粗细
     LineStyle drawingLineStyle; // 新增: 当前绘图线条样式
@@ -144,12 +185,11 @@ private:
     bool isDrawingLine = false;
     QPointF startPoint;
     QPointF endPoint;
-    QGraphicsLineItem *previewLine = nullptr;
     DrawingMode currentMode;
-    QList<QGraphicsItem*> selectedItems;
+    SelectionModel selection; // 当前选中的图形项
     QList<QGraphicsItem*> copiedItems; // 存储复制的图形项
 
-    HandleItem* draggedHandle = nullptr; // 存储当前正在拖动的端点
+    HandleRole draggedHandleRole = HandleRole::None; // 当前正在拖动的控制点类型
     QGraphicsItem* draggedItem = nullptr; // 存储当前正在拖动的项
 
     bool isDraggingSelectionGroup = false; // 标志是否正在拖动选中组
@@ -169,17 +209,14 @@ private:
     int draggedHandleIndex;
     bool closePolylineOnFinish = false; // 是否在结束时闭合折线
 
-    EditableLineItem *previewClosingSegment = nullptr; // 闭合预览线（从鼠标到第一个点） // 新增
 
 
 
     // 矩形绘制相关
-    QGraphicsRectItem *previewRect = nullptr; // 预览矩形
     QPointF rectStartPoint; // 矩形绘制的起始点
 
 
     // 椭圆绘制相关
-    QGraphicsEllipseItem *previewEllipse = nullptr; // 预览椭圆
     QPointF ellipseStartPoint; // 椭圆绘制的起始点 (与rectStartPoint功能类似，但可以分开管理)
 
 
@@ -193,13 +230,12 @@ private:
     ArcDrawingState currentArcState;
     QPointF arcCenterPoint;
     QPointF arcRadiusStartPoint;
-    QGraphicsPathItem *previewArc = nullptr; // 预览圆弧
 
     // 多边形绘制相关
     // 注意：多边形绘制逻辑与折线非常相似，可以复用许多变量
     // bool isDrawingPolygon = false; // 可以复用 isDrawingPolyline
     // QVector<QPointF> polygonPoints; // 可以复用 polylinePoints
-    QGraphicsPolygonItem *previewPolygon = nullptr; // 预览多边形
+    void updatePolygonPreview(const QPointF &cursorPos); // 更新跟随鼠标的多边形预览边
     // EditablePolylineItem *currentPolyline = nullptr; // 这个可能需要调整为 QGraphicsPolygonItem
 
 
@@ -209,13 +245,20 @@ private:
     QColor drawingFillColor; // *** 当前填充颜色 ***
 
     QString fillImagePath; // 填充图片路径
-    QPixmap fillPixmap; // 存储填充图片数据
+    std::shared_ptr<ImageMipChain> fillMipChain; // 填充图片（来自共享图片库），本次选择的图片绘制的所有矩形共享
 
 
     QRubberBand *rubberBand = nullptr; // 用于显示选择框
     QPoint rubberBandOrigin;      // 选择框的起始点
     bool isSelectingWithRubberBand = false; // 是否正在进行框选
-
+    QList<QGraphicsItem*> rubberBandPreview; // 框选过程中将被选中的项（实时高亮）
+    void updateRubberBandPreview();
+
+    QPen drawingPen() const; // 当前颜色、线宽和线型组成的画笔
+    PreviewLayer previewLayer; // 绘制过程中的预览图形（前景绘制，不进入场景）
+    SelectionOverlay selectionOverlay; // 选中轮廓与控制点（前景绘制）
+    MoveSession moveSession; // 整组拖动会话（大量选中项时使用缓存位图）
+    PickingEngine pickingEngine; // 点击/悬停拾取引擎
 };
 
 #endif // GRAPHICS_TOOL_VIEW_H
@@ -0,0 +1,337 @@
+#include "hit_test_kernels.h"
+#include "editable_line_item.h"
+#include "editable_polyline_item.h"
+#include "arc_item.h"
+#include <QGraphicsRectItem>
+#include <QGraphicsEllipseItem>
+#include <QGraphicsPolygonItem>
+#include <QPainterPath>
+#include <QtConcurrent>
+#include <QtMath>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+// 候选项较少时串行更快，线程调度开销反而更大
+const int ParallelThreshold = 2048;
+
+enum class Kernel {
+    Segment,
+    Polyline,
+    Polygon,
+    Arc,
+    Rect,
+    Ellipse
+};
+
+// 在 GUI 线程中采集的几何快照，工作线程只读取快照，不访问图元本身
+struct HitCandidate
+{
+    QGraphicsItem *item = nullptr;
+    Kernel kernel = Kernel::Rect;
+    QRectF probe;          // 选择框（图元本地坐标，已按画笔半宽扩大）
+    QLineF line;
+    QPolygonF points;      // 折线/多边形顶点
+    QRectF rect;           // 矩形/椭圆
+    bool closed = false;
+    Qt::FillRule fillRule = Qt::OddEvenFill;
+    QPointF center;        // 圆弧
+    qreal radius = 0;
+    qreal startAngle = 0;
+    qreal spanAngle = 0;
+};
+
+bool angleInSpan(qreal angle, qreal start, qreal span)
+{
+    if (qAbs(span) >= 360.0) {
+        return true;
+    }
+    qreal d = std::fmod(span >= 0 ? angle - start : start - angle, 360.0);
+    if (d < 0) {
+        d += 360.0;
+    }
+    return d <= qAbs(span);
+}
+
+QPointF pointOnCircle(const QPointF &center, qreal radius, qreal angleDegrees)
+{
+    const qreal radians = qDegreesToRadians(angleDegrees);
+    return QPointF(center.x() + radius * qCos(radians), center.y() - radius * qSin(radians));
+}
+
+bool candidateHits(const HitCandidate &c)
+{
+    switch (c.kernel) {
+    case Kernel::Segment:
+        return HitTest::segmentIntersectsRect(c.line.p1(), c.line.p2(), c.probe);
+    case Kernel::Polyline:
+        return HitTest::polylineIntersectsRect(c.points.constData(), c.points.size(), c.closed, c.probe);
+    case Kernel::Polygon:
+        return HitTest::polygonIntersectsRect(c.points, c.fillRule, c.probe);
+    case Kernel::Arc:
+        return HitTest::arcIntersectsRect(c.center, c.radius, c.startAngle, c.spanAngle, c.probe);
+    case Kernel::Rect:
+        return c.rect.intersects(c.probe);
+    case Kernel::Ellipse:
+        return HitTest::ellipseIntersectsRect(c.rect, c.probe);
+    }
+    return false;
+}
+
+// 为支持解析测试的图元生成快照；不支持的类型返回 false，由调用方退回形状测试
+bool makeCandidate(QGraphicsItem *item, const QRectF &sceneRect, HitCandidate &c)
+{
+    const QTransform sceneTransform = item->sceneTransform();
+    if (sceneTransform.type() > QTransform::TxTranslate) {
+        return false; // 旋转/缩放过的图元仍使用形状测试
+    }
+    c.item = item;
+    c.probe = sceneRect.translated(-sceneTransform.dx(), -sceneTransform.dy());
+
+    qreal penWidth = 0;
+    switch (item->type()) {
+    case EditableLineItem::Type: {
+        EditableLineItem *lineItem = static_cast<EditableLineItem*>(item);
+        c.kernel = Kernel::Segment;
+        c.line = lineItem->line();
+        penWidth = lineItem->pen().widthF();
+        break;
+    }
+    case EditablePolylineItem::Type: {
+        EditablePolylineItem *polylineItem = static_cast<EditablePolylineItem*>(item);
+        c.kernel = Kernel::Polyline;
+        c.points = QPolygonF(polylineItem->getPoints());
+        c.closed = polylineItem->isClosed();
+        penWidth = polylineItem->pen().widthF();
+        break;
+    }
+    case ArcItem::Type: {
+        ArcItem *arcItem = static_cast<ArcItem*>(item);
+        c.kernel = Kernel::Arc;
+        c.center = arcItem->center();
+        c.radius = arcItem->radius();
+        c.startAngle = arcItem->startAngle();
+        c.spanAngle = arcItem->spanAngle();
+        penWidth = arcItem->pen().widthF();
+        break;
+    }
+    case QGraphicsPolygonItem::Type: {
+        QGraphicsPolygonItem *polygonItem = static_cast<QGraphicsPolygonItem*>(item);
+        c.kernel = Kernel::Polygon;
+        c.points = polygonItem->polygon();
+        c.fillRule = polygonItem->fillRule();
+        penWidth = polygonItem->pen().widthF();
+        break;
+    }
+    case QGraphicsRectItem::Type: {
+        QGraphicsRectItem *rectItem = static_cast<QGraphicsRectItem*>(item);
+        c.kernel = Kernel::Rect;
+        c.rect = rectItem->rect();
+        penWidth = rectItem->pen().widthF();
+        break;
+    }
+    case QGraphicsEllipseItem::Type: {
+        QGraphicsEllipseItem *ellipseItem = static_cast<QGraphicsEllipseItem*>(item);
+        if (ellipseItem->spanAngle() != 360 * 16) {
+            return false; // 扇形使用形状测试
+        }
+        c.kernel = Kernel::Ellipse;
+        c.rect = ellipseItem->rect();
+        penWidth = ellipseItem->pen().widthF();
+        break;
+    }
+    default:
+        return false;
+    }
+
+    const qreal halfPen = penWidth / 2.0;
+    c.probe.adjust(-halfPen, -halfPen, halfPen, halfPen);
+    return true;
+}
+
+} // namespace
+
+bool HitTest::segmentIntersectsRect(const QPointF &a, const QPointF &b, const QRectF &rect)
+{
+    if (rect.contains(a) || rect.contains(b)) {
+        return true;
+    }
+    // Liang-Barsky 裁剪：线段与矩形有交集则裁剪区间非空
+    const qreal dx = b.x() - a.x();
+    const qreal dy = b.y() - a.y();
+    const qreal p[4] = { -dx, dx, -dy, dy };
+    const qreal q[4] = { a.x() - rect.left(), rect.right() - a.x(),
+                         a.y() - rect.top(), rect.bottom() - a.y() };
+    qreal t0 = 0.0;
+    qreal t1 = 1.0;
+    for (int i = 0; i < 4; ++i) {
+        if (p[i] == 0) {
+            if (q[i] < 0) {
+                return false; // 平行于该边且在外侧
+            }
+            continue;
+        }
+        const qreal t = q[i] / p[i];
+        if (p[i] < 0) {
+            if (t > t1) return false;
+            if (t > t0) t0 = t;
+        } else {
+            if (t < t0) return false;
+            if (t < t1) t1 = t;
+        }
+    }
+    return t0 <= t1;
+}
+
+bool HitTest::polylineIntersectsRect(const QPointF *points, int count, bool closed, const QRectF &rect)
+{
+    if (count == 1) {
+        return rect.contains(points[0]);
+    }
+    const qreal left = rect.left();
+    const qreal right = rect.right();
+    const qreal top = rect.top();
+    const qreal bottom = rect.bottom();
+    const int segmentCount = (closed && count >= 3) ? count : count - 1;
+    for (int i = 0; i < segmentCount; ++i) {
+        const QPointF &a = points[i];
+        const QPointF &b = points[(i + 1) % count];
+        // 先用线段包围盒快速排除
+        if (qMax(a.x(), b.x()) < left || qMin(a.x(), b.x()) > right ||
+            qMax(a.y(), b.y()) < top || qMin(a.y(), b.y()) > bottom) {
+            continue;
+        }
+        if (segmentIntersectsRect(a, b, rect)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+bool HitTest::polygonIntersectsRect(const QPolygonF &polygon, Qt::FillRule fillRule, const QRectF &rect)
+{
+    if (polygon.isEmpty() || !polygon.boundingRect().intersects(rect)) {
+        return false;
+    }
+    if (polylineIntersectsRect(polygon.constData(), polygon.size(), true, rect)) {
+        return true;
+    }
+    // 选择框完全落在多边形内部
+    return polygon.containsPoint(rect.center(), fillRule);
+}
+
+bool HitTest::arcIntersectsRect(const QPointF &center, qreal radius, qreal startAngle, qreal spanAngle, const QRectF &rect)
+{
+    if (radius <= 0) {
+        return rect.contains(center);
+    }
+    const QRectF circleRect(center.x() - radius, center.y() - radius, 2 * radius, 2 * radius);
+    if (!circleRect.intersects(rect)) {
+        return false;
+    }
+    // 任一端点在框内
+    if (rect.contains(pointOnCircle(center, radius, startAngle)) ||
+        rect.contains(pointOnCircle(center, radius, startAngle + spanAngle))) {
+        return true;
+    }
+    // 否则圆弧必须穿过框的某条边：求圆与每条边的交点，检查交点是否落在圆弧角度范围内
+    const QPointF corners[4] = { rect.topLeft(), rect.topRight(), rect.bottomRight(), rect.bottomLeft() };
+    for (int i = 0; i < 4; ++i) {
+        const QPointF a = corners[i];
+        const QPointF d = corners[(i + 1) % 4] - a;
+        const QPointF f = a - center;
+        const qreal qa = QPointF::dotProduct(d, d);
+        const qreal qb = 2.0 * QPointF::dotProduct(f, d);
+        const qreal qc = QPointF::dotProduct(f, f) - radius * radius;
+        const qreal disc = qb * qb - 4.0 * qa * qc;
+        if (qa == 0 || disc < 0) {
+            continue;
+        }
+        const qreal sq = qSqrt(disc);
+        const qreal roots[2] = { (-qb - sq) / (2.0 * qa), (-qb + sq) / (2.0 * qa) };
+        for (qreal t : roots) {
+            if (t < 0.0 || t > 1.0) {
+                continue;
+            }
+            const QPointF p = a + d * t;
+            const qreal angle = qRadiansToDegrees(qAtan2(-(p.y() - center.y()), p.x() - center.x()));
+            if (angleInSpan(angle, startAngle, spanAngle)) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool HitTest::ellipseIntersectsRect(const QRectF &ellipse, const QRectF &rect)
+{
+    const QRectF e = ellipse.normalized();
+    const qreal rx = e.width() / 2.0;
+    const qreal ry = e.height() / 2.0;
+    if (rx <= 0 || ry <= 0) {
+        return segmentIntersectsRect(e.topLeft(), e.bottomRight(), rect);
+    }
+    // 缩放到单位圆后，矩形仍为轴对齐矩形：求矩形上离圆心最近的点
+    const QPointF c = e.center();
+    const qreal left = (rect.left() - c.x()) / rx;
+    const qreal right = (rect.right() - c.x()) / rx;
+    const qreal top = (rect.top() - c.y()) / ry;
+    const qreal bottom = (rect.bottom() - c.y()) / ry;
+    const qreal nx = qBound(left, 0.0, right);
+    const qreal ny = qBound(top, 0.0, bottom);
+    return nx * nx + ny * ny <= 1.0;
+}
+
+QList<QGraphicsItem*> HitTest::itemsInRect(QGraphicsScene *scene, const QRectF &sceneRect, ItemFilter filter)
+{
+    QList<QGraphicsItem*> hits;
+    if (!scene || sceneRect.isEmpty()) {
+        return hits;
+    }
+
+    // 场景索引按包围盒预筛选
+    const QList<QGraphicsItem*> prefiltered = scene->items(sceneRect, Qt::IntersectsItemBoundingRect);
+    QVector<HitCandidate> candidates;
+    QList<QGraphicsItem*> shapeFallback;
+    candidates.reserve(prefiltered.size());
+    for (QGraphicsItem *item : prefiltered) {
+        if (item->parentItem() || !item->isVisible() || (filter && !filter(item))) {
+            continue; // 控制点等子项不参与框选
+        }
+        if (sceneRect.contains(item->sceneBoundingRect())) {
+            hits.append(item); // 完全在框内，无需精确测试
+            continue;
+        }
+        HitCandidate candidate;
+        if (makeCandidate(item, sceneRect, candidate)) {
+            candidates.append(candidate);
+        } else {
+            shapeFallback.append(item);
+        }
+    }
+
+    // 解析测试只读取快照，候选较多时并行执行
+    if (candidates.size() >= ParallelThreshold) {
+        candidates = QtConcurrent::blockingFiltered(candidates, candidateHits);
+    } else {
+        candidates.erase(std::remove_if(candidates.begin(), candidates.end(),
+                                        [](const HitCandidate &c) { return !candidateHits(c); }),
+                         candidates.end());
+    }
+    for (const HitCandidate &candidate : std::as_const(candidates)) {
+        hits.append(candidate.item);
+    }
+
+    // 其余类型仍使用图元自身的形状，只能在 GUI 线程中执行
+    if (!shapeFallback.isEmpty()) {
+        QPainterPath probe;
+        probe.addRect(sceneRect);
+        for (QGraphicsItem *item : std::as_const(shapeFallback)) {
+            if (item->collidesWithPath(item->mapFromScene(probe), Qt::IntersectsItemShape)) {
+                hits.append(item);
+            }
+        }
+    }
+    return hits;
+}
@@ -0,0 +1,31 @@
+#ifndef HIT_TEST_KERNELS_H
+#define HIT_TEST_KERNELS_H
+
+#include <QGraphicsScene>
+#include <QGraphicsItem>
+#include <QPointF>
+#include <QRectF>
+#include <QPolygonF>
+#include <QList>
+
+// 按图元类型的解析命中测试，替代 QPainterPath 形状求交
+namespace HitTest {
+
+bool segmentIntersectsRect(const QPointF &a, const QPointF &b, const QRectF &rect);
+// 逐段测试，命中即提前返回
+bool polylineIntersectsRect(const QPointF *points, int count, bool closed, const QRectF &rect);
+// 填充多边形：边相交、顶点在框内或框在多边形内部
+bool polygonIntersectsRect(const QPolygonF &polygon, Qt::FillRule fillRule, const QRectF &rect);
+// 圆弧轮廓（角度单位为度，与 QLineF::angle() 一致）
+bool arcIntersectsRect(const QPointF &center, qreal radius, qreal startAngle, qreal spanAngle, const QRectF &rect);
+// 填充椭圆
+bool ellipseIntersectsRect(const QRectF &ellipse, const QRectF &rect);
+
+typedef bool (*ItemFilter)(const QGraphicsItem *item);
+
+// 框选：先用场景索引按包围盒预筛选，再按类型做解析测试；候选较多时分发到多个线程
+QList<QGraphicsItem*> itemsInRect(QGraphicsScene *scene, const QRectF &sceneRect, ItemFilter filter = nullptr);
+
+} // namespace HitTest
+
+#endif // HIT_TEST_KERNELS_H
@@ -0,0 +1,122 @@
+#include "image_mip_chain.h"
+#include "logging_categories.h"
+#include <QtConcurrent>
+#include <QDebug>
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#include <emmintrin.h>
+#define IMAGE_MIP_CHAIN_SSE2
+#endif
+
+namespace {
+
+// 工作线程：生成第 1 层及以下，只读取传入的图片
+QVector<QImage> buildLevels(const QImage &image)
+{
+    QVector<QImage> result;
+    QImage current = image.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    while (qMax(current.width(), current.height()) / 2 >= ImageMipChain::MinLevelSide) {
+        current = ImageMipChain::downsample(current);
+        result.append(current);
+    }
+    return result;
+}
+
+inline quint32 averagePixels(quint32 a, quint32 b, quint32 c, quint32 d)
+{
+    quint32 result = 0;
+    for (int shift = 0; shift < 32; shift += 8) {
+        const quint32 sum = ((a >> shift) & 0xff) + ((b >> shift) & 0xff) + ((c >> shift) & 0xff) + ((d >> shift) & 0xff);
+        result |= ((sum + 2) >> 2) << shift;
+    }
+    return result;
+}
+
+} // namespace
+
+ImageMipChain::ImageMipChain(const QImage &image)
+{
+    levels.append(image);
+    if (qMax(image.width(), image.height()) / 2 < MinLevelSide) {
+        complete = true;
+        return;
+    }
+    connect(&watcher, &QFutureWatcher<QVector<QImage>>::finished, this, [this]() {
+        levels.append(watcher.result());
+        complete = true;
+        qCDebug(lcItems) << "Mip chain ready for" << size() << "image," << levels.size() << "levels.";
+        emit levelsReady();
+    });
+    watcher.setFuture(QtConcurrent::run(buildLevels, image));
+}
+
+qint64 ImageMipChain::byteSize() const
+{
+    qint64 bytes = 0;
+    for (const QImage &level : levels) {
+        bytes += level.sizeInBytes();
+    }
+    return bytes;
+}
+
+const QImage &ImageMipChain::levelFor(const QSizeF &deviceSize) const
+{
+    if (levels.size() == 1 || deviceSize.width() <= 0 || deviceSize.height() <= 0) {
+        return levels.first();
+    }
+    // 取两个方向中较小的缩小倍数，所选层在两个方向上都不低于目标分辨率
+    const qreal ratio = qMin(size().width() / deviceSize.width(), size().height() / deviceSize.height());
+    if (ratio < 2.0) {
+        return levels.first();
+    }
+    const int level = qMin(int(std::floor(std::log2(ratio))), levels.size() - 1);
+    return levels.at(level);
+}
+
+QImage ImageMipChain::downsample(const QImage &source)
+{
+    const QImage input = source.format() == QImage::Format_ARGB32_Premultiplied
+                             ? source : source.convertToFormat(QImage::Format_ARGB32_Premultiplied);
+    const int sourceWidth = input.width();
+    const int sourceHeight = input.height();
+    const int width = qMax(1, sourceWidth / 2);
+    const int height = qMax(1, sourceHeight / 2);
+    QImage result(width, height, QImage::Format_ARGB32_Premultiplied);
+    for (int y = 0; y < height; ++y) {
+        const quint32 *row0 = reinterpret_cast<const quint32*>(input.constScanLine(qMin(2 * y, sourceHeight - 1)));
+        const quint32 *row1 = reinterpret_cast<const quint32*>(input.constScanLine(qMin(2 * y + 1, sourceHeight - 1)));
+        quint32 *out = reinterpret_cast<quint32*>(result.scanLine(y));
+        int x = 0;
+#ifdef IMAGE_MIP_CHAIN_SSE2
+        if (sourceWidth >= 2) {
+            const __m128i zero = _mm_setzero_si128();
+            const __m128i bias = _mm_set1_epi16(2);
+            // 每次读取两行各 8 个像素，按 16 位通道累加后输出 4 个像素
+            for (; x + 4 <= width; x += 4) {
+                const __m128i a0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 2 * x));
+                const __m128i a1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row0 + 2 * x + 4));
+                const __m128i b0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 2 * x));
+                const __m128i b1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row1 + 2 * x + 4));
+                // 上下两行相加，每个寄存器两个像素
+                const __m128i s0 = _mm_add_epi16(_mm_unpacklo_epi8(a0, zero), _mm_unpacklo_epi8(b0, zero));
+                const __m128i s1 = _mm_add_epi16(_mm_unpackhi_epi8(a0, zero), _mm_unpackhi_epi8(b0, zero));
+                const __m128i s2 = _mm_add_epi16(_mm_unpacklo_epi8(a1, zero), _mm_unpacklo_epi8(b1, zero));
+                const __m128i s3 = _mm_add_epi16(_mm_unpackhi_epi8(a1, zero), _mm_unpackhi_epi8(b1, zero));
+                // 左右相邻像素相加
+                const __m128i h0 = _mm_add_epi16(_mm_unpacklo_epi64(s0, s1), _mm_unpackhi_epi64(s0, s1));
+                const __m128i h1 = _mm_add_epi16(_mm_unpacklo_epi64(s2, s3), _mm_unpackhi_epi64(s2, s3));
+                const __m128i r0 = _mm_srli_epi16(_mm_add_epi16(h0, bias), 2);
+                const __m128i r1 = _mm_srli_epi16(_mm_add_epi16(h1, bias), 2);
+                _mm_storeu_si128(reinterpret_cast<__m128i*>(out + x), _mm_packus_epi16(r0, r1));
+            }
+        }
+#endif
+        for (; x < width; ++x) {
+            const int left = qMin(2 * x, sourceWidth - 1);
+            const int right = qMin(2 * x + 1, sourceWidth - 1);
+            out[x] = averagePixels(row0[left], row0[right], row1[left], row1[right]);
+        }
+    }
+    return result;
+}
@@ -0,0 +1,42 @@
+#ifndef IMAGE_MIP_CHAIN_H
+#define IMAGE_MIP_CHAIN_H
+
+#include <QObject>
+#include <QImage>
+#include <QVector>
+#include <QSizeF>
+#include <QFutureWatcher>
+
+// 填充图片的多级缩略链：第 0 层是原图，之后每层长宽减半（2x2 均值），由线程池后台生成。
+// 绘制时按目标设备像素尺寸选取不低于目标分辨率的最小一层；生成完成前只有原图可用。
+// 由 ImageStore 按内容去重后通过 std::shared_ptr 共享给各图元，只在 GUI 线程访问。
+class ImageMipChain : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ImageMipChain(const QImage &image);
+
+    const QImage &original() const { return levels.first(); }
+    QSize size() const { return levels.first().size(); }
+    bool isComplete() const { return complete; }
+    int levelCount() const { return levels.size(); }
+    qint64 byteSize() const; // 全部已生成层的像素占用
+
+    // deviceSize 为图片绘制到设备上的尺寸（设备像素）
+    const QImage &levelFor(const QSizeF &deviceSize) const;
+
+    // 长宽减半的 2x2 均值缩小（预乘 ARGB32），x86 上使用 SSE2 每次输出 4 个像素
+    static QImage downsample(const QImage &source);
+
+    static constexpr int MinLevelSide = 8; // 长边小于此值后不再生成更小的层
+
+signals:
+    void levelsReady(); // 后台生成完成，视图可据此重绘
+
+private:
+    QVector<QImage> levels;
+    bool complete = false;
+    QFutureWatcher<QVector<QImage>> watcher;
+};
+
+#endif // IMAGE_MIP_CHAIN_H
@@ -0,0 +1,189 @@
+#include "image_store.h"
+#include "logging_categories.h"
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QFileInfo>
+#include <QFile>
+#include <QStringList>
+#include <QDebug>
+#include <algorithm>
+
+ImageStore::ImageStore(QObject *parent)
+    : QObject(parent)
+{
+}
+
+ImageStore *ImageStore::instance()
+{
+    // 随应用对象销毁，先于线程池退出，场景中的图元此时已经释放
+    static ImageStore *store = new ImageStore(QCoreApplication::instance());
+    return store;
+}
+
+std::shared_ptr<ImageMipChain> ImageStore::load(const QString &filePath)
+{
+    const QFileInfo info(filePath);
+    if (!info.isFile()) {
+        qCWarning(lcIo) << "Image file not found:" << filePath;
+        return nullptr;
+    }
+    const QString key = info.absoluteFilePath();
+    auto path = paths.constFind(key);
+    if (path != paths.cend() && path->fileSize == info.size() && path->modified == info.lastModified()) {
+        auto record = records.find(path->hash);
+        if (record != records.end()) {
+            record->lastUsed = ++useCounter;
+            return record->chain;
+        }
+    }
+
+    QFile file(key);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCWarning(lcIo) << "Cannot open image file:" << filePath << file.errorString();
+        return nullptr;
+    }
+    const QByteArray data = file.readAll();
+    const QByteArray hash = QCryptographicHash::hash(data, QCryptographicHash::Sha1);
+    paths.insert(key, PathEntry{hash, info.size(), info.lastModified()});
+    auto record = records.find(hash);
+    if (record != records.end()) {
+        record->lastUsed = ++useCounter;
+        qCDebug(lcItems) << "Image store hit by content:" << filePath << "->" << record->label;
+        return record->chain;
+    }
+    const QImage image = QImage::fromData(data);
+    if (image.isNull()) {
+        qCWarning(lcIo) << "Cannot decode image file:" << filePath;
+        return nullptr;
+    }
+    return addRecord(hash, image, info.fileName());
+}
+
+QPixmap ImageStore::thumbnail(const QString &filePath, const QSize &size)
+{
+    const std::shared_ptr<ImageMipChain> chain = load(filePath);
+    if (!chain || size.isEmpty()) {
+        return QPixmap();
+    }
+    auto found = records.find(paths.value(QFileInfo(filePath).absoluteFilePath()).hash);
+    if (found == records.end()) {
+        return QPixmap();
+    }
+    Record &record = *found;
+    const quint64 key = (quint64(quint32(size.width())) << 32) | quint32(size.height());
+    auto cached = record.thumbnails.constFind(key);
+    if (cached != record.thumbnails.cend()) {
+        return *cached;
+    }
+    // 从不小于目标尺寸的缩略层缩放，避免每次缩放原图
+    const QSize target = chain->size().scaled(size, Qt::KeepAspectRatio);
+    const QImage &level = chain->levelFor(QSizeF(target));
+    const QPixmap pixmap = QPixmap::fromImage(level.scaled(target, Qt::IgnoreAspectRatio, Qt::SmoothTransformation));
+    record.thumbnails.insert(key, pixmap);
+    trim();
+    return pixmap;
+}
+
+void ImageStore::setMemoryBudget(qint64 bytes)
+{
+    budget = qMax<qint64>(0, bytes);
+    trim();
+}
+
+qint64 ImageStore::totalBytes() const
+{
+    qint64 total = 0;
+    for (const Record &record : records) {
+        total += recordBytes(record);
+    }
+    return total;
+}
+
+QVector<ImageStore::ImageReport> ImageStore::report() const
+{
+    QVector<ImageReport> result;
+    result.reserve(records.size());
+    for (const Record &record : records) {
+        ImageReport entry;
+        entry.label = record.label;
+        entry.size = record.chain->size();
+        entry.levels = record.chain->levelCount();
+        entry.bytes = recordBytes(record);
+        entry.users = int(record.chain.use_count()) - 1;
+        result.append(entry);
+    }
+    std::sort(result.begin(), result.end(), [](const ImageReport &a, const ImageReport &b) {
+        return a.bytes > b.bytes;
+    });
+    return result;
+}
+
+QString ImageStore::reportText() const
+{
+    QStringList lines;
+    lines << tr("图片库占用: %1 / %2 KB，共 %3 张")
+                 .arg(totalBytes() / 1024).arg(budget / 1024).arg(records.size());
+    for (const ImageReport &entry : report()) {
+        lines << tr("%1  %2x%3  %4 层  %5 KB  使用者 %6")
+                     .arg(entry.label).arg(entry.size.width()).arg(entry.size.height())
+                     .arg(entry.levels).arg(entry.bytes / 1024).arg(entry.users);
+    }
+    return lines.join(QLatin1Char('\n'));
+}
+
+std::shared_ptr<ImageMipChain> ImageStore::addRecord(const QByteArray &hash, const QImage &image, const QString &label)
+{
+    Record record;
+    record.chain = std::make_shared<ImageMipChain>(image);
+    record.label = label;
+    record.lastUsed = ++useCounter;
+    // 缩略层生成后占用增加，需要重新检查上限；排队执行，避免在图片自身的信号中释放它
+    connect(record.chain.get(), &ImageMipChain::levelsReady, this, [this]() {
+        trim();
+        emit changed();
+    }, Qt::QueuedConnection);
+    const std::shared_ptr<ImageMipChain> chain = record.chain;
+    records.insert(hash, record);
+    qCDebug(lcItems) << "Image store added" << label << image.size();
+    trim();
+    emit changed();
+    return chain;
+}
+
+qint64 ImageStore::recordBytes(const Record &record)
+{
+    qint64 bytes = record.chain->byteSize();
+    for (const QPixmap &pixmap : record.thumbnails) {
+        bytes += qint64(pixmap.width()) * pixmap.height() * pixmap.depth() / 8;
+    }
+    return bytes;
+}
+
+void ImageStore::trim()
+{
+    qint64 total = totalBytes();
+    if (total <= budget) {
+        return;
+    }
+    // 只释放库外无人使用的图片，最久未用的先释放
+    QVector<QByteArray> unused;
+    for (auto it = records.cbegin(); it != records.cend(); ++it) {
+        if (it->chain.use_count() == 1) {
+            unused.append(it.key());
+        }
+    }
+    std::sort(unused.begin(), unused.end(), [this](const QByteArray &a, const QByteArray &b) {
+        return records.constFind(a)->lastUsed < records.constFind(b)->lastUsed;
+    });
+    for (const QByteArray &hash : std::as_const(unused)) {
+        if (total <= budget) {
+            break;
+        }
+        const Record record = records.take(hash);
+        total -= recordBytes(record);
+        qCDebug(lcItems) << "Image store released" << record.label;
+    }
+    if (total > budget) {
+        qCWarning(lcItems) << "Images in use exceed the image store budget:" << total << ">" << budget;
+    }
+}
@@ -0,0 +1,73 @@
+#ifndef IMAGE_STORE_H
+#define IMAGE_STORE_H
+
+#include <QObject>
+#include <QHash>
+#include <QDateTime>
+#include <QPixmap>
+#include <QVector>
+#include <QSize>
+#include <memory>
+#include "image_mip_chain.h"
+
+// 共享图片库：图片按内容哈希（SHA-1）去重，同一张图片无论被多少矩形、缩略图使用都只解码保存一份。
+// 使用方持有 std::shared_ptr；无人使用的图片在内存上限内按最近使用保留，超出时最久未用的先释放。
+// 只在 GUI 线程使用。
+class ImageStore : public QObject
+{
+    Q_OBJECT
+public:
+    static ImageStore *instance();
+
+    // 加载图片文件，失败返回空指针；文件未变化时不再读取
+    std::shared_ptr<ImageMipChain> load(const QString &filePath);
+    // 列表缩略图，从不小于目标尺寸的缩略层生成并按尺寸缓存
+    QPixmap thumbnail(const QString &filePath, const QSize &size);
+
+    void setMemoryBudget(qint64 bytes);
+    qint64 memoryBudget() const { return budget; }
+    qint64 totalBytes() const;
+
+    // 每张图片的占用
+    struct ImageReport {
+        QString label;
+        QSize size;
+        int levels = 0;
+        qint64 bytes = 0; // 全部缩略层和缩略图
+        int users = 0;    // 库外持有者数量
+    };
+    QVector<ImageReport> report() const;
+    QString reportText() const;
+
+    static constexpr qint64 DefaultMemoryBudget = 256 * 1024 * 1024;
+
+signals:
+    void changed();
+
+private:
+    explicit ImageStore(QObject *parent = nullptr);
+
+    struct Record {
+        std::shared_ptr<ImageMipChain> chain;
+        QString label;
+        QHash<quint64, QPixmap> thumbnails; // 键为宽高
+        quint64 lastUsed = 0;
+    };
+    // 文件路径到内容哈希，文件大小和修改时间不变时直接复用
+    struct PathEntry {
+        QByteArray hash;
+        qint64 fileSize = 0;
+        QDateTime modified;
+    };
+
+    std::shared_ptr<ImageMipChain> addRecord(const QByteArray &hash, const QImage &image, const QString &label);
+    static qint64 recordBytes(const Record &record);
+    void trim();
+
+    QHash<QByteArray, Record> records;
+    QHash<QString, PathEntry> paths;
+    qint64 budget = DefaultMemoryBudget;
+    quint64 useCounter = 0;
+};
+
+#endif // IMAGE_STORE_H
@@ -0,0 +1,74 @@
+#include "input_coalescer.h"
+#include <QScreen>
+#include <QtMath>
+
+InputCoalescer::InputCoalescer(QWidget *widget)
+    : QObject(widget),
+    widget(widget)
+{
+    frameTimer.setSingleShot(true);
+    frameTimer.setTimerType(Qt::PreciseTimer);
+    connect(&frameTimer, &QTimer::timeout, this, &InputCoalescer::deliver);
+    sinceDelivery.start();
+}
+
+void InputCoalescer::pushMove(const QMouseEvent *event)
+{
+    hasMove = true;
+    latestLocalPos = event->position();
+    latestGlobalPos = event->globalPosition();
+    latestButtons = event->buttons();
+    latestModifiers = event->modifiers();
+    history.append(latestLocalPos);
+    schedule();
+}
+
+void InputCoalescer::pushWheel(const QWheelEvent *event)
+{
+    // 高精度触控板的增量很小，累加后按比例缩放，而不是每个事件固定缩放一次
+    pendingWheel += event->angleDelta().y();
+    wheelAnchor = event->position();
+    schedule();
+}
+
+void InputCoalescer::flush()
+{
+    frameTimer.stop();
+    deliver();
+}
+
+void InputCoalescer::schedule()
+{
+    if (frameTimer.isActive()) {
+        return; // 本帧已经安排分发
+    }
+    // 距上次分发已超过一帧时立即分发，避免引入额外延迟
+    const int remaining = frameInterval() - int(sinceDelivery.elapsed());
+    if (remaining <= 0) {
+        deliver();
+    } else {
+        frameTimer.start(remaining);
+    }
+}
+
+void InputCoalescer::deliver()
+{
+    sinceDelivery.restart();
+    if (hasMove) {
+        hasMove = false;
+        emit moveFrame(latestLocalPos, latestGlobalPos, latestButtons, latestModifiers);
+        history.clear();
+    }
+    if (!qFuzzyIsNull(pendingWheel)) {
+        const qreal delta = pendingWheel;
+        pendingWheel = 0.0;
+        emit wheelFrame(delta, wheelAnchor);
+    }
+}
+
+int InputCoalescer::frameInterval() const
+{
+    const QScreen *screen = widget->screen();
+    const qreal refreshRate = (screen && screen->refreshRate() > 0) ? screen->refreshRate() : 60.0;
+    return qMax(1, qRound(1000.0 / refreshRate));
+}
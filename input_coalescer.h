@@ -0,0 +1,54 @@
+#ifndef INPUT_COALESCER_H
+#define INPUT_COALESCER_H
+
+#include <QObject>
+#include <QWidget>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QMouseEvent>
+#include <QWheelEvent>
+#include <QPointF>
+#include <QVector>
+
+// 输入合并器：把高频鼠标移动和滚轮事件按显示帧合并。
+// 每帧只分发一次移动（取最新位置，完整轨迹保留在 moveHistory() 中），
+// 滚轮增量在一帧内累加后一次性分发。
+class InputCoalescer : public QObject
+{
+    Q_OBJECT
+public:
+    explicit InputCoalescer(QWidget *widget);
+
+    void pushMove(const QMouseEvent *event);
+    void pushWheel(const QWheelEvent *event);
+    void flush(); // 立即分发所有待处理输入（按下/释放前调用，保证事件顺序）
+
+    // 本帧内所有移动位置（视口坐标，按时间顺序），只在 moveFrame 处理期间有效
+    const QVector<QPointF> &moveHistory() const { return history; }
+
+signals:
+    void moveFrame(const QPointF &localPos, const QPointF &globalPos,
+                   Qt::MouseButtons buttons, Qt::KeyboardModifiers modifiers);
+    void wheelFrame(qreal angleDelta, const QPointF &anchorPos); // angleDelta 以 1/8 度为单位
+
+private:
+    void schedule();
+    void deliver();
+    int frameInterval() const; // 毫秒，按屏幕刷新率计算
+
+    QWidget *widget;
+    QTimer frameTimer;
+    QElapsedTimer sinceDelivery;
+
+    bool hasMove = false;
+    QPointF latestLocalPos;
+    QPointF latestGlobalPos;
+    Qt::MouseButtons latestButtons;
+    Qt::KeyboardModifiers latestModifiers;
+    QVector<QPointF> history;
+
+    qreal pendingWheel = 0.0;
+    QPointF wheelAnchor;
+};
+
+#endif // INPUT_COALESCER_H
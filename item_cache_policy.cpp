@@ -0,0 +1,350 @@
+#include "item_cache_policy.h"
+#include "editable_polyline_item.h"
+#include "bulk_primitive_item.h"
+#include "custom_rect_item.h"
+#include "selection_model.h"
+#include "render_quality.h"
+#include "scene_item_events.h"
+#include "logging_categories.h"
+#include <QGraphicsScene>
+#include <QGraphicsPolygonItem>
+#include <QGraphicsPathItem>
+#include <QGraphicsTextItem>
+#include <QStyleOptionGraphicsItem>
+#include <QPixmapCache>
+#include <QElapsedTimer>
+#include <QPainter>
+#include <QImage>
+#include <QtMath>
+#include <QDebug>
+#include <algorithm>
+#include <limits>
+
+namespace {
+
+constexpr int MaxStaleProfiles = 4096; // 不可见图元的测量结果超过此数量时清理
+constexpr int QtDefaultPixmapCacheKB = 10240;
+
+qreal levelOfDetailOf(const QTransform &transform)
+{
+    return qSqrt(qAbs(transform.determinant()));
+}
+
+} // namespace
+
+ItemCachePolicy::ItemCachePolicy(QGraphicsView *view)
+    : QObject(view),
+    view(view)
+{
+    evaluateTimer.setSingleShot(true);
+    evaluateTimer.setInterval(EvaluateDelayMs);
+    connect(&evaluateTimer, &QTimer::timeout, this, &ItemCachePolicy::evaluate);
+    setMemoryBudget(DefaultMemoryBudget);
+    if (view->scene()) {
+        SceneItemEvents *events = SceneItemEvents::of(view->scene());
+        connect(events, &SceneItemEvents::itemRemoving, this, &ItemCachePolicy::forget);
+        connect(events, &SceneItemEvents::clearing, this, &ItemCachePolicy::forgetAll);
+    }
+}
+
+void ItemCachePolicy::setEnabled(bool enabled)
+{
+    if (this->enabled == enabled) {
+        return;
+    }
+    this->enabled = enabled;
+    if (!enabled) {
+        evaluateTimer.stop();
+        clear();
+    }
+    qCDebug(lcView) << "Item cache policy" << (enabled ? "enabled." : "disabled.");
+}
+
+void ItemCachePolicy::setMemoryBudget(qint64 bytes)
+{
+    budget = qMax<qint64>(0, bytes);
+    // 图元缓存位图存放在 QPixmapCache 中，其上限不能低于本策略的预算
+    const int neededKB = int(qMin<qint64>(budget / 1024 + QtDefaultPixmapCacheKB, std::numeric_limits<int>::max()));
+    if (QPixmapCache::cacheLimit() < neededKB) {
+        QPixmapCache::setCacheLimit(neededKB);
+    }
+    evictToBudget();
+}
+
+void ItemCachePolicy::notePainted()
+{
+    // 已在计时则不重新计时，持续绘制时也能按固定间隔评估
+    if (enabled && !evaluateTimer.isActive()) {
+        evaluateTimer.start();
+    }
+}
+
+void ItemCachePolicy::clear()
+{
+    evaluateTimer.stop();
+    for (auto it = entries.cbegin(); it != entries.cend(); ++it) {
+        it.key()->setCacheMode(QGraphicsItem::NoCache);
+    }
+    entries.clear();
+    profiles.clear();
+    cacheBytes = 0;
+    emit reportChanged();
+}
+
+void ItemCachePolicy::invalidateCaches()
+{
+    // 缓存模式不变时 assign() 不会重设，位图只能靠重绘请求作废
+    for (auto it = entries.cbegin(); it != entries.cend(); ++it) {
+        it.key()->update();
+    }
+}
+
+void ItemCachePolicy::forget(QGraphicsItem *item)
+{
+    profiles.remove(item);
+    auto it = entries.find(item);
+    if (it == entries.end()) {
+        return;
+    }
+    // 图元可能被重新加入场景（如冻结后解冻），不能留着未记录的缓存
+    cacheBytes -= it->bytes;
+    entries.erase(it);
+    item->setCacheMode(QGraphicsItem::NoCache);
+}
+
+void ItemCachePolicy::forgetAll()
+{
+    entries.clear();
+    profiles.clear();
+    cacheBytes = 0;
+    emit reportChanged();
+}
+
+void ItemCachePolicy::evaluate()
+{
+    QGraphicsScene *scene = view->scene();
+    if (!enabled || !scene) {
+        return;
+    }
+    if (RenderQuality::isInteractive()) {
+        evaluateTimer.start(); // 交互期间缩放还在变化，停下来再评估
+        return;
+    }
+    QElapsedTimer timer;
+    timer.start();
+    ++passCounter;
+
+    const QTransform viewTransform = view->viewportTransform();
+    const QRectF visibleSceneRect = viewTransform.inverted().mapRect(QRectF(view->viewport()->rect()));
+    const QList<QGraphicsItem*> candidates = scene->items(visibleSceneRect, Qt::IntersectsItemBoundingRect);
+    QSet<QGraphicsItem*> visible;
+    int measured = 0;
+    bool deferred = false;
+    for (QGraphicsItem *item : candidates) {
+        if (item->parentItem() || !SelectionModel::isSelectableType(item)) {
+            continue;
+        }
+        visible.insert(item);
+        const QTransform deviceTransform = item->deviceTransform(viewTransform);
+        auto profile = profiles.find(item);
+        const qreal levelOfDetail = levelOfDetailOf(deviceTransform);
+        if (profile == profiles.end() || profile->boundingRect != item->boundingRect()
+            || levelOfDetail > profile->levelOfDetail * 2 || levelOfDetail < profile->levelOfDetail / 2) {
+            if (measured == ProfilesPerPass) {
+                deferred = true;
+                continue;
+            }
+            profile = profiles.insert(item, measure(item, deviceTransform));
+            ++measured;
+        }
+        QSize cacheSize;
+        qint64 bytes = 0;
+        const QGraphicsItem::CacheMode mode = chooseMode(item, *profile, deviceTransform, &cacheSize, &bytes);
+        assign(item, mode, cacheSize, bytes, profile->paintNs);
+    }
+    if (profiles.size() > visible.size() + MaxStaleProfiles) {
+        for (auto it = profiles.begin(); it != profiles.end();) {
+            it = visible.contains(it.key()) ? std::next(it) : profiles.erase(it);
+        }
+    }
+    evictToBudget();
+    if (deferred) {
+        evaluateTimer.start();
+    }
+
+    lastEvaluateUs = timer.nsecsElapsed() / 1000;
+    qCDebug(lcView).noquote() << reportText();
+    emit reportChanged();
+}
+
+ItemCachePolicy::Profile ItemCachePolicy::measure(QGraphicsItem *item, const QTransform &deviceTransform) const
+{
+    Profile profile;
+    profile.boundingRect = item->boundingRect();
+    profile.levelOfDetail = levelOfDetailOf(deviceTransform);
+    switch (item->type()) {
+    case EditablePolylineItem::Type:
+        profile.vertexCount = static_cast<EditablePolylineItem*>(item)->pointCount();
+        break;
+    case BulkPrimitiveItem::Type:
+        profile.vertexCount = static_cast<BulkPrimitiveItem*>(item)->primitiveCount() * 2;
+        break;
+    case QGraphicsPolygonItem::Type:
+        profile.vertexCount = static_cast<QGraphicsPolygonItem*>(item)->polygon().size();
+        break;
+    case QGraphicsPathItem::Type:
+        profile.vertexCount = static_cast<QGraphicsPathItem*>(item)->path().elementCount();
+        break;
+    case QGraphicsTextItem::Type:
+        profile.hasText = true;
+        break;
+    case QGraphicsRectItem::Type:
+        if (const CustomRectItem *rect = dynamic_cast<const CustomRectItem*>(item)) {
+            profile.hasImage = rect->hasFillImage();
+        }
+        break;
+    default:
+        break;
+    }
+
+    // 按当前缩放绘制到一块固定大小的画布上计时，大图元只绘制画布覆盖的部分
+    const QRectF deviceRect = deviceTransform.mapRect(profile.boundingRect);
+    if (deviceRect.isEmpty()) {
+        return profile;
+    }
+    QImage canvas(ProfileSide, ProfileSide, QImage::Format_ARGB32_Premultiplied);
+    canvas.fill(Qt::transparent);
+    QPainter painter(&canvas);
+    painter.setRenderHints(QPainter::Antialiasing | QPainter::SmoothPixmapTransform);
+    const QTransform canvasTransform = deviceTransform * QTransform::fromTranslate(-deviceRect.left(), -deviceRect.top());
+    painter.setTransform(canvasTransform);
+    QStyleOptionGraphicsItem option;
+    option.exposedRect = canvasTransform.inverted().mapRect(QRectF(canvas.rect())) & profile.boundingRect;
+    option.rect = profile.boundingRect.toAlignedRect();
+
+    const RenderQuality::FullQualityScope fullQuality; // 缓存内容按完整质量绘制
+    QElapsedTimer timer;
+    timer.start();
+    item->paint(&painter, &option, nullptr);
+    profile.paintNs = timer.nsecsElapsed();
+    painter.end();
+    return profile;
+}
+
+QGraphicsItem::CacheMode ItemCachePolicy::chooseMode(QGraphicsItem *item, const Profile &profile,
+                                                     const QTransform &deviceTransform,
+                                                     QSize *cacheSize, qint64 *bytes) const
+{
+    const bool expensive = profile.hasText || profile.hasImage || profile.vertexCount >= ComplexVertexCount
+                           || profile.paintNs >= qint64(CheapPaintUs) * 1000;
+    if (!expensive) {
+        return QGraphicsItem::NoCache;
+    }
+    const QRectF deviceRect = deviceTransform.mapRect(profile.boundingRect);
+    const QSize viewportSize = view->viewport()->size();
+    // 放大到比视口还大时缓存的复用率低而占用大，不缓存
+    if (deviceRect.width() * deviceRect.height() > qreal(viewportSize.width()) * viewportSize.height()) {
+        return QGraphicsItem::NoCache;
+    }
+    const qreal dpr = view->devicePixelRatioF();
+    if (item->transform().type() > QTransform::TxTranslate || !qFuzzyIsNull(item->rotation())
+        || !qFuzzyCompare(item->scale(), 1.0)) {
+        // 自身带旋转或缩放的图元用本地坐标缓存，变换改变时不必重绘
+        QSizeF size = profile.boundingRect.size() * profile.levelOfDetail * dpr;
+        const qreal longest = qMax(size.width(), size.height());
+        if (longest > MaxItemCacheSide) {
+            size *= MaxItemCacheSide / longest;
+        }
+        *cacheSize = QSize(qMax(1, qCeil(size.width())), qMax(1, qCeil(size.height())));
+        *bytes = qint64(cacheSize->width()) * cacheSize->height() * 4;
+        return QGraphicsItem::ItemCoordinateCache;
+    }
+    *bytes = qint64(qCeil(deviceRect.width() * dpr)) * qCeil(deviceRect.height() * dpr) * 4;
+    return QGraphicsItem::DeviceCoordinateCache;
+}
+
+void ItemCachePolicy::assign(QGraphicsItem *item, QGraphicsItem::CacheMode mode, const QSize &cacheSize,
+                             qint64 bytes, qint64 paintNs)
+{
+    auto it = entries.find(item);
+    if (mode == QGraphicsItem::NoCache) {
+        if (it != entries.end()) {
+            cacheBytes -= it->bytes;
+            entries.erase(it);
+            item->setCacheMode(QGraphicsItem::NoCache);
+        }
+        return;
+    }
+    if (it == entries.end()) {
+        it = entries.insert(item, Entry());
+    } else {
+        cacheBytes -= it->bytes;
+    }
+    if (it->mode != mode || it->cacheSize != cacheSize) {
+        item->setCacheMode(mode, cacheSize); // DeviceCoordinateCache 忽略尺寸
+        it->mode = mode;
+        it->cacheSize = cacheSize;
+    }
+    it->bytes = bytes;
+    it->paintNs = paintNs;
+    it->lastUsed = passCounter;
+    cacheBytes += bytes;
+}
+
+void ItemCachePolicy::evictToBudget()
+{
+    if (cacheBytes <= budget) {
+        return;
+    }
+    // 最久未用的先淘汰；同一次评估中可见的，按每字节节省的绘制耗时从低到高淘汰
+    QVector<QGraphicsItem*> order;
+    order.reserve(entries.size());
+    for (auto it = entries.cbegin(); it != entries.cend(); ++it) {
+        order.append(it.key());
+    }
+    std::sort(order.begin(), order.end(), [this](QGraphicsItem *a, QGraphicsItem *b) {
+        const Entry &left = *entries.constFind(a);
+        const Entry &right = *entries.constFind(b);
+        if (left.lastUsed != right.lastUsed) {
+            return left.lastUsed < right.lastUsed;
+        }
+        return qreal(left.paintNs) / qMax<qint64>(left.bytes, 1) < qreal(right.paintNs) / qMax<qint64>(right.bytes, 1);
+    });
+    for (QGraphicsItem *item : std::as_const(order)) {
+        if (cacheBytes <= budget) {
+            break;
+        }
+        const Entry entry = entries.take(item);
+        cacheBytes -= entry.bytes;
+        ++evictionCount;
+        item->setCacheMode(QGraphicsItem::NoCache);
+    }
+    qCDebug(lcView) << "Item caches evicted to budget, now" << cacheBytes << "bytes.";
+}
+
+ItemCachePolicy::Report ItemCachePolicy::report() const
+{
+    Report result;
+    result.profiledItems = profiles.size();
+    for (const Entry &entry : entries) {
+        if (entry.mode == QGraphicsItem::DeviceCoordinateCache) {
+            ++result.deviceCachedItems;
+        } else {
+            ++result.itemCachedItems;
+        }
+    }
+    result.cacheBytes = cacheBytes;
+    result.memoryBudget = budget;
+    result.evictions = evictionCount;
+    result.lastEvaluateUs = lastEvaluateUs;
+    return result;
+}
+
+QString ItemCachePolicy::reportText() const
+{
+    const Report r = report();
+    return tr("已测量图元: %1\n设备坐标缓存: %2\n图元坐标缓存: %3\n缓存占用: %4 / %5 KB\n累计淘汰: %6\n最近评估耗时: %7 us")
+        .arg(r.profiledItems).arg(r.deviceCachedItems).arg(r.itemCachedItems)
+        .arg(r.cacheBytes / 1024).arg(r.memoryBudget / 1024)
+        .arg(r.evictions).arg(r.lastEvaluateUs);
+}
@@ -0,0 +1,96 @@
+#ifndef ITEM_CACHE_POLICY_H
+#define ITEM_CACHE_POLICY_H
+
+#include <QObject>
+#include <QGraphicsView>
+#include <QGraphicsItem>
+#include <QHash>
+#include <QSet>
+#include <QTimer>
+#include <QString>
+
+// 图元缓存策略：按实测绘制耗时、复杂度（顶点数、图片填充、文字）和当前缩放，
+// 为可见图元选择 DeviceCoordinateCache、ItemCoordinateCache 或不缓存。
+// 全部缓存的估算占用受内存上限约束，超出时按最近使用时间（LRU）淘汰。
+// 只作用于视图直接绘制场景的路径；瓦片缓存接管绘制时由视图清空。
+// 图元经 SceneItemEvents 移出场景时立即忘掉它的记录，记录中的指针始终有效。
+class ItemCachePolicy : public QObject
+{
+    Q_OBJECT
+public:
+    explicit ItemCachePolicy(QGraphicsView *view);
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return enabled; }
+    void setMemoryBudget(qint64 bytes);
+    qint64 memoryBudget() const { return budget; }
+
+    void notePainted(); // 视图直接绘制场景后调用，稍后按可见图元重新评估
+    void clear();       // 取消全部已分配的缓存
+    // 已分配缓存的位图全部作废：交互期间按降低的质量重绘过的缓存，恢复完整质量后需要重新生成
+    void invalidateCaches();
+
+    // 统计信息
+    struct Report {
+        int profiledItems = 0;     // 已测量的图元
+        int deviceCachedItems = 0;
+        int itemCachedItems = 0;
+        qint64 cacheBytes = 0;     // 已分配缓存的估算占用
+        qint64 memoryBudget = 0;
+        quint64 evictions = 0;     // 累计因超出上限而取消的缓存
+        qint64 lastEvaluateUs = 0; // 最近一次评估耗时
+    };
+    Report report() const;
+    QString reportText() const;
+
+    static constexpr qint64 DefaultMemoryBudget = 64 * 1024 * 1024;
+    static constexpr int EvaluateDelayMs = 200;     // 绘制后多久评估一次，避免逐帧评估
+    static constexpr int ProfilesPerPass = 64;      // 每次评估最多测量的图元数，其余留到下一次
+    static constexpr int CheapPaintUs = 40;         // 绘制耗时低于此值且结构简单的图元不缓存
+    static constexpr int ComplexVertexCount = 64;   // 顶点数达到此值视为复杂图元
+    static constexpr int ProfileSide = 256;         // 测量绘制耗时的画布边长（像素）
+    static constexpr int MaxItemCacheSide = 1024;   // ItemCoordinateCache 位图边长上限
+
+signals:
+    void reportChanged();
+
+private:
+    struct Profile {
+        QRectF boundingRect;     // 测量时的本地包围盒，变化后重新测量
+        qreal levelOfDetail = 1.0; // 测量时的缩放，相差一倍以上时重新测量
+        qint64 paintNs = 0;
+        int vertexCount = 0;
+        bool hasText = false;
+        bool hasImage = false;
+    };
+    struct Entry {
+        QGraphicsItem::CacheMode mode = QGraphicsItem::NoCache;
+        QSize cacheSize;   // 仅 ItemCoordinateCache 使用
+        qint64 bytes = 0;
+        qint64 paintNs = 0;
+        quint64 lastUsed = 0;
+    };
+
+    void evaluate();
+    Profile measure(QGraphicsItem *item, const QTransform &deviceTransform) const;
+    QGraphicsItem::CacheMode chooseMode(QGraphicsItem *item, const Profile &profile, const QTransform &deviceTransform,
+                                        QSize *cacheSize, qint64 *bytes) const;
+    void assign(QGraphicsItem *item, QGraphicsItem::CacheMode mode, const QSize &cacheSize, qint64 bytes, qint64 paintNs);
+    void evictToBudget();
+    void forget(QGraphicsItem *item); // 图元即将移出场景
+    void forgetAll();                 // 场景即将清空，图元随后被删除
+
+    QGraphicsView *view;
+    bool enabled = true;
+    qint64 budget = DefaultMemoryBudget;
+    QTimer evaluateTimer;
+
+    QHash<QGraphicsItem*, Profile> profiles;
+    QHash<QGraphicsItem*, Entry> entries; // 已分配缓存的图元
+    qint64 cacheBytes = 0;
+    quint64 passCounter = 0;
+    quint64 evictionCount = 0;
+    qint64 lastEvaluateUs = 0;
+};
+
+#endif // ITEM_CACHE_POLICY_H
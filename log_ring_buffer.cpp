@@ -0,0 +1,125 @@
+#include "log_ring_buffer.h"
+#include <QDateTime>
+#include <QFile>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QTextStream>
+#include <QVector>
+#include <cstdio>
+
+namespace {
+
+// 日志可能来自工作线程，所有状态由互斥锁保护
+struct RingState {
+    QMutex mutex;
+    QVector<QString> entries;
+    int next = 0;   // 下一条写入位置
+    int count = 0;  // 已保存条数
+    bool installed = false;
+    QtMessageHandler previousHandler = nullptr;
+};
+
+RingState &ringState()
+{
+    static RingState state;
+    return state;
+}
+
+char typeLetter(QtMsgType type)
+{
+    switch (type) {
+    case QtDebugMsg: return 'D';
+    case QtInfoMsg: return 'I';
+    case QtWarningMsg: return 'W';
+    case QtCriticalMsg: return 'C';
+    case QtFatalMsg: return 'F';
+    }
+    return '?';
+}
+
+} // namespace
+
+void LogRingBuffer::install(int capacity)
+{
+    RingState &state = ringState();
+    QMutexLocker locker(&state.mutex);
+    state.entries = QVector<QString>(qMax(1, capacity));
+    state.next = 0;
+    state.count = 0;
+    if (!state.installed) {
+        state.previousHandler = qInstallMessageHandler(&LogRingBuffer::messageHandler);
+        state.installed = true;
+    }
+}
+
+void LogRingBuffer::uninstall()
+{
+    RingState &state = ringState();
+    QMutexLocker locker(&state.mutex);
+    if (!state.installed) {
+        return;
+    }
+    qInstallMessageHandler(state.previousHandler);
+    state.previousHandler = nullptr;
+    state.installed = false;
+}
+
+bool LogRingBuffer::isInstalled()
+{
+    RingState &state = ringState();
+    QMutexLocker locker(&state.mutex);
+    return state.installed;
+}
+
+QStringList LogRingBuffer::messages()
+{
+    RingState &state = ringState();
+    QMutexLocker locker(&state.mutex);
+    QStringList result;
+    result.reserve(state.count);
+    const int capacity = state.entries.size();
+    const int first = (state.next - state.count + capacity) % qMax(1, capacity);
+    for (int i = 0; i < state.count; ++i) {
+        result.append(state.entries.at((first + i) % capacity));
+    }
+    return result;
+}
+
+bool LogRingBuffer::dumpToFile(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Text | QIODevice::Truncate)) {
+        return false;
+    }
+    QTextStream out(&file);
+    const QStringList lines = messages();
+    for (const QString &line : lines) {
+        out << line << '\n';
+    }
+    return true;
+}
+
+void LogRingBuffer::messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message)
+{
+    RingState &state = ringState();
+    QtMessageHandler previous = nullptr;
+    {
+        QMutexLocker locker(&state.mutex);
+        if (!state.entries.isEmpty()) {
+            state.entries[state.next] = QStringLiteral("%1 %2 %3: %4")
+                                            .arg(QTime::currentTime().toString(QStringLiteral("hh:mm:ss.zzz")))
+                                            .arg(QLatin1Char(typeLetter(type)))
+                                            .arg(QLatin1String(context.category ? context.category : "default"))
+                                            .arg(message);
+            state.next = (state.next + 1) % state.entries.size();
+            state.count = qMin(state.count + 1, int(state.entries.size()));
+        }
+        previous = state.previousHandler;
+    }
+    // 继续交给原处理器输出到控制台
+    if (previous) {
+        previous(type, context, message);
+    } else {
+        fprintf(stderr, "%s\n", qPrintable(qFormatLogMessage(type, context, message)));
+    }
+}
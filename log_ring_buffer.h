@@ -0,0 +1,24 @@
+#ifndef LOG_RING_BUFFER_H
+#define LOG_RING_BUFFER_H
+
+#include <QString>
+#include <QStringList>
+#include <QtGlobal>
+
+// 内存日志环形缓冲：安装为 Qt 消息处理器，保存最近 capacity 条已启用的日志，
+// 同时转发给原处理器。发布版中可用于事后查看问题现场，未安装时没有任何开销。
+class LogRingBuffer
+{
+public:
+    static void install(int capacity);
+    static void uninstall();
+    static bool isInstalled();
+
+    static QStringList messages();             // 按时间先后排列
+    static bool dumpToFile(const QString &path); // 写出当前缓冲内容
+
+private:
+    static void messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message);
+};
+
+#endif // LOG_RING_BUFFER_H
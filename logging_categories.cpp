@@ -0,0 +1,7 @@
+#include "logging_categories.h"
+
+// 默认只输出 info 及以上级别
+Q_LOGGING_CATEGORY(lcView, "graph_tool.view", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcItems, "graph_tool.items", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcIo, "graph_tool.io", QtInfoMsg)
+Q_LOGGING_CATEGORY(lcManager, "graph_tool.manager", QtInfoMsg)
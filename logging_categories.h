@@ -0,0 +1,14 @@
+#ifndef LOGGING_CATEGORIES_H
+#define LOGGING_CATEGORIES_H
+
+#include <QLoggingCategory>
+
+// 日志分类。调试级别默认关闭，qCDebug 在分类未启用时不会计算参数；
+// 非 Debug 构建定义了 QT_NO_DEBUG_OUTPUT，qCDebug 整体被编译掉。
+// 运行时可通过 QT_LOGGING_RULES 开启，例如 "graph_tool.view.debug=true"。
+Q_DECLARE_LOGGING_CATEGORY(lcView)    // 视图交互、选择、拖动、绘制工具
+Q_DECLARE_LOGGING_CATEGORY(lcItems)   // 图形项
+Q_DECLARE_LOGGING_CATEGORY(lcIo)      // 导入导出
+Q_DECLARE_LOGGING_CATEGORY(lcManager) // 图形管理树
+
+#endif // LOGGING_CATEGORIES_H
@@ -1,4 +1,5 @@
 #include "mainwindow.h"
+#include "log_ring_buffer.h"
 
 #include <QApplication>
 
@@ -6,8 +7,21 @@ int main(int argc, char *argv[])
 {
 
     QApplication a(argc, argv);
+
+    // 设置 GRAPH_TOOL_LOG_RING=<条数> 开启内存日志环形缓冲（发布版同样可用），
+    // 设置 GRAPH_TOOL_LOG_RING_FILE 则在退出时把缓冲内容写到该文件
+    const int logRingCapacity = qEnvironmentVariableIntValue("GRAPH_TOOL_LOG_RING");
+    if (logRingCapacity > 0) {
+        LogRingBuffer::install(logRingCapacity);
+    }
+
     MainWindow w;
     w.show();
 
-    return a.exec();
+    const int result = a.exec();
+    const QString logRingFile = qEnvironmentVariable("GRAPH_TOOL_LOG_RING_FILE");
+    if (LogRingBuffer::isInstalled() && !logRingFile.isEmpty()) {
+        LogRingBuffer::dumpToFile(logRingFile);
+    }
+    return result;
 }
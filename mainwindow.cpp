@@ -12,18 +12,32 @@
 #include <QGraphicsLineItem>
 #include <QGraphicsRectItem>
 #include "graphics_tool_view.h"
+#include "scene_transaction.h"
+#include "scene_item_events.h"
+#include "logging_categories.h"
+#include "image_store.h"
+#include "raster_pyramid_item.h"
 #include <QSpinBox> // 包含 QSpinBox 头文件
 #include <QFileDialog>
-#include <QtSvg/QSvgGenerator>
 #include <QPainter>
 #include <QtSvg/QSvgRenderer>     //
-#include <QGraphicsSvgItem>
+#include "svg_tile_item.h"
+#include "svg_stream_importer.h"
+#include "svg_writer.h"
+#include "raster_exporter.h"
+#include "scene_change_log.h"
+#include "tile_pyramid_exporter.h"
+#include <QInputDialog>
+#include <QFileInfo>
 #include <QMessageBox>         //  (用于提示信息)
+#include <QStatusBar>
+#include <QProgressDialog>
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
     , scene(new QGraphicsScene(this))
     , graphicsView(new GraphicsToolView(scene,this))
+    , changeLog(new SceneChangeLog(scene, this))
 {
     // ui->setupUi(this);
     // 连接填充图片选择的信号
@@ -34,7 +48,6 @@ MainWindow::MainWindow(QWidget *parent)
 
     resize(800, 600);
 
-    graphicsView->setRenderHint(QPainter::Antialiasing);
 
     QWidget *centralWidget = new QWidget(this);
     QVBoxLayout *layout = new QVBoxLayout(centralWidget);
@@ -205,7 +218,7 @@ void MainWindow::onColorSelected(const QColor &color)
 {
     if (color.isValid()) {
         currentLineColor = color;
-        qDebug() << "MainWindow: Color selected -" << color.name();
+        qCDebug(lcView) << "MainWindow: Color selected -" << color.name();
         if(graphicsView) {
             graphicsView->setDrawingColor(currentLineColor);
         }
@@ -247,7 +260,7 @@ void MainWindow::onFillColorSelected(const QColor &color)
     // 目前我们直接使用所选颜色，如果选择了黑色，那就是黑色填充。
     // 如果想实现“无填充”按钮，可以修改 ColorSelectorPopup 或在这里判断 sender 和 color。
     currentFillColor = color;
-    qDebug() << "MainWindow: Fill Color selected -" << currentFillColor.name();
+    qCDebug(lcView) << "MainWindow: Fill Color selected -" << currentFillColor.name();
     if(graphicsView) {
         graphicsView->setDrawingFillColor(currentFillColor); // 设置 GraphicsView 的填充颜色
     }
@@ -304,7 +317,7 @@ void MainWindow::displayNewImage(const QString &imageName) {
     QPixmap blankImage(800, 600);
     blankImage.fill(Qt::white);
     if(scene){
-        scene->clear();
+        SceneItemEvents::clear(scene);
     }
 }
 
@@ -316,8 +329,10 @@ void MainWindow::initMenu(){
     QAction *saveAction = fileMenu->addAction(tr("保存"));saveAction->setShortcut(QKeySequence(Qt::CTRL | Qt::Key_S));
     QAction *exportAction = fileMenu->addAction(tr("导出..."));exportAction->setShortcut(QKeySequence(Qt::CTRL | Qt::Key_E));
     QAction *exportSvgAction = fileMenu->addAction(tr("导出为SVG...")); //
+    QAction *exportTilesAction = fileMenu->addAction(tr("导出瓦片金字塔..."));
     QAction *importAction = fileMenu->addAction(tr("导入..."));importAction->setShortcut(QKeySequence(Qt::CTRL | Qt::Key_I));
     QAction *importSvgAction = fileMenu->addAction(tr("导入SVG...")); //
+    QAction *importSvgItemsAction = fileMenu->addAction(tr("导入SVG为可编辑图形..."));
     fileMenu->addSeparator();
     QAction *graphManagementAction = fileMenu->addAction(tr("图管理(&T)..."));graphManagementAction->setShortcut(QKeySequence(Qt::CTRL | Qt::Key_G));
     QAction *symboManagementlAction = fileMenu->addAction(tr("符号管理(&M)..."));symboManagementlAction->setShortcut(QKeySequence(Qt::CTRL | Qt::Key_M));
@@ -337,6 +352,8 @@ void MainWindow::initMenu(){
     QAction *pasteAction = editMenu->addAction(tr("粘贴(&P)"));pasteAction->setShortcut(QKeySequence(Qt::CTRL  | Qt::Key_V));
     QAction *deleteAction = editMenu->addAction(tr("删除(&D)"));deleteAction->setShortcut(QKeySequence(Qt::Key_Delete));
     QAction *selectAllAction = editMenu->addAction(tr("全选(&A)"));selectAllAction->setShortcut(QKeySequence(Qt::CTRL | Qt::Key_A));
+    QAction *packAction = editMenu->addAction(tr("打包为静态图层")); // 双击其中的图形可转换回可编辑图形
+    QAction *freezeAction = editMenu->addAction(tr("冻结静态内容")); // 点中其中的图形即自动解冻
     QMenu *viewMenu = menuBar->addMenu(tr("视窗(&V)"));
     QAction *markToolRefAction = viewMenu->addAction(tr("标准工具条"));
     QAction *iconMarkToolRefAction = viewMenu->addAction(tr("图形编辑工具条"));
@@ -348,6 +365,11 @@ void MainWindow::initMenu(){
     QAction *statusBarAction = viewMenu->addAction(tr("状态条"));
     QAction *gridAction = viewMenu->addAction(tr("网格"));
     QAction *drawResourceExplorerAction = viewMenu->addAction(tr("绘图资源管理器"));
+    QAction *tileCacheAction = viewMenu->addAction(tr("瓦片缓存渲染"));
+    tileCacheAction->setCheckable(true);
+    tileCacheAction->setChecked(true);
+    QAction *cacheReportAction = viewMenu->addAction(tr("图元缓存统计"));
+    QAction *imageStoreReportAction = viewMenu->addAction(tr("图片库统计"));
     QMenu *toolsMenu = menuBar->addMenu(tr("工具(&T)"));
     QAction *configPreviewModeAction = toolsMenu->addAction(tr("配置预览方式"));
     QMenu *windowMenu = menuBar->addMenu(tr("窗口(&W)"));
@@ -372,8 +394,34 @@ void MainWindow::initMenu(){
     // 添加连接：将粘贴动作的 triggered 信号连接到 graphicsView 的 pasteCopiedItems 槽
     connect(pasteAction, &QAction::triggered, graphicsView, &GraphicsToolView::pasteCopiedItems);
     connect(deleteAction, &QAction::triggered, graphicsView, &GraphicsToolView::deleteSelectedItems);
+    connect(selectAllAction, &QAction::triggered, graphicsView, &GraphicsToolView::selectAllItems);
+    connect(packAction, &QAction::triggered, this, [this]() {
+        if (!graphicsView->packSelectedItems()) {
+            QMessageBox::information(this, tr("打包为静态图层"),
+                                     tr("所选图形在叠放次序中不连续，中间夹有其他图元，打包会改变它们的上下关系。\n"
+                                        "请选择叠放次序相邻的图形再打包。"));
+        }
+    });
+    connect(freezeAction, &QAction::triggered, this, [this]() {
+        if (!graphicsView->freezeItems()) {
+            QMessageBox::information(this, tr("冻结图层"),
+                                     tr("所选图元在叠放次序中不连续，中间夹有其他图元，烘焙为一个图层会改变它们的上下关系。\n"
+                                        "请选择叠放次序相邻的图元再冻结。"));
+        }
+    });
+    connect(tileCacheAction, &QAction::toggled, graphicsView, &GraphicsToolView::setTileCacheEnabled);
+    connect(cacheReportAction, &QAction::triggered, this, [this]() {
+        QMessageBox::information(this, tr("图元缓存统计"), graphicsView->cachePolicy()->reportText());
+    });
+    connect(imageStoreReportAction, &QAction::triggered, this, [this]() {
+        QMessageBox::information(this, tr("图片库统计"), ImageStore::instance()->reportText());
+    });
     connect(exportSvgAction, &QAction::triggered, this, &MainWindow::exportAsSvg); //
     connect(importSvgAction, &QAction::triggered, this, &MainWindow::importSvg); //
+    connect(exportAction, &QAction::triggered, this, &MainWindow::exportRaster);
+    connect(exportTilesAction, &QAction::triggered, this, &MainWindow::exportTilePyramid);
+    connect(importAction, &QAction::triggered, this, &MainWindow::importRaster);
+    connect(importSvgItemsAction, &QAction::triggered, this, &MainWindow::importSvgAsItems);
 
 }
 
@@ -399,26 +447,118 @@ void MainWindow::exportAsSvg()
         return; // 用户取消了操作
     }
 
-    QSvgGenerator generator;
-    generator.setFileName(filePath);
-    generator.setSize(scene->sceneRect().size().toSize()); // 使用场景的矩形大小
-    // 或者使用graphicsView的大小: generator.setSize(graphicsView->viewport()->size());
-    generator.setViewBox(scene->sceneRect()); // 设置SVG的 viewBox
-    generator.setTitle(tr("我的图形"));        // 可选：设置SVG标题
-    generator.setDescription(tr("从Graph Tool导出的SVG文件")); // 可选：设置SVG描述
+    // 直接按图元写出 SVG：共享样式类、重复几何用 <symbol>/<use>，画布大小取实际内容
+    SvgWriter writer(scene);
+    if (!writer.write(filePath)) {
+        QMessageBox::warning(this, tr("导出错误"), tr("无法导出 SVG:\n%1").arg(writer.errorString()));
+        return;
+    }
 
-    QPainter painter;
-    painter.begin(&generator); // 开始将内容绘制到SVG生成器
+    qCInfo(lcIo) << "Exported SVG:" << filePath;
+    QMessageBox::information(this, tr("导出成功"), tr("文件已成功导出为SVG:\n%1").arg(filePath));
+}
 
-    // 清除选中状态，避免导出选中框（如果需要的话）
-    // graphicsView->clearSelection(); // 或者 graphicsView->cleanupSelection();
-    // 或者临时取消选中，导出后再恢复，但这比较复杂
 
-    scene->render(&painter);   // 将场景渲染到painter
+void MainWindow::exportRaster()
+{
+    if (!scene) {
+        QMessageBox::warning(this, tr("导出错误"), tr("场景无效，无法导出。"));
+        return;
+    }
+    const QRectF sourceRect = scene->itemsBoundingRect();
+    if (sourceRect.isEmpty()) {
+        QMessageBox::information(this, tr("导出"), tr("场景中没有可导出的内容。"));
+        return;
+    }
 
-    painter.end();             // 结束绘制
+    QString filePath = QFileDialog::getSaveFileName(this, tr("导出图片"), "",
+                                                    tr("PNG 图片 (*.png);;TIFF 图片 (*.tif *.tiff)"));
+    if (filePath.isEmpty()) {
+        return; // 用户取消了操作
+    }
+    const QString suffix = QFileInfo(filePath).suffix().toLower();
+    if (suffix != QLatin1String("png") && suffix != QLatin1String("tif") && suffix != QLatin1String("tiff")) {
+        filePath += QStringLiteral(".png");
+    }
+    bool ok = false;
+    const int dpi = QInputDialog::getInt(this, tr("导出图片"), tr("分辨率 (DPI):"), 300, 24, 4800, 1, &ok);
+    if (!ok) {
+        return;
+    }
 
-    QMessageBox::information(this, tr("导出成功"), tr("文件已成功导出为SVG:\n%1").arg(filePath));
+    // 分条带在后台渲染并逐行写入文件，任意尺寸都不需要整张图片的内存
+    const QSize size = RasterExporter::outputSizeFor(sourceRect, dpi);
+    RasterExporter *exporter = new RasterExporter(scene, this);
+    QProgressDialog *progress = new QProgressDialog(tr("正在导出图片 (%1 × %2)...").arg(size.width()).arg(size.height()),
+                                                    tr("取消"), 0, 100, this);
+    progress->setWindowModality(Qt::WindowModal);
+    progress->setMinimumDuration(0);
+    progress->setAutoClose(false);
+    progress->setAutoReset(false);
+    connect(exporter, &RasterExporter::progressChanged, progress, &QProgressDialog::setValue);
+    connect(progress, &QProgressDialog::canceled, exporter, &RasterExporter::cancel);
+    connect(exporter, &RasterExporter::finished, this, [this, exporter, progress, filePath, size](const QString &error) {
+        progress->deleteLater();
+        exporter->deleteLater();
+        if (!error.isEmpty()) {
+            QMessageBox::warning(this, tr("导出失败"), tr("图片导出未完成:\n%1\n%2").arg(filePath, error));
+            return;
+        }
+        qCInfo(lcIo) << "Exported raster:" << filePath << size;
+        QMessageBox::information(this, tr("导出成功"), tr("文件已成功导出 (%1 × %2):\n%3")
+                                 .arg(size.width()).arg(size.height()).arg(filePath));
+    });
+    if (!exporter->start(filePath, sourceRect, dpi)) {
+        const QString error = exporter->errorString();
+        progress->deleteLater();
+        exporter->deleteLater();
+        QMessageBox::warning(this, tr("导出失败"), tr("无法导出图片:\n%1\n%2").arg(filePath, error));
+    }
+}
+
+void MainWindow::exportTilePyramid()
+{
+    if (!scene) {
+        QMessageBox::warning(this, tr("导出错误"), tr("场景无效，无法导出。"));
+        return;
+    }
+    const QRectF contentRect = scene->itemsBoundingRect();
+    if (contentRect.isEmpty()) {
+        QMessageBox::information(this, tr("导出"), tr("场景中没有可导出的内容。"));
+        return;
+    }
+    const QString directory = QFileDialog::getExistingDirectory(this, tr("选择瓦片输出目录"));
+    if (directory.isEmpty()) {
+        return; // 用户取消了操作
+    }
+
+    // 再次导出到同一目录时只重新渲染编辑过的区域
+    TilePyramidExporter *exporter = new TilePyramidExporter(scene, changeLog, this);
+    QProgressDialog *progress = new QProgressDialog(tr("正在导出瓦片..."), tr("取消"), 0, 100, this);
+    progress->setWindowModality(Qt::WindowModal);
+    progress->setMinimumDuration(0);
+    progress->setAutoClose(false);
+    progress->setAutoReset(false);
+    connect(exporter, &TilePyramidExporter::progressChanged, progress, &QProgressDialog::setValue);
+    connect(progress, &QProgressDialog::canceled, exporter, &TilePyramidExporter::cancel);
+    connect(exporter, &TilePyramidExporter::finished, this, [this, exporter, progress, directory](const QString &error) {
+        progress->deleteLater();
+        exporter->deleteLater();
+        if (!error.isEmpty()) {
+            QMessageBox::warning(this, tr("导出失败"), tr("瓦片导出未完成:\n%1\n%2").arg(directory, error));
+            return;
+        }
+        const QString mode = exporter->isIncremental() ? tr("增量更新") : tr("全量导出");
+        qCInfo(lcIo) << "Exported tile pyramid:" << directory << exporter->tileCount() << "tiles" << mode;
+        QMessageBox::information(this, tr("导出成功"), tr("瓦片已导出（%1，处理 %2 块）:\n%3")
+                                 .arg(mode).arg(exporter->tileCount()).arg(directory));
+    });
+    if (!exporter->start(directory, contentRect)) {
+        const QString error = exporter->errorString();
+        progress->deleteLater();
+        exporter->deleteLater();
+        QMessageBox::warning(this, tr("导出失败"), tr("无法导出瓦片:\n%1\n%2").arg(directory, error));
+    }
 }
 
 
@@ -456,10 +596,11 @@ void MainWindow::importSvg()
     // }
 
 
-    // 使用 QGraphicsSvgItem 直接加载
-    QGraphicsSvgItem *svgItem = new QGraphicsSvgItem(filePath);
+    // 按缩放档位切瓦片后台渲染，平移缩放时不再逐帧重新渲染整个 SVG
+    SvgTileItem *svgItem = new SvgTileItem(filePath);
 
-    if (!svgItem->renderer() || !svgItem->renderer()->isValid()) {
+    if (!svgItem->isValid()) {
+        qCWarning(lcIo) << "Failed to load SVG:" << filePath;
         QMessageBox::warning(this, tr("导入失败"), tr("无法加载或解析SVG文件:\n%1").arg(filePath));
         delete svgItem;
         return;
@@ -470,8 +611,10 @@ void MainWindow::importSvg()
     svgItem->setFlag(QGraphicsItem::ItemIsMovable, true);
     // svgItem->setFlag(QGraphicsItem::ItemSendsGeometryChanges, true); // 如果需要精确的边界更新
 
-    // 将SVG项添加到场景中
+    // 将SVG项添加到场景中，整个导入作为一次场景事务提交
+    SceneTransaction transaction(scene, 1);
     scene->addItem(svgItem);
+    transaction.commit();
 
     // 可选: 将SVG项放置在场景中心或用户可见区域
     // svgItem->setPos(graphicsView->mapToScene(graphicsView->viewport()->rect().center()) - svgItem->boundingRect().center());
@@ -480,12 +623,101 @@ void MainWindow::importSvg()
     // graphicsView->setSceneRect(scene->itemsBoundingRect()); // 更新场景矩形以包含新项目
     // graphicsView->fitInView(svgItem->boundingRect(), Qt::KeepAspectRatio); // 尝试让导入的SVG适应视图
 
+    qCInfo(lcIo) << "Imported SVG:" << filePath;
     QMessageBox::information(this, tr("导入成功"), tr("SVG文件已成功导入场景。"));
 }
 
+void MainWindow::importSvgAsItems()
+{
+    if (!scene) {
+        QMessageBox::warning(this, tr("导入错误"), tr("场景无效，无法导入。"));
+        return;
+    }
+
+    QString filePath = QFileDialog::getOpenFileName(this, tr("导入 SVG 为可编辑图形"), "", tr("SVG 文件 (*.svg)"));
+    if (filePath.isEmpty()) {
+        return; // 用户取消了操作
+    }
+
+    // 后台流式解析，图元分批加入场景，期间显示进度并允许取消
+    SvgStreamImporter *importer = new SvgStreamImporter(scene, this);
+    QProgressDialog *progress = new QProgressDialog(tr("正在导入 SVG..."), tr("取消"), 0, 100, this);
+    progress->setWindowModality(Qt::WindowModal);
+    progress->setMinimumDuration(0);
+    progress->setAutoClose(false);
+    progress->setAutoReset(false);
+    connect(importer, &SvgStreamImporter::progressChanged, progress, &QProgressDialog::setValue);
+    connect(progress, &QProgressDialog::canceled, importer, &SvgStreamImporter::cancel);
+    connect(importer, &SvgStreamImporter::finished, this, [this, importer, progress, filePath](int itemCount, int skipped, const QString &error) {
+        progress->deleteLater();
+        importer->deleteLater();
+        if (!error.isEmpty()) {
+            QMessageBox::warning(this, tr("导入失败"), tr("SVG 导入未完成:\n%1\n%2").arg(filePath, error));
+            return;
+        }
+        QString message = tr("已导入 %1 个图形。").arg(itemCount);
+        if (skipped > 0) {
+            // 计入 skipped 的只有图片和无法解析的引用；剪切、蒙版、渐变、滤镜等效果不计数，直接忽略
+            message += tr("\n%1 个元素已跳过：图片（image），以及引用外部文件或后文定义内容的 use。").arg(skipped);
+        }
+        QMessageBox::information(this, tr("导入成功"), message);
+    });
+    if (!importer->start(filePath)) {
+        progress->deleteLater();
+        importer->deleteLater();
+        QMessageBox::warning(this, tr("导入失败"), tr("无法打开SVG文件:\n%1").arg(filePath));
+    }
+}
+
+void MainWindow::importRaster()
+{
+    if (!scene) {
+        QMessageBox::warning(this, tr("导入错误"), tr("场景无效，无法导入。"));
+        return;
+    }
+
+    QString filePath = QFileDialog::getOpenFileName(this, tr("导入栅格底图"), "",
+                                                    tr("图片文件 (*.png *.jpg *.jpeg *.tif *.tiff *.bmp)"));
+    if (filePath.isEmpty()) {
+        return; // 用户取消了操作
+    }
+
+    // 只读取文件头，瓦片金字塔在后台生成，完成前显示占位框
+    RasterPyramidItem *rasterItem = new RasterPyramidItem(filePath);
+    if (!rasterItem->isValid()) {
+        QMessageBox::warning(this, tr("导入失败"), tr("无法读取图片文件:\n%1").arg(filePath));
+        delete rasterItem;
+        return;
+    }
+    connect(rasterItem, &RasterPyramidItem::progressChanged, this, [this](int percent) {
+        statusBar()->showMessage(tr("正在生成底图瓦片... %1%").arg(percent));
+    });
+    connect(rasterItem, &RasterPyramidItem::ready, this, [this]() {
+        statusBar()->showMessage(tr("底图瓦片已生成"), 3000);
+    });
+    connect(rasterItem, &RasterPyramidItem::failed, this, [this, filePath](const QString &message) {
+        statusBar()->clearMessage();
+        QMessageBox::warning(this, tr("导入失败"), tr("无法生成底图瓦片:\n%1\n%2").arg(filePath, message));
+    });
+
+    // 作为底图放在所有图形之下
+    qreal z = 0;
+    const QList<QGraphicsItem*> items = scene->items();
+    for (QGraphicsItem *item : items) {
+        z = qMin(z, item->zValue());
+    }
+    rasterItem->setZValue(z - 1);
+
+    SceneTransaction transaction(scene, 1);
+    scene->addItem(rasterItem);
+    transaction.commit();
+
+    qCInfo(lcIo) << "Imported raster:" << filePath << rasterItem->imageSize();
+}
+
 void MainWindow::onBackgroundImageSelected(const QString &imagePath)
 {
-    qDebug() << "Background image selected:" << imagePath;
+    qCDebug(lcView) << "Background image selected:" << imagePath;
     currentFillImagePath = imagePath;
     if (graphicsView) {
         graphicsView->setDrawingFillImage(imagePath); // 假设 GraphicsToolView 有这个方法
@@ -497,7 +729,7 @@ void MainWindow::onBackgroundImageSelected(const QString &imagePath)
 void MainWindow::onLineThicknessChanged(int thickness)
 {
     currentLineThickness = thickness;
-    qDebug() << "MainWindow: Line thickness changed to" << thickness << "px";
+    qCDebug(lcView) << "MainWindow: Line thickness changed to" << thickness << "px";
     if (graphicsView) {
         graphicsView->setDrawingPenWidth(currentLineThickness); // 更新 GraphicsToolView 的线条粗细
     }
@@ -16,6 +16,7 @@
 class ColorSelectorPopup; // *** 前向声明 ***
 
 class ColorSelectorPopupFill;
+class SceneChangeLog;
 
 enum class ToolType {
     Select,
@@ -61,7 +62,11 @@ private slots: // *** 私有槽 ***
     void onAlignCenterVerticalTriggered(); // 垂直居中对齐槽
     void onAlignCenterHorizontalTriggered(); // 水平居中对齐槽
     void exportAsSvg(); //导出为SVG文件的槽函数
+    void exportRaster(); // 按指定 DPI 分条带导出 PNG/TIFF
+    void exportTilePyramid(); // 导出 z/x/y 瓦片金字塔，再次导出时只更新变化区域
     void importSvg();   //导入SVG文件的槽函数
+    void importSvgAsItems(); // 流式导入SVG，转换为可编辑图形
+    void importRaster(); // 导入超大栅格底图（瓦片金字塔）
 
 private:
     Ui::MainWindow *ui;
@@ -70,6 +75,7 @@ private:
     // --- Graphics View Related ---
     QGraphicsScene *scene;       // The scene to hold items
     GraphicsToolView *graphicsView; // The view to display the scene
+    SceneChangeLog *changeLog; // 场景变化记录，供瓦片金字塔增量导出
         // OR: Replace with your custom GraphicsView subclass if you create one
 
     // --- Tool Management ---
@@ -0,0 +1,246 @@
+#include "move_session.h"
+#include "selection_model.h"
+#include "selection_overlay.h"
+#include "scene_transaction.h"
+#include "logging_categories.h"
+#include <QStyleOptionGraphicsItem>
+#include <QPainterPath>
+#include <QDebug>
+#include <QtMath>
+
+MoveSession::MoveSession(QGraphicsView *view, SelectionModel *selection)
+    : view(view),
+    selection(selection)
+{
+}
+
+void MoveSession::begin()
+{
+    if (active) {
+        commit();
+    }
+    active = true;
+    offset = QPointF();
+    movingItems = selection->items();
+    proxyMode = movingItems.size() >= ProxyThreshold;
+    if (proxyMode) {
+        renderProxy();
+    }
+    if (proxyMode) {
+        // 只改一次透明度，拖动期间这些项不再参与场景绘制；仍留在场景索引中，用于判断叠放次序
+        for (QGraphicsItem *item : std::as_const(movingItems)) {
+            if (item->isVisible()) {
+                fadedItems.insert(item, item->opacity());
+                item->setOpacity(0.0);
+            }
+        }
+    }
+    qCDebug(lcView) << "Move session started, items:" << movingItems.size() << "proxy:" << usesProxy()
+                    << "live:" << liveItems.size();
+}
+
+void MoveSession::moveBy(const QPointF &delta)
+{
+    if (!active || delta.isNull()) {
+        return;
+    }
+    const QPointF oldOffset = offset;
+    offset += delta;
+    if (usesProxy()) {
+        updateDirtyRegion(oldOffset, offset);
+        return;
+    }
+    // 选中项较少时直接移动，图元自身会触发重绘
+    for (QGraphicsItem *item : std::as_const(movingItems)) {
+        item->setPos(item->pos() + delta);
+    }
+    selection->translateBounds(delta);
+    updateDirtyRegion(oldOffset, offset);
+}
+
+void MoveSession::commit()
+{
+    if (!active) {
+        return;
+    }
+    if (usesProxy()) {
+        // 一次性写回最终位置并恢复透明度
+        SceneTransaction transaction(view->scene(), movingItems.size());
+        for (QGraphicsItem *item : std::as_const(movingItems)) {
+            item->setPos(item->pos() + offset);
+        }
+        for (auto it = fadedItems.cbegin(); it != fadedItems.cend(); ++it) {
+            it.key()->setOpacity(it.value());
+        }
+        transaction.commit();
+        selection->translateBounds(offset);
+        releaseProxy();
+    }
+    qCDebug(lcView) << "Move session committed, offset:" << offset;
+    movingItems.clear();
+    offset = QPointF();
+    active = false;
+}
+
+void MoveSession::cancel()
+{
+    if (!active) {
+        return;
+    }
+    if (usesProxy()) {
+        for (auto it = fadedItems.cbegin(); it != fadedItems.cend(); ++it) {
+            it.key()->setOpacity(it.value());
+        }
+        releaseProxy();
+    } else {
+        for (QGraphicsItem *item : std::as_const(movingItems)) {
+            item->setPos(item->pos() - offset);
+        }
+        selection->translateBounds(-offset);
+    }
+    view->viewport()->update();
+    qCDebug(lcView) << "Move session cancelled.";
+    movingItems.clear();
+    offset = QPointF();
+    active = false;
+}
+
+void MoveSession::paint(QPainter *painter, const QRectF &exposedSceneRect) const
+{
+    if (!active || !usesProxy()) {
+        return;
+    }
+    const QRectF target = proxySceneRect.translated(offset);
+    const QRectF visible = target & exposedSceneRect;
+    if (!visible.isEmpty()) {
+        painter->drawPixmap(target, proxy, QRectF(QPointF(0, 0), proxy.size()));
+    }
+    // 缓存范围外的项逐个按偏移直接绘制
+    QVector<QGraphicsItem*> live;
+    for (QGraphicsItem *item : std::as_const(liveItems)) {
+        if (item->sceneBoundingRect().translated(offset).intersects(exposedSceneRect)) {
+            live.append(item);
+        }
+    }
+    if (!live.isEmpty()) {
+        painter->save();
+        painter->translate(offset);
+        paintItems(painter, live, exposedSceneRect.translated(-offset));
+        painter->restore();
+    }
+    if (!visible.isEmpty()) {
+        paintOccluders(painter, visible);
+    }
+}
+
+void MoveSession::paintItems(QPainter *painter, const QVector<QGraphicsItem*> &items, const QRectF &clipSceneRect) const
+{
+    // items 按自下而上的次序排列；painter 处于场景坐标系
+    painter->save();
+    painter->setClipRect(clipSceneRect, Qt::IntersectClip);
+    const QTransform sceneToDevice = painter->worldTransform();
+    QStyleOptionGraphicsItem option;
+    for (QGraphicsItem *item : items) {
+        painter->setWorldTransform(item->sceneTransform() * sceneToDevice);
+        // 拖动中的项已设为全透明，按拖动前的透明度绘制
+        const qreal opacity = fadedItems.value(item, item->opacity());
+        painter->setOpacity(item->parentItem() ? item->parentItem()->effectiveOpacity() * opacity : opacity);
+        option.exposedRect = item->boundingRect();
+        item->paint(painter, &option, nullptr);
+    }
+    painter->restore();
+}
+
+void MoveSession::paintOccluders(QPainter *painter, const QRectF &area) const
+{
+    // 位图画在前景层，会盖住叠放次序更高的图元：把它们在位图之上重画一遍。
+    // 查询区域同时包含 topItem（全透明但仍在索引中），结果按叠放次序排列，topItem 之前的都在它之上
+    QPainterPath region;
+    region.setFillRule(Qt::WindingFill);
+    region.addRect(area);
+    region.addRect(topItem->sceneBoundingRect());
+    const QList<QGraphicsItem*> candidates = view->scene()->items(region, Qt::IntersectsItemBoundingRect, Qt::DescendingOrder);
+    QVector<QGraphicsItem*> above;
+    for (QGraphicsItem *item : candidates) {
+        if (item == topItem) {
+            break;
+        }
+        if (!fadedItems.contains(item) && item->sceneBoundingRect().intersects(area)) {
+            above.prepend(item);
+        }
+    }
+    if (!above.isEmpty()) {
+        paintItems(painter, above, area);
+    }
+}
+
+void MoveSession::renderProxy()
+{
+    // 只缓存视口附近的部分（四周各扩展半个视口），限制位图大小
+    const QTransform viewportTransform = view->viewportTransform();
+    const QRect viewportRect = view->viewport()->rect();
+    const QRect cacheArea = viewportRect.adjusted(-viewportRect.width() / 2, -viewportRect.height() / 2,
+                                                  viewportRect.width() / 2, viewportRect.height() / 2);
+    const QRect deviceRect = viewportTransform.mapRect(selection->boundingRect()).toAlignedRect()
+                                 .adjusted(-2, -2, 2, 2).intersected(cacheArea);
+    const QRectF cacheSceneRect = viewportTransform.inverted().mapRect(QRectF(deviceRect));
+
+    // 完全落在缓存范围内的项按场景的叠放次序画进位图，其余的拖动期间逐个直接绘制
+    QSet<QGraphicsItem*> remaining(movingItems.cbegin(), movingItems.cend());
+    QVector<QGraphicsItem*> ordered;
+    if (!deviceRect.isEmpty()) {
+        const QList<QGraphicsItem*> stacked = view->scene()->items(cacheSceneRect, Qt::ContainsItemBoundingRect, Qt::AscendingOrder);
+        for (QGraphicsItem *item : stacked) {
+            if (remaining.remove(item)) {
+                ordered.append(item);
+            }
+        }
+    }
+    if (ordered.isEmpty()) { // 没有可缓存的项，全部直接移动
+        proxyMode = false;
+        return;
+    }
+    for (QGraphicsItem *item : std::as_const(movingItems)) {
+        if (remaining.contains(item) && item->isVisible()) {
+            liveItems.append(item);
+        }
+    }
+
+    const qreal dpr = view->viewport()->devicePixelRatioF();
+    QPixmap pixmap(deviceRect.size() * dpr);
+    pixmap.setDevicePixelRatio(dpr);
+    pixmap.fill(Qt::transparent);
+
+    QPainter painter(&pixmap);
+    painter.setRenderHints(view->renderHints());
+    painter.setTransform(viewportTransform * QTransform::fromTranslate(-deviceRect.x(), -deviceRect.y()));
+    paintItems(&painter, ordered, cacheSceneRect);
+    painter.end();
+
+    proxy = pixmap;
+    proxySceneRect = cacheSceneRect;
+    topItem = ordered.constLast();
+}
+
+void MoveSession::releaseProxy()
+{
+    proxy = QPixmap();
+    proxySceneRect = QRectF();
+    fadedItems.clear();
+    liveItems.clear();
+    topItem = nullptr;
+    proxyMode = false;
+}
+
+void MoveSession::updateDirtyRegion(const QPointF &oldOffset, const QPointF &newOffset)
+{
+    // 只重绘拖动前后选中区域（含控制点）覆盖的视口范围
+    // 代理模式下选中项尚未移动，需叠加偏移；直接模式下包围盒已随图元平移
+    const QRectF current = usesProxy() ? selection->boundingRect().united(proxySceneRect).translated(newOffset)
+                                       : selection->boundingRect();
+    const QRectF previous = current.translated(oldOffset - newOffset);
+    const int margin = qCeil(SelectionOverlay::HandleSize) + 2;
+    const QRect dirty = view->viewportTransform().mapRect(previous.united(current)).toAlignedRect()
+                            .adjusted(-margin, -margin, margin, margin);
+    view->viewport()->update(dirty);
+}
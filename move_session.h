@@ -0,0 +1,59 @@
+#ifndef MOVE_SESSION_H
+#define MOVE_SESSION_H
+
+#include <QGraphicsView>
+#include <QGraphicsItem>
+#include <QPainter>
+#include <QPixmap>
+#include <QPointF>
+#include <QRectF>
+#include <QVector>
+#include <QHash>
+#include <QSet>
+
+class SelectionModel;
+
+// 整组拖动会话：选中项较多时，开始拖动前把缓存范围内的项渲染成一张位图，并把选中项暂时设为全透明，
+// 拖动过程中只移动位图（缓存范围外的项按偏移直接绘制），释放时一次性提交所有项的新位置。
+// 位图画在前景层，叠放次序在选中项之上的图元会在位图上重画，保持原有的遮挡关系。
+class MoveSession
+{
+public:
+    MoveSession(QGraphicsView *view, SelectionModel *selection);
+
+    void begin();
+    void moveBy(const QPointF &delta); // 场景坐标偏移
+    void commit();                     // 提交最终位置
+    void cancel();                     // 放弃拖动，恢复原位置
+
+    bool isActive() const { return active; }
+    bool usesProxy() const { return proxyMode; }
+    // 尚未提交到图元的偏移，前景层（控制点等）需要按此平移绘制
+    QPointF pendingOffset() const { return usesProxy() ? offset : QPointF(); }
+
+    // painter 处于场景坐标系（由 drawForeground 传入）
+    void paint(QPainter *painter, const QRectF &exposedSceneRect) const;
+
+    static constexpr int ProxyThreshold = 64; // 选中项不少于该数量时使用缓存位图
+
+private:
+    void renderProxy();
+    void paintItems(QPainter *painter, const QVector<QGraphicsItem*> &items, const QRectF &clipSceneRect) const;
+    void paintOccluders(QPainter *painter, const QRectF &area) const;
+    void releaseProxy();
+    void updateDirtyRegion(const QPointF &oldOffset, const QPointF &newOffset);
+
+    QGraphicsView *view;
+    SelectionModel *selection;
+    QVector<QGraphicsItem*> movingItems;
+    QHash<QGraphicsItem*, qreal> fadedItems; // 拖动期间设为全透明的项及其原透明度
+    QVector<QGraphicsItem*> liveItems;       // 缓存范围外、拖动期间逐个按偏移绘制的项
+    QGraphicsItem *topItem = nullptr;        // 位图中叠放次序最高的项
+    QPixmap proxy;        // 选中项的缓存位图
+    QRectF proxySceneRect; // 缓存位图对应的场景区域（拖动开始时）
+    QPointF offset;       // 累计偏移
+    bool active = false;
+    bool proxyMode = false; // 选中项位置延迟到提交时写回
+};
+
+#endif // MOVE_SESSION_H
@@ -0,0 +1,51 @@
+#include "picking_engine.h"
+#include "selection_model.h"
+#include "raster_pyramid_item.h"
+#include <QGraphicsScene>
+#include <QtMath>
+
+PickingEngine::PickingEngine(QGraphicsView *view, const SelectionOverlay *overlay)
+    : view(view),
+    overlay(overlay),
+    tolerancePx(6.0)
+{
+}
+
+void PickingEngine::setTolerance(qreal pixels)
+{
+    tolerancePx = qMax<qreal>(0.0, pixels);
+}
+
+PickResult PickingEngine::pick(const QPoint &viewPos, const SelectionModel &selection) const
+{
+    PickResult result;
+    if (!view || !view->scene()) {
+        return result;
+    }
+    result.scenePos = view->mapToScene(viewPos);
+
+    // 控制点优先，只有选中项才会显示控制点
+    if (overlay && overlay->hitHandle(QPointF(viewPos), tolerancePx, result.item, result.handleRole, result.handleIndex)) {
+        result.kind = PickResult::Kind::Handle;
+        return result;
+    }
+
+    // 以光标为中心、按屏幕像素容差构造探测区域，交给场景索引查询候选项
+    // Qt::IntersectsItemShape 会先用索引按包围盒筛选，再对候选项做形状测试
+    const int t = qCeil(tolerancePx);
+    const QPolygonF probe = view->mapToScene(QRect(viewPos - QPoint(t, t), QSize(2 * t + 1, 2 * t + 1)));
+    const QList<QGraphicsItem*> candidates = view->scene()->items(probe, Qt::IntersectsItemShape,
+                                                                  Qt::DescendingOrder, view->viewportTransform());
+    for (QGraphicsItem *candidate : candidates) {
+        // 栅格底图不参与拾取，点在底图上等同于点在空白处
+        if (!candidate->isVisible() || candidate->type() == RasterPyramidItem::Type) {
+            continue;
+        }
+        // 命中子项时归属到其顶层图形项
+        QGraphicsItem *item = candidate->topLevelItem();
+        result.item = item;
+        result.kind = selection.contains(item) ? PickResult::Kind::SelectedGroup : PickResult::Kind::Item;
+        return result;
+    }
+    return result;
+}
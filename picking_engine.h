@@ -0,0 +1,49 @@
+#ifndef PICKING_ENGINE_H
+#define PICKING_ENGINE_H
+
+#include <QGraphicsView>
+#include <QGraphicsItem>
+#include <QPoint>
+#include <QPointF>
+#include <QList>
+#include "selection_overlay.h"
+
+class SelectionModel;
+
+// 一次拾取的结果：按下、移动和光标更新共用
+struct PickResult
+{
+    enum class Kind {
+        None,          // 空白处
+        Handle,        // 选中项的控制点
+        Item,          // 未选中的图形项
+        SelectedGroup  // 已选中的图形项（拖动整组）
+    };
+
+    Kind kind = Kind::None;
+    QGraphicsItem *item = nullptr; // 命中的图形项（控制点则为其所属项）
+    HandleRole handleRole = HandleRole::None; // 命中的控制点类型
+    int handleIndex = -1;          // 折线顶点索引，其他控制点为 -1
+    QPointF scenePos;              // 拾取位置（场景坐标）
+
+    bool isNull() const { return kind == Kind::None; }
+};
+
+// 拾取引擎：在场景空间索引中查询光标附近的候选项，再做精确的形状测试
+class PickingEngine
+{
+public:
+    PickingEngine(QGraphicsView *view, const SelectionOverlay *overlay);
+
+    void setTolerance(qreal pixels); // 拾取容差（屏幕像素）
+    qreal tolerance() const { return tolerancePx; }
+
+    PickResult pick(const QPoint &viewPos, const SelectionModel &selection) const;
+
+private:
+    QGraphicsView *view;
+    const SelectionOverlay *overlay; // 控制点由选择覆盖层拾取
+    qreal tolerancePx;
+};
+
+#endif // PICKING_ENGINE_H
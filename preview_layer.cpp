@@ -0,0 +1,101 @@
+#include "preview_layer.h"
+#include <QtMath>
+
+PreviewLayer::PreviewLayer(QGraphicsView *view)
+    : view(view)
+{
+}
+
+void PreviewLayer::setPath(Slot slot, const QPainterPath &path, const QPen &pen, const QBrush &brush)
+{
+    Shape &shape = shapes[slot];
+    const QRectF oldBounds = shape.visible ? shape.sceneBounds : QRectF();
+
+    shape.path = path;
+    shape.pen = pen;
+    shape.brush = brush;
+    shape.visible = true;
+    // 装饰画笔的宽度按像素计，由 invalidate 统一留出边距
+    const qreal margin = pen.isCosmetic() ? 0.0 : pen.widthF() / 2.0;
+    shape.sceneBounds = path.controlPointRect().adjusted(-margin, -margin, margin, margin);
+
+    // 只重绘新旧图形覆盖的区域
+    invalidate(oldBounds.isNull() ? shape.sceneBounds : oldBounds.united(shape.sceneBounds));
+}
+
+void PreviewLayer::setLine(Slot slot, const QLineF &line, const QPen &pen)
+{
+    QPainterPath path(line.p1());
+    path.lineTo(line.p2());
+    setPath(slot, path, pen);
+}
+
+void PreviewLayer::setRect(Slot slot, const QRectF &rect, const QPen &pen)
+{
+    QPainterPath path;
+    path.addRect(rect);
+    setPath(slot, path, pen);
+}
+
+void PreviewLayer::setEllipse(Slot slot, const QRectF &rect, const QPen &pen)
+{
+    QPainterPath path;
+    path.addEllipse(rect);
+    setPath(slot, path, pen);
+}
+
+void PreviewLayer::lineTo(Slot slot, const QPointF &point)
+{
+    Shape &shape = shapes[slot];
+    if (!shape.visible) {
+        return;
+    }
+    const QPointF last = shape.path.currentPosition();
+    shape.path.lineTo(point);
+    const qreal margin = shape.pen.isCosmetic() ? 0.0 : shape.pen.widthF() / 2.0;
+    const QRectF segmentBounds = QRectF(last, point).normalized().adjusted(-margin, -margin, margin, margin);
+    shape.sceneBounds = shape.sceneBounds.united(segmentBounds);
+    invalidate(segmentBounds);
+}
+
+void PreviewLayer::clear(Slot slot)
+{
+    Shape &shape = shapes[slot];
+    if (!shape.visible) {
+        return;
+    }
+    shape.visible = false;
+    shape.path = QPainterPath();
+    invalidate(shape.sceneBounds);
+}
+
+void PreviewLayer::clearAll()
+{
+    for (int i = 0; i < SlotCount; ++i) {
+        clear(static_cast<Slot>(i));
+    }
+}
+
+void PreviewLayer::paint(QPainter *painter, const QRectF &exposedSceneRect) const
+{
+    for (const Shape &shape : shapes) {
+        if (!shape.visible || !shape.sceneBounds.intersects(exposedSceneRect)) {
+            continue;
+        }
+        painter->save();
+        painter->setPen(shape.pen);
+        painter->setBrush(shape.brush);
+        painter->drawPath(shape.path);
+        painter->restore();
+    }
+}
+
+void PreviewLayer::invalidate(const QRectF &sceneRect) const
+{
+    if (sceneRect.isNull()) {
+        return;
+    }
+    // 额外留 2 像素给抗锯齿和装饰画笔
+    const QRect deviceRect = view->viewportTransform().mapRect(sceneRect).toAlignedRect().adjusted(-2, -2, 2, 2);
+    view->viewport()->update(deviceRect);
+}
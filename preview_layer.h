@@ -0,0 +1,55 @@
+#ifndef PREVIEW_LAYER_H
+#define PREVIEW_LAYER_H
+
+#include <QGraphicsView>
+#include <QPainter>
+#include <QPainterPath>
+#include <QPen>
+#include <QBrush>
+#include <QLineF>
+#include <QRectF>
+
+// 绘制预览层：绘制过程中的临时图形（预览线、矩形、圆弧等）不再是场景图元，
+// 而是在视图前景中绘制，修改时只重绘新旧图形覆盖的视口区域，不涉及场景索引。
+class PreviewLayer
+{
+public:
+    // 预览槽位，同一时刻每个槽位只保存一个图形
+    enum Slot {
+        ShapeSlot,   // 主预览图形（直线、矩形、椭圆、圆弧、多边形已确定的边）
+        SegmentSlot, // 跟随鼠标的线段（折线/多边形的橡皮筋线段）
+        ClosingSlot, // 闭合预览线段（从鼠标到第一个点）
+        SlotCount
+    };
+
+    explicit PreviewLayer(QGraphicsView *view);
+
+    // 图形均为场景坐标
+    void setPath(Slot slot, const QPainterPath &path, const QPen &pen, const QBrush &brush = Qt::NoBrush);
+    void setLine(Slot slot, const QLineF &line, const QPen &pen);
+    void setRect(Slot slot, const QRectF &rect, const QPen &pen);
+    void setEllipse(Slot slot, const QRectF &rect, const QPen &pen);
+    void lineTo(Slot slot, const QPointF &point); // 在已有路径末尾追加线段，只重绘新线段
+    void clear(Slot slot);
+    void clearAll();
+    bool isEmpty(Slot slot) const { return !shapes[slot].visible; }
+
+    // painter 处于场景坐标系（由 drawForeground 传入）
+    void paint(QPainter *painter, const QRectF &exposedSceneRect) const;
+
+private:
+    struct Shape {
+        QPainterPath path;
+        QPen pen;
+        QBrush brush;
+        QRectF sceneBounds; // 含画笔宽度的场景包围盒
+        bool visible = false;
+    };
+
+    void invalidate(const QRectF &sceneRect) const;
+
+    QGraphicsView *view;
+    Shape shapes[SlotCount];
+};
+
+#endif // PREVIEW_LAYER_H
@@ -0,0 +1,126 @@
+#include "primitive_grid.h"
+#include <QtGlobal>
+#include <algorithm>
+#include <cmath>
+
+void PrimitiveGrid::build(const QVector<QRectF> &boxes)
+{
+    clear();
+    boxCount = boxes.size();
+    if (boxCount == 0) {
+        return;
+    }
+    qreal left = boxes[0].left();
+    qreal top = boxes[0].top();
+    qreal right = boxes[0].right();
+    qreal bottom = boxes[0].bottom();
+    for (const QRectF &box : boxes) {
+        left = qMin(left, box.left());
+        top = qMin(top, box.top());
+        right = qMax(right, box.right());
+        bottom = qMax(bottom, box.bottom());
+    }
+    extent = QRectF(QPointF(left, top), QPointF(right, bottom));
+
+    // 单元格数约为包围盒数 / TargetPerCell；范围退化为一条线时按长边划分
+    const qreal width = right - left;
+    const qreal height = bottom - top;
+    const qreal cells = qMax<qreal>(1.0, qreal(boxCount) / TargetPerCell);
+    cellSize = qMax(std::sqrt(width * height / cells), qMax(width, height) / cells);
+    if (!(cellSize > 0.0)) {
+        cellSize = 1.0;
+    }
+    columns = int(width / cellSize) + 1;
+    rows = int(height / cellSize) + 1;
+
+    // 两遍：先统计每格数量得到区间起点，再按序号顺序填入
+    cellStart.fill(0, columns * rows + 1);
+    int firstColumn = 0, firstRow = 0, lastColumn = 0, lastRow = 0;
+    for (int i = 0; i < boxCount; ++i) {
+        cellRange(boxes[i], firstColumn, firstRow, lastColumn, lastRow);
+        if ((lastColumn - firstColumn + 1) * (lastRow - firstRow + 1) > MaxCellsPerBox) {
+            largeItems.append(i);
+            continue;
+        }
+        for (int row = firstRow; row <= lastRow; ++row) {
+            for (int column = firstColumn; column <= lastColumn; ++column) {
+                ++cellStart[row * columns + column + 1];
+            }
+        }
+    }
+    for (int cell = 0; cell < columns * rows; ++cell) {
+        cellStart[cell + 1] += cellStart[cell];
+    }
+    cellItems.resize(cellStart.last());
+    QVector<int> cursor = cellStart;
+    int large = 0;
+    for (int i = 0; i < boxCount; ++i) {
+        if (large < largeItems.size() && largeItems[large] == i) {
+            ++large;
+            continue;
+        }
+        cellRange(boxes[i], firstColumn, firstRow, lastColumn, lastRow);
+        for (int row = firstRow; row <= lastRow; ++row) {
+            for (int column = firstColumn; column <= lastColumn; ++column) {
+                cellItems[cursor[row * columns + column]++] = i;
+            }
+        }
+    }
+}
+
+void PrimitiveGrid::clear()
+{
+    extent = QRectF();
+    cellSize = 1.0;
+    columns = 0;
+    rows = 0;
+    boxCount = 0;
+    cellStart.clear();
+    cellItems.clear();
+    largeItems.clear();
+}
+
+bool PrimitiveGrid::query(const QRectF &rect, QVector<int> &result) const
+{
+    result.clear();
+    int firstColumn = 0, firstRow = 0, lastColumn = 0, lastRow = 0;
+    if (boxCount == 0 || !cellRange(rect, firstColumn, firstRow, lastColumn, lastRow)) {
+        return true;
+    }
+    const qint64 covered = qint64(lastColumn - firstColumn + 1) * (lastRow - firstRow + 1);
+    if (covered * 2 > qint64(columns) * rows) {
+        return false;
+    }
+    for (int row = firstRow; row <= lastRow; ++row) {
+        const int rowStart = row * columns;
+        for (int column = firstColumn; column <= lastColumn; ++column) {
+            const int cell = rowStart + column;
+            for (int k = cellStart[cell]; k < cellStart[cell + 1]; ++k) {
+                result.append(cellItems[k]);
+            }
+        }
+    }
+    result.append(largeItems);
+    // 跨格的包围盒会在多个单元格中出现
+    std::sort(result.begin(), result.end());
+    result.erase(std::unique(result.begin(), result.end()), result.end());
+    return true;
+}
+
+bool PrimitiveGrid::cellRange(const QRectF &rect, int &firstColumn, int &firstRow, int &lastColumn, int &lastRow) const
+{
+    // 包含边界：水平/竖直线段的包围盒面积为零
+    if (rect.right() < extent.left() || rect.left() > extent.right()
+        || rect.bottom() < extent.top() || rect.top() > extent.bottom()) {
+        return false;
+    }
+    // 先在浮点范围内截断，查询矩形远大于网格时不会溢出
+    auto cellOf = [this](qreal offset, int count) {
+        return int(qBound<qreal>(0.0, std::floor(offset / cellSize), count - 1));
+    };
+    firstColumn = cellOf(rect.left() - extent.left(), columns);
+    lastColumn = cellOf(rect.right() - extent.left(), columns);
+    firstRow = cellOf(rect.top() - extent.top(), rows);
+    lastRow = cellOf(rect.bottom() - extent.top(), rows);
+    return true;
+}
@@ -0,0 +1,37 @@
+#ifndef PRIMITIVE_GRID_H
+#define PRIMITIVE_GRID_H
+
+#include <QVector>
+#include <QRectF>
+
+// 包围盒均匀网格：按总范围和数量选取单元格大小，使每格平均只有几个包围盒，
+// 单元格内容按序号升序紧凑存放（CSR）。跨越过多单元格的大包围盒单独存放，每次查询都返回。
+// 区域查询只访问相交的单元格，结果为候选序号，调用方再做精确测试。
+class PrimitiveGrid
+{
+public:
+    void build(const QVector<QRectF> &boxes);
+    void clear();
+    bool isEmpty() const { return boxCount == 0; }
+
+    // 包围盒可能与 rect 相交的序号（升序、无重复）；rect 覆盖了网格的大部分时返回 false，
+    // 此时逐个遍历全部包围盒更快
+    bool query(const QRectF &rect, QVector<int> &result) const;
+
+    static constexpr int TargetPerCell = 4;  // 每个单元格平均的包围盒数
+    static constexpr int MaxCellsPerBox = 64; // 跨越更多单元格的包围盒放入大包围盒列表
+
+private:
+    bool cellRange(const QRectF &rect, int &firstColumn, int &firstRow, int &lastColumn, int &lastRow) const;
+
+    QRectF extent;
+    qreal cellSize = 1.0;
+    int columns = 0;
+    int rows = 0;
+    int boxCount = 0;
+    QVector<int> cellStart; // 单元格 c 的内容为 cellItems[cellStart[c], cellStart[c + 1])
+    QVector<int> cellItems;
+    QVector<int> largeItems;
+};
+
+#endif // PRIMITIVE_GRID_H
@@ -0,0 +1,219 @@
+#include "raster_exporter.h"
+#include "streaming_image_encoder.h"
+#include "logging_categories.h"
+#include <QFutureWatcher>
+#include <QPainter>
+#include <QFile>
+#include <QThread>
+#include <QtConcurrent>
+#include <QtMath>
+#include <QDebug>
+#include <atomic>
+
+// 编码器和目标文件；最后一个持有者释放时，若导出已放弃则删除写了一半的文件
+struct RasterExporter::Output {
+    std::unique_ptr<StreamingImageEncoder> encoder;
+    QString filePath;
+    std::atomic<bool> discard{false};
+
+    ~Output()
+    {
+        encoder.reset(); // 先关闭文件
+        if (discard) {
+            QFile::remove(filePath);
+        }
+    }
+};
+
+namespace {
+
+// 工作线程：回放一个条带的录制结果，转换为编码器的行格式
+QImage renderBand(const QPicture &picture, int width, int rows, const QColor &background)
+{
+    const bool alpha = background.alpha() < 255;
+    QImage image(width, rows, alpha ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
+    image.fill(background);
+    QPainter painter(&image);
+    painter.drawPicture(0, 0, picture);
+    painter.end();
+    return image.convertToFormat(StreamingImageEncoder::rowFormat(alpha));
+}
+
+} // namespace
+
+RasterExporter::RasterExporter(QGraphicsScene *scene, QObject *parent)
+    : QObject(parent),
+    scene(scene)
+{
+}
+
+RasterExporter::~RasterExporter()
+{
+    if (running && output) {
+        output->discard = true;
+    }
+}
+
+QSize RasterExporter::outputSizeFor(const QRectF &sourceRect, qreal dpi)
+{
+    const qreal scale = dpi / SceneDpi;
+    return QSize(qCeil(sourceRect.width() * scale), qCeil(sourceRect.height() * scale));
+}
+
+bool RasterExporter::start(const QString &filePath, const QRectF &sourceRect, qreal dpi, const QColor &background)
+{
+    if (running || !scene) {
+        return false;
+    }
+    error.clear();
+    size = outputSizeFor(sourceRect, dpi);
+    if (size.isEmpty() || dpi <= 0) {
+        error = tr("导出区域或分辨率无效");
+        return false;
+    }
+    std::unique_ptr<StreamingImageEncoder> encoder = StreamingImageEncoder::create(filePath);
+    if (!encoder) {
+        error = tr("不支持的图片格式，请使用 .png 或 .tif");
+        return false;
+    }
+    const bool alpha = background.alpha() < 255;
+    if (!encoder->begin(size.width(), size.height(), alpha, dpi)) {
+        error = encoder->errorString();
+        return false;
+    }
+    output = std::make_shared<Output>();
+    output->encoder = std::move(encoder);
+    output->filePath = filePath;
+
+    source = sourceRect;
+    scale = dpi / SceneDpi;
+    this->background = background;
+    // 条带高度按内存上限取，宽图的条带更矮
+    const qint64 rowBytes = qint64(size.width()) * 4;
+    bandRows = int(qBound<qint64>(1, BandBytes / rowBytes, size.height()));
+    bandCount = (size.height() + bandRows - 1) / bandRows;
+    nextBand = 0;
+    nextWrite = 0;
+    inFlight = 0;
+    pictureBytes = 0;
+    rendered.clear();
+    writing = false;
+    lastProgress = -1;
+    running = true;
+    qCInfo(lcIo) << "Raster export started:" << filePath << size << "at" << dpi << "dpi," << bandCount << "bands of" << bandRows << "rows.";
+    dispatch();
+    return true;
+}
+
+void RasterExporter::cancel()
+{
+    if (!running) {
+        return;
+    }
+    finish(tr("导出已取消"));
+}
+
+QPicture RasterExporter::recordBand(int index) const
+{
+    // 条带在输出图片中的行范围对应到场景中的一条横带；只有与它相交的图元会被绘制
+    const int top = index * bandRows;
+    const int rows = qMin(bandRows, size.height() - top);
+    const QRectF target(0, 0, size.width(), rows);
+    const QRectF band(source.left(), source.top() + top / scale, size.width() / scale, rows / scale);
+
+    QPicture picture;
+    QPainter painter(&picture);
+    painter.setRenderHints(QPainter::Antialiasing | QPainter::SmoothPixmapTransform | QPainter::TextAntialiasing);
+    scene->render(&painter, target, band, Qt::IgnoreAspectRatio);
+    painter.end();
+    return picture;
+}
+
+void RasterExporter::dispatch()
+{
+    // 录制必须在 GUI 线程（图元的 paint 不是线程安全的），回放交给线程池。
+    // 录制里包含条带中的整张图片，大图片较多时录制本身可能比条带位图还大，因此同时按录制大小限流
+    const int maxInFlight = qMax(1, QThread::idealThreadCount()) + ExtraBands;
+    while (running && inFlight < maxInFlight && nextBand < bandCount && (pictureBytes < PictureBudget || pictureBytes == 0)) {
+        const int index = nextBand++;
+        const int rows = qMin(bandRows, size.height() - index * bandRows);
+        const QPicture picture = recordBand(index);
+        const qint64 bytes = picture.size();
+        pictureBytes += bytes;
+        ++inFlight;
+        QFutureWatcher<QImage> *watcher = new QFutureWatcher<QImage>(this);
+        connect(watcher, &QFutureWatcher<QImage>::finished, this, [this, watcher, index, bytes]() {
+            pictureBytes -= bytes; // 回放结束，工作线程持有的录制副本已释放
+            bandRendered(index, watcher->result());
+            watcher->deleteLater();
+        });
+        watcher->setFuture(QtConcurrent::run(renderBand, picture, size.width(), rows, background));
+    }
+}
+
+void RasterExporter::bandRendered(int index, const QImage &band)
+{
+    if (!running) {
+        return;
+    }
+    rendered.insert(index, band);
+    encodeNext();
+    dispatch(); // 录制大小腾出了空间
+}
+
+void RasterExporter::encodeNext()
+{
+    // 编码器只能顺序写入：同一时刻只有一个写入任务，条带按序号依次交给它
+    if (!running || writing) {
+        return;
+    }
+    const bool last = nextWrite == bandCount;
+    if (!last && !rendered.contains(nextWrite)) {
+        return;
+    }
+    writing = true;
+    const QImage band = last ? QImage() : rendered.take(nextWrite);
+    const std::shared_ptr<Output> target = output;
+    QFutureWatcher<bool> *watcher = new QFutureWatcher<bool>(this);
+    connect(watcher, &QFutureWatcher<bool>::finished, this, [this, watcher, last]() {
+        const bool ok = watcher->result();
+        watcher->deleteLater();
+        writing = false;
+        if (!running) {
+            return;
+        }
+        if (!ok) {
+            finish(output->encoder->errorString());
+            return;
+        }
+        if (last) {
+            finish(QString());
+            return;
+        }
+        ++nextWrite;
+        --inFlight;
+        const int progress = nextWrite * 100 / bandCount;
+        if (progress != lastProgress) {
+            lastProgress = progress;
+            emit progressChanged(progress);
+        }
+        dispatch();
+        encodeNext();
+    });
+    watcher->setFuture(QtConcurrent::run([target, band, last]() {
+        return last ? target->encoder->finish() : target->encoder->writeRows(band);
+    }));
+}
+
+void RasterExporter::finish(const QString &error)
+{
+    running = false;
+    rendered.clear();
+    if (!error.isEmpty() && output) {
+        output->discard = true; // 仍在进行的写入任务结束后删除文件
+    }
+    output.reset();
+    this->error = error;
+    qCInfo(lcIo) << "Raster export finished," << nextWrite << "of" << bandCount << "bands written." << error;
+    emit finished(error);
+}
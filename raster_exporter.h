@@ -0,0 +1,70 @@
+#ifndef RASTER_EXPORTER_H
+#define RASTER_EXPORTER_H
+
+#include <QObject>
+#include <QGraphicsScene>
+#include <QPicture>
+#include <QImage>
+#include <QColor>
+#include <QMap>
+#include <QRectF>
+#include <QSize>
+#include <memory>
+
+// 任意分辨率的栅格导出（PNG/TIFF）：GUI 线程逐个条带把场景录制成 QPicture（只遍历与条带相交的图元），
+// 线程池并行把条带回放成位图，再按顺序交给编码器逐行压缩写入文件。
+// 同时在途的条带数和录制总大小都有上限：位图占用只与图片宽度有关，大图片被每个条带重复录制时
+// 由录制大小限制同时存在的份数。导出期间场景不应被修改（调用方用模态进度框）。
+class RasterExporter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit RasterExporter(QGraphicsScene *scene, QObject *parent = nullptr);
+    ~RasterExporter() override;
+
+    // 把场景中的 sourceRect 按 dpi 导出（场景单位按 96 DPI 下的像素计），格式由文件后缀决定；
+    // background 为透明时输出 alpha 通道。参数或文件无效时返回 false，原因见 errorString()
+    bool start(const QString &filePath, const QRectF &sourceRect, qreal dpi, const QColor &background = Qt::white);
+    void cancel(); // 停止导出并删除未写完的文件
+    bool isRunning() const { return running; }
+    QString errorString() const { return error; }
+
+    static QSize outputSizeFor(const QRectF &sourceRect, qreal dpi);
+
+    static constexpr qreal SceneDpi = 96.0;               // 场景单位对应的分辨率
+    static constexpr qint64 BandBytes = 32 * 1024 * 1024; // 单个条带位图的内存上限
+    static constexpr int ExtraBands = 2;                  // 在途条带数 = 线程数 + ExtraBands
+    static constexpr qint64 PictureBudget = 128 * 1024 * 1024; // 尚未回放完的条带录制总大小上限（至少放行一个条带）
+
+signals:
+    void progressChanged(int percent);
+    void finished(const QString &error); // error 为空表示成功
+
+private:
+    struct Output;
+    QPicture recordBand(int index) const;
+    void dispatch();
+    void bandRendered(int index, const QImage &band);
+    void encodeNext();
+    void finish(const QString &error);
+
+    QGraphicsScene *scene;
+    std::shared_ptr<Output> output; // 编码器由写入任务和本对象共同持有
+    QRectF source;
+    qreal scale = 1.0;
+    QSize size;
+    QColor background;
+    int bandRows = 0;
+    int bandCount = 0;
+    int nextBand = 0;    // 下一个要录制的条带
+    int nextWrite = 0;   // 下一个要写入的条带
+    int inFlight = 0;    // 已录制、尚未写入的条带数
+    qint64 pictureBytes = 0; // 已录制、尚未回放完的条带录制大小
+    QMap<int, QImage> rendered; // 渲染完成、等待按顺序写入的条带
+    bool writing = false;
+    bool running = false;
+    int lastProgress = -1;
+    QString error;
+};
+
+#endif // RASTER_EXPORTER_H
@@ -0,0 +1,524 @@
+#include "raster_pyramid_item.h"
+#include "image_mip_chain.h"
+#include "logging_categories.h"
+#include <QGraphicsScene>
+#include <QGraphicsView>
+#include <QStyleOptionGraphicsItem>
+#include <QPainter>
+#include <QImageReader>
+#include <QCryptographicHash>
+#include <QStandardPaths>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QSettings>
+#include <QDir>
+#include <QFile>
+#include <QVector>
+#include <QtConcurrent>
+#include <QPromise>
+#include <QDebug>
+#include <cmath>
+
+namespace {
+
+// 同一文件的金字塔只生成一次，多个图元共享同一个后台任务
+struct Build {
+    QFuture<RasterPyramidItem::PyramidInfo> future;
+    int users = 0;
+};
+
+QHash<QString, Build> &activeBuilds()
+{
+    static QHash<QString, Build> builds;
+    return builds;
+}
+
+void releaseBuild(const QString &dir, bool cancel)
+{
+    auto it = activeBuilds().find(dir);
+    if (it == activeBuilds().end() || --it->users > 0) {
+        return;
+    }
+    if (cancel) {
+        it->future.cancel(); // 没有使用者了，生成任务在下一行瓦片处停止
+    }
+    activeBuilds().erase(it);
+}
+
+QString infoPath(const QString &dir)
+{
+    return dir + QStringLiteral("/pyramid.ini");
+}
+
+// 读取已完成的金字塔；元数据最后写入，存在即表示瓦片完整
+RasterPyramidItem::PyramidInfo readInfo(const QString &dir)
+{
+    RasterPyramidItem::PyramidInfo info;
+    if (!QFile::exists(infoPath(dir))) {
+        return info;
+    }
+    const QSettings settings(infoPath(dir), QSettings::IniFormat);
+    if (settings.value(QStringLiteral("tileSize")).toInt() != RasterPyramidItem::TileSize) {
+        return info;
+    }
+    info.size = QSize(settings.value(QStringLiteral("width")).toInt(), settings.value(QStringLiteral("height")).toInt());
+    info.levels = settings.value(QStringLiteral("levels")).toInt();
+    info.opaque = settings.value(QStringLiteral("opaque"), true).toBool();
+    return info;
+}
+
+// 逐行接收第 0 层瓦片并写入磁盘；每凑齐两行就合成下一层的一行，每层最多暂存一行
+class PyramidWriter
+{
+public:
+    PyramidWriter(const QString &dir, const QSize &size)
+        : dir(dir)
+    {
+        int columns = (size.width() + RasterPyramidItem::TileSize - 1) / RasterPyramidItem::TileSize;
+        int rows = (size.height() + RasterPyramidItem::TileSize - 1) / RasterPyramidItem::TileSize;
+        rowCounts.append(rows);
+        while (columns > 1 || rows > 1) {
+            columns = (columns + 1) / 2;
+            rows = (rows + 1) / 2;
+            rowCounts.append(rows);
+        }
+        nextRow.fill(0, rowCounts.size());
+        pending.resize(rowCounts.size());
+    }
+
+    int levelCount() const { return rowCounts.size(); }
+    bool createDirectories() const
+    {
+        for (int level = 0; level < levelCount(); ++level) {
+            if (!QDir().mkpath(dir + QLatin1Char('/') + QString::number(level))) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool pushRow(int level, const QVector<QImage> &row)
+    {
+        const int y = nextRow[level]++;
+        for (int x = 0; x < row.size(); ++x) {
+            // 不透明的原图按 RGB 保存，文件更小、读回后绘制也更快
+            const QImage tile = opaque ? row.at(x).convertToFormat(QImage::Format_RGB32) : row.at(x);
+            const QString path = dir + QStringLiteral("/%1/%2_%3.png").arg(level).arg(x).arg(y);
+            if (!tile.save(path, "PNG")) {
+                qCWarning(lcIo) << "Cannot write pyramid tile:" << path;
+                return false;
+            }
+        }
+        if (level + 1 == levelCount()) {
+            return true;
+        }
+        // 偶数行先暂存，等下一行到达；最后一行落单时单独合成
+        if (y % 2 == 0 && y + 1 < rowCounts.at(level)) {
+            pending[level] = row;
+            return true;
+        }
+        const QVector<QImage> upper = y % 2 == 0 ? row : pending.at(level);
+        const QVector<QImage> lower = y % 2 == 0 ? QVector<QImage>() : row;
+        pending[level].clear();
+        QVector<QImage> next;
+        for (int x = 0; x < upper.size(); x += 2) {
+            next.append(combine(upper, lower, x));
+        }
+        return pushRow(level + 1, next);
+    }
+
+    bool opaque = true;
+
+private:
+    // 2x2 块瓦片拼合后缩小一半，得到下一层的一块瓦片
+    static QImage combine(const QVector<QImage> &upper, const QVector<QImage> &lower, int x)
+    {
+        const QImage &topLeft = upper.at(x);
+        const QImage *topRight = x + 1 < upper.size() ? &upper.at(x + 1) : nullptr;
+        const QImage *bottomLeft = lower.isEmpty() ? nullptr : &lower.at(x);
+        const QImage *bottomRight = bottomLeft && topRight ? &lower.at(x + 1) : nullptr;
+        QImage quad(topLeft.width() + (topRight ? topRight->width() : 0),
+                    topLeft.height() + (bottomLeft ? bottomLeft->height() : 0),
+                    QImage::Format_ARGB32_Premultiplied);
+        QPainter painter(&quad);
+        painter.setCompositionMode(QPainter::CompositionMode_Source);
+        painter.drawImage(0, 0, topLeft);
+        if (topRight) {
+            painter.drawImage(topLeft.width(), 0, *topRight);
+        }
+        if (bottomLeft) {
+            painter.drawImage(0, topLeft.height(), *bottomLeft);
+        }
+        if (bottomRight) {
+            painter.drawImage(topLeft.width(), topLeft.height(), *bottomRight);
+        }
+        painter.end();
+        return ImageMipChain::downsample(quad);
+    }
+
+    QString dir;
+    QVector<int> rowCounts; // 每层的瓦片行数
+    QVector<int> nextRow;
+    QVector<QVector<QImage>> pending;
+};
+
+// 从已解码的图像带中切出一行第 0 层瓦片
+QVector<QImage> cutRow(const QImage &band, int top, int height)
+{
+    QVector<QImage> row;
+    for (int left = 0; left < band.width(); left += RasterPyramidItem::TileSize) {
+        const QRect rect(left, top, qMin(RasterPyramidItem::TileSize, band.width() - left), height);
+        row.append(band.copy(rect).convertToFormat(QImage::Format_ARGB32_Premultiplied));
+    }
+    return row;
+}
+
+// 工作线程：生成金字塔。原图按自身格式（如单色扫描图每像素 1 位）能放进内存时一次解码，
+// 否则要求解码器支持按区域读取，逐带解码，任何时候都不会整张展开为 ARGB32
+void buildPyramid(QPromise<RasterPyramidItem::PyramidInfo> &promise, const QString &source, const QString &dir)
+{
+    RasterPyramidItem::PyramidInfo info;
+    QImageReader reader(source);
+    info.size = reader.size();
+    const int width = info.size.width();
+    const int height = info.size.height();
+    if (info.size.isEmpty()) {
+        info.error = RasterPyramidItem::tr("无法读取图片尺寸: %1").arg(reader.errorString());
+        promise.addResult(info);
+        return;
+    }
+
+    QFile::remove(infoPath(dir)); // 中断过的旧结果不能被当作完整金字塔
+    PyramidWriter writer(dir, info.size);
+    if (!writer.createDirectories()) {
+        info.error = RasterPyramidItem::tr("无法创建瓦片缓存目录: %1").arg(dir);
+        promise.addResult(info);
+        return;
+    }
+
+    const int tileRows = (height + RasterPyramidItem::TileSize - 1) / RasterPyramidItem::TileSize;
+    promise.setProgressRange(0, tileRows);
+    const int bits = QImage::toPixelFormat(reader.imageFormat()).bitsPerPixel();
+    const qint64 nativeBytes = qint64(width) * height * (bits > 0 ? bits : 32) / 8;
+
+    // 每带的瓦片行数；能一次解码时整张图作为一带
+    int bandTileRows = tileRows;
+    if (nativeBytes > RasterPyramidItem::MaxDecodeBytes) {
+        if (!reader.supportsOption(QImageIOHandler::ClipRect)) {
+            info.error = RasterPyramidItem::tr("图片过大且该格式不支持按区域解码，请转换为 JPEG 后再导入");
+            promise.addResult(info);
+            return;
+        }
+        const qint64 tileRowBytes = qint64(width) * 4 * RasterPyramidItem::TileSize;
+        bandTileRows = int(qBound<qint64>(1, RasterPyramidItem::BandBytes / tileRowBytes, tileRows));
+    }
+    const qint64 bandBytes = bandTileRows < tileRows ? qint64(width) * 4 * bandTileRows * RasterPyramidItem::TileSize
+                                                     : nativeBytes;
+    QImageReader::setAllocationLimit(qMax(QImageReader::allocationLimit(), int(bandBytes / (1024 * 1024)) + 1));
+
+    for (int bandRow = 0; bandRow < tileRows; bandRow += bandTileRows) {
+        if (promise.isCanceled()) {
+            return;
+        }
+        const int top = bandRow * RasterPyramidItem::TileSize;
+        const int bandHeight = qMin(bandTileRows * RasterPyramidItem::TileSize, height - top);
+        QImageReader bandReader(source);
+        if (bandTileRows < tileRows) {
+            bandReader.setClipRect(QRect(0, top, width, bandHeight));
+        }
+        const QImage band = bandReader.read();
+        if (band.isNull()) {
+            info.error = RasterPyramidItem::tr("解码失败: %1").arg(bandReader.errorString());
+            promise.addResult(info);
+            return;
+        }
+        if (bandRow == 0) {
+            writer.opaque = !band.hasAlphaChannel();
+            info.opaque = writer.opaque;
+        }
+        for (int localTop = 0; localTop < band.height(); localTop += RasterPyramidItem::TileSize) {
+            if (promise.isCanceled()) {
+                return;
+            }
+            const int rowHeight = qMin(RasterPyramidItem::TileSize, band.height() - localTop);
+            if (!writer.pushRow(0, cutRow(band, localTop, rowHeight))) {
+                info.error = RasterPyramidItem::tr("无法写入瓦片缓存目录: %1").arg(dir);
+                promise.addResult(info);
+                return;
+            }
+            promise.setProgressValue(bandRow + localTop / RasterPyramidItem::TileSize + 1);
+        }
+    }
+
+    QSettings settings(infoPath(dir), QSettings::IniFormat);
+    settings.setValue(QStringLiteral("source"), source);
+    settings.setValue(QStringLiteral("width"), width);
+    settings.setValue(QStringLiteral("height"), height);
+    settings.setValue(QStringLiteral("tileSize"), RasterPyramidItem::TileSize);
+    settings.setValue(QStringLiteral("levels"), writer.levelCount());
+    settings.setValue(QStringLiteral("opaque"), info.opaque);
+    settings.sync();
+    info.levels = writer.levelCount();
+    promise.addResult(info);
+}
+
+// 工作线程：读取一块瓦片并转换为绘制最快的格式；文件缺失时返回空图
+QImage loadTile(const QString &path)
+{
+    const QImage image(path);
+    if (image.isNull()) {
+        return image;
+    }
+    return image.convertToFormat(image.hasAlphaChannel() ? QImage::Format_ARGB32_Premultiplied : QImage::Format_RGB32);
+}
+
+} // namespace
+
+RasterPyramidItem::RasterPyramidItem(const QString &sourcePath, QGraphicsItem *parent)
+    : QGraphicsObject(parent),
+    source(QFileInfo(sourcePath).absoluteFilePath())
+{
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption, true); // 需要实际暴露区域来决定加载哪些瓦片
+
+    QImageReader reader(source);
+    size = reader.size();
+    if (size.isEmpty()) {
+        qCWarning(lcIo) << "Cannot read raster size:" << source << reader.errorString();
+        return;
+    }
+
+    // 文件路径、大小和修改时间都不变时复用上次生成的金字塔
+    const QFileInfo info(source);
+    const QByteArray identity = QStringLiteral("%1|%2|%3").arg(source).arg(info.size())
+                                    .arg(info.lastModified().toMSecsSinceEpoch()).toUtf8();
+    cacheDir = QStandardPaths::writableLocation(QStandardPaths::CacheLocation) + QStringLiteral("/raster_pyramids/")
+               + QString::fromLatin1(QCryptographicHash::hash(identity, QCryptographicHash::Sha1).toHex());
+    const PyramidInfo existing = readInfo(cacheDir);
+    if (existing.levels > 0 && existing.size == size) {
+        levels = existing.levels;
+        qCDebug(lcItems) << "Reusing raster pyramid for" << source << size << levels << "levels.";
+        return;
+    }
+
+    connect(&buildWatcher, &QFutureWatcher<PyramidInfo>::progressValueChanged, this, [this](int value) {
+        const int maximum = buildWatcher.progressMaximum();
+        emit progressChanged(maximum > 0 ? value * 100 / maximum : 0);
+    });
+    connect(&buildWatcher, &QFutureWatcher<PyramidInfo>::finished, this, &RasterPyramidItem::buildFinished);
+    Build &build = activeBuilds()[cacheDir];
+    if (build.users == 0) {
+        qCInfo(lcIo) << "Building raster pyramid for" << source << size;
+        build.future = QtConcurrent::run(buildPyramid, source, cacheDir);
+    }
+    ++build.users;
+    building = true;
+    buildWatcher.setFuture(build.future);
+}
+
+RasterPyramidItem::~RasterPyramidItem()
+{
+    if (building) {
+        releaseBuild(cacheDir, true);
+    }
+}
+
+QRectF RasterPyramidItem::boundingRect() const
+{
+    return QRectF(QPointF(0, 0), QSizeF(size));
+}
+
+void RasterPyramidItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(widget);
+    const QRectF bounds = boundingRect();
+    if (!isReady()) {
+        // 金字塔生成中（或生成失败）只画占位框
+        painter->save();
+        painter->setPen(QPen(QColor(128, 128, 128), 0, Qt::DashLine));
+        painter->setBrush(QColor(128, 128, 128, 32));
+        painter->drawRect(bounds);
+        painter->restore();
+        return;
+    }
+
+    const QTransform world = painter->worldTransform();
+    const qreal dpr = painter->device()->devicePixelRatioF();
+    const int level = levelForScale(option->levelOfDetailFromTransform(world) * dpr);
+
+    // 只处理真正可见的部分：暴露区域与设备视口、裁剪区域的交集
+    QRectF visible = option->exposedRect & bounds;
+    visible &= world.inverted().mapRect(QRectF(painter->viewport()));
+    if (painter->hasClipping()) {
+        visible &= painter->clipBoundingRect();
+    }
+    if (visible.isEmpty()) {
+        return;
+    }
+
+    // 视口中异步加载；导出等离屏绘制同步读取，保证结果完整
+    const bool async = painter->device()->devType() == QInternal::Widget;
+    const qint64 span = qint64(TileSize) << level;
+    const qreal scale = qreal(qint64(1) << level);
+    const int firstX = int(visible.left() / span);
+    const int lastX = qMin(tileColumns(level) - 1, int(visible.right() / span));
+    const int firstY = int(visible.top() / span);
+    const int lastY = qMin(tileRows(level) - 1, int(visible.bottom() / span));
+    for (int y = firstY; y <= lastY; ++y) {
+        for (int x = firstX; x <= lastX; ++x) {
+            const quint64 key = tileKey(level, x, y);
+            if (!async && !tiles.contains(key)) {
+                insertTile(key, loadTile(tilePath(level, x, y)));
+            }
+            const QImage *image = cachedTile(key);
+            if (!image) {
+                requestTile(level, x, y);
+                drawFallback(painter, level, x, y);
+                continue;
+            }
+            if (!image->isNull()) {
+                painter->drawImage(QRectF(x * span, y * span, image->width() * scale, image->height() * scale), *image);
+            }
+        }
+    }
+}
+
+QString RasterPyramidItem::tilePath(int level, int x, int y) const
+{
+    return cacheDir + QStringLiteral("/%1/%2_%3.png").arg(level).arg(x).arg(y);
+}
+
+int RasterPyramidItem::levelForScale(qreal scale) const
+{
+    // 第 k 层分辨率为原图的 1/2^k，取分辨率不低于目标的最粗一层
+    if (scale >= 1.0 || scale <= 0.0 || levels <= 1) {
+        return 0;
+    }
+    return qBound(0, int(std::floor(std::log2(1.0 / scale))), levels - 1);
+}
+
+int RasterPyramidItem::tileColumns(int level) const
+{
+    const qint64 span = qint64(TileSize) << level;
+    return int((size.width() + span - 1) / span);
+}
+
+int RasterPyramidItem::tileRows(int level) const
+{
+    const qint64 span = qint64(TileSize) << level;
+    return int((size.height() + span - 1) / span);
+}
+
+const QImage *RasterPyramidItem::cachedTile(quint64 key)
+{
+    auto it = tiles.find(key);
+    if (it == tiles.end()) {
+        return nullptr;
+    }
+    it->lastUsed = ++useCounter;
+    return &it->image;
+}
+
+void RasterPyramidItem::requestTile(int level, int x, int y)
+{
+    const quint64 key = tileKey(level, x, y);
+    if (tiles.contains(key) || pendingLoads.contains(key)) {
+        return;
+    }
+    if (pendingLoads.size() >= MaxPendingLoads) {
+        requestsDropped = true;
+        return;
+    }
+    pendingLoads.insert(key);
+    const qint64 span = qint64(TileSize) << level;
+    const QRectF rect(x * span, y * span, span, span);
+    QFutureWatcher<QImage> *watcher = new QFutureWatcher<QImage>(this);
+    connect(watcher, &QFutureWatcher<QImage>::finished, this, [this, watcher, key, rect]() {
+        pendingLoads.remove(key);
+        insertTile(key, watcher->result());
+        watcher->deleteLater();
+        if (pendingLoads.isEmpty() && requestsDropped) {
+            // 排队已满时放弃过请求，整体重绘一次以重新请求仍然可见的瓦片
+            requestsDropped = false;
+            repaintViews(boundingRect());
+        } else {
+            repaintViews(rect);
+        }
+    });
+    watcher->setFuture(QtConcurrent::run(loadTile, tilePath(level, x, y)));
+}
+
+void RasterPyramidItem::insertTile(quint64 key, const QImage &image)
+{
+    if (tiles.contains(key)) {
+        return;
+    }
+    tiles.insert(key, CachedTile{image, ++useCounter});
+    tileBytes += image.sizeInBytes();
+    // 超出内存上限时淘汰最久未使用的瓦片
+    while (tileBytes > TileMemoryBudget && tiles.size() > 1) {
+        auto oldest = tiles.begin();
+        for (auto it = tiles.begin(); it != tiles.end(); ++it) {
+            if (it->lastUsed < oldest->lastUsed) {
+                oldest = it;
+            }
+        }
+        tileBytes -= oldest->image.sizeInBytes();
+        tiles.erase(oldest);
+    }
+}
+
+void RasterPyramidItem::drawFallback(QPainter *painter, int level, int x, int y)
+{
+    // 用更粗层级中已在内存的瓦片放大代替；都没有时请求只有一块的最粗一层
+    const qint64 span = qint64(TileSize) << level;
+    for (int coarse = level + 1; coarse < levels; ++coarse) {
+        const int shift = coarse - level;
+        const QImage *image = cachedTile(tileKey(coarse, x >> shift, y >> shift));
+        if (!image) {
+            continue;
+        }
+        if (!image->isNull()) {
+            const qint64 coarseSpan = qint64(TileSize) << coarse;
+            const qreal coarseScale = qreal(qint64(1) << coarse);
+            const QPointF origin((x >> shift) * coarseSpan, (y >> shift) * coarseSpan);
+            const QRectF target = QRectF(x * span, y * span, span, span) & boundingRect();
+            const QRectF sourceRect((target.left() - origin.x()) / coarseScale, (target.top() - origin.y()) / coarseScale,
+                                    target.width() / coarseScale, target.height() / coarseScale);
+            painter->drawImage(target, *image, sourceRect);
+        }
+        return;
+    }
+    requestTile(levels - 1, 0, 0);
+}
+
+void RasterPyramidItem::repaintViews(const QRectF &localRect)
+{
+    // 瓦片到达不改变图元内容，直接重绘视口而不通知场景，避免作废视口瓦片缓存
+    if (!scene()) {
+        return;
+    }
+    const QRectF sceneRect = mapRectToScene(localRect & boundingRect());
+    const QList<QGraphicsView*> views = scene()->views();
+    for (QGraphicsView *view : views) {
+        view->viewport()->update(view->mapFromScene(sceneRect).boundingRect().adjusted(-1, -1, 1, 1));
+    }
+}
+
+void RasterPyramidItem::buildFinished()
+{
+    building = false;
+    releaseBuild(cacheDir, false);
+    if (buildWatcher.isCanceled() || buildWatcher.future().resultCount() == 0) {
+        return;
+    }
+    const PyramidInfo info = buildWatcher.result();
+    if (!info.error.isEmpty()) {
+        qCWarning(lcIo) << "Raster pyramid failed for" << source << info.error;
+        emit failed(info.error);
+        return;
+    }
+    levels = info.levels;
+    qCInfo(lcIo) << "Raster pyramid ready for" << source << size << levels << "levels.";
+    update();
+    emit ready();
+}
@@ -0,0 +1,91 @@
+#ifndef RASTER_PYRAMID_ITEM_H
+#define RASTER_PYRAMID_ITEM_H
+
+#include <QGraphicsObject>
+#include <QFutureWatcher>
+#include <QHash>
+#include <QImage>
+#include <QSet>
+#include <QSize>
+#include <QString>
+
+// 超大栅格底图：首次导入时在后台把原图切成磁盘上的瓦片金字塔（每层长宽减半，256 像素瓦片，
+// 按文件路径、大小和修改时间缓存，再次导入直接复用），绘制时只加载当前缩放对应层级中与可见区域相交的瓦片。
+// 瓦片由线程池读取，未到达前用更粗层级中已缓存的瓦片放大代替；内存中的瓦片按最近使用淘汰。
+// 作为底图使用：不可选中，不进入视口瓦片快照、烘焙图层和图元缓存策略。
+class RasterPyramidItem : public QGraphicsObject
+{
+    Q_OBJECT
+public:
+    enum { Type = UserType + 6 }; // 自定义类型，便于 qgraphicsitem_cast 和按类型分派
+    int type() const override { return Type; }
+
+    // 只读取文件头得到尺寸，金字塔不存在时开始后台生成
+    explicit RasterPyramidItem(const QString &sourcePath, QGraphicsItem *parent = nullptr);
+    ~RasterPyramidItem() override;
+
+    QString sourcePath() const { return source; }
+    QSize imageSize() const { return size; }
+    bool isValid() const { return !size.isEmpty(); } // 文件可读
+    bool isReady() const { return levels > 0; }      // 金字塔可用
+    int levelCount() const { return levels; }
+
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget = nullptr) override;
+
+    // 生成结果，工作线程返回
+    struct PyramidInfo {
+        QSize size;
+        int levels = 0;
+        bool opaque = true;
+        QString error;
+    };
+
+    static constexpr int TileSize = 256;
+    static constexpr qint64 TileMemoryBudget = 128 * 1024 * 1024; // 内存中瓦片上限（字节）
+    static constexpr int MaxPendingLoads = 64;   // 同时排队读取的瓦片数，其余等下次重绘再请求
+    static constexpr qint64 MaxDecodeBytes = 1024LL * 1024 * 1024; // 原图按自身格式一次解码的上限
+    static constexpr qint64 BandBytes = 256LL * 1024 * 1024; // 分带解码时每带的上限（ARGB32）
+
+signals:
+    void progressChanged(int percent);
+    void ready();
+    void failed(const QString &message);
+
+private:
+    static quint64 tileKey(int level, int x, int y)
+    {
+        return (quint64(level) << 48) | (quint64(quint32(y) & 0xffffff) << 24) | (quint32(x) & 0xffffff);
+    }
+    QString tilePath(int level, int x, int y) const;
+    int levelForScale(qreal scale) const;
+    int tileColumns(int level) const;
+    int tileRows(int level) const;
+    const QImage *cachedTile(quint64 key);
+    void requestTile(int level, int x, int y);
+    void insertTile(quint64 key, const QImage &image);
+    void drawFallback(QPainter *painter, int level, int x, int y);
+    void repaintViews(const QRectF &localRect);
+    void buildFinished();
+
+    struct CachedTile {
+        QImage image; // 瓦片文件缺失时为空，避免反复读取
+        quint64 lastUsed = 0;
+    };
+
+    QString source;
+    QString cacheDir;
+    QSize size;
+    int levels = 0;
+    bool building = false;
+
+    QHash<quint64, CachedTile> tiles;
+    QSet<quint64> pendingLoads;
+    bool requestsDropped = false; // 排队已满时放弃过请求
+    qint64 tileBytes = 0;
+    quint64 useCounter = 0;
+
+    QFutureWatcher<PyramidInfo> buildWatcher;
+};
+
+#endif // RASTER_PYRAMID_ITEM_H
@@ -0,0 +1,26 @@
+#include "render_quality.h"
+#include <atomic>
+
+namespace {
+std::atomic<bool> interactiveMode{false};
+}
+
+bool RenderQuality::isInteractive()
+{
+    return interactiveMode.load(std::memory_order_relaxed);
+}
+
+void RenderQuality::setInteractive(bool interactive)
+{
+    interactiveMode.store(interactive, std::memory_order_relaxed);
+}
+
+QPen RenderQuality::effectivePen(const QPen &pen)
+{
+    if (!isInteractive() || pen.style() == Qt::SolidLine || pen.style() == Qt::NoPen) {
+        return pen;
+    }
+    QPen solidPen(pen);
+    solidPen.setStyle(Qt::SolidLine);
+    return solidPen;
+}
@@ -0,0 +1,32 @@
+#ifndef RENDER_QUALITY_H
+#define RENDER_QUALITY_H
+
+#include <QPen>
+
+// 交互渲染模式：缩放、平移、拖动和绘制期间由视图开启，
+// 图形项据此去掉虚线等昂贵效果；停止交互一小段时间后视图恢复完整质量并重绘。
+class RenderQuality
+{
+public:
+    static bool isInteractive();
+    static void setInteractive(bool interactive);
+
+    // 交互模式下把虚线画笔换成实线，其余情况原样返回
+    static QPen effectivePen(const QPen &pen);
+
+    static constexpr int IdleRestoreMs = 150; // 停止交互多久后恢复完整质量
+
+    // 录制缓存内容（快照、烘焙图层）期间临时恢复完整质量，只在 GUI 线程使用
+    class FullQualityScope
+    {
+    public:
+        FullQualityScope() : wasInteractive(isInteractive()) { setInteractive(false); }
+        ~FullQualityScope() { setInteractive(wasInteractive); }
+        FullQualityScope(const FullQualityScope &) = delete;
+        FullQualityScope &operator=(const FullQualityScope &) = delete;
+    private:
+        bool wasInteractive;
+    };
+};
+
+#endif // RENDER_QUALITY_H
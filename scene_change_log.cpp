@@ -0,0 +1,51 @@
+#include "scene_change_log.h"
+#include "logging_categories.h"
+#include "scene_item_events.h"
+#include <QDebug>
+
+SceneChangeLog::SceneChangeLog(QGraphicsScene *scene, QObject *parent)
+    : QObject(parent),
+    sessionId(QUuid::createUuid())
+{
+    // 与瓦片缓存相同，经 SceneItemEvents 监听 changed，移除图元时记录其实际区域而不是整个场景
+    connect(SceneItemEvents::of(scene), &SceneItemEvents::changed, this, &SceneChangeLog::record);
+}
+
+bool SceneChangeLog::changesSince(quint64 serial, QVector<QRectF> &regions) const
+{
+    regions.clear();
+    if (serial > current) {
+        return false;
+    }
+    for (const Entry &entry : entries) {
+        if (entry.serial > serial) {
+            regions.append(entry.rect);
+        }
+    }
+    return true;
+}
+
+void SceneChangeLog::record(const QList<QRectF> &region)
+{
+    if (region.isEmpty()) {
+        return;
+    }
+    ++current;
+    for (const QRectF &rect : region) {
+        if (!rect.isNull()) {
+            entries.append(Entry{current, rect});
+        }
+    }
+    if (entries.size() <= MaxEntries) {
+        return;
+    }
+    // 最早的一半合并为一个矩形，带上其中最新的序号，查询结果只会偏大
+    const int merged = entries.size() / 2;
+    Entry oldest{entries.at(merged - 1).serial, QRectF()};
+    for (int i = 0; i < merged; ++i) {
+        oldest.rect |= entries.at(i).rect;
+    }
+    entries.remove(0, merged);
+    entries.prepend(oldest);
+    qCDebug(lcItems) << "Scene change log compacted," << merged << "entries merged into" << oldest.rect;
+}
@@ -0,0 +1,39 @@
+#ifndef SCENE_CHANGE_LOG_H
+#define SCENE_CHANGE_LOG_H
+
+#include <QObject>
+#include <QGraphicsScene>
+#include <QUuid>
+#include <QVector>
+#include <QRectF>
+
+// 场景变化记录：经 SceneItemEvents 监听场景变化，按递增序号保存变化区域（场景坐标），
+// 供增量导出查询"某次导出之后哪些区域变过"。条目数有上限，超出时最早的条目合并为一个矩形；
+// 序号只在本次运行内有效，用 session() 区分。
+class SceneChangeLog : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SceneChangeLog(QGraphicsScene *scene, QObject *parent = nullptr);
+
+    QUuid session() const { return sessionId; }
+    quint64 serial() const { return current; } // 每记录一批变化加一
+
+    // serial 之后的变化区域；serial 不属于本次运行的范围时返回 false（调用方应全量处理）
+    bool changesSince(quint64 serial, QVector<QRectF> &regions) const;
+
+    static constexpr int MaxEntries = 4096; // 超出时把最早的一半合并为一个矩形
+
+private:
+    void record(const QList<QRectF> &region);
+
+    struct Entry {
+        quint64 serial = 0;
+        QRectF rect;
+    };
+    QUuid sessionId;
+    QVector<Entry> entries; // 序号递增
+    quint64 current = 0;
+};
+
+#endif // SCENE_CHANGE_LOG_H
@@ -0,0 +1,55 @@
+#include "scene_item_events.h"
+#include "logging_categories.h"
+#include <QDebug>
+
+SceneItemEvents::SceneItemEvents(QGraphicsScene *scene)
+    : QObject(scene),
+    scene(scene)
+{
+    connect(scene, &QGraphicsScene::changed, this, &SceneItemEvents::sceneChanged);
+}
+
+SceneItemEvents *SceneItemEvents::of(QGraphicsScene *scene)
+{
+    SceneItemEvents *events = scene->findChild<SceneItemEvents*>(QString(), Qt::FindDirectChildrenOnly);
+    return events ? events : new SceneItemEvents(scene);
+}
+
+void SceneItemEvents::removeItem(QGraphicsScene *scene, QGraphicsItem *item)
+{
+    if (!scene || !item || item->scene() != scene) {
+        return;
+    }
+    const QRectF sceneRect = item->sceneBoundingRect().united(item->mapRectToScene(item->childrenBoundingRect()));
+    SceneItemEvents *events = of(scene);
+    emit events->itemRemoving(item, sceneRect);
+    emit events->changed({ sceneRect });
+    events->removalPending = events->removalPending || item->isVisible(); // 不可见图元移除时场景不标脏
+    scene->removeItem(item);
+}
+
+void SceneItemEvents::clear(QGraphicsScene *scene)
+{
+    if (!scene) {
+        return;
+    }
+    SceneItemEvents *events = of(scene);
+    emit events->clearing();
+    events->removalPending = false; // 清空时整个场景范围就是实际变化
+    scene->clear();
+    qCDebug(lcItems) << "Scene cleared.";
+}
+
+void SceneItemEvents::sceneChanged(const QList<QRectF> &region)
+{
+    // 移除图元时场景按 update() 整体标脏，同一轮的其他变化也并入整个范围；移除的区域已经报告过，
+    // 这一次整体范围丢弃。同一轮中与移除无关的变化会随之丢失，调用方移除时只伴随新增落在移除区域内的图元
+    if (removalPending) {
+        removalPending = false;
+        if (region.size() == 1 && region.first() == scene->sceneRect()) {
+            qCDebug(lcItems) << "Whole-scene change after item removal replaced by the removed regions.";
+            return;
+        }
+    }
+    emit changed(region);
+}
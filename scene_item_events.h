@@ -0,0 +1,39 @@
+#ifndef SCENE_ITEM_EVENTS_H
+#define SCENE_ITEM_EVENTS_H
+
+#include <QObject>
+#include <QGraphicsScene>
+#include <QGraphicsItem>
+#include <QRectF>
+
+// 场景图元移除通知：QGraphicsScene 没有图元移除的信号，按图元指针保存状态的对象（如图元缓存策略）
+// 无法得知图元已离开场景或被删除。移除图元的代码统一经 removeItem()/clear()，
+// 在图元仍然有效时先发出通知，再交给场景。每个场景一个实例，作为场景的子对象随场景销毁。
+// 另外转发场景的 changed：监听 changed 时，Qt 移除图元只报告整个场景范围，这里改为报告图元实际占据的区域。
+class SceneItemEvents : public QObject
+{
+    Q_OBJECT
+public:
+    static SceneItemEvents *of(QGraphicsScene *scene); // 不存在时创建
+
+    // 通知后把顶层图元移出场景（不删除），子项随之移出
+    static void removeItem(QGraphicsScene *scene, QGraphicsItem *item);
+    // 通知后清空场景（删除全部图元）
+    static void clear(QGraphicsScene *scene);
+
+signals:
+    // item 即将移出场景，此时仍可访问；sceneRect 为它及子项的场景包围盒
+    void itemRemoving(QGraphicsItem *item, const QRectF &sceneRect);
+    void clearing(); // 全部图元即将被删除
+    // 场景坐标下的变化区域，用法同 QGraphicsScene::changed
+    void changed(const QList<QRectF> &region);
+
+private:
+    explicit SceneItemEvents(QGraphicsScene *scene);
+    void sceneChanged(const QList<QRectF> &region);
+
+    QGraphicsScene *scene;
+    bool removalPending = false; // 移除后场景的下一次 changed 是整个场景范围
+};
+
+#endif // SCENE_ITEM_EVENTS_H
@@ -0,0 +1,78 @@
+#include "scene_transaction.h"
+#include "logging_categories.h"
+#include <QDebug>
+
+SceneTransaction::SceneTransaction(QGraphicsScene *scene, int expectedChanges)
+    : scene(scene)
+{
+    if (!scene) {
+        committed = true;
+        return;
+    }
+    State &state = states()[scene];
+    if (state.depth++ > 0) {
+        return; // 嵌套事务由最外层统一提交
+    }
+
+    // 暂停视口刷新，修改期间产生的脏区域不再逐次调度重绘
+    const QList<QGraphicsView*> views = scene->views();
+    for (QGraphicsView *view : views) {
+        state.views.append(view);
+        state.updateModes.append(view->viewportUpdateMode());
+        view->setViewportUpdateMode(QGraphicsView::NoViewportUpdate);
+    }
+
+    // 大批量修改时切换为无索引，避免每次增删都维护 BSP 树
+    if (expectedChanges < 0 || expectedChanges >= IndexSuspendThreshold) {
+        state.indexMethod = scene->itemIndexMethod();
+        if (state.indexMethod != QGraphicsScene::NoIndex) {
+            scene->setItemIndexMethod(QGraphicsScene::NoIndex);
+            state.indexSuspended = true;
+        }
+    }
+    qCDebug(lcView) << "Scene transaction started, expected changes:" << expectedChanges << "index suspended:" << state.indexSuspended;
+}
+
+SceneTransaction::~SceneTransaction()
+{
+    commit();
+}
+
+void SceneTransaction::commit()
+{
+    if (committed) {
+        return;
+    }
+    committed = true;
+
+    auto it = states().find(scene);
+    if (it == states().end() || --it->depth > 0) {
+        return;
+    }
+    const State state = *it;
+    states().erase(it);
+
+    // 恢复索引方式，BSP 树在此一次性重建
+    if (state.indexSuspended) {
+        scene->setItemIndexMethod(state.indexMethod);
+    }
+    // 恢复视口刷新模式，每个视图整体重绘一次
+    for (int i = 0; i < state.views.size(); ++i) {
+        if (QGraphicsView *view = state.views.at(i)) {
+            view->setViewportUpdateMode(state.updateModes.at(i));
+            view->viewport()->update();
+        }
+    }
+    qCDebug(lcView) << "Scene transaction committed.";
+}
+
+bool SceneTransaction::isActive(const QGraphicsScene *scene)
+{
+    return states().contains(scene);
+}
+
+QHash<const QGraphicsScene*, SceneTransaction::State> &SceneTransaction::states()
+{
+    static QHash<const QGraphicsScene*, State> activeStates; // 只在 GUI 线程使用
+    return activeStates;
+}
@@ -0,0 +1,42 @@
+#ifndef SCENE_TRANSACTION_H
+#define SCENE_TRANSACTION_H
+
+#include <QGraphicsScene>
+#include <QGraphicsView>
+#include <QHash>
+#include <QList>
+#include <QPointer>
+
+// 场景批量修改事务：构造时开始，commit() 或析构时提交。
+// 事务期间暂停所有视图的视口刷新；预计修改项较多时还会暂停场景索引，
+// 提交时只重建一次索引、每个视图只重绘一次。事务可以嵌套，只有最外层生效。
+class SceneTransaction
+{
+public:
+    // expectedChanges 为预计增删改的图形项数量，-1 表示未知（按大批量处理）
+    explicit SceneTransaction(QGraphicsScene *scene, int expectedChanges = -1);
+    ~SceneTransaction();
+
+    void commit();
+
+    static bool isActive(const QGraphicsScene *scene);
+
+    static constexpr int IndexSuspendThreshold = 1000; // 超过该数量时暂停索引
+
+private:
+    struct State {
+        int depth = 0;
+        bool indexSuspended = false;
+        QGraphicsScene::ItemIndexMethod indexMethod = QGraphicsScene::BspTreeIndex;
+        QList<QPointer<QGraphicsView>> views;
+        QList<QGraphicsView::ViewportUpdateMode> updateModes;
+    };
+    static QHash<const QGraphicsScene*, State> &states();
+
+    QGraphicsScene *scene;
+    bool committed = false;
+
+    Q_DISABLE_COPY(SceneTransaction)
+};
+
+#endif // SCENE_TRANSACTION_H
@@ -0,0 +1,260 @@
+#include "segment_index.h"
+#include <QtGlobal>
+#include <cmath>
+
+namespace {
+
+qreal segmentDistanceSquared(const QPointF &pos, const QPointF &a, const QPointF &b)
+{
+    const qreal dx = b.x() - a.x();
+    const qreal dy = b.y() - a.y();
+    const qreal length2 = dx * dx + dy * dy;
+    qreal t = 0.0;
+    if (length2 > 0.0) {
+        t = qBound<qreal>(0.0, ((pos.x() - a.x()) * dx + (pos.y() - a.y()) * dy) / length2, 1.0);
+    }
+    const qreal px = a.x() + t * dx - pos.x();
+    const qreal py = a.y() + t * dy - pos.y();
+    return px * px + py * py;
+}
+
+qreal pointDistanceSquared(const QPointF &a, const QPointF &b)
+{
+    const qreal dx = a.x() - b.x();
+    const qreal dy = a.y() - b.y();
+    return dx * dx + dy * dy;
+}
+
+} // namespace
+
+void SegmentIndex::Box::unite(const Box &other)
+{
+    if (other.isEmpty()) {
+        return;
+    }
+    if (isEmpty()) {
+        *this = other;
+        return;
+    }
+    left = qMin(left, other.left);
+    top = qMin(top, other.top);
+    right = qMax(right, other.right);
+    bottom = qMax(bottom, other.bottom);
+}
+
+qreal SegmentIndex::Box::distanceSquaredTo(const QPointF &pos) const
+{
+    const qreal dx = pos.x() < left ? left - pos.x() : (pos.x() > right ? pos.x() - right : 0.0);
+    const qreal dy = pos.y() < top ? top - pos.y() : (pos.y() > bottom ? pos.y() - bottom : 0.0);
+    return dx * dx + dy * dy;
+}
+
+bool SegmentIndex::Box::intersects(const QRectF &rect) const
+{
+    return !isEmpty() && left <= rect.right() && right >= rect.left()
+           && top <= rect.bottom() && bottom >= rect.top();
+}
+
+QRectF SegmentIndex::Box::toRect() const
+{
+    return isEmpty() ? QRectF() : QRectF(QPointF(left, top), QPointF(right, bottom));
+}
+
+void SegmentIndex::build(const QVector<QPointF> &points, bool closed)
+{
+    this->closed = closed;
+    vertexCount = points.size();
+    count = vertexCount < 2 ? 0 : (closed && vertexCount >= 3 ? vertexCount : vertexCount - 1);
+
+    // 预留一倍空间，连续追加顶点时不必每次重建
+    capacity = 1;
+    while (capacity < count) {
+        capacity *= 2;
+    }
+    nodes.fill(Box(), 2 * capacity);
+    for (int i = 0; i < count; ++i) {
+        nodes[capacity + i] = segmentBox(points, i);
+    }
+    // 单个顶点时没有线段，包围盒直接放在根节点
+    if (count == 0 && vertexCount == 1) {
+        nodes[capacity] = Box{points[0].x(), points[0].y(), points[0].x(), points[0].y()};
+    }
+    for (int node = capacity - 1; node >= 1; --node) {
+        nodes[node] = nodes[2 * node];
+        nodes[node].unite(nodes[2 * node + 1]);
+    }
+}
+
+void SegmentIndex::updateVertex(const QVector<QPointF> &points, int index)
+{
+    if (count == 0) {
+        build(points, closed);
+        return;
+    }
+    // 只有以该顶点为端点的两条线段受影响
+    if (index > 0) {
+        refreshSegment(points, index - 1);
+    } else if (closed && count == vertexCount) {
+        refreshSegment(points, count - 1);
+    }
+    if (index < count) {
+        refreshSegment(points, index);
+    }
+}
+
+void SegmentIndex::appendVertex(const QVector<QPointF> &points)
+{
+    const int newVertexCount = points.size();
+    const int newCount = newVertexCount < 2 ? 0 : (closed && newVertexCount >= 3 ? newVertexCount : newVertexCount - 1);
+    if (count == 0 || newCount > capacity) {
+        build(points, closed); // 容量翻倍，均摊 O(1)
+        return;
+    }
+    vertexCount = newVertexCount;
+    count = newCount;
+    // 新增线段，闭合时还有替换掉的旧闭合边和新的闭合边
+    for (int segment = qMax(0, newVertexCount - 2); segment < count; ++segment) {
+        refreshSegment(points, segment);
+    }
+}
+
+QRectF SegmentIndex::bounds() const
+{
+    return nodes.isEmpty() ? QRectF() : nodes[1].toRect();
+}
+
+QRectF SegmentIndex::segmentBounds(int segment) const
+{
+    if (segment < 0 || segment >= count) {
+        return QRectF();
+    }
+    return nodes[capacity + segment].toRect();
+}
+
+QRectF SegmentIndex::vertexNeighbourhood(int index) const
+{
+    Box box;
+    if (index > 0 && index - 1 < count) {
+        box.unite(nodes[capacity + index - 1]);
+    } else if (index == 0 && closed && count == vertexCount && count > 0) {
+        box.unite(nodes[capacity + count - 1]);
+    }
+    if (index >= 0 && index < count) {
+        box.unite(nodes[capacity + index]);
+    }
+    return box.toRect();
+}
+
+QVector<int> SegmentIndex::segmentsInRect(const QRectF &rect) const
+{
+    QVector<int> result;
+    if (count == 0) {
+        return result;
+    }
+    QVector<int> stack;
+    stack.append(1);
+    while (!stack.isEmpty()) {
+        const int node = stack.takeLast();
+        if (!nodes[node].intersects(rect)) {
+            continue;
+        }
+        if (node >= capacity) {
+            result.append(node - capacity);
+        } else {
+            // 先压右子树，保证按线段序号升序输出
+            stack.append(2 * node + 1);
+            stack.append(2 * node);
+        }
+    }
+    return result;
+}
+
+int SegmentIndex::nearestVertex(const QVector<QPointF> &points, const QPointF &pos, qreal maxDistance) const
+{
+    if (vertexCount == 1) {
+        return pointDistanceSquared(points[0], pos) <= maxDistance * maxDistance ? 0 : -1;
+    }
+    int best = -1;
+    qreal bestDistance2 = maxDistance * maxDistance;
+    if (count == 0) {
+        return best;
+    }
+    QVector<int> stack;
+    stack.append(1);
+    while (!stack.isEmpty()) {
+        const int node = stack.takeLast();
+        const Box &box = nodes[node];
+        if (box.isEmpty() || box.distanceSquaredTo(pos) > bestDistance2) {
+            continue;
+        }
+        if (node >= capacity) {
+            const int segment = node - capacity;
+            for (int vertex : {segment, segmentEnd(segment)}) {
+                const qreal d2 = pointDistanceSquared(points[vertex], pos);
+                if (d2 < bestDistance2 || (d2 == bestDistance2 && best < 0)) {
+                    bestDistance2 = d2;
+                    best = vertex;
+                }
+            }
+            continue;
+        }
+        // 先访问较近的子节点，尽早收紧剪枝距离
+        const int closer = nodes[2 * node].distanceSquaredTo(pos) <= nodes[2 * node + 1].distanceSquaredTo(pos) ? 2 * node : 2 * node + 1;
+        stack.append(closer ^ 1);
+        stack.append(closer);
+    }
+    return best;
+}
+
+int SegmentIndex::nearestSegment(const QVector<QPointF> &points, const QPointF &pos, qreal maxDistance,
+                                 qreal *distance) const
+{
+    int best = -1;
+    qreal bestDistance2 = maxDistance * maxDistance;
+    QVector<int> stack;
+    if (count > 0) {
+        stack.append(1);
+    }
+    while (!stack.isEmpty()) {
+        const int node = stack.takeLast();
+        const Box &box = nodes[node];
+        if (box.isEmpty() || box.distanceSquaredTo(pos) > bestDistance2) {
+            continue;
+        }
+        if (node >= capacity) {
+            const int segment = node - capacity;
+            const qreal d2 = segmentDistanceSquared(pos, points[segment], points[segmentEnd(segment)]);
+            if (d2 < bestDistance2 || (d2 == bestDistance2 && best < 0)) {
+                bestDistance2 = d2;
+                best = segment;
+            }
+            continue;
+        }
+        const int closer = nodes[2 * node].distanceSquaredTo(pos) <= nodes[2 * node + 1].distanceSquaredTo(pos) ? 2 * node : 2 * node + 1;
+        stack.append(closer ^ 1);
+        stack.append(closer);
+    }
+    if (distance && best >= 0) {
+        *distance = std::sqrt(bestDistance2);
+    }
+    return best;
+}
+
+SegmentIndex::Box SegmentIndex::segmentBox(const QVector<QPointF> &points, int segment) const
+{
+    const QPointF &a = points[segment];
+    const QPointF &b = points[segmentEnd(segment)];
+    return Box{qMin(a.x(), b.x()), qMin(a.y(), b.y()), qMax(a.x(), b.x()), qMax(a.y(), b.y())};
+}
+
+void SegmentIndex::refreshSegment(const QVector<QPointF> &points, int segment)
+{
+    int node = capacity + segment;
+    nodes[node] = segmentBox(points, segment);
+    // 沿路径向上合并子节点包围盒
+    for (node /= 2; node >= 1; node /= 2) {
+        Box merged = nodes[2 * node];
+        merged.unite(nodes[2 * node + 1]);
+        nodes[node] = merged;
+    }
+}
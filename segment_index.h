@@ -0,0 +1,57 @@
+#ifndef SEGMENT_INDEX_H
+#define SEGMENT_INDEX_H
+
+#include <QVector>
+#include <QPointF>
+#include <QRectF>
+
+// 折线线段索引：按线段序号排列的隐式完全二叉树，每个节点保存其线段区间的包围盒。
+// 线段 i 连接顶点 i 和 i+1，闭合折线的最后一条线段连接末顶点和首顶点。
+// 移动一个顶点只需沿两条叶子路径向上刷新，最近顶点/线段和区域查询按包围盒剪枝，
+// 均为 O(log n)（区域查询另加命中数量）。顶点数组由调用方持有，每次调用时传入。
+class SegmentIndex
+{
+public:
+    void build(const QVector<QPointF> &points, bool closed);
+    void updateVertex(const QVector<QPointF> &points, int index); // 顶点 index 已修改
+    void appendVertex(const QVector<QPointF> &points);            // 末尾已追加一个顶点
+
+    int segmentCount() const { return count; }
+    QRectF bounds() const; // 全部顶点的包围盒，空折线返回空矩形
+    QRectF segmentBounds(int segment) const;
+    // 顶点移动会影响的线段包围盒（移动前后各调用一次即可得到重绘区域）
+    QRectF vertexNeighbourhood(int index) const;
+
+    // 与矩形相交的线段序号，按升序排列
+    QVector<int> segmentsInRect(const QRectF &rect) const;
+    // 距离不超过 maxDistance 的最近顶点/线段，没有时返回 -1
+    int nearestVertex(const QVector<QPointF> &points, const QPointF &pos, qreal maxDistance) const;
+    int nearestSegment(const QVector<QPointF> &points, const QPointF &pos, qreal maxDistance,
+                       qreal *distance = nullptr) const;
+
+private:
+    // 用坐标极值表示包围盒：QRectF::united 会忽略水平/竖直线段的零面积矩形
+    struct Box {
+        qreal left = 1.0;
+        qreal top = 1.0;
+        qreal right = -1.0;
+        qreal bottom = -1.0;
+        bool isEmpty() const { return left > right; }
+        void unite(const Box &other);
+        qreal distanceSquaredTo(const QPointF &pos) const;
+        bool intersects(const QRectF &rect) const;
+        QRectF toRect() const;
+    };
+
+    Box segmentBox(const QVector<QPointF> &points, int segment) const;
+    void refreshSegment(const QVector<QPointF> &points, int segment);
+    int segmentEnd(int segment) const { return segment + 1 < vertexCount ? segment + 1 : 0; }
+
+    QVector<Box> nodes; // 1 为根，叶子从 capacity 开始
+    int capacity = 0;   // 叶子数，2 的幂
+    int count = 0;      // 线段数
+    int vertexCount = 0;
+    bool closed = false;
+};
+
+#endif // SEGMENT_INDEX_H
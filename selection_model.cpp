@@ -0,0 +1,132 @@
+#include "selection_model.h"
+#include "editable_line_item.h"
+#include "editable_polyline_item.h"
+#include "arc_item.h"
+#include "bulk_primitive_item.h"
+#include <QGraphicsRectItem>
+#include <QGraphicsEllipseItem>
+#include <QGraphicsPathItem>
+#include <QGraphicsPolygonItem>
+#include <QGraphicsTextItem>
+
+SelectionModel::SelectionModel(QObject *parent)
+    : QObject(parent)
+{
+}
+
+bool SelectionModel::add(QGraphicsItem *item)
+{
+    if (!item || itemSet.contains(item)) {
+        return false;
+    }
+    itemSet.insert(item);
+    orderedItems.append(item);
+    if (boundsValid) {
+        cachedBounds = cachedBounds.isNull() ? item->sceneBoundingRect()
+                                             : cachedBounds.united(item->sceneBoundingRect());
+    }
+    markChanged();
+    return true;
+}
+
+bool SelectionModel::remove(QGraphicsItem *item)
+{
+    if (!itemSet.remove(item)) {
+        return false;
+    }
+    orderedItems.removeOne(item);
+    boundsValid = false;
+    markChanged();
+    return true;
+}
+
+void SelectionModel::addItems(const QList<QGraphicsItem*> &items)
+{
+    beginGesture();
+    itemSet.reserve(itemSet.size() + items.size());
+    orderedItems.reserve(orderedItems.size() + items.size());
+    for (QGraphicsItem *item : items) {
+        add(item);
+    }
+    endGesture();
+}
+
+void SelectionModel::clear()
+{
+    if (orderedItems.isEmpty()) {
+        return;
+    }
+    itemSet.clear();
+    orderedItems.clear();
+    cachedBounds = QRectF();
+    boundsValid = true;
+    markChanged();
+}
+
+QRectF SelectionModel::boundingRect() const
+{
+    if (!boundsValid) {
+        cachedBounds = QRectF();
+        for (QGraphicsItem *item : orderedItems) {
+            cachedBounds = cachedBounds.isNull() ? item->sceneBoundingRect()
+                                                 : cachedBounds.united(item->sceneBoundingRect());
+        }
+        boundsValid = true;
+    }
+    return cachedBounds;
+}
+
+void SelectionModel::translateBounds(const QPointF &offset)
+{
+    if (boundsValid) {
+        cachedBounds.translate(offset);
+    }
+}
+
+void SelectionModel::invalidateBounds()
+{
+    boundsValid = false;
+}
+
+void SelectionModel::beginGesture()
+{
+    ++gestureDepth;
+}
+
+void SelectionModel::endGesture()
+{
+    if (gestureDepth == 0) {
+        return;
+    }
+    if (--gestureDepth == 0 && changedDuringGesture) {
+        changedDuringGesture = false;
+        emit selectionChanged();
+    }
+}
+
+bool SelectionModel::isSelectableType(const QGraphicsItem *item)
+{
+    switch (item->type()) {
+    case EditableLineItem::Type:
+    case EditablePolylineItem::Type:
+    case ArcItem::Type:
+    case BulkPrimitiveItem::Type:
+    case QGraphicsRectItem::Type:
+    case QGraphicsEllipseItem::Type:
+    case QGraphicsPathItem::Type:
+    case QGraphicsPolygonItem::Type:
+    case QGraphicsTextItem::Type:
+        return true;
+    default:
+        return false;
+    }
+}
+
+void SelectionModel::markChanged()
+{
+    if (gestureDepth > 0) {
+        changedDuringGesture = true;
+    } else {
+        emit selectionChanged();
+    }
+}
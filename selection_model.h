@@ -0,0 +1,53 @@
+#ifndef SELECTION_MODEL_H
+#define SELECTION_MODEL_H
+
+#include <QObject>
+#include <QGraphicsItem>
+#include <QSet>
+#include <QVector>
+#include <QRectF>
+
+// 选择模型：哈希集合判断成员 O(1)，有序数组保持选择顺序，
+// 缓存选中项的联合包围盒，每次手势只发出一次 selectionChanged。
+// 选中外观由视图的 SelectionOverlay 绘制，模型本身不修改图元
+class SelectionModel : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SelectionModel(QObject *parent = nullptr);
+
+    bool contains(QGraphicsItem *item) const { return itemSet.contains(item); }
+    bool isEmpty() const { return orderedItems.isEmpty(); }
+    int size() const { return orderedItems.size(); }
+    const QVector<QGraphicsItem*> &items() const { return orderedItems; } // 按选中先后排序
+
+    bool add(QGraphicsItem *item);    // 已选中则返回 false
+    bool remove(QGraphicsItem *item); // 未选中则返回 false
+    void addItems(const QList<QGraphicsItem*> &items);
+    void clear();
+
+    QRectF boundingRect() const;                // 选中项在场景中的联合包围盒（缓存）
+    void translateBounds(const QPointF &offset); // 整组平移时直接平移缓存
+    void invalidateBounds();                     // 选中项几何变化后使缓存失效
+
+    // 手势期间的修改合并为一次通知
+    void beginGesture();
+    void endGesture();
+
+    static bool isSelectableType(const QGraphicsItem *item); // 可被选择操作的图形类型
+
+signals:
+    void selectionChanged();
+
+private:
+    void markChanged();
+
+    QSet<QGraphicsItem*> itemSet;
+    QVector<QGraphicsItem*> orderedItems;
+    mutable QRectF cachedBounds;
+    mutable bool boundsValid = false;
+    int gestureDepth = 0;
+    bool changedDuringGesture = false;
+};
+
+#endif // SELECTION_MODEL_H
@@ -0,0 +1,162 @@
+#include "selection_overlay.h"
+#include "selection_model.h"
+#include "editable_line_item.h"
+#include "editable_polyline_item.h"
+#include <QPen>
+#include <QVector>
+#include <QtMath>
+
+namespace {
+
+// 遍历直线图元的控制点（场景坐标），回调返回 true 时停止遍历；折线顶点走线段索引
+template<typename Fn>
+bool forEachHandle(QGraphicsItem *item, Fn fn)
+{
+    const QTransform sceneTransform = item->sceneTransform();
+    switch (item->type()) {
+    case EditableLineItem::Type: {
+        EditableLineItem *lineItem = static_cast<EditableLineItem*>(item);
+        return fn(HandleRole::Start, -1, sceneTransform.map(lineItem->startHandlePos()))
+            || fn(HandleRole::End, -1, sceneTransform.map(lineItem->endHandlePos()))
+            || fn(HandleRole::Rotation, -1, sceneTransform.map(lineItem->rotationHandlePos()));
+    }
+    default:
+        return false;
+    }
+}
+
+bool hasHandles(const QGraphicsItem *item)
+{
+    return item->type() == EditableLineItem::Type || item->type() == EditablePolylineItem::Type;
+}
+
+} // namespace
+
+SelectionOverlay::SelectionOverlay(QGraphicsView *view, const SelectionModel *selection)
+    : view(view),
+    selection(selection)
+{
+}
+
+void SelectionOverlay::paint(QPainter *painter, const QRectF &exposedSceneRect) const
+{
+    if (!selection || selection->isEmpty()) {
+        return;
+    }
+
+    painter->save();
+    const QPen outlinePen(QColor(0, 120, 215), 0, Qt::DashLine); // 0 宽度为装饰画笔，不随缩放变化
+    painter->setBrush(Qt::NoBrush);
+
+    if (selection->size() > MaxHandleItems) {
+        painter->setPen(outlinePen);
+        painter->drawRect(selection->boundingRect());
+        painter->restore();
+        return;
+    }
+
+    // 控制点按像素大小绘制，裁剪时按当前缩放换算成场景距离
+    const QTransform deviceTransform = painter->transform();
+    const qreal scale = qMax<qreal>(qAbs(deviceTransform.m11()) + qAbs(deviceTransform.m21()), 1e-6);
+    const qreal margin = HandleSize / scale;
+    const QRectF cullRect = exposedSceneRect.adjusted(-margin, -margin, margin, margin);
+
+    QVector<QPointF> vertexHandles;   // 视口坐标
+    QVector<QPointF> rotationHandles; // 视口坐标
+    painter->setPen(outlinePen);
+    for (QGraphicsItem *item : selection->items()) {
+        if (!hasHandles(item)) {
+            const QRectF bounds = item->sceneBoundingRect();
+            if (bounds.intersects(cullRect)) {
+                painter->drawRect(bounds);
+            }
+            continue;
+        }
+        if (item->type() == EditablePolylineItem::Type) {
+            if (!item->sceneBoundingRect().intersects(cullRect)) {
+                continue;
+            }
+            // 通过线段索引只取可见范围内的顶点
+            const EditablePolylineItem *polyline = static_cast<const EditablePolylineItem*>(item);
+            const QTransform sceneTransform = item->sceneTransform();
+            const QRectF localCull = sceneTransform.inverted().mapRect(cullRect);
+            const QVector<QPointF> points = polyline->getPoints();
+            for (int vertex : polyline->verticesInRect(localCull)) {
+                const QPointF scenePos = sceneTransform.map(points[vertex]);
+                if (cullRect.contains(scenePos)) {
+                    vertexHandles.append(deviceTransform.map(scenePos));
+                }
+            }
+            continue;
+        }
+        forEachHandle(item, [&](HandleRole role, int, const QPointF &scenePos) {
+            if (cullRect.contains(scenePos)) {
+                (role == HandleRole::Rotation ? rotationHandles : vertexHandles).append(deviceTransform.map(scenePos));
+            }
+            return false;
+        });
+    }
+
+    painter->resetTransform();
+    const qreal radius = HandleSize / 2.0;
+    painter->setPen(QPen(Qt::gray, 0));
+    painter->setBrush(Qt::gray);
+    for (const QPointF &p : std::as_const(vertexHandles)) {
+        painter->drawEllipse(p, radius, radius);
+    }
+    painter->setPen(QPen(Qt::blue, 0));
+    painter->setBrush(Qt::blue);
+    for (const QPointF &p : std::as_const(rotationHandles)) {
+        painter->drawEllipse(p, radius, radius);
+    }
+    painter->restore();
+}
+
+bool SelectionOverlay::hitHandle(const QPointF &viewPos, qreal tolerancePx,
+                                 QGraphicsItem *&item, HandleRole &role, int &index) const
+{
+    if (!selection || selection->isEmpty() || selection->size() > MaxHandleItems) {
+        return false;
+    }
+    const QTransform viewportTransform = view->viewportTransform();
+    const qreal maxDist2 = tolerancePx * tolerancePx;
+    const QPointF scenePos = view->mapToScene(viewPos.toPoint());
+    const qreal sceneTolerance = tolerancePx / qMax<qreal>(qAbs(viewportTransform.m11()) + qAbs(viewportTransform.m21()), 1e-6);
+
+    for (QGraphicsItem *candidate : selection->items()) {
+        if (!hasHandles(candidate)) {
+            continue;
+        }
+        // 折线先按包围盒排除，再用线段索引查找最近顶点，避免逐个顶点比较
+        if (candidate->type() == EditablePolylineItem::Type) {
+            if (!candidate->sceneBoundingRect().adjusted(-sceneTolerance, -sceneTolerance, sceneTolerance, sceneTolerance).contains(scenePos)) {
+                continue;
+            }
+            const QTransform sceneTransform = candidate->sceneTransform();
+            const qreal itemScale = qMax<qreal>(qSqrt(qAbs(sceneTransform.determinant())), 1e-6);
+            const int vertex = static_cast<EditablePolylineItem*>(candidate)->nearestVertex(
+                sceneTransform.inverted().map(scenePos), sceneTolerance / itemScale);
+            if (vertex >= 0) {
+                item = candidate;
+                role = HandleRole::Vertex;
+                index = vertex;
+                return true;
+            }
+            continue;
+        }
+        const bool found = forEachHandle(candidate, [&](HandleRole handleRole, int handleIndex, const QPointF &handleScenePos) {
+            const QPointF d = viewportTransform.map(handleScenePos) - viewPos;
+            if (d.x() * d.x() + d.y() * d.y() <= maxDist2) {
+                role = handleRole;
+                index = handleIndex;
+                return true;
+            }
+            return false;
+        });
+        if (found) {
+            item = candidate;
+            return true;
+        }
+    }
+    return false;
+}
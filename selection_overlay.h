@@ -0,0 +1,43 @@
+#ifndef SELECTION_OVERLAY_H
+#define SELECTION_OVERLAY_H
+
+#include <QGraphicsView>
+#include <QGraphicsItem>
+#include <QPainter>
+#include <QPointF>
+#include <QRectF>
+
+class SelectionModel;
+
+// 控制点类型
+enum class HandleRole {
+    None,
+    Start,    // 线段起点
+    End,      // 线段终点
+    Rotation, // 线段旋转点
+    Vertex    // 折线顶点
+};
+
+// 选择覆盖层：在视图前景中绘制选中项的轮廓和控制点，并负责控制点的拾取。
+// 控制点不再是场景中的子图元，只为选中项计算，始终按屏幕像素大小绘制。
+class SelectionOverlay
+{
+public:
+    SelectionOverlay(QGraphicsView *view, const SelectionModel *selection);
+
+    // painter 处于场景坐标系（由 drawForeground 传入）
+    void paint(QPainter *painter, const QRectF &exposedSceneRect) const;
+
+    // 在视口坐标中拾取控制点，命中时返回所属项、类型和顶点索引
+    bool hitHandle(const QPointF &viewPos, qreal tolerancePx,
+                   QGraphicsItem *&item, HandleRole &role, int &index) const;
+
+    static constexpr qreal HandleSize = 4.0;     // 控制点直径（像素）
+    static constexpr int MaxHandleItems = 5000;  // 选中项过多时只绘制整体轮廓
+
+private:
+    QGraphicsView *view;
+    const SelectionModel *selection;
+};
+
+#endif // SELECTION_OVERLAY_H
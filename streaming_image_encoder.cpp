@@ -0,0 +1,364 @@
+#include "streaming_image_encoder.h"
+#include "logging_categories.h"
+#include <QFileInfo>
+#include <QByteArray>
+#include <QVector>
+#include <QDebug>
+#include <zlib.h>
+#include <cstring>
+
+namespace {
+
+void appendBigEndian32(QByteArray &data, quint32 value)
+{
+    data.append(char(value >> 24)).append(char(value >> 16)).append(char(value >> 8)).append(char(value));
+}
+
+void appendLittleEndian16(QByteArray &data, quint16 value)
+{
+    data.append(char(value)).append(char(value >> 8));
+}
+
+void appendLittleEndian32(QByteArray &data, quint32 value)
+{
+    data.append(char(value)).append(char(value >> 8)).append(char(value >> 16)).append(char(value >> 24));
+}
+
+// PNG：所有行组成一个 zlib 流，压缩输出每满一块就写成一个 IDAT 块
+class PngEncoder : public StreamingImageEncoder
+{
+public:
+    explicit PngEncoder(const QString &filePath) : StreamingImageEncoder(filePath) {}
+    ~PngEncoder() override
+    {
+        if (streamOpen) {
+            deflateEnd(&stream);
+        }
+    }
+
+    static constexpr int ChunkSize = 256 * 1024; // 单个 IDAT 块的数据长度
+
+protected:
+    bool writeHeader() override
+    {
+        static const char signature[8] = { '\x89', 'P', 'N', 'G', '\r', '\n', '\x1a', '\n' };
+        if (!writeBytes(signature, sizeof(signature))) {
+            return false;
+        }
+        QByteArray header;
+        appendBigEndian32(header, quint32(width));
+        appendBigEndian32(header, quint32(height));
+        header.append(char(8));                      // 每通道 8 位
+        header.append(char(channels == 4 ? 6 : 2));  // RGBA / RGB
+        header.append(3, char(0));                   // 压缩、过滤、交错方式
+        // 分辨率按每米像素数记录
+        const quint32 pixelsPerMetre = quint32(qRound(dpi / 0.0254));
+        QByteArray physical;
+        appendBigEndian32(physical, pixelsPerMetre);
+        appendBigEndian32(physical, pixelsPerMetre);
+        physical.append(char(1));
+        if (!writeChunk("IHDR", header.constData(), header.size())
+            || !writeChunk("pHYs", physical.constData(), physical.size())) {
+            return false;
+        }
+
+        std::memset(&stream, 0, sizeof(stream));
+        if (deflateInit(&stream, Z_DEFAULT_COMPRESSION) != Z_OK) {
+            error = tr("无法初始化压缩");
+            return false;
+        }
+        streamOpen = true;
+        filtered.resize(1 + qsizetype(width) * channels);
+        output.resize(ChunkSize);
+        return true;
+    }
+
+    bool writeRow(const uchar *row) override
+    {
+        // Sub 过滤：每个字节减去左侧像素同一通道的字节，图形中大片同色区域压缩后几乎为零
+        uchar *out = reinterpret_cast<uchar*>(filtered.data());
+        const qsizetype bytes = qsizetype(width) * channels;
+        out[0] = 1;
+        std::memcpy(out + 1, row, size_t(qMin<qsizetype>(channels, bytes)));
+        for (qsizetype i = channels; i < bytes; ++i) {
+            out[1 + i] = uchar(row[i] - row[i - channels]);
+        }
+        return compress(out, bytes + 1, Z_NO_FLUSH);
+    }
+
+    bool writeTrailer() override
+    {
+        if (!compress(nullptr, 0, Z_FINISH)) {
+            return false;
+        }
+        deflateEnd(&stream);
+        streamOpen = false;
+        return writeChunk("IEND", nullptr, 0);
+    }
+
+private:
+    bool compress(const uchar *data, qsizetype size, int flush)
+    {
+        stream.next_in = const_cast<Bytef*>(data);
+        stream.avail_in = uInt(size);
+        for (;;) {
+            stream.next_out = reinterpret_cast<Bytef*>(output.data()) + outputUsed;
+            stream.avail_out = uInt(output.size() - outputUsed);
+            const int result = deflate(&stream, flush);
+            if (result == Z_STREAM_ERROR) {
+                error = tr("压缩数据失败");
+                return false;
+            }
+            outputUsed = int(output.size() - stream.avail_out);
+            const bool done = flush == Z_FINISH ? result == Z_STREAM_END
+                                                : stream.avail_in == 0 && stream.avail_out > 0;
+            if (outputUsed == output.size() || (done && flush == Z_FINISH && outputUsed > 0)) {
+                if (!writeChunk("IDAT", output.constData(), outputUsed)) {
+                    return false;
+                }
+                outputUsed = 0;
+            }
+            if (done) {
+                return true;
+            }
+        }
+    }
+
+    bool writeChunk(const char type[4], const char *data, qsizetype size)
+    {
+        QByteArray length;
+        appendBigEndian32(length, quint32(size));
+        uLong crc = crc32(0L, reinterpret_cast<const Bytef*>(type), 4);
+        if (size > 0) {
+            crc = crc32(crc, reinterpret_cast<const Bytef*>(data), uInt(size));
+        }
+        QByteArray checksum;
+        appendBigEndian32(checksum, quint32(crc));
+        return writeBytes(length.constData(), 4) && writeBytes(type, 4)
+               && (size == 0 || writeBytes(data, size)) && writeBytes(checksum.constData(), 4);
+    }
+
+    z_stream stream;
+    bool streamOpen = false;
+    QByteArray filtered; // 过滤类型 + 一行过滤后的字节
+    QByteArray output;
+    int outputUsed = 0;
+};
+
+// TIFF（小端）：每 RowsPerStrip 行压缩成一个 Deflate 条带，条带表和目录写在文件末尾
+class TiffEncoder : public StreamingImageEncoder
+{
+public:
+    explicit TiffEncoder(const QString &filePath) : StreamingImageEncoder(filePath) {}
+
+    static constexpr int RowsPerStrip = 64;
+    static constexpr qint64 MaxOffset = 0xFFFFFFFFLL; // 经典 TIFF 的偏移为 32 位
+
+protected:
+    bool writeHeader() override
+    {
+        QByteArray header("II");
+        appendLittleEndian16(header, 42);
+        appendLittleEndian32(header, 0); // 目录偏移，写完条带后回填
+        rowBytes = qsizetype(width) * channels;
+        strip.reserve(rowBytes * RowsPerStrip);
+        return writeBytes(header.constData(), header.size());
+    }
+
+    bool writeRow(const uchar *row) override
+    {
+        strip.append(reinterpret_cast<const char*>(row), rowBytes);
+        if (++stripRows == RowsPerStrip) {
+            return flushStrip();
+        }
+        return true;
+    }
+
+    bool writeTrailer() override
+    {
+        if (stripRows > 0 && !flushStrip()) {
+            return false;
+        }
+        // 目录中放不下的数组先写出，记录它们的偏移
+        auto writeArray = [this](const QByteArray &data, quint32 &offset) {
+            if (file.pos() % 2 == 1 && !writeBytes("", 1)) {
+                return false;
+            }
+            offset = quint32(file.pos());
+            return writeBytes(data.constData(), data.size());
+        };
+        QByteArray bits;
+        for (int i = 0; i < channels; ++i) {
+            appendLittleEndian16(bits, 8);
+        }
+        QByteArray offsets;
+        QByteArray counts;
+        for (int i = 0; i < stripOffsets.size(); ++i) {
+            appendLittleEndian32(offsets, stripOffsets.at(i));
+            appendLittleEndian32(counts, stripCounts.at(i));
+        }
+        QByteArray resolution;
+        appendLittleEndian32(resolution, quint32(qRound(dpi * 100)));
+        appendLittleEndian32(resolution, 100);
+        quint32 bitsOffset = 0;
+        quint32 offsetsOffset = stripOffsets.value(0);
+        quint32 countsOffset = stripCounts.value(0);
+        quint32 resolutionOffset = 0;
+        if (!writeArray(bits, bitsOffset) || !writeArray(resolution, resolutionOffset)) {
+            return false;
+        }
+        if (stripOffsets.size() > 1 && (!writeArray(offsets, offsetsOffset) || !writeArray(counts, countsOffset))) {
+            return false;
+        }
+
+        // 目录项：标签、类型（3 SHORT / 4 LONG / 5 RATIONAL）、个数、值或偏移，按标签升序
+        QByteArray directory;
+        int entryCount = 0;
+        auto entry = [&directory, &entryCount](quint16 tag, quint16 type, quint32 count, quint32 value) {
+            appendLittleEndian16(directory, tag);
+            appendLittleEndian16(directory, type);
+            appendLittleEndian32(directory, count);
+            appendLittleEndian32(directory, value);
+            ++entryCount;
+        };
+        entry(256, 4, 1, quint32(width));
+        entry(257, 4, 1, quint32(height));
+        entry(258, 3, quint32(channels), bitsOffset);
+        entry(259, 3, 1, 8);  // Deflate
+        entry(262, 3, 1, 2);  // RGB
+        entry(273, 4, quint32(stripOffsets.size()), offsetsOffset);
+        entry(277, 3, 1, quint32(channels));
+        entry(278, 4, 1, RowsPerStrip);
+        entry(279, 4, quint32(stripCounts.size()), countsOffset);
+        entry(282, 5, 1, resolutionOffset);
+        entry(283, 5, 1, resolutionOffset);
+        entry(284, 3, 1, 1);  // 交错存储
+        entry(296, 3, 1, 2);  // 英寸
+        if (channels == 4) {
+            entry(338, 3, 1, 2); // 非预乘 alpha
+        }
+        QByteArray ifd;
+        appendLittleEndian16(ifd, quint16(entryCount));
+        ifd.append(directory);
+        appendLittleEndian32(ifd, 0);
+
+        quint32 ifdOffset = 0;
+        if (!writeArray(ifd, ifdOffset)) {
+            return false;
+        }
+        if (file.pos() > MaxOffset) {
+            error = tr("TIFF 文件超过 4 GB，请改用 PNG 格式");
+            return false;
+        }
+        QByteArray pointer;
+        appendLittleEndian32(pointer, ifdOffset);
+        return file.seek(4) && writeBytes(pointer.constData(), pointer.size());
+    }
+
+private:
+    bool flushStrip()
+    {
+        uLongf size = compressBound(uLong(strip.size()));
+        compressed.resize(qsizetype(size));
+        if (compress2(reinterpret_cast<Bytef*>(compressed.data()), &size,
+                      reinterpret_cast<const Bytef*>(strip.constData()), uLong(strip.size()), Z_DEFAULT_COMPRESSION) != Z_OK) {
+            error = tr("压缩数据失败");
+            return false;
+        }
+        if (file.pos() + qint64(size) > MaxOffset) {
+            error = tr("TIFF 文件超过 4 GB，请改用 PNG 格式");
+            return false;
+        }
+        stripOffsets.append(quint32(file.pos()));
+        stripCounts.append(quint32(size));
+        strip.clear();
+        stripRows = 0;
+        return writeBytes(compressed.constData(), qint64(size));
+    }
+
+    qsizetype rowBytes = 0;
+    QByteArray strip; // 当前条带的原始行
+    int stripRows = 0;
+    QByteArray compressed;
+    QVector<quint32> stripOffsets;
+    QVector<quint32> stripCounts;
+};
+
+} // namespace
+
+StreamingImageEncoder::StreamingImageEncoder(const QString &filePath)
+    : file(filePath)
+{
+}
+
+std::unique_ptr<StreamingImageEncoder> StreamingImageEncoder::create(const QString &filePath)
+{
+    const QString suffix = QFileInfo(filePath).suffix().toLower();
+    if (suffix == QLatin1String("png")) {
+        return std::make_unique<PngEncoder>(filePath);
+    }
+    if (suffix == QLatin1String("tif") || suffix == QLatin1String("tiff")) {
+        return std::make_unique<TiffEncoder>(filePath);
+    }
+    return nullptr;
+}
+
+bool StreamingImageEncoder::begin(int width, int height, bool alpha, qreal dpi)
+{
+    if (width <= 0 || height <= 0) {
+        error = tr("图片尺寸无效");
+        return false;
+    }
+    this->width = width;
+    this->height = height;
+    this->channels = alpha ? 4 : 3;
+    this->dpi = dpi;
+    rowsWritten = 0;
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        error = tr("无法写入文件：%1").arg(file.errorString());
+        return false;
+    }
+    return writeHeader();
+}
+
+bool StreamingImageEncoder::writeRows(const QImage &rows)
+{
+    if (rows.width() != width || rows.format() != rowFormat(channels == 4)) {
+        error = tr("行数据格式与图片不一致");
+        return false;
+    }
+    for (int y = 0; y < rows.height(); ++y) {
+        if (rowsWritten >= height) {
+            error = tr("写入的行数超过图片高度");
+            return false;
+        }
+        if (!writeRow(rows.constScanLine(y))) {
+            return false;
+        }
+        ++rowsWritten;
+    }
+    return true;
+}
+
+bool StreamingImageEncoder::finish()
+{
+    if (rowsWritten != height) {
+        error = tr("图片数据不完整（%1/%2 行）").arg(rowsWritten).arg(height);
+        return false;
+    }
+    if (!writeTrailer()) {
+        return false;
+    }
+    file.close();
+    qCDebug(lcIo) << "Streamed image written:" << file.fileName() << width << "x" << height;
+    return true;
+}
+
+bool StreamingImageEncoder::writeBytes(const char *data, qint64 size)
+{
+    if (file.write(data, size) != size) {
+        error = tr("写入文件失败：%1").arg(file.errorString());
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,47 @@
+#ifndef STREAMING_IMAGE_ENCODER_H
+#define STREAMING_IMAGE_ENCODER_H
+
+#include <QCoreApplication>
+#include <QFile>
+#include <QImage>
+#include <QString>
+#include <memory>
+
+// 逐行写出的图片编码器：按从上到下的顺序接收若干行像素，边压缩边写入文件，
+// 内存占用只与一行（TIFF 为一个条带）有关，与图片总大小无关。支持 PNG 和 TIFF（Deflate 压缩）。
+class StreamingImageEncoder
+{
+    Q_DECLARE_TR_FUNCTIONS(StreamingImageEncoder)
+public:
+    virtual ~StreamingImageEncoder() = default;
+
+    // 按文件后缀创建编码器（.png / .tif / .tiff），不支持的后缀返回空
+    static std::unique_ptr<StreamingImageEncoder> create(const QString &filePath);
+
+    bool begin(int width, int height, bool alpha, qreal dpi);
+    // rows 为 Format_RGBA8888（alpha）或 Format_RGB888，宽度与 begin 一致
+    bool writeRows(const QImage &rows);
+    bool finish(); // 写完全部行后调用，写出文件尾并关闭文件
+    QString errorString() const { return error; }
+
+    // 输入行的像素格式
+    static QImage::Format rowFormat(bool alpha) { return alpha ? QImage::Format_RGBA8888 : QImage::Format_RGB888; }
+
+protected:
+    explicit StreamingImageEncoder(const QString &filePath);
+
+    virtual bool writeHeader() = 0;
+    virtual bool writeRow(const uchar *row) = 0; // 一行 width * channels 字节
+    virtual bool writeTrailer() = 0;
+    bool writeBytes(const char *data, qint64 size);
+
+    QFile file;
+    int width = 0;
+    int height = 0;
+    int channels = 3;
+    qreal dpi = 96.0;
+    int rowsWritten = 0;
+    QString error;
+};
+
+#endif // STREAMING_IMAGE_ENCODER_H
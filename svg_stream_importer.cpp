@@ -0,0 +1,1140 @@
+#include "svg_stream_importer.h"
+#include "editable_line_item.h"
+#include "editable_polyline_item.h"
+#include "custom_rect_item.h"
+#include "scene_transaction.h"
+#include "scene_item_events.h"
+#include "logging_categories.h"
+#include <QGraphicsEllipseItem>
+#include <QGraphicsPathItem>
+#include <QGraphicsPolygonItem>
+#include <QGraphicsTextItem>
+#include <QTextDocument>
+#include <QFontMetricsF>
+#include <QXmlStreamReader>
+#include <QElapsedTimer>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QWaitCondition>
+#include <QQueue>
+#include <QFile>
+#include <QLocale>
+#include <QHash>
+#include <QRegularExpression>
+#include <QtConcurrent>
+#include <QtMath>
+#include <QDebug>
+#include <atomic>
+#include <functional>
+#include <cmath>
+
+// 解析线程与 GUI 线程共享的批次队列；由双方共同持有，任何一方先退出都不影响另一方
+struct SvgStreamImporter::Channel {
+    QMutex mutex;
+    QWaitCondition notFull;
+    QQueue<Batch> batches;
+    bool canceled = false;
+    std::atomic<int> progress{0};
+    std::atomic<int> skipped{0};
+};
+
+namespace {
+
+// 数字、标志和命令字母的扫描器，分隔符为空白和逗号
+class Scanner
+{
+public:
+    explicit Scanner(QStringView text) : text(text) {}
+
+    bool atEnd()
+    {
+        skipSeparators();
+        return pos >= text.size();
+    }
+    QChar peek()
+    {
+        skipSeparators();
+        return pos < text.size() ? text.at(pos) : QChar();
+    }
+    void advance() { ++pos; }
+
+    bool number(qreal &value)
+    {
+        skipSeparators();
+        const qsizetype start = pos;
+        if (pos < text.size() && (text.at(pos) == QLatin1Char('+') || text.at(pos) == QLatin1Char('-'))) {
+            ++pos;
+        }
+        bool digits = false;
+        while (pos < text.size() && text.at(pos).isDigit()) {
+            ++pos;
+            digits = true;
+        }
+        if (pos < text.size() && text.at(pos) == QLatin1Char('.')) {
+            ++pos;
+            while (pos < text.size() && text.at(pos).isDigit()) {
+                ++pos;
+                digits = true;
+            }
+        }
+        if (!digits) {
+            pos = start;
+            return false;
+        }
+        // 指数部分必须带数字，否则 "e" 可能是后面的单位
+        if (pos < text.size() && (text.at(pos) == QLatin1Char('e') || text.at(pos) == QLatin1Char('E'))) {
+            qsizetype exponent = pos + 1;
+            if (exponent < text.size() && (text.at(exponent) == QLatin1Char('+') || text.at(exponent) == QLatin1Char('-'))) {
+                ++exponent;
+            }
+            if (exponent < text.size() && text.at(exponent).isDigit()) {
+                pos = exponent;
+                while (pos < text.size() && text.at(pos).isDigit()) {
+                    ++pos;
+                }
+            }
+        }
+        bool ok = false;
+        value = QLocale::c().toDouble(text.mid(start, pos - start), &ok);
+        return ok;
+    }
+
+    // 圆弧标志可以不带分隔符紧挨着写，如 "a1 1 0 00 1 1"
+    bool flag(bool &value)
+    {
+        skipSeparators();
+        if (pos < text.size() && (text.at(pos) == QLatin1Char('0') || text.at(pos) == QLatin1Char('1'))) {
+            value = text.at(pos++) == QLatin1Char('1');
+            return true;
+        }
+        return false;
+    }
+
+    bool point(QPointF &value)
+    {
+        qreal x = 0;
+        qreal y = 0;
+        if (!number(x) || !number(y)) {
+            return false;
+        }
+        value = QPointF(x, y);
+        return true;
+    }
+
+    QStringView rest() const { return text.mid(pos); }
+
+private:
+    void skipSeparators()
+    {
+        while (pos < text.size() && (text.at(pos).isSpace() || text.at(pos) == QLatin1Char(','))) {
+            ++pos;
+        }
+    }
+
+    QStringView text;
+    qsizetype pos = 0;
+};
+
+QVector<qreal> parseNumbers(QStringView text)
+{
+    QVector<qreal> numbers;
+    Scanner scanner(text);
+    qreal value = 0;
+    while (scanner.number(value)) {
+        numbers.append(value);
+    }
+    return numbers;
+}
+
+// 长度转换为像素（96 DPI），百分比等无法确定的单位返回 fallback
+qreal parseLength(QStringView text, qreal fallback)
+{
+    Scanner scanner(text);
+    qreal value = 0;
+    if (!scanner.number(value)) {
+        return fallback;
+    }
+    const QStringView unit = scanner.rest().trimmed();
+    if (unit.isEmpty() || unit == QLatin1String("px")) {
+        return value;
+    }
+    if (unit == QLatin1String("pt")) {
+        return value * 96.0 / 72.0;
+    }
+    if (unit == QLatin1String("pc")) {
+        return value * 16.0;
+    }
+    if (unit == QLatin1String("mm")) {
+        return value * 96.0 / 25.4;
+    }
+    if (unit == QLatin1String("cm")) {
+        return value * 96.0 / 2.54;
+    }
+    if (unit == QLatin1String("in")) {
+        return value * 96.0;
+    }
+    if (unit == QLatin1String("em")) {
+        return value * 16.0;
+    }
+    return fallback;
+}
+
+// SVG 的变换列表，"A B" 表示先应用 B 再应用 A
+QTransform parseTransform(QStringView text)
+{
+    QTransform result;
+    qsizetype pos = 0;
+    while (pos < text.size()) {
+        const qsizetype open = text.indexOf(QLatin1Char('('), pos);
+        const qsizetype close = open < 0 ? -1 : text.indexOf(QLatin1Char(')'), open);
+        if (close < 0) {
+            break;
+        }
+        QStringView function = text.mid(pos, open - pos).trimmed();
+        while (function.startsWith(QLatin1Char(','))) {
+            function = function.mid(1).trimmed(); // 变换之间可以用逗号分隔
+        }
+        const QVector<qreal> v = parseNumbers(text.mid(open + 1, close - open - 1));
+        QTransform transform;
+        if (function == QLatin1String("matrix") && v.size() == 6) {
+            transform = QTransform(v[0], v[1], v[2], v[3], v[4], v[5]);
+        } else if (function == QLatin1String("translate") && !v.isEmpty()) {
+            transform.translate(v[0], v.size() > 1 ? v[1] : 0.0);
+        } else if (function == QLatin1String("scale") && !v.isEmpty()) {
+            transform.scale(v[0], v.size() > 1 ? v[1] : v[0]);
+        } else if (function == QLatin1String("rotate") && !v.isEmpty()) {
+            if (v.size() >= 3) {
+                transform.translate(v[1], v[2]);
+                transform.rotate(v[0]);
+                transform.translate(-v[1], -v[2]);
+            } else {
+                transform.rotate(v[0]);
+            }
+        } else if (function == QLatin1String("skewX") && !v.isEmpty()) {
+            transform.shear(std::tan(qDegreesToRadians(v[0])), 0);
+        } else if (function == QLatin1String("skewY") && !v.isEmpty()) {
+            transform.shear(0, std::tan(qDegreesToRadians(v[0])));
+        }
+        result = transform * result;
+        pos = close + 1;
+    }
+    return result;
+}
+
+// 颜色；"none" 和无法识别的颜色（如渐变引用）返回无效颜色，表示不绘制
+QColor parseColor(QStringView text, const QColor &currentColor)
+{
+    const QStringView value = text.trimmed();
+    if (value.isEmpty() || value == QLatin1String("none")) {
+        return QColor();
+    }
+    if (value == QLatin1String("currentColor")) {
+        return currentColor;
+    }
+    if (value.startsWith(QLatin1String("rgb("))) {
+        const qsizetype close = value.indexOf(QLatin1Char(')'));
+        const QString body = value.mid(4, close < 0 ? -1 : close - 4).toString();
+        const QVector<qreal> v = parseNumbers(QString(body).remove(QLatin1Char('%')));
+        if (v.size() < 3) {
+            return QColor();
+        }
+        const qreal scale = body.contains(QLatin1Char('%')) ? 2.55 : 1.0;
+        return QColor(qBound(0, qRound(v[0] * scale), 255), qBound(0, qRound(v[1] * scale), 255),
+                      qBound(0, qRound(v[2] * scale), 255));
+    }
+    return QColor(value.toString());
+}
+
+// 继承的样式；变换已累积到场景坐标
+struct Style {
+    QTransform transform;
+    QColor color = Qt::black;  // currentColor
+    QColor stroke;             // 默认不描边
+    qreal strokeWidth = 1.0;
+    QVector<qreal> dashes;
+    Qt::PenCapStyle cap = Qt::FlatCap;
+    Qt::PenJoinStyle join = Qt::MiterJoin;
+    qreal strokeOpacity = 1.0;
+    bool nonScalingStroke = false; // vector-effect:non-scaling-stroke，导入为装饰性画笔
+    QColor fill = Qt::black;   // 默认黑色填充
+    qreal fillOpacity = 1.0;
+    qreal opacity = 1.0;       // 组透明度近似为逐个图形相乘
+    QString fontFamily;
+    qreal fontSize = 16.0;
+    bool bold = false;
+    bool italic = false;
+    bool visible = true;
+    Qt::FillRule fillRule = Qt::WindingFill; // SVG 默认 nonzero
+    bool inDefs = false;       // 位于 <defs> 中，图形不直接输出
+    QString definition;        // 正在定义的 symbol（或 defs 子元素）的 id，图形存入定义表
+};
+
+void applyProperty(Style &style, QStringView name, QStringView value)
+{
+    value = value.trimmed();
+    if (name == QLatin1String("stroke")) {
+        style.stroke = parseColor(value, style.color);
+    } else if (name == QLatin1String("stroke-width")) {
+        style.strokeWidth = parseLength(value, style.strokeWidth);
+    } else if (name == QLatin1String("stroke-dasharray")) {
+        style.dashes = value == QLatin1String("none") ? QVector<qreal>() : parseNumbers(value);
+    } else if (name == QLatin1String("stroke-linecap")) {
+        style.cap = value == QLatin1String("round") ? Qt::RoundCap
+                    : value == QLatin1String("square") ? Qt::SquareCap : Qt::FlatCap;
+    } else if (name == QLatin1String("stroke-linejoin")) {
+        style.join = value == QLatin1String("round") ? Qt::RoundJoin
+                     : value == QLatin1String("bevel") ? Qt::BevelJoin : Qt::MiterJoin;
+    } else if (name == QLatin1String("stroke-opacity")) {
+        style.strokeOpacity = parseLength(value, 1.0);
+    } else if (name == QLatin1String("fill")) {
+        style.fill = parseColor(value, style.color);
+    } else if (name == QLatin1String("fill-opacity")) {
+        style.fillOpacity = parseLength(value, 1.0);
+    } else if (name == QLatin1String("opacity")) {
+        style.opacity *= parseLength(value, 1.0);
+    } else if (name == QLatin1String("color")) {
+        const QColor color = parseColor(value, style.color);
+        if (color.isValid()) {
+            style.color = color;
+        }
+    } else if (name == QLatin1String("font-family")) {
+        style.fontFamily = value.toString().remove(QLatin1Char('\'')).remove(QLatin1Char('"')).section(QLatin1Char(','), 0, 0).trimmed();
+    } else if (name == QLatin1String("font-size")) {
+        style.fontSize = parseLength(value, style.fontSize);
+    } else if (name == QLatin1String("font-weight")) {
+        style.bold = value == QLatin1String("bold") || value == QLatin1String("bolder") || parseLength(value, 400) >= 600;
+    } else if (name == QLatin1String("font-style")) {
+        style.italic = value == QLatin1String("italic") || value == QLatin1String("oblique");
+    } else if (name == QLatin1String("display")) {
+        style.visible = value != QLatin1String("none");
+    } else if (name == QLatin1String("vector-effect")) {
+        style.nonScalingStroke = value == QLatin1String("non-scaling-stroke");
+    } else if (name == QLatin1String("fill-rule")) {
+        style.fillRule = value == QLatin1String("evenodd") ? Qt::OddEvenFill : Qt::WindingFill;
+    }
+}
+
+// "name:value;..." 形式的声明列表
+void applyDeclarations(Style &style, QStringView declarations)
+{
+    qsizetype pos = 0;
+    while (pos < declarations.size()) {
+        qsizetype end = declarations.indexOf(QLatin1Char(';'), pos);
+        if (end < 0) {
+            end = declarations.size();
+        }
+        const QStringView declaration = declarations.mid(pos, end - pos);
+        const qsizetype colon = declaration.indexOf(QLatin1Char(':'));
+        if (colon > 0) {
+            applyProperty(style, declaration.left(colon).trimmed(), declaration.mid(colon + 1));
+        }
+        pos = end + 1;
+    }
+}
+
+// 表现属性先应用，其次是样式表中 class 选择器的声明，style 属性中的声明最后覆盖
+void applyAttributes(Style &style, const QXmlStreamAttributes &attributes, const QHash<QString, QString> &classRules)
+{
+    for (const QXmlStreamAttribute &attribute : attributes) {
+        if (attribute.namespaceUri().isEmpty() && attribute.name() != QLatin1String("style")
+            && attribute.name() != QLatin1String("class")) {
+            applyProperty(style, attribute.name(), attribute.value());
+        }
+    }
+    if (!classRules.isEmpty()) {
+        const QList<QStringView> names = attributes.value(QLatin1String("class")).split(QLatin1Char(' '), Qt::SkipEmptyParts);
+        for (QStringView name : names) {
+            applyDeclarations(style, classRules.value(name.toString()));
+        }
+    }
+    applyDeclarations(style, attributes.value(QLatin1String("style")));
+}
+
+// 样式表只支持单个类选择器（如 ".a, .b { ... }"），其余规则忽略
+void parseStyleSheet(QString css, QHash<QString, QString> &classRules)
+{
+    static const QRegularExpression comments(QStringLiteral("/\\*.*?\\*/"), QRegularExpression::DotMatchesEverythingOption);
+    css.remove(comments);
+    qsizetype pos = 0;
+    while (pos < css.size()) {
+        const qsizetype open = css.indexOf(QLatin1Char('{'), pos);
+        const qsizetype close = open < 0 ? -1 : css.indexOf(QLatin1Char('}'), open);
+        if (close < 0) {
+            break;
+        }
+        const QString body = css.mid(open + 1, close - open - 1);
+        const QStringList selectors = css.mid(pos, open - pos).split(QLatin1Char(','));
+        for (const QString &selector : selectors) {
+            const QString name = selector.trimmed();
+            static const QRegularExpression simpleClass(QStringLiteral("^\\.[-\\w]+$"));
+            if (simpleClass.match(name).hasMatch()) {
+                classRules[name.mid(1)] += body + QLatin1Char(';');
+            }
+        }
+        pos = close + 1;
+    }
+}
+
+// 画笔宽度随变换缩放（非均匀缩放取几何平均）
+QPen penFor(const Style &style)
+{
+    if (!style.stroke.isValid() || style.strokeWidth <= 0) {
+        return Qt::NoPen;
+    }
+    QColor color = style.stroke;
+    color.setAlphaF(qBound<qreal>(0.0, color.alphaF() * style.strokeOpacity * style.opacity, 1.0));
+    const qreal scale = style.nonScalingStroke ? 1.0 : std::sqrt(std::abs(style.transform.determinant()));
+    QPen pen(color, style.strokeWidth * (scale > 0 ? scale : 1.0), Qt::SolidLine, style.cap, style.join);
+    pen.setCosmetic(style.nonScalingStroke);
+    // 虚线长度以线宽为单位
+    QVector<qreal> pattern;
+    for (qreal dash : style.dashes) {
+        pattern.append(qMax<qreal>(dash, 0.0) / style.strokeWidth);
+    }
+    if (pattern.size() % 2 == 1) {
+        pattern += pattern; // 奇数个值按 SVG 规定重复一次
+    }
+    if (!pattern.isEmpty()) {
+        pen.setDashPattern(pattern);
+    }
+    return pen;
+}
+
+QBrush brushFor(const Style &style)
+{
+    if (!style.fill.isValid()) {
+        return Qt::NoBrush;
+    }
+    QColor color = style.fill;
+    color.setAlphaF(qBound<qreal>(0.0, color.alphaF() * style.fillOpacity * style.opacity, 1.0));
+    return QBrush(color);
+}
+
+// 把定义表中的图形放到 <use> 的位置
+SvgStreamImporter::Primitive transformed(const SvgStreamImporter::Primitive &primitive, const QTransform &transform)
+{
+    using Primitive = SvgStreamImporter::Primitive;
+    Primitive result = primitive;
+    const qreal scale = std::sqrt(std::abs(transform.determinant()));
+    if (result.pen.style() != Qt::NoPen && !result.pen.isCosmetic() && scale > 0) {
+        result.pen.setWidthF(result.pen.widthF() * scale);
+    }
+    switch (primitive.kind) {
+    case Primitive::Line:
+    case Primitive::Polyline:
+    case Primitive::Polygon:
+        result.points = transform.map(primitive.points);
+        break;
+    case Primitive::Rect:
+    case Primitive::Ellipse:
+        if (transform.type() <= QTransform::TxScale) {
+            result.rect = transform.mapRect(primitive.rect);
+        } else {
+            QPainterPath path;
+            if (primitive.kind == Primitive::Rect) {
+                path.addRect(primitive.rect);
+            } else {
+                path.addEllipse(primitive.rect);
+            }
+            result.kind = Primitive::Path;
+            result.path = transform.map(path);
+        }
+        break;
+    case Primitive::Path:
+        result.path = transform.map(primitive.path);
+        break;
+    case Primitive::Text:
+        result.transform = primitive.transform * transform;
+        break;
+    }
+    return result;
+}
+
+// SVG 端点参数化的椭圆弧转换为三次贝塞尔曲线（每段不超过 90 度）
+void arcTo(QPainterPath &path, const QPointF &from, qreal rx, qreal ry, qreal angle,
+           bool largeArc, bool sweep, const QPointF &to)
+{
+    if (from == to) {
+        return;
+    }
+    rx = std::abs(rx);
+    ry = std::abs(ry);
+    if (rx == 0 || ry == 0) {
+        path.lineTo(to);
+        return;
+    }
+    const qreal phi = qDegreesToRadians(angle);
+    const qreal cosPhi = std::cos(phi);
+    const qreal sinPhi = std::sin(phi);
+    const qreal dx = (from.x() - to.x()) / 2;
+    const qreal dy = (from.y() - to.y()) / 2;
+    const qreal x1 = cosPhi * dx + sinPhi * dy;
+    const qreal y1 = -sinPhi * dx + cosPhi * dy;
+    // 半径不足以连接两端点时等比放大
+    const qreal lambda = (x1 * x1) / (rx * rx) + (y1 * y1) / (ry * ry);
+    if (lambda > 1) {
+        rx *= std::sqrt(lambda);
+        ry *= std::sqrt(lambda);
+    }
+    const qreal numerator = rx * rx * ry * ry - rx * rx * y1 * y1 - ry * ry * x1 * x1;
+    const qreal denominator = rx * rx * y1 * y1 + ry * ry * x1 * x1;
+    const qreal coefficient = (largeArc == sweep ? -1.0 : 1.0)
+                              * std::sqrt(qMax<qreal>(0.0, denominator > 0 ? numerator / denominator : 0.0));
+    const qreal cxp = coefficient * rx * y1 / ry;
+    const qreal cyp = -coefficient * ry * x1 / rx;
+    const qreal cx = cosPhi * cxp - sinPhi * cyp + (from.x() + to.x()) / 2;
+    const qreal cy = sinPhi * cxp + cosPhi * cyp + (from.y() + to.y()) / 2;
+    const qreal theta = std::atan2((y1 - cyp) / ry, (x1 - cxp) / rx);
+    qreal delta = std::atan2((-y1 - cyp) / ry, (-x1 - cxp) / rx) - theta;
+    if (!sweep && delta > 0) {
+        delta -= 2 * M_PI;
+    } else if (sweep && delta < 0) {
+        delta += 2 * M_PI;
+    }
+
+    const int segments = qMax(1, qCeil(std::abs(delta) / (M_PI / 2) - 1e-9));
+    const qreal step = delta / segments;
+    const qreal kappa = 4.0 / 3.0 * std::tan(step / 4);
+    auto pointAt = [&](qreal t) {
+        return QPointF(cx + rx * std::cos(t) * cosPhi - ry * std::sin(t) * sinPhi,
+                       cy + rx * std::cos(t) * sinPhi + ry * std::sin(t) * cosPhi);
+    };
+    auto tangentAt = [&](qreal t) {
+        return QPointF(-rx * std::sin(t) * cosPhi - ry * std::cos(t) * sinPhi,
+                       -rx * std::sin(t) * sinPhi + ry * std::cos(t) * cosPhi);
+    };
+    for (int i = 0; i < segments; ++i) {
+        const qreal t1 = theta + i * step;
+        const qreal t2 = t1 + step;
+        const QPointF end = i + 1 == segments ? to : pointAt(t2);
+        path.cubicTo(pointAt(t1) + kappa * tangentAt(t1), pointAt(t2) - kappa * tangentAt(t2), end);
+    }
+}
+
+// 路径数据；遇到格式错误时保留已解析的部分（与 SVG 规范一致）
+QPainterPath parsePathData(QStringView data)
+{
+    QPainterPath path;
+    Scanner scanner(data);
+    QPointF current;
+    QPointF subpathStart;
+    QPointF lastControl;
+    QChar command;
+    QChar previous;
+    while (!scanner.atEnd()) {
+        const QChar next = scanner.peek();
+        if (next.isLetter()) {
+            command = next;
+            scanner.advance();
+        } else if (command.isNull() || command.toUpper() == QLatin1Char('Z')) {
+            break;
+        }
+        const bool relative = command.isLower();
+        const QPointF base = relative ? current : QPointF();
+        const QChar upper = command.toUpper();
+        bool ok = true;
+        if (upper == QLatin1Char('M')) {
+            QPointF p;
+            ok = scanner.point(p);
+            if (ok) {
+                current = base + p;
+                subpathStart = current;
+                path.moveTo(current);
+                command = relative ? QLatin1Char('l') : QLatin1Char('L'); // 后续坐标对按直线处理
+            }
+        } else if (upper == QLatin1Char('L')) {
+            QPointF p;
+            ok = scanner.point(p);
+            if (ok) {
+                current = base + p;
+                path.lineTo(current);
+            }
+        } else if (upper == QLatin1Char('H')) {
+            qreal x = 0;
+            ok = scanner.number(x);
+            if (ok) {
+                current.setX((relative ? current.x() : 0.0) + x);
+                path.lineTo(current);
+            }
+        } else if (upper == QLatin1Char('V')) {
+            qreal y = 0;
+            ok = scanner.number(y);
+            if (ok) {
+                current.setY((relative ? current.y() : 0.0) + y);
+                path.lineTo(current);
+            }
+        } else if (upper == QLatin1Char('C')) {
+            QPointF c1, c2, p;
+            ok = scanner.point(c1) && scanner.point(c2) && scanner.point(p);
+            if (ok) {
+                lastControl = base + c2;
+                current = base + p;
+                path.cubicTo(base + c1, lastControl, current);
+            }
+        } else if (upper == QLatin1Char('S')) {
+            QPointF c2, p;
+            ok = scanner.point(c2) && scanner.point(p);
+            if (ok) {
+                const QPointF c1 = previous == QLatin1Char('C') || previous == QLatin1Char('S')
+                                       ? 2 * current - lastControl : current;
+                lastControl = base + c2;
+                current = base + p;
+                path.cubicTo(c1, lastControl, current);
+            }
+        } else if (upper == QLatin1Char('Q')) {
+            QPointF c, p;
+            ok = scanner.point(c) && scanner.point(p);
+            if (ok) {
+                lastControl = base + c;
+                current = base + p;
+                path.quadTo(lastControl, current);
+            }
+        } else if (upper == QLatin1Char('T')) {
+            QPointF p;
+            ok = scanner.point(p);
+            if (ok) {
+                lastControl = previous == QLatin1Char('Q') || previous == QLatin1Char('T')
+                                  ? 2 * current - lastControl : current;
+                current = base + p;
+                path.quadTo(lastControl, current);
+            }
+        } else if (upper == QLatin1Char('A')) {
+            qreal rx = 0, ry = 0, angle = 0;
+            bool largeArc = false, sweep = false;
+            QPointF p;
+            ok = scanner.number(rx) && scanner.number(ry) && scanner.number(angle)
+                 && scanner.flag(largeArc) && scanner.flag(sweep) && scanner.point(p);
+            if (ok) {
+                arcTo(path, current, rx, ry, angle, largeArc, sweep, base + p);
+                current = base + p;
+            }
+        } else if (upper == QLatin1Char('Z')) {
+            path.closeSubpath();
+            current = subpathStart;
+        } else {
+            ok = false;
+        }
+        if (!ok) {
+            break;
+        }
+        previous = upper;
+    }
+    return path;
+}
+
+QPolygonF parsePoints(QStringView text)
+{
+    const QVector<qreal> v = parseNumbers(text);
+    QPolygonF points;
+    points.reserve(v.size() / 2);
+    for (int i = 0; i + 1 < v.size(); i += 2) {
+        points.append(QPointF(v[i], v[i + 1]));
+    }
+    return points;
+}
+
+qreal attributeLength(const QXmlStreamAttributes &attributes, QLatin1String name, qreal fallback = 0.0)
+{
+    return attributes.hasAttribute(name) ? parseLength(attributes.value(name), fallback) : fallback;
+}
+
+bool isAxisAligned(const QTransform &transform)
+{
+    return transform.type() <= QTransform::TxScale;
+}
+
+// 解析器：逐个元素产生基本图形，凑满一批交给 flush
+class SvgParser
+{
+public:
+    SvgParser(const std::function<bool(SvgStreamImporter::Batch &)> &flush, std::atomic<int> &skipped)
+        : flush(flush), skipped(skipped)
+    {
+    }
+
+    QString parse(QFile &file, std::atomic<int> &progress)
+    {
+        QXmlStreamReader reader(&file);
+        const qint64 fileSize = qMax<qint64>(1, file.size());
+        QVector<Style> stack;
+        stack.append(Style());
+        while (!reader.atEnd()) {
+            const QXmlStreamReader::TokenType token = reader.readNext();
+            if (token == QXmlStreamReader::EndElement) {
+                if (stack.size() > 1) {
+                    stack.removeLast();
+                }
+                continue;
+            }
+            if (token != QXmlStreamReader::StartElement) {
+                continue;
+            }
+            progress = int(file.pos() * 100 / fileSize);
+
+            const QStringView name = reader.name();
+            const QXmlStreamAttributes attributes = reader.attributes();
+            if (name == QLatin1String("style")) {
+                parseStyleSheet(reader.readElementText(), classRules);
+                continue;
+            }
+            if (isSkippedContainer(name)) {
+                reader.skipCurrentElement();
+                continue;
+            }
+            Style style = stack.last();
+            // symbol 和 defs 中带 id 的元素存入定义表，使用自己的坐标系，由 <use> 放置
+            const QStringView id = attributes.value(QLatin1String("id"));
+            if (!id.isEmpty() && style.definition.isEmpty() && (style.inDefs || name == QLatin1String("symbol"))) {
+                style = Style();
+                style.definition = id.toString();
+            }
+            if (name == QLatin1String("defs")) {
+                style.inDefs = true;
+            }
+            style.transform = parseTransform(attributes.value(QLatin1String("transform"))) * style.transform;
+            if (name == QLatin1String("svg") && stack.size() == 1) {
+                style.transform = rootTransform(attributes) * style.transform;
+            }
+            applyAttributes(style, attributes, classRules);
+            if (!style.visible) {
+                reader.skipCurrentElement();
+                continue;
+            }
+            if (name == QLatin1String("text")) {
+                // 文字内容包括其中的 tspan，读取后当前元素已结束
+                const QString text = reader.readElementText(QXmlStreamReader::IncludeChildElements).simplified();
+                if (!text.isEmpty() && !add(textPrimitive(attributes, style, text), style)) {
+                    return QString();
+                }
+                continue;
+            }
+            stack.append(style);
+            if (isGroup(name)) {
+                continue;
+            }
+            if (name == QLatin1String("use")) {
+                if (!addUse(attributes, style)) {
+                    return QString();
+                }
+                continue;
+            }
+            SvgStreamImporter::Primitive primitive;
+            if (!shapePrimitive(name, attributes, style, primitive)) {
+                if (name == QLatin1String("image") && !style.inDefs && style.definition.isEmpty()) {
+                    ++skipped; // 暂不支持的元素，退化的图形（如空路径）不计入；定义中的在 <use> 时计入
+                }
+                continue;
+            }
+            if (!add(primitive, style)) {
+                return QString();
+            }
+        }
+        if (reader.hasError()) {
+            return SvgStreamImporter::tr("第 %1 行解析错误: %2").arg(reader.lineNumber()).arg(reader.errorString());
+        }
+        if (!batch.isEmpty()) {
+            flush(batch);
+        }
+        progress = 100;
+        return QString();
+    }
+
+private:
+    static bool isSkippedContainer(QStringView name)
+    {
+        static const char *const names[] = { "clipPath", "mask", "pattern", "marker",
+                                             "linearGradient", "radialGradient", "filter", "metadata",
+                                             "title", "desc", "script", "foreignObject" };
+        for (const char *skippedName : names) {
+            if (name == QLatin1String(skippedName)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    static bool isGroup(QStringView name)
+    {
+        return name == QLatin1String("svg") || name == QLatin1String("g") || name == QLatin1String("a")
+               || name == QLatin1String("switch") || name == QLatin1String("defs") || name == QLatin1String("symbol");
+    }
+
+    // 根元素的 viewBox 映射到 width/height
+    static QTransform rootTransform(const QXmlStreamAttributes &attributes)
+    {
+        const QVector<qreal> viewBox = parseNumbers(attributes.value(QLatin1String("viewBox")));
+        if (viewBox.size() != 4 || viewBox[2] <= 0 || viewBox[3] <= 0) {
+            return QTransform();
+        }
+        const qreal width = attributeLength(attributes, QLatin1String("width"), viewBox[2]);
+        const qreal height = attributeLength(attributes, QLatin1String("height"), viewBox[3]);
+        QTransform transform;
+        transform.scale(width / viewBox[2], height / viewBox[3]);
+        transform.translate(-viewBox[0], -viewBox[1]);
+        return transform;
+    }
+
+    static SvgStreamImporter::Primitive textPrimitive(const QXmlStreamAttributes &attributes, const Style &style,
+                                                      const QString &text)
+    {
+        SvgStreamImporter::Primitive primitive;
+        primitive.kind = SvgStreamImporter::Primitive::Text;
+        primitive.text = text;
+        const QVector<qreal> x = parseNumbers(attributes.value(QLatin1String("x")));
+        const QVector<qreal> y = parseNumbers(attributes.value(QLatin1String("y")));
+        primitive.transform = QTransform::fromTranslate(x.isEmpty() ? 0.0 : x.first(), y.isEmpty() ? 0.0 : y.first())
+                              * style.transform;
+        primitive.fontFamily = style.fontFamily;
+        primitive.fontPixelSize = style.fontSize;
+        primitive.bold = style.bold;
+        primitive.italic = style.italic;
+        primitive.brush = brushFor(style);
+        return primitive;
+    }
+
+    static bool shapePrimitive(QStringView name, const QXmlStreamAttributes &attributes, const Style &style,
+                               SvgStreamImporter::Primitive &primitive)
+    {
+        using Primitive = SvgStreamImporter::Primitive;
+        const QTransform &transform = style.transform;
+        primitive.pen = penFor(style);
+        primitive.brush = brushFor(style);
+        if (name == QLatin1String("line")) {
+            primitive.kind = Primitive::Line;
+            primitive.points = transform.map(QPolygonF({
+                QPointF(attributeLength(attributes, QLatin1String("x1")), attributeLength(attributes, QLatin1String("y1"))),
+                QPointF(attributeLength(attributes, QLatin1String("x2")), attributeLength(attributes, QLatin1String("y2")))}));
+            primitive.brush = Qt::NoBrush;
+            return primitive.pen.style() != Qt::NoPen;
+        }
+        if (name == QLatin1String("polyline") || name == QLatin1String("polygon")) {
+            const QPolygonF points = parsePoints(attributes.value(QLatin1String("points")));
+            if (points.size() < 2) {
+                return false;
+            }
+            primitive.points = transform.map(points);
+            // 可编辑折线没有填充，带填充的折线按闭合路径导入
+            primitive.fillRule = style.fillRule;
+            if (name == QLatin1String("polygon")) {
+                primitive.kind = Primitive::Polygon;
+            } else if (primitive.brush.style() == Qt::NoBrush) {
+                primitive.kind = Primitive::Polyline;
+            } else {
+                primitive.kind = Primitive::Path;
+                primitive.path.addPolygon(primitive.points);
+                primitive.path.setFillRule(style.fillRule);
+            }
+            return true;
+        }
+        if (name == QLatin1String("rect") || name == QLatin1String("circle") || name == QLatin1String("ellipse")) {
+            QRectF rect;
+            qreal rx = 0;
+            qreal ry = 0;
+            if (name == QLatin1String("rect")) {
+                rect = QRectF(attributeLength(attributes, QLatin1String("x")), attributeLength(attributes, QLatin1String("y")),
+                              attributeLength(attributes, QLatin1String("width")), attributeLength(attributes, QLatin1String("height")));
+                rx = attributeLength(attributes, QLatin1String("rx"), -1);
+                ry = attributeLength(attributes, QLatin1String("ry"), -1);
+                if (rx < 0) {
+                    rx = qMax<qreal>(ry, 0.0);
+                }
+                if (ry < 0) {
+                    ry = rx;
+                }
+            } else {
+                const QPointF center(attributeLength(attributes, QLatin1String("cx")), attributeLength(attributes, QLatin1String("cy")));
+                const qreal radiusX = name == QLatin1String("circle") ? attributeLength(attributes, QLatin1String("r"))
+                                                                      : attributeLength(attributes, QLatin1String("rx"));
+                const qreal radiusY = name == QLatin1String("circle") ? radiusX : attributeLength(attributes, QLatin1String("ry"));
+                rect = QRectF(center.x() - radiusX, center.y() - radiusY, 2 * radiusX, 2 * radiusY);
+            }
+            if (rect.width() <= 0 || rect.height() <= 0) {
+                return false;
+            }
+            const bool ellipse = name != QLatin1String("rect");
+            // 旋转、斜切或圆角时按路径导入
+            if (isAxisAligned(transform) && (ellipse || (rx <= 0 && ry <= 0))) {
+                primitive.kind = ellipse ? Primitive::Ellipse : Primitive::Rect;
+                primitive.rect = transform.mapRect(rect);
+                return true;
+            }
+            QPainterPath path;
+            if (ellipse) {
+                path.addEllipse(rect);
+            } else {
+                path.addRoundedRect(rect, qMin(rx, rect.width() / 2), qMin(ry, rect.height() / 2));
+            }
+            primitive.kind = Primitive::Path;
+            primitive.path = transform.map(path);
+            return true;
+        }
+        if (name == QLatin1String("path")) {
+            const QPainterPath path = parsePathData(attributes.value(QLatin1String("d")));
+            if (path.isEmpty()) {
+                return false;
+            }
+            primitive.kind = Primitive::Path;
+            primitive.path = transform.map(path);
+            primitive.path.setFillRule(style.fillRule);
+            return true;
+        }
+        return false; // image 等暂不支持
+    }
+
+    // <use> 引用之前定义的 symbol 或 defs 元素；x/y 在 use 自身的变换之前应用
+    bool addUse(const QXmlStreamAttributes &attributes, const Style &style)
+    {
+        QStringView href = attributes.value(QLatin1String("http://www.w3.org/1999/xlink"), QLatin1String("href"));
+        if (href.isEmpty()) {
+            href = attributes.value(QLatin1String("href"));
+        }
+        const auto it = href.startsWith(QLatin1Char('#')) ? definitions.constFind(href.mid(1).toString())
+                                                          : definitions.constEnd();
+        if (it == definitions.constEnd()) {
+            ++skipped; // 外部引用、后定义的元素和图片
+            return true;
+        }
+        const QTransform placement = QTransform::fromTranslate(attributeLength(attributes, QLatin1String("x")),
+                                                               attributeLength(attributes, QLatin1String("y")))
+                                     * style.transform;
+        for (const SvgStreamImporter::Primitive &primitive : it.value()) {
+            if (!add(transformed(primitive, placement), style)) {
+                return false;
+            }
+        }
+        return true;
+    }
+
+    bool add(const SvgStreamImporter::Primitive &primitive, const Style &style)
+    {
+        if (!style.definition.isEmpty()) {
+            definitions[style.definition].append(primitive);
+            return true;
+        }
+        if (style.inDefs) {
+            return true; // defs 中没有 id 的元素无法被引用
+        }
+        batch.append(primitive);
+        if (batch.size() < SvgStreamImporter::BatchSize) {
+            return true;
+        }
+        return flush(batch);
+    }
+
+    std::function<bool(SvgStreamImporter::Batch &)> flush;
+    std::atomic<int> &skipped;
+    SvgStreamImporter::Batch batch;
+    QHash<QString, QString> classRules;                    // 类名 -> 样式声明
+    QHash<QString, SvgStreamImporter::Batch> definitions;  // id -> 定义坐标系下的图形
+};
+
+} // namespace
+
+SvgStreamImporter::SvgStreamImporter(QGraphicsScene *scene, QObject *parent)
+    : QObject(parent),
+    scene(scene)
+{
+    drainTimer.setInterval(DrainIntervalMs);
+    connect(&drainTimer, &QTimer::timeout, this, &SvgStreamImporter::drain);
+    connect(&watcher, &QFutureWatcher<QString>::finished, this, [this]() {
+        parsed = true;
+        parseError = watcher.result();
+        drain(); // 剩余批次处理完后结束
+    });
+}
+
+SvgStreamImporter::~SvgStreamImporter()
+{
+    if (channel) {
+        QMutexLocker locker(&channel->mutex);
+        channel->canceled = true;
+        channel->notFull.wakeAll();
+    }
+}
+
+bool SvgStreamImporter::start(const QString &filePath)
+{
+    if (running || !scene) {
+        return false;
+    }
+    if (!QFile::exists(filePath)) {
+        qCWarning(lcIo) << "SVG file not found:" << filePath;
+        return false;
+    }
+    channel = std::make_shared<Channel>();
+    current.clear();
+    currentIndex = 0;
+    created.clear();
+    parsed = false;
+    parseError.clear();
+    lastProgress = -1;
+    running = true;
+    // 整个导入作为一次场景事务，未知数量按大批量处理（暂停索引）
+    transaction = std::make_unique<SceneTransaction>(scene, -1);
+    qCInfo(lcIo) << "Streaming SVG import started:" << filePath;
+    watcher.setFuture(QtConcurrent::run(&SvgStreamImporter::parse, channel, filePath));
+    drainTimer.start();
+    return true;
+}
+
+void SvgStreamImporter::cancel()
+{
+    if (!running) {
+        return;
+    }
+    {
+        QMutexLocker locker(&channel->mutex);
+        channel->canceled = true;
+        channel->batches.clear();
+        channel->notFull.wakeAll();
+    }
+    for (QGraphicsItem *item : std::as_const(created)) {
+        SceneItemEvents::removeItem(scene, item);
+        delete item;
+    }
+    qCInfo(lcIo) << "Streaming SVG import canceled," << created.size() << "items removed.";
+    created.clear();
+    current.clear();
+    finish(tr("导入已取消"));
+}
+
+QString SvgStreamImporter::parse(const std::shared_ptr<Channel> &channel, const QString &filePath)
+{
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        return tr("无法打开文件: %1").arg(file.errorString());
+    }
+    // 队列满时等待 GUI 线程取走批次
+    auto flush = [&channel](Batch &batch) {
+        QMutexLocker locker(&channel->mutex);
+        while (channel->batches.size() >= MaxQueuedBatches && !channel->canceled) {
+            channel->notFull.wait(&channel->mutex);
+        }
+        if (channel->canceled) {
+            return false;
+        }
+        channel->batches.enqueue(std::move(batch));
+        batch = Batch();
+        return true;
+    };
+    SvgParser parser(flush, channel->skipped);
+    return parser.parse(file, channel->progress);
+}
+
+void SvgStreamImporter::drain()
+{
+    if (!running) {
+        return;
+    }
+    QElapsedTimer elapsed;
+    elapsed.start();
+    while (elapsed.elapsed() < DrainBudgetMs) {
+        if (currentIndex >= current.size()) {
+            QMutexLocker locker(&channel->mutex);
+            if (channel->batches.isEmpty()) {
+                break;
+            }
+            current = channel->batches.dequeue();
+            currentIndex = 0;
+            channel->notFull.wakeAll();
+        }
+        // 每 64 个图元检查一次时间片
+        const int end = qMin(current.size(), currentIndex + 64);
+        for (; currentIndex < end; ++currentIndex) {
+            if (QGraphicsItem *item = createItem(current.at(currentIndex))) {
+                scene->addItem(item);
+                created.append(item);
+            }
+        }
+    }
+
+    const int progress = channel->progress;
+    if (progress != lastProgress) {
+        lastProgress = progress;
+        emit progressChanged(progress);
+    }
+    if (!parsed || currentIndex < current.size()) {
+        return;
+    }
+    QMutexLocker locker(&channel->mutex);
+    if (channel->batches.isEmpty()) {
+        locker.unlock();
+        finish(parseError);
+    }
+}
+
+void SvgStreamImporter::finish(const QString &error)
+{
+    drainTimer.stop();
+    running = false;
+    current.clear();
+    transaction.reset(); // 提交事务，索引在此一次性重建
+    const int itemCount = created.size();
+    created.clear();
+    qCInfo(lcIo) << "Streaming SVG import finished," << itemCount << "items," << channel->skipped << "elements skipped."
+                 << error;
+    emit finished(itemCount, channel->skipped, error);
+}
+
+QGraphicsItem *SvgStreamImporter::createItem(const Primitive &primitive)
+{
+    switch (primitive.kind) {
+    case Primitive::Line: {
+        EditableLineItem *line = new EditableLineItem(primitive.points.at(0), primitive.points.at(1));
+        line->setPen(primitive.pen);
+        return line;
+    }
+    case Primitive::Polyline: {
+        EditablePolylineItem *polyline = new EditablePolylineItem(primitive.points);
+        polyline->setPen(primitive.pen);
+        return polyline;
+    }
+    case Primitive::Polygon: {
+        QGraphicsPolygonItem *polygon = new QGraphicsPolygonItem(primitive.points);
+        polygon->setPen(primitive.pen);
+        polygon->setBrush(primitive.brush);
+        polygon->setFillRule(primitive.fillRule);
+        return polygon;
+    }
+    case Primitive::Rect: {
+        CustomRectItem *rect = new CustomRectItem(primitive.rect);
+        rect->setPen(primitive.pen);
+        rect->setBrush(primitive.brush);
+        return rect;
+    }
+    case Primitive::Ellipse: {
+        QGraphicsEllipseItem *ellipse = new QGraphicsEllipseItem(primitive.rect);
+        ellipse->setPen(primitive.pen);
+        ellipse->setBrush(primitive.brush);
+        return ellipse;
+    }
+    case Primitive::Path: {
+        QGraphicsPathItem *path = new QGraphicsPathItem(primitive.path);
+        path->setPen(primitive.pen);
+        path->setBrush(primitive.brush);
+        return path;
+    }
+    case Primitive::Text: {
+        QGraphicsTextItem *text = new QGraphicsTextItem();
+        text->setPlainText(primitive.text);
+        QFont font = text->font();
+        if (!primitive.fontFamily.isEmpty()) {
+            font.setFamily(primitive.fontFamily);
+        }
+        font.setPixelSize(qMax(1, qRound(primitive.fontPixelSize)));
+        font.setBold(primitive.bold);
+        font.setItalic(primitive.italic);
+        text->setFont(font);
+        text->document()->setDocumentMargin(0);
+        if (primitive.brush.style() != Qt::NoBrush) {
+            text->setDefaultTextColor(primitive.brush.color());
+        }
+        // SVG 的文字坐标是基线起点，文本项的原点是左上角
+        text->setTransform(QTransform::fromTranslate(0, -QFontMetricsF(font).ascent()) * primitive.transform);
+        text->setFlag(QGraphicsItem::ItemIsMovable);
+        text->setFlag(QGraphicsItem::ItemIsSelectable);
+        return text;
+    }
+    }
+    return nullptr;
+}
@@ -0,0 +1,85 @@
+#ifndef SVG_STREAM_IMPORTER_H
+#define SVG_STREAM_IMPORTER_H
+
+#include <QObject>
+#include <QGraphicsScene>
+#include <QFutureWatcher>
+#include <QTimer>
+#include <QVector>
+#include <QList>
+#include <QPolygonF>
+#include <QPainterPath>
+#include <QTransform>
+#include <QPen>
+#include <QBrush>
+#include <memory>
+
+class SceneTransaction;
+
+// 流式 SVG 导入：工作线程用 QXmlStreamReader 边读边解析，把线、折线、多边形、矩形、椭圆、路径和文字
+// 转换为纯数据（场景坐标下的几何 + 画笔/画刷），按批交给 GUI 线程创建原生可编辑图元。
+// 支持样式表中的类选择器，以及引用此前定义的 <symbol>/<defs> 元素的 <use>。
+// 批次队列有上限，GUI 来不及处理时解析线程等待，内存占用与文件大小无关；
+// GUI 线程每次只处理一个时间片，整个导入处于同一个场景事务中，索引在结束时只重建一次。
+class SvgStreamImporter : public QObject
+{
+    Q_OBJECT
+public:
+    explicit SvgStreamImporter(QGraphicsScene *scene, QObject *parent = nullptr);
+    ~SvgStreamImporter() override;
+
+    bool start(const QString &filePath); // 文件无法打开时返回 false
+    void cancel(); // 停止解析并移除已导入的图元
+    bool isRunning() const { return running; }
+
+    // 一个基本图形，由工作线程产生，只包含值类型
+    struct Primitive {
+        enum Kind { Line, Polyline, Polygon, Rect, Ellipse, Path, Text };
+        Kind kind = Path;
+        QPolygonF points;  // Line 为两个端点，Polyline/Polygon 为顶点
+        QRectF rect;       // Rect/Ellipse
+        QPainterPath path; // Path
+        QString text;      // Text：基线起点为本地原点，transform 映射到场景
+        QString fontFamily;
+        qreal fontPixelSize = 16;
+        bool bold = false;
+        bool italic = false;
+        QTransform transform;
+        QPen pen;
+        QBrush brush;
+        Qt::FillRule fillRule = Qt::WindingFill; // Polygon 的填充规则，Path 记在路径上
+    };
+    using Batch = QVector<Primitive>;
+
+    static constexpr int BatchSize = 2000;      // 每批图形数
+    static constexpr int MaxQueuedBatches = 4;  // 等待 GUI 处理的批次上限
+    static constexpr int DrainIntervalMs = 10;  // GUI 线程取批次的间隔
+    static constexpr int DrainBudgetMs = 25;    // GUI 线程每次创建图元的时间片
+
+signals:
+    void progressChanged(int percent);
+    // error 为空表示成功；skipped 为不支持而跳过的元素数
+    void finished(int itemCount, int skipped, const QString &error);
+
+private:
+    struct Channel;
+    static QString parse(const std::shared_ptr<Channel> &channel, const QString &filePath);
+    void drain();
+    void finish(const QString &error);
+    static QGraphicsItem *createItem(const Primitive &primitive);
+
+    QGraphicsScene *scene;
+    std::shared_ptr<Channel> channel;
+    QFutureWatcher<QString> watcher;
+    QTimer drainTimer;
+    std::unique_ptr<SceneTransaction> transaction;
+    Batch current;          // 正在创建图元的批次
+    int currentIndex = 0;
+    QList<QGraphicsItem*> created;
+    bool running = false;
+    bool parsed = false;    // 解析线程已结束
+    QString parseError;
+    int lastProgress = -1;
+};
+
+#endif // SVG_STREAM_IMPORTER_H
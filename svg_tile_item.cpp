@@ -0,0 +1,298 @@
+#include "svg_tile_item.h"
+#include "logging_categories.h"
+#include <QGraphicsScene>
+#include <QGraphicsView>
+#include <QStyleOptionGraphicsItem>
+#include <QSvgRenderer>
+#include <QPainter>
+#include <QPainterPath>
+#include <QPicture>
+#include <QFile>
+#include <QThread>
+#include <QtConcurrent>
+#include <QtMath>
+#include <QDebug>
+#include <cmath>
+
+namespace {
+
+// 工作线程：使用自己的渲染器解析 SVG 并录制成 QPicture 数据
+QByteArray recordSvg(const QByteArray &data, const QRectF &bounds)
+{
+    QSvgRenderer renderer(data);
+    if (!renderer.isValid()) {
+        return QByteArray();
+    }
+    QPicture picture;
+    QPainter painter(&picture);
+    renderer.render(&painter, bounds);
+    painter.end();
+    return QByteArray(picture.data(), int(picture.size()));
+}
+
+// 工作线程：回放录制数据得到一块瓦片，只读取传入的数据
+QImage renderTile(const QByteArray &data, int bucket, int x, int y)
+{
+    QImage image(SvgTileItem::TileSize, SvgTileItem::TileSize, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QPicture picture;
+    picture.setData(data.constData(), uint(data.size()));
+
+    QPainter painter(&image);
+    painter.setRenderHints(QPainter::Antialiasing | QPainter::SmoothPixmapTransform | QPainter::TextAntialiasing);
+    painter.translate(-x * SvgTileItem::TileSize, -y * SvgTileItem::TileSize);
+    const qreal scale = std::ldexp(1.0, bucket);
+    painter.scale(scale, scale);
+    painter.drawPicture(0, 0, picture);
+    painter.end();
+    return image;
+}
+
+} // namespace
+
+SvgTileItem::SvgTileItem(const QString &filePath, QGraphicsItem *parent)
+    : QGraphicsObject(parent),
+    path(filePath),
+    renderer(new QSvgRenderer(this))
+{
+    setFlag(QGraphicsItem::ItemUsesExtendedStyleOption, true); // 需要实际暴露区域来决定绘制哪些瓦片
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::ReadOnly)) {
+        qCWarning(lcIo) << "Cannot open SVG file:" << filePath << file.errorString();
+        return;
+    }
+    const QByteArray data = file.readAll();
+    if (!renderer->load(data)) {
+        return;
+    }
+
+    connect(&recordWatcher, &QFutureWatcher<QByteArray>::finished, this, [this]() {
+        picture = recordWatcher.result();
+        if (picture.isEmpty()) {
+            qCWarning(lcIo) << "Cannot record SVG for tiling, keeping live rendering:" << path;
+            return;
+        }
+        qCDebug(lcItems) << "SVG recorded for tiling:" << path << picture.size() << "bytes.";
+        update(); // 场景瓦片缓存中的实时渲染结果需要作废
+    });
+    recordWatcher.setFuture(QtConcurrent::run(recordSvg, data, boundingRect()));
+}
+
+bool SvgTileItem::isValid() const
+{
+    return renderer->isValid();
+}
+
+QRectF SvgTileItem::boundingRect() const
+{
+    return QRectF(QPointF(0, 0), renderer->defaultSize());
+}
+
+void SvgTileItem::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+{
+    Q_UNUSED(widget);
+    if (!isValid()) {
+        return;
+    }
+    const QRectF bounds = boundingRect();
+
+    // 视口以外的设备（瓦片快照、导出）直接输出矢量内容，保证任意缩放下的精度
+    if (painter->device()->devType() != QInternal::Widget) {
+        if (isRecorded()) {
+            QPicture recorded;
+            recorded.setData(picture.constData(), uint(picture.size()));
+            painter->drawPicture(0, 0, recorded);
+        } else {
+            renderer->render(painter, bounds);
+        }
+        return;
+    }
+
+    const qreal lod = option->levelOfDetailFromTransform(painter->worldTransform())
+                      * painter->device()->devicePixelRatioF();
+    if (lod <= 0.0) {
+        return;
+    }
+    // 取分辨率不低于目标的档位；整个图形已小于一块瓦片时不再继续缩小
+    const int bucket = qMax(minBucket(), qCeil(std::log2(lod)));
+    if (!isRecorded() && !recordWatcher.isFinished()) {
+        drawPlaceholder(painter); // 后台录制完成前不在 GUI 线程渲染整个 SVG
+        return;
+    }
+    if (!isRecorded() || bucket > MaxBucket) {
+        renderer->render(painter, bounds); // 录制失败，或放大超过最细档位
+        return;
+    }
+
+    // 只处理真正可见的部分：暴露区域与设备视口、裁剪区域的交集
+    QRectF visible = option->exposedRect & bounds;
+    visible &= painter->worldTransform().inverted().mapRect(QRectF(painter->viewport()));
+    if (painter->hasClipping()) {
+        visible &= painter->clipBoundingRect();
+    }
+    if (visible.isEmpty()) {
+        return;
+    }
+
+    const qreal span = tileSpan(bucket);
+    const int firstX = qFloor(visible.left() / span);
+    const int lastX = qFloor(visible.right() / span);
+    const int firstY = qFloor(visible.top() / span);
+    const int lastY = qFloor(visible.bottom() / span);
+    QPainterPath uncovered;
+    for (int y = firstY; y <= lastY; ++y) {
+        for (int x = firstX; x <= lastX; ++x) {
+            const TileKey key{bucket, x, y};
+            const QRectF rect(x * span, y * span, span, span);
+            if (const QImage *image = cachedTile(key)) {
+                painter->drawImage(rect, *image);
+                continue;
+            }
+            requestTile(key);
+            if (!drawFallback(painter, key)) {
+                uncovered.addRect(rect);
+            }
+        }
+    }
+    dispatchTiles();
+
+    // 连概览瓦片都还没有的区域只画占位，瓦片就绪后重绘
+    if (!uncovered.isEmpty()) {
+        painter->save();
+        painter->setClipPath(uncovered, Qt::IntersectClip);
+        drawPlaceholder(painter);
+        painter->restore();
+    }
+}
+
+void SvgTileItem::drawPlaceholder(QPainter *painter) const
+{
+    // 与栅格底图相同的占位框
+    painter->save();
+    painter->setPen(QPen(QColor(128, 128, 128), 0, Qt::DashLine));
+    painter->setBrush(QColor(128, 128, 128, 32));
+    painter->drawRect(boundingRect());
+    painter->restore();
+}
+
+int SvgTileItem::minBucket() const
+{
+    // 整个图形落在一块瓦片内的档位
+    const qreal side = qMax(boundingRect().width(), boundingRect().height());
+    return side > 0 ? qFloor(std::log2(TileSize / side)) : 0;
+}
+
+qreal SvgTileItem::tileSpan(int bucket)
+{
+    return std::ldexp(qreal(TileSize), -bucket);
+}
+
+const QImage *SvgTileItem::cachedTile(const TileKey &key)
+{
+    auto it = tiles.find(key);
+    if (it == tiles.end()) {
+        return nullptr;
+    }
+    it->lastUsed = ++useCounter;
+    return &it->image;
+}
+
+bool SvgTileItem::drawFallback(QPainter *painter, const TileKey &key)
+{
+    // 用更粗档位中已缓存的瓦片放大代替：先查相近的几档，最后总是退到覆盖整个图形的概览瓦片
+    const qreal span = tileSpan(key.bucket);
+    const QRectF target(key.x * span, key.y * span, span, span);
+    auto drawFrom = [&](int coarse) {
+        const int shift = key.bucket - coarse;
+        const TileKey coarseKey{coarse, key.x >> shift, key.y >> shift};
+        const QImage *image = cachedTile(coarseKey);
+        if (!image) {
+            return false;
+        }
+        const qreal coarseSpan = tileSpan(coarse);
+        const qreal pixelsPerUnit = TileSize / coarseSpan;
+        const QRectF source((target.left() - coarseKey.x * coarseSpan) * pixelsPerUnit,
+                            (target.top() - coarseKey.y * coarseSpan) * pixelsPerUnit,
+                            span * pixelsPerUnit, span * pixelsPerUnit);
+        painter->drawImage(target, *image, source);
+        return true;
+    };
+    const int overview = minBucket();
+    const int lowest = qMax(overview, key.bucket - FallbackBuckets);
+    for (int coarse = key.bucket - 1; coarse >= lowest; --coarse) {
+        if (drawFrom(coarse)) {
+            return true;
+        }
+    }
+    if (lowest > overview && drawFrom(overview)) {
+        return true;
+    }
+    // 概览瓦片只有一块，请求它作为之后的替代
+    requestTile(TileKey{overview, 0, 0});
+    return false;
+}
+
+void SvgTileItem::requestTile(const TileKey &key)
+{
+    if (tiles.contains(key) || jobs.contains(key)) {
+        return;
+    }
+    queued.removeOne(key);
+    queued.append(key);
+    if (queued.size() > MaxQueuedTiles) {
+        queued.removeFirst(); // 最早的请求多半已经移出视口
+    }
+}
+
+void SvgTileItem::dispatchTiles()
+{
+    // 同时进行的任务数不超过线程数，后请求的先渲染
+    const int maxJobs = qMax(1, QThread::idealThreadCount());
+    while (jobs.size() < maxJobs && !queued.isEmpty()) {
+        const TileKey key = queued.takeLast();
+        jobs.insert(key);
+        QFutureWatcher<QImage> *watcher = new QFutureWatcher<QImage>(this);
+        connect(watcher, &QFutureWatcher<QImage>::finished, this, [this, watcher, key]() {
+            tileRendered(key, watcher->result());
+            watcher->deleteLater();
+        });
+        watcher->setFuture(QtConcurrent::run(renderTile, picture, key.bucket, key.x, key.y));
+    }
+}
+
+void SvgTileItem::tileRendered(const TileKey &key, const QImage &image)
+{
+    jobs.remove(key);
+    tiles.insert(key, CachedTile{image, ++useCounter});
+    tileBytes += image.sizeInBytes();
+    // 超出内存上限时淘汰最久未使用的瓦片
+    // 概览瓦片是所有未就绪区域的替代，不淘汰
+    const TileKey overview{minBucket(), 0, 0};
+    while (tileBytes > TileMemoryBudget && tiles.size() > 1) {
+        auto oldest = tiles.end();
+        for (auto it = tiles.begin(); it != tiles.end(); ++it) {
+            if (!(it.key() == overview) && (oldest == tiles.end() || it->lastUsed < oldest->lastUsed)) {
+                oldest = it;
+            }
+        }
+        tileBytes -= oldest->image.sizeInBytes();
+        tiles.erase(oldest);
+    }
+    const qreal span = tileSpan(key.bucket);
+    repaintViews(QRectF(key.x * span, key.y * span, span, span));
+    dispatchTiles();
+}
+
+void SvgTileItem::repaintViews(const QRectF &localRect)
+{
+    // 瓦片到达不改变图形内容，直接重绘视口而不通知场景，避免作废视口瓦片缓存
+    if (!scene()) {
+        return;
+    }
+    const QRectF sceneRect = mapRectToScene(localRect & boundingRect());
+    const QList<QGraphicsView*> views = scene()->views();
+    for (QGraphicsView *view : views) {
+        view->viewport()->update(view->mapFromScene(sceneRect).boundingRect().adjusted(-1, -1, 1, 1));
+    }
+}
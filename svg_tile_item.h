@@ -0,0 +1,78 @@
+#ifndef SVG_TILE_ITEM_H
+#define SVG_TILE_ITEM_H
+
+#include <QGraphicsObject>
+#include <QFutureWatcher>
+#include <QByteArray>
+#include <QHash>
+#include <QImage>
+#include <QSet>
+#include <QVector>
+
+class QSvgRenderer;
+
+// 导入的 SVG 图形：按缩放档位（2 的幂）切成固定大小的瓦片，由线程池栅格化后缓存，
+// 平移和缩放只绘制已缓存的瓦片。导入时在后台把 SVG 录制成 QPicture 数据，工作线程只回放它；
+// 瓦片未就绪时用更粗档位的瓦片放大代替，最终退到整个图形的概览瓦片，连它也没有时画占位框；
+// 只有放大超过最细档位（或录制失败）时才在 GUI 线程实时渲染 SVG。
+class SvgTileItem : public QGraphicsObject
+{
+    Q_OBJECT
+public:
+    enum { Type = UserType + 7 }; // 自定义类型，便于 qgraphicsitem_cast 和按类型分派
+    int type() const override { return Type; }
+
+    explicit SvgTileItem(const QString &filePath, QGraphicsItem *parent = nullptr);
+
+    QString filePath() const { return path; }
+    bool isValid() const;
+    bool isRecorded() const { return !picture.isEmpty(); }
+
+    QRectF boundingRect() const override;
+    void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget = nullptr) override;
+
+    static constexpr int TileSize = 256;        // 瓦片边长（设备像素）
+    static constexpr int MaxBucket = 6;         // 最细档位（放大 64 倍），再放大时实时渲染
+    static constexpr int FallbackBuckets = 4;   // 瓦片未就绪时向上逐档查找的粗档位数，之后直接用概览瓦片
+    static constexpr int MaxQueuedTiles = 256;  // 排队瓦片上限，超出时丢弃最早的请求
+    static constexpr qint64 TileMemoryBudget = 96 * 1024 * 1024; // 瓦片缓存上限（字节）
+
+private:
+    struct TileKey {
+        int bucket = 0;
+        int x = 0;
+        int y = 0;
+        bool operator==(const TileKey &other) const { return bucket == other.bucket && x == other.x && y == other.y; }
+    };
+    friend size_t qHash(const TileKey &key, size_t seed) noexcept
+    {
+        return qHashMulti(seed, key.bucket, key.x, key.y);
+    }
+    struct CachedTile {
+        QImage image;
+        quint64 lastUsed = 0;
+    };
+
+    int minBucket() const;
+    static qreal tileSpan(int bucket); // 瓦片在本地坐标下的边长
+    const QImage *cachedTile(const TileKey &key);
+    bool drawFallback(QPainter *painter, const TileKey &key);
+    void drawPlaceholder(QPainter *painter) const;
+    void requestTile(const TileKey &key);
+    void dispatchTiles();
+    void tileRendered(const TileKey &key, const QImage &image);
+    void repaintViews(const QRectF &localRect);
+
+    QString path;
+    QSvgRenderer *renderer; // GUI 线程实时渲染用
+    QByteArray picture;     // 本地坐标下录制的绘制指令，录制完成前为空
+    QFutureWatcher<QByteArray> recordWatcher;
+
+    QHash<TileKey, CachedTile> tiles;
+    QSet<TileKey> jobs;      // 渲染中的瓦片
+    QVector<TileKey> queued; // 等待渲染的瓦片，后请求的先渲染
+    qint64 tileBytes = 0;
+    quint64 useCounter = 0;
+};
+
+#endif // SVG_TILE_ITEM_H
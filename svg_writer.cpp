@@ -0,0 +1,827 @@
+#include "svg_writer.h"
+#include "logging_categories.h"
+#include "editable_polyline_item.h"
+#include "custom_rect_item.h"
+#include "bulk_primitive_item.h"
+#include "baked_layer_item.h"
+#include "raster_pyramid_item.h"
+#include "svg_tile_item.h"
+#include <QGraphicsLineItem>
+#include <QGraphicsRectItem>
+#include <QGraphicsEllipseItem>
+#include <QGraphicsPathItem>
+#include <QGraphicsPolygonItem>
+#include <QGraphicsSimpleTextItem>
+#include <QGraphicsTextItem>
+#include <QGraphicsPixmapItem>
+#include <QStyleOptionGraphicsItem>
+#include <QXmlStreamWriter>
+#include <QCryptographicHash>
+#include <QTextDocument>
+#include <QFontMetricsF>
+#include <QPainter>
+#include <QBuffer>
+#include <QFile>
+#include <QUrl>
+#include <QtMath>
+#include <QDebug>
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+const QString XlinkNamespace = QStringLiteral("http://www.w3.org/1999/xlink");
+
+// 坐标和长度保留两位小数，去掉多余的零和负零
+QString number(qreal value)
+{
+    const qreal rounded = std::round(value * 100.0) / 100.0;
+    if (rounded == 0.0) {
+        return QStringLiteral("0");
+    }
+    return QString::number(rounded, 'g', 15);
+}
+
+// 变换矩阵的系数需要更高精度（旋转的正余弦），保留 6 位有效数字
+QString factor(qreal value)
+{
+    return qFuzzyIsNull(value) ? QStringLiteral("0") : QString::number(value, 'g', 6);
+}
+
+QString pointList(const QPolygonF &points, const QPointF &shift)
+{
+    QString text;
+    text.reserve(points.size() * 12);
+    for (const QPointF &p : points) {
+        if (!text.isEmpty()) {
+            text += QLatin1Char(' ');
+        }
+        text += number(p.x() + shift.x()) + QLatin1Char(',') + number(p.y() + shift.y());
+    }
+    return text;
+}
+
+QString pathData(const QPainterPath &path, const QPointF &shift)
+{
+    QString data;
+    data.reserve(path.elementCount() * 12);
+    for (int i = 0; i < path.elementCount(); ++i) {
+        const QPainterPath::Element element = path.elementAt(i);
+        switch (element.type) {
+        case QPainterPath::MoveToElement:
+            data += QLatin1Char('M');
+            break;
+        case QPainterPath::LineToElement:
+            data += QLatin1Char('L');
+            break;
+        case QPainterPath::CurveToElement:
+            data += QLatin1Char('C');
+            break;
+        case QPainterPath::CurveToDataElement:
+            data += QLatin1Char(' ');
+            break;
+        }
+        data += number(element.x + shift.x()) + QLatin1Char(' ') + number(element.y + shift.y());
+    }
+    return data;
+}
+
+QString penStyle(const QPen &pen)
+{
+    if (pen.style() == Qt::NoPen || pen.brush().style() == Qt::NoBrush) {
+        return QStringLiteral("stroke:none");
+    }
+    QStringList parts;
+    const QColor color = pen.color();
+    parts << QStringLiteral("stroke:") + color.name();
+    if (color.alpha() < 255) {
+        parts << QStringLiteral("stroke-opacity:") + number(color.alphaF());
+    }
+    // 宽度为 0 的画笔在 Qt 中是 1 像素的装饰性画笔，不随缩放变粗
+    const qreal width = pen.widthF();
+    parts << QStringLiteral("stroke-width:") + number(width > 0 ? width : 1.0);
+    if (width <= 0 || pen.isCosmetic()) {
+        parts << QStringLiteral("vector-effect:non-scaling-stroke");
+    }
+    if (pen.capStyle() == Qt::SquareCap) {
+        parts << QStringLiteral("stroke-linecap:square");
+    } else if (pen.capStyle() == Qt::RoundCap) {
+        parts << QStringLiteral("stroke-linecap:round");
+    }
+    if (pen.joinStyle() == Qt::RoundJoin) {
+        parts << QStringLiteral("stroke-linejoin:round");
+    } else if (pen.joinStyle() == Qt::BevelJoin) {
+        parts << QStringLiteral("stroke-linejoin:bevel");
+    } else if (pen.miterLimit() != 4.0) {
+        parts << QStringLiteral("stroke-miterlimit:") + number(pen.miterLimit());
+    }
+    if (pen.style() != Qt::SolidLine) {
+        // Qt 的虚线模式以线宽为单位
+        const qreal unit = width > 0 ? width : 1.0;
+        QStringList dashes;
+        const QVector<qreal> pattern = pen.dashPattern();
+        for (qreal dash : pattern) {
+            dashes << number(dash * unit);
+        }
+        parts << QStringLiteral("stroke-dasharray:") + dashes.join(QLatin1Char(','));
+        if (pen.dashOffset() != 0) {
+            parts << QStringLiteral("stroke-dashoffset:") + number(pen.dashOffset() * unit);
+        }
+    }
+    return parts.join(QLatin1Char(';'));
+}
+
+QString brushStyle(const QBrush &brush)
+{
+    if (brush.style() == Qt::NoBrush) {
+        return QStringLiteral("fill:none");
+    }
+    // 渐变和图案画刷没有对应的共享样式，取其主色
+    QColor color = brush.color();
+    if (const QGradient *gradient = brush.gradient()) {
+        if (!gradient->stops().isEmpty()) {
+            color = gradient->stops().first().second;
+        }
+    }
+    QString style = QStringLiteral("fill:") + color.name();
+    if (color.alpha() < 255) {
+        style += QStringLiteral(";fill-opacity:") + number(color.alphaF());
+    }
+    return style;
+}
+
+QString fontStyle(const QFont &font)
+{
+    const qreal pixelSize = font.pixelSize() > 0 ? font.pixelSize() : font.pointSizeF() * 96.0 / 72.0;
+    QString family = font.family();
+    family.remove(QLatin1Char('\''));
+    QString style = QStringLiteral("font-family:'%1';font-size:%2px").arg(family, number(pixelSize));
+    if (font.bold()) {
+        style += QStringLiteral(";font-weight:bold");
+    }
+    if (font.italic()) {
+        style += QStringLiteral(";font-style:italic");
+    }
+    return style;
+}
+
+int attributesLength(const QXmlStreamAttributes &attributes)
+{
+    int length = 0;
+    for (const QXmlStreamAttribute &attribute : attributes) {
+        length += attribute.name().size() + attribute.value().size() + 4;
+    }
+    return length;
+}
+
+// 被烘焙的图元不在场景中，按 BakedLayerItem 录制时的顺序展开：子项按 Z 值排序，垫在父项下的先画
+void appendInPaintOrder(QGraphicsItem *item, QList<QGraphicsItem*> &items)
+{
+    if (!item->isVisible()) {
+        return;
+    }
+    QList<QGraphicsItem*> children = item->childItems();
+    std::stable_sort(children.begin(), children.end(), [](QGraphicsItem *a, QGraphicsItem *b) {
+        return a->zValue() < b->zValue();
+    });
+    auto behindParent = [](QGraphicsItem *child) {
+        return (child->flags() & QGraphicsItem::ItemStacksBehindParent) || child->zValue() < 0;
+    };
+    for (QGraphicsItem *child : std::as_const(children)) {
+        if (behindParent(child)) {
+            appendInPaintOrder(child, items);
+        }
+    }
+    if (!(item->flags() & QGraphicsItem::ItemHasNoContents)) {
+        items.append(item);
+    }
+    for (QGraphicsItem *child : std::as_const(children)) {
+        if (!behindParent(child)) {
+            appendInPaintOrder(child, items);
+        }
+    }
+}
+
+} // namespace
+
+SvgWriter::SvgWriter(QGraphicsScene *scene)
+    : scene(scene)
+{
+}
+
+bool SvgWriter::write(const QString &filePath)
+{
+    error.clear();
+    counters = Stats();
+    classes.clear();
+    classOrder.clear();
+    images.clear();
+    imageOrder.clear();
+    geometries.clear();
+    collectItems();
+
+    // 第一遍：登记样式类和图片，只按哈希统计可复用几何的出现次数，不保留任何输出
+    for (int i = 0; i < items.size(); ++i) {
+        const QVector<Shape> shapes = shapesFor(items.at(i));
+        for (int j = 0; j < shapes.size(); ++j) {
+            const Shape &shape = shapes.at(j);
+            const QString style = styleOf(shape);
+            if (!style.isEmpty() && !classes.contains(style)) {
+                classes.insert(style, QStringLiteral("c") + QString::number(classOrder.size(), 36));
+                classOrder.append(style);
+            }
+            if (!normalizable(shape)) {
+                continue;
+            }
+            const QXmlStreamAttributes attributes = geometry(shape, -symbolOrigin(shape));
+            if (attributesLength(attributes) < MinSymbolLength) {
+                continue;
+            }
+            GeometryUse &use = geometries[geometryKey(tagOf(shape), classes.value(style), attributes)];
+            if (use.count++ == 0) {
+                use.item = i;
+                use.shape = j;
+            }
+        }
+    }
+
+    // 出现两次以上的几何按首次出现的顺序编号为 <symbol>
+    geometries.removeIf([](const QHash<QByteArray, GeometryUse>::iterator &it) {
+        return it->count < 2;
+    });
+    QVector<GeometryUse*> repeated;
+    for (GeometryUse &use : geometries) {
+        repeated.append(&use);
+    }
+    std::sort(repeated.begin(), repeated.end(), [](const GeometryUse *a, const GeometryUse *b) {
+        return a->item != b->item ? a->item < b->item : a->shape < b->shape;
+    });
+    for (int i = 0; i < repeated.size(); ++i) {
+        repeated[i]->id = QStringLiteral("s") + QString::number(i, 36);
+    }
+
+    QFile file(filePath);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        error = tr("无法写入文件：%1").arg(file.errorString());
+        return false;
+    }
+    QXmlStreamWriter xml(&file);
+    xml.writeStartDocument();
+    xml.writeStartElement(QStringLiteral("svg"));
+    xml.writeDefaultNamespace(QStringLiteral("http://www.w3.org/2000/svg"));
+    xml.writeNamespace(XlinkNamespace, QStringLiteral("xlink"));
+    xml.writeAttribute(QStringLiteral("version"), QStringLiteral("1.1"));
+    // 画布取内容的包围盒（向外取整），空场景退回场景矩形
+    const QRect canvas = (contentBounds.isEmpty() ? scene->sceneRect() : contentBounds).toAlignedRect();
+    xml.writeAttribute(QStringLiteral("width"), QString::number(canvas.width()));
+    xml.writeAttribute(QStringLiteral("height"), QString::number(canvas.height()));
+    xml.writeAttribute(QStringLiteral("viewBox"), QStringLiteral("%1 %2 %3 %4")
+                       .arg(canvas.x()).arg(canvas.y()).arg(canvas.width()).arg(canvas.height()));
+
+    writeStyles(xml);
+    writeDefs(xml);
+
+    // 第二遍：按绘制顺序写出
+    for (QGraphicsItem *item : std::as_const(items)) {
+        const QVector<Shape> shapes = shapesFor(item);
+        for (const Shape &shape : shapes) {
+            writeShape(xml, shape);
+        }
+    }
+    xml.writeEndDocument();
+
+    if (xml.hasError()) {
+        error = tr("写入文件时出错：%1").arg(file.errorString());
+        return false;
+    }
+    counters.classes = classOrder.size();
+    counters.symbols = repeated.size();
+    counters.bytes = file.size();
+    qCInfo(lcIo) << "SVG written:" << filePath << counters.elements << "elements," << counters.classes << "classes,"
+                 << counters.symbols << "symbols," << counters.uses << "uses," << counters.bytes << "bytes.";
+    return true;
+}
+
+void SvgWriter::collectItems()
+{
+    items.clear();
+    contentBounds = QRectF();
+    const QList<QGraphicsItem*> sceneItems = scene->items(Qt::AscendingOrder);
+    for (QGraphicsItem *item : sceneItems) {
+        if (!item->isVisible()) {
+            continue;
+        }
+        if (BakedLayerItem *layer = qgraphicsitem_cast<BakedLayerItem*>(item)) {
+            for (QGraphicsItem *baked : layer->items()) {
+                appendInPaintOrder(baked, items);
+            }
+        } else if (!(item->flags() & QGraphicsItem::ItemHasNoContents)) {
+            items.append(item);
+        }
+    }
+    for (QGraphicsItem *item : std::as_const(items)) {
+        contentBounds |= item->sceneBoundingRect();
+    }
+}
+
+QVector<SvgWriter::Shape> SvgWriter::shapesFor(QGraphicsItem *item)
+{
+    QVector<Shape> shapes;
+    Shape base;
+    base.transform = item->sceneTransform();
+    base.opacity = item->effectiveOpacity();
+
+    switch (item->type()) {
+    case BulkPrimitiveItem::Type: {
+        const BulkPrimitiveItem *bulk = static_cast<const BulkPrimitiveItem*>(item);
+        shapes.reserve(bulk->primitiveCount());
+        const QVector<int> order = bulk->paintOrder(); // 与图元自身的绘制顺序一致
+        for (int i : order) {
+            Shape shape = base;
+            const QVector<QPointF> points = bulk->primitivePoints(i);
+            shape.pen = bulk->primitivePen(i);
+            switch (bulk->kind(i)) {
+            case BulkPrimitiveItem::Kind::Line:
+                shape.kind = Shape::Line;
+                shape.points = QPolygonF(points);
+                break;
+            case BulkPrimitiveItem::Kind::Polyline:
+                shape.kind = Shape::Polyline;
+                shape.points = QPolygonF(points);
+                break;
+            case BulkPrimitiveItem::Kind::ClosedPolyline:
+                shape.kind = Shape::Polygon;
+                shape.points = QPolygonF(points);
+                break;
+            case BulkPrimitiveItem::Kind::Rect:
+                shape.kind = Shape::Rect;
+                shape.rect = QRectF(points.at(0), points.at(1));
+                shape.brush = bulk->primitiveBrush(i);
+                break;
+            }
+            shapes.append(shape);
+        }
+        return shapes;
+    }
+    case RasterPyramidItem::Type: {
+        // 超大位图只链接源文件，不内嵌
+        const RasterPyramidItem *raster = static_cast<const RasterPyramidItem*>(item);
+        ImageDef def;
+        def.linkPath = raster->sourcePath();
+        def.size = raster->boundingRect().size();
+        Shape shape = base;
+        shape.kind = Shape::Image;
+        shape.rect = raster->boundingRect();
+        shape.imageKey = registerImage(QStringLiteral("file:") + def.linkPath, def);
+        shapes.append(shape);
+        return shapes;
+    }
+    case SvgTileItem::Type: {
+        // 导入的 SVG 原样内嵌，保持矢量
+        const SvgTileItem *svg = static_cast<const SvgTileItem*>(item);
+        ImageDef def;
+        def.svgPath = svg->filePath();
+        def.size = svg->boundingRect().size();
+        Shape shape = base;
+        shape.kind = Shape::Image;
+        shape.rect = svg->boundingRect();
+        shape.imageKey = registerImage(QStringLiteral("svg:") + def.svgPath, def);
+        shapes.append(shape);
+        return shapes;
+    }
+    case EditablePolylineItem::Type: {
+        const EditablePolylineItem *polyline = static_cast<const EditablePolylineItem*>(item);
+        Shape shape = base;
+        shape.points = QPolygonF(polyline->getPoints());
+        shape.kind = (polyline->isClosed() && shape.points.size() >= 3) ? Shape::Polygon : Shape::Polyline;
+        shape.pen = polyline->pen();
+        shapes.append(shape);
+        return shapes;
+    }
+    default:
+        break;
+    }
+
+    if (const QGraphicsLineItem *line = dynamic_cast<const QGraphicsLineItem*>(item)) {
+        Shape shape = base;
+        shape.kind = Shape::Line;
+        shape.points = QPolygonF({ line->line().p1(), line->line().p2() });
+        shape.pen = line->pen();
+        shapes.append(shape);
+    } else if (const QGraphicsRectItem *rectItem = dynamic_cast<const QGraphicsRectItem*>(item)) {
+        const CustomRectItem *customRect = dynamic_cast<const CustomRectItem*>(item);
+        Shape shape = base;
+        shape.kind = Shape::Rect;
+        shape.rect = rectItem->rect().normalized();
+        shape.pen = rectItem->pen();
+        if (customRect && customRect->hasFillImage()) {
+            // 与 CustomRectItem::paint 一致：先画边框，图片拉伸覆盖整个矩形；同一张图片只内嵌一次
+            shapes.append(shape);
+            ImageDef def;
+            def.image = customRect->fillImage()->original();
+            def.size = def.image.size();
+            Shape image = base;
+            image.kind = Shape::Image;
+            image.rect = shape.rect;
+            image.imageKey = registerImage(QStringLiteral("image:") + QString::number(def.image.cacheKey()), def);
+            shapes.append(image);
+        } else {
+            shape.brush = rectItem->brush();
+            shapes.append(shape);
+        }
+    } else if (const QGraphicsEllipseItem *ellipse = dynamic_cast<const QGraphicsEllipseItem*>(item)) {
+        Shape shape = base;
+        shape.rect = ellipse->rect().normalized();
+        shape.pen = ellipse->pen();
+        shape.brush = ellipse->brush();
+        if (qAbs(ellipse->spanAngle()) >= 360 * 16) {
+            shape.kind = Shape::Ellipse;
+        } else {
+            // 不完整的椭圆按 QGraphicsEllipseItem 的方式画成扇形
+            shape.kind = Shape::Path;
+            shape.path.moveTo(shape.rect.center());
+            shape.path.arcTo(shape.rect, ellipse->startAngle() / 16.0, ellipse->spanAngle() / 16.0);
+            shape.path.closeSubpath();
+        }
+        shapes.append(shape);
+    } else if (const QGraphicsPathItem *pathItem = dynamic_cast<const QGraphicsPathItem*>(item)) {
+        Shape shape = base;
+        shape.kind = Shape::Path;
+        shape.path = pathItem->path();
+        shape.fillRule = shape.path.fillRule();
+        shape.pen = pathItem->pen();
+        shape.brush = pathItem->brush();
+        shapes.append(shape);
+    } else if (const QGraphicsPolygonItem *polygon = dynamic_cast<const QGraphicsPolygonItem*>(item)) {
+        Shape shape = base;
+        shape.kind = Shape::Polygon;
+        shape.points = polygon->polygon();
+        shape.fillRule = polygon->fillRule();
+        shape.pen = polygon->pen();
+        shape.brush = polygon->brush();
+        shapes.append(shape);
+    } else if (const QGraphicsSimpleTextItem *simpleText = dynamic_cast<const QGraphicsSimpleTextItem*>(item)) {
+        const QFontMetricsF metrics(simpleText->font());
+        const QStringList lines = simpleText->text().split(QLatin1Char('\n'));
+        for (int i = 0; i < lines.size(); ++i) {
+            Shape shape = base;
+            shape.kind = Shape::Text;
+            shape.text = lines.at(i);
+            shape.font = simpleText->font();
+            shape.brush = simpleText->brush();
+            shape.rect = QRectF(QPointF(0, metrics.ascent() + i * metrics.lineSpacing()), QSizeF());
+            shapes.append(shape);
+        }
+    } else if (const QGraphicsTextItem *textItem = dynamic_cast<const QGraphicsTextItem*>(item)) {
+        // 富文本按纯文本逐行导出
+        const QFontMetricsF metrics(textItem->font());
+        const qreal margin = textItem->document()->documentMargin();
+        const QStringList lines = textItem->toPlainText().split(QLatin1Char('\n'));
+        for (int i = 0; i < lines.size(); ++i) {
+            Shape shape = base;
+            shape.kind = Shape::Text;
+            shape.text = lines.at(i);
+            shape.font = textItem->font();
+            shape.brush = textItem->defaultTextColor();
+            shape.rect = QRectF(QPointF(margin, margin + metrics.ascent() + i * metrics.lineSpacing()), QSizeF());
+            shapes.append(shape);
+        }
+    } else if (const QGraphicsPixmapItem *pixmapItem = dynamic_cast<const QGraphicsPixmapItem*>(item)) {
+        const QPixmap pixmap = pixmapItem->pixmap();
+        ImageDef def;
+        def.image = pixmap.toImage();
+        def.size = def.image.size();
+        Shape shape = base;
+        shape.kind = Shape::Image;
+        shape.rect = QRectF(pixmapItem->offset(), pixmap.deviceIndependentSize());
+        shape.imageKey = registerImage(QStringLiteral("image:") + QString::number(pixmap.cacheKey()), def);
+        shapes.append(shape);
+    } else {
+        addRasterShape(item, shapes);
+    }
+    return shapes;
+}
+
+void SvgWriter::addRasterShape(QGraphicsItem *item, QVector<Shape> &shapes)
+{
+    // 没有矢量对应的图元：按自身绘制结果栅格化后内嵌
+    const QRectF bounds = item->boundingRect();
+    if (bounds.isEmpty()) {
+        return;
+    }
+    const QString key = QStringLiteral("item:") + QString::number(quintptr(item));
+    if (!images.contains(key)) {
+        const qreal scale = qMin(RasterScale, MaxRasterSide / qMax(bounds.width(), bounds.height()));
+        QImage image(qMax(1, qCeil(bounds.width() * scale)), qMax(1, qCeil(bounds.height() * scale)),
+                     QImage::Format_ARGB32_Premultiplied);
+        image.fill(Qt::transparent);
+        QPainter painter(&image);
+        painter.setRenderHints(QPainter::Antialiasing | QPainter::SmoothPixmapTransform | QPainter::TextAntialiasing);
+        painter.scale(scale, scale);
+        painter.translate(-bounds.topLeft());
+        QStyleOptionGraphicsItem option;
+        option.exposedRect = bounds;
+        option.rect = bounds.toAlignedRect();
+        item->paint(&painter, &option, nullptr);
+        painter.end();
+        qCDebug(lcIo) << "SVG export rasterized item of type" << item->type() << "at" << image.size();
+
+        ImageDef def;
+        def.image = image;
+        def.size = image.size();
+        registerImage(key, def);
+    }
+    Shape shape;
+    shape.kind = Shape::Image;
+    shape.rect = bounds;
+    shape.imageKey = key;
+    shape.transform = item->sceneTransform();
+    shape.opacity = item->effectiveOpacity();
+    shapes.append(shape);
+}
+
+QString SvgWriter::registerImage(const QString &key, const ImageDef &def)
+{
+    if (!images.contains(key)) {
+        ImageDef entry = def;
+        entry.id = QStringLiteral("i") + QString::number(imageOrder.size(), 36);
+        images.insert(key, entry);
+        imageOrder.append(key);
+    }
+    return key;
+}
+
+QString SvgWriter::styleOf(const Shape &shape)
+{
+    QString style;
+    switch (shape.kind) {
+    case Shape::Image:
+        return QString();
+    case Shape::Text:
+        style = brushStyle(shape.brush) + QStringLiteral(";stroke:none;") + fontStyle(shape.font);
+        break;
+    case Shape::Line:
+    case Shape::Polyline:
+        style = penStyle(shape.pen) + QStringLiteral(";fill:none");
+        break;
+    default:
+        style = penStyle(shape.pen) + QLatin1Char(';') + brushStyle(shape.brush);
+        if ((shape.kind == Shape::Polygon || shape.kind == Shape::Path)
+            && shape.brush.style() != Qt::NoBrush && shape.fillRule == Qt::OddEvenFill) {
+            style += QStringLiteral(";fill-rule:evenodd");
+        }
+        break;
+    }
+    if (shape.opacity < 1.0) {
+        style += QStringLiteral(";opacity:") + number(shape.opacity);
+    }
+    return style;
+}
+
+QString SvgWriter::tagOf(const Shape &shape)
+{
+    switch (shape.kind) {
+    case Shape::Line: return QStringLiteral("line");
+    case Shape::Polyline: return QStringLiteral("polyline");
+    case Shape::Polygon: return QStringLiteral("polygon");
+    case Shape::Rect: return QStringLiteral("rect");
+    case Shape::Ellipse:
+        return shape.rect.width() == shape.rect.height() ? QStringLiteral("circle") : QStringLiteral("ellipse");
+    case Shape::Path: return QStringLiteral("path");
+    case Shape::Text: return QStringLiteral("text");
+    case Shape::Image: return QStringLiteral("use");
+    }
+    return QString();
+}
+
+QRectF SvgWriter::geometryBounds(const Shape &shape)
+{
+    switch (shape.kind) {
+    case Shape::Line:
+    case Shape::Polyline:
+    case Shape::Polygon:
+        return shape.points.boundingRect();
+    case Shape::Path:
+        return shape.path.controlPointRect();
+    default:
+        return shape.rect;
+    }
+}
+
+QXmlStreamAttributes SvgWriter::geometry(const Shape &shape, const QPointF &shift)
+{
+    QXmlStreamAttributes attributes;
+    switch (shape.kind) {
+    case Shape::Line:
+        attributes.append(QStringLiteral("x1"), number(shape.points.at(0).x() + shift.x()));
+        attributes.append(QStringLiteral("y1"), number(shape.points.at(0).y() + shift.y()));
+        attributes.append(QStringLiteral("x2"), number(shape.points.at(1).x() + shift.x()));
+        attributes.append(QStringLiteral("y2"), number(shape.points.at(1).y() + shift.y()));
+        break;
+    case Shape::Polyline:
+    case Shape::Polygon:
+        attributes.append(QStringLiteral("points"), pointList(shape.points, shift));
+        break;
+    case Shape::Rect:
+        attributes.append(QStringLiteral("x"), number(shape.rect.x() + shift.x()));
+        attributes.append(QStringLiteral("y"), number(shape.rect.y() + shift.y()));
+        attributes.append(QStringLiteral("width"), number(shape.rect.width()));
+        attributes.append(QStringLiteral("height"), number(shape.rect.height()));
+        break;
+    case Shape::Ellipse:
+        attributes.append(QStringLiteral("cx"), number(shape.rect.center().x() + shift.x()));
+        attributes.append(QStringLiteral("cy"), number(shape.rect.center().y() + shift.y()));
+        if (shape.rect.width() == shape.rect.height()) {
+            attributes.append(QStringLiteral("r"), number(shape.rect.width() / 2));
+        } else {
+            attributes.append(QStringLiteral("rx"), number(shape.rect.width() / 2));
+            attributes.append(QStringLiteral("ry"), number(shape.rect.height() / 2));
+        }
+        break;
+    case Shape::Path:
+        attributes.append(QStringLiteral("d"), pathData(shape.path, shift));
+        break;
+    case Shape::Text:
+        attributes.append(QStringLiteral("x"), number(shape.rect.x() + shift.x()));
+        attributes.append(QStringLiteral("y"), number(shape.rect.y() + shift.y()));
+        break;
+    case Shape::Image:
+        break;
+    }
+    return attributes;
+}
+
+QByteArray SvgWriter::geometryKey(const QString &tag, const QString &styleClass, const QXmlStreamAttributes &attributes)
+{
+    QString text = tag + QLatin1Char('|') + styleClass;
+    for (const QXmlStreamAttribute &attribute : attributes) {
+        text += QLatin1Char('|') + attribute.name() + QLatin1Char('=') + attribute.value();
+    }
+    return QCryptographicHash::hash(text.toUtf8(), QCryptographicHash::Sha1);
+}
+
+bool SvgWriter::normalizable(const Shape &shape)
+{
+    return shape.kind != Shape::Text && shape.kind != Shape::Image;
+}
+
+QPointF SvgWriter::symbolOrigin(const Shape &shape)
+{
+    // 取到两位小数，保证平移前后的坐标按同样的方式取整
+    const QPointF topLeft = geometryBounds(shape).topLeft();
+    return QPointF(std::round(topLeft.x() * 100.0) / 100.0, std::round(topLeft.y() * 100.0) / 100.0);
+}
+
+void SvgWriter::writeStyles(QXmlStreamWriter &xml)
+{
+    if (classOrder.isEmpty()) {
+        return;
+    }
+    QString css;
+    for (const QString &style : std::as_const(classOrder)) {
+        css += QLatin1Char('.') + classes.value(style) + QLatin1Char('{') + style + QStringLiteral("}\n");
+    }
+    xml.writeStartElement(QStringLiteral("style"));
+    xml.writeAttribute(QStringLiteral("type"), QStringLiteral("text/css"));
+    xml.writeCharacters(css);
+    xml.writeEndElement();
+}
+
+void SvgWriter::writeDefs(QXmlStreamWriter &xml)
+{
+    if (images.isEmpty() && geometries.isEmpty()) {
+        return;
+    }
+    xml.writeStartElement(QStringLiteral("defs"));
+
+    for (const QString &key : std::as_const(imageOrder)) {
+        const ImageDef &def = images[key];
+        QString href;
+        if (!def.linkPath.isEmpty()) {
+            href = QUrl::fromLocalFile(def.linkPath).toString();
+        } else if (!def.svgPath.isEmpty()) {
+            QFile svgFile(def.svgPath);
+            if (svgFile.open(QIODevice::ReadOnly)) {
+                href = QStringLiteral("data:image/svg+xml;base64,") + QString::fromLatin1(svgFile.readAll().toBase64());
+            } else {
+                qCWarning(lcIo) << "Cannot read SVG for embedding, linking instead:" << def.svgPath;
+                href = QUrl::fromLocalFile(def.svgPath).toString();
+            }
+        } else {
+            QByteArray png;
+            QBuffer buffer(&png);
+            buffer.open(QIODevice::WriteOnly);
+            def.image.save(&buffer, "PNG");
+            href = QStringLiteral("data:image/png;base64,") + QString::fromLatin1(png.toBase64());
+        }
+        xml.writeEmptyElement(QStringLiteral("image"));
+        xml.writeAttribute(QStringLiteral("id"), def.id);
+        xml.writeAttribute(QStringLiteral("width"), number(def.size.width()));
+        xml.writeAttribute(QStringLiteral("height"), number(def.size.height()));
+        xml.writeAttribute(QStringLiteral("preserveAspectRatio"), QStringLiteral("none"));
+        xml.writeAttribute(XlinkNamespace, QStringLiteral("href"), href);
+    }
+
+    // 重复几何：按首次出现的位置重新生成一次，坐标平移到包围盒左上角为原点
+    QVector<const GeometryUse*> symbols;
+    for (const GeometryUse &use : std::as_const(geometries)) {
+        symbols.append(&use);
+    }
+    std::sort(symbols.begin(), symbols.end(), [](const GeometryUse *a, const GeometryUse *b) {
+        return a->item != b->item ? a->item < b->item : a->shape < b->shape;
+    });
+    int shapesItem = -1;
+    QVector<Shape> shapes;
+    for (const GeometryUse *use : std::as_const(symbols)) {
+        if (use->item != shapesItem) {
+            shapes = shapesFor(items.at(use->item));
+            shapesItem = use->item;
+        }
+        const Shape &shape = shapes.at(use->shape);
+        xml.writeStartElement(QStringLiteral("symbol"));
+        xml.writeAttribute(QStringLiteral("id"), use->id);
+        xml.writeAttribute(QStringLiteral("overflow"), QStringLiteral("visible"));
+        writeElement(xml, shape, classes.value(styleOf(shape)), -symbolOrigin(shape), QTransform());
+        xml.writeEndElement();
+    }
+    xml.writeEndElement();
+}
+
+void SvgWriter::writeShape(QXmlStreamWriter &xml, const Shape &shape)
+{
+    ++counters.elements;
+    if (shape.kind == Shape::Image) {
+        const ImageDef &def = images[shape.imageKey];
+        if (def.size.isEmpty()) {
+            return;
+        }
+        xml.writeEmptyElement(QStringLiteral("use"));
+        xml.writeAttribute(XlinkNamespace, QStringLiteral("href"), QLatin1Char('#') + def.id);
+        // 图片按自身尺寸定义，缩放到放置区域
+        const QTransform placement(shape.rect.width() / def.size.width(), 0, 0, shape.rect.height() / def.size.height(),
+                                   shape.rect.x(), shape.rect.y());
+        writePlacement(xml, placement * shape.transform, true);
+        if (shape.opacity < 1.0) {
+            xml.writeAttribute(QStringLiteral("opacity"), number(shape.opacity));
+        }
+        return;
+    }
+
+    const QString styleClass = classes.value(styleOf(shape));
+    if (normalizable(shape) && !geometries.isEmpty()) {
+        const QPointF origin = symbolOrigin(shape);
+        const QXmlStreamAttributes attributes = geometry(shape, -origin);
+        if (attributesLength(attributes) >= MinSymbolLength) {
+            const auto it = geometries.constFind(geometryKey(tagOf(shape), styleClass, attributes));
+            if (it != geometries.constEnd()) {
+                xml.writeEmptyElement(QStringLiteral("use"));
+                xml.writeAttribute(XlinkNamespace, QStringLiteral("href"), QLatin1Char('#') + it->id);
+                writePlacement(xml, QTransform::fromTranslate(origin.x(), origin.y()) * shape.transform, true);
+                ++counters.uses;
+                return;
+            }
+        }
+    }
+
+    // 只有平移时直接并入坐标，否则写出变换矩阵
+    if (shape.transform.type() <= QTransform::TxTranslate) {
+        writeElement(xml, shape, styleClass, QPointF(shape.transform.dx(), shape.transform.dy()), QTransform());
+    } else {
+        writeElement(xml, shape, styleClass, QPointF(), shape.transform);
+    }
+}
+
+void SvgWriter::writeElement(QXmlStreamWriter &xml, const Shape &shape, const QString &styleClass,
+                             const QPointF &shift, const QTransform &transform)
+{
+    xml.writeStartElement(tagOf(shape));
+    if (!styleClass.isEmpty()) {
+        xml.writeAttribute(QStringLiteral("class"), styleClass);
+    }
+    xml.writeAttributes(geometry(shape, shift));
+    writePlacement(xml, transform, false);
+    if (shape.kind == Shape::Text) {
+        xml.writeCharacters(shape.text);
+    }
+    xml.writeEndElement();
+}
+
+void SvgWriter::writePlacement(QXmlStreamWriter &xml, const QTransform &transform, bool allowPosition)
+{
+    if (transform.type() <= QTransform::TxTranslate) {
+        // allowPosition 为 false 时调用方已把平移并入坐标
+        if (allowPosition) {
+            if (number(transform.dx()) != QLatin1String("0")) {
+                xml.writeAttribute(QStringLiteral("x"), number(transform.dx()));
+            }
+            if (number(transform.dy()) != QLatin1String("0")) {
+                xml.writeAttribute(QStringLiteral("y"), number(transform.dy()));
+            }
+        }
+        return;
+    }
+    // SVG 的 matrix(a b c d e f) 对应 QTransform 的仿射部分
+    xml.writeAttribute(QStringLiteral("transform"), QStringLiteral("matrix(%1 %2 %3 %4 %5 %6)")
+                       .arg(factor(transform.m11()), factor(transform.m12()), factor(transform.m21()),
+                            factor(transform.m22()), number(transform.dx()), number(transform.dy())));
+}
@@ -0,0 +1,113 @@
+#ifndef SVG_WRITER_H
+#define SVG_WRITER_H
+
+#include <QCoreApplication>
+#include <QGraphicsScene>
+#include <QXmlStreamAttributes>
+#include <QByteArray>
+#include <QHash>
+#include <QImage>
+#include <QList>
+#include <QVector>
+#include <QPolygonF>
+#include <QPainterPath>
+#include <QTransform>
+#include <QPen>
+#include <QBrush>
+#include <QFont>
+
+class QXmlStreamWriter;
+
+// 原生 SVG 导出：直接遍历图元写出对应的 SVG 元素，边生成边写入文件，不经过 QPainter 录制。
+// 相同的画笔/画刷组合合并为共享的 CSS 类；平移后几何相同的图形只在 <defs> 中写一次 <symbol>，
+// 其余位置用 <use> 引用；画布大小取实际内容的包围盒。第一遍只统计样式和几何哈希，第二遍写出。
+class SvgWriter
+{
+    Q_DECLARE_TR_FUNCTIONS(SvgWriter)
+public:
+    explicit SvgWriter(QGraphicsScene *scene);
+
+    bool write(const QString &filePath); // 失败时返回 false，原因见 errorString()
+    QString errorString() const { return error; }
+
+    struct Stats {
+        int elements = 0; // 写出的图形元素数（含 <use>）
+        int classes = 0;  // 共享样式类数
+        int symbols = 0;  // 重复几何的 <symbol> 数
+        int uses = 0;     // 引用 <symbol> 的次数
+        qint64 bytes = 0;
+    };
+    Stats stats() const { return counters; }
+
+    static constexpr int MinSymbolLength = 64;  // 几何描述短于此长度时直接写出，<use> 并不更短
+    static constexpr int MaxRasterSide = 4096;  // 无法矢量化的图元栅格化后的边长上限（像素）
+    static constexpr qreal RasterScale = 2.0;   // 栅格化时每场景单位的像素数
+
+private:
+    // 一个待写出的图形：本地坐标下的几何、样式和到场景的变换
+    struct Shape {
+        enum Kind { Line, Polyline, Polygon, Rect, Ellipse, Path, Text, Image };
+        Kind kind = Path;
+        QPolygonF points;  // Line 为两个端点，Polyline/Polygon 为顶点
+        QRectF rect;       // Rect/Ellipse；Image 为放置区域
+        QPainterPath path; // Path
+        QString text;      // Text：基线起点为 rect.topLeft()
+        QFont font;
+        QPen pen = Qt::NoPen;
+        QBrush brush;
+        Qt::FillRule fillRule = Qt::OddEvenFill; // Polygon/Path 有填充时需要
+        qreal opacity = 1.0;
+        QString imageKey;  // Image：图片表中的键
+        QTransform transform;
+    };
+    // <defs> 中的一张图片：内嵌 PNG、内嵌 SVG 数据或外部文件链接
+    struct ImageDef {
+        QString id;
+        QImage image;
+        QString svgPath;
+        QString linkPath;
+        QSizeF size;
+    };
+    // 可做 <symbol> 的几何：出现次数和首次出现的位置
+    struct GeometryUse {
+        int count = 0;
+        int item = 0;
+        int shape = 0;
+        QString id;
+    };
+
+    void collectItems();
+    QVector<Shape> shapesFor(QGraphicsItem *item);
+    void addRasterShape(QGraphicsItem *item, QVector<Shape> &shapes);
+    QString registerImage(const QString &key, const ImageDef &def);
+
+    static QString styleOf(const Shape &shape);
+    static QString tagOf(const Shape &shape);
+    static QRectF geometryBounds(const Shape &shape);
+    static QXmlStreamAttributes geometry(const Shape &shape, const QPointF &shift);
+    static QByteArray geometryKey(const QString &tag, const QString &styleClass, const QXmlStreamAttributes &attributes);
+    static bool normalizable(const Shape &shape);
+    static QPointF symbolOrigin(const Shape &shape);
+
+    void writeStyles(QXmlStreamWriter &xml);
+    void writeDefs(QXmlStreamWriter &xml);
+    void writeShape(QXmlStreamWriter &xml, const Shape &shape);
+    void writeElement(QXmlStreamWriter &xml, const Shape &shape, const QString &styleClass, const QPointF &shift,
+                      const QTransform &transform);
+    static void writePlacement(QXmlStreamWriter &xml, const QTransform &transform, bool allowPosition);
+
+    QGraphicsScene *scene;
+    QList<QGraphicsItem*> items; // 按绘制顺序（自底向上）
+    QRectF contentBounds;
+
+    QHash<QString, QString> classes; // CSS 声明 -> 类名
+    QVector<QString> classOrder;     // 按出现顺序的 CSS 声明
+    QHash<QString, ImageDef> images; // 图片键 -> 定义
+    QVector<QString> imageOrder;
+    QHash<QByteArray, GeometryUse> geometries;
+
+    QString error;
+    Stats counters;
+};
+
+#endif // SVG_WRITER_H
@@ -0,0 +1,311 @@
+#include "tile_pyramid_exporter.h"
+#include "scene_change_log.h"
+#include "logging_categories.h"
+#include <QFutureWatcher>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QPainter>
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QFile>
+#include <QDir>
+#include <QSet>
+#include <QThread>
+#include <QTimer>
+#include <QtConcurrent>
+#include <QtMath>
+#include <QDebug>
+#include <cmath>
+
+namespace {
+
+QString metadataPath(const QString &directory)
+{
+    return directory + QStringLiteral("/tiles.json");
+}
+
+bool isTransparent(const QImage &image)
+{
+    for (int y = 0; y < image.height(); ++y) {
+        const QRgb *line = reinterpret_cast<const QRgb*>(image.constScanLine(y));
+        for (int x = 0; x < image.width(); ++x) {
+            if (qAlpha(line[x]) != 0) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+// 工作线程：回放瓦片的录制结果并写成 PNG；全透明的瓦片删除旧文件而不写入
+QString writeTile(const QPicture &picture, const QString &path)
+{
+    QImage image(TilePyramidExporter::TileSize, TilePyramidExporter::TileSize, QImage::Format_ARGB32_Premultiplied);
+    image.fill(Qt::transparent);
+    QPainter painter(&image);
+    painter.drawPicture(0, 0, picture);
+    painter.end();
+    if (isTransparent(image)) {
+        QFile::remove(path);
+        return QString();
+    }
+    if (!QDir().mkpath(QFileInfo(path).path())) {
+        return TilePyramidExporter::tr("无法创建目录：%1").arg(QFileInfo(path).path());
+    }
+    // 先写临时文件再替换，查看器不会读到写了一半的瓦片
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || !image.save(&file, "PNG") || !file.commit()) {
+        return TilePyramidExporter::tr("无法写入瓦片：%1").arg(path);
+    }
+    return QString();
+}
+
+} // namespace
+
+qreal TilePyramidExporter::Geometry::scale(int z) const
+{
+    return std::ldexp(1.0, z - maxZoom);
+}
+
+QRectF TilePyramidExporter::Geometry::tileRect(int z, int x, int y) const
+{
+    const qreal span = TileSize / scale(z);
+    return QRectF(origin.x() + x * span, origin.y() + y * span, span, span);
+}
+
+bool TilePyramidExporter::Geometry::covers(const QRectF &rect) const
+{
+    return isValid() && tileRect(0, 0, 0).contains(rect);
+}
+
+TilePyramidExporter::TilePyramidExporter(QGraphicsScene *scene, SceneChangeLog *changeLog, QObject *parent)
+    : QObject(parent),
+    scene(scene),
+    changeLog(changeLog)
+{
+}
+
+TilePyramidExporter::Geometry TilePyramidExporter::geometryFor(const QRectF &contentRect)
+{
+    // 第 0 级的一块瓦片覆盖全部内容，最大层级为 1:1
+    Geometry geometry;
+    geometry.origin = QPointF(std::floor(contentRect.left()), std::floor(contentRect.top()));
+    const qreal side = qMax(contentRect.right() - geometry.origin.x(), contentRect.bottom() - geometry.origin.y());
+    geometry.maxZoom = qMax(0, qCeil(std::log2(side / TileSize)));
+    return geometry;
+}
+
+bool TilePyramidExporter::start(const QString &directory, const QRectF &contentRect)
+{
+    if (running || !scene || !changeLog) {
+        return false;
+    }
+    error.clear();
+    if (contentRect.isEmpty()) {
+        error = tr("没有可导出的内容");
+        return false;
+    }
+    if (!QDir().mkpath(directory)) {
+        error = tr("无法创建目录：%1").arg(directory);
+        return false;
+    }
+    this->directory = directory;
+    content = contentRect;
+    serialAtStart = changeLog->serial();
+
+    // 同一运行中完整导出过、且内容仍在原金字塔范围内时，只处理之后变化过的区域
+    Geometry previous;
+    bool complete = false;
+    QString session;
+    quint64 serial = 0;
+    QVector<QRectF> regions;
+    const bool hasPrevious = readMetadata(previous, complete, session, serial);
+    incremental = hasPrevious && complete && session == changeLog->session().toString() && previous.covers(contentRect)
+                  && changeLog->changesSince(serial, regions);
+    if (incremental) {
+        geometry = previous;
+    } else {
+        geometry = geometryFor(contentRect);
+        regions = { contentRect };
+        if (hasPrevious) {
+            // 旧金字塔（包括上次未完成的）的层级目录整体删除，内容范围外的旧瓦片也随之清除；其他文件不动
+            for (int z = 0; z <= previous.maxZoom; ++z) {
+                QDir(directory + QLatin1Char('/') + QString::number(z)).removeRecursively();
+            }
+        }
+    }
+    // 写瓦片前先记下本次的几何并标记为未完成：中途取消或失败时，下次导出据此删除已写的层级目录并全量处理
+    if (!writeMetadata(false)) {
+        error = tr("无法写入 %1").arg(metadataPath(directory));
+        return false;
+    }
+
+    collectTiles(regions);
+    nextTile = 0;
+    inFlight = 0;
+    done = 0;
+    lastProgress = -1;
+    running = true;
+    qCInfo(lcIo) << "Tile pyramid export started:" << directory << (incremental ? "incremental," : "full,")
+                 << tiles.size() << "tiles, max zoom" << geometry.maxZoom;
+    QTimer::singleShot(0, this, &TilePyramidExporter::dispatch);
+    return true;
+}
+
+void TilePyramidExporter::cancel()
+{
+    if (!running) {
+        return;
+    }
+    finish(tr("导出已取消"));
+}
+
+void TilePyramidExporter::collectTiles(const QVector<QRectF> &regions)
+{
+    // 每一级取与区域相交的瓦片（向外扩一个像素，包含抗锯齿的边缘），粗层级在前，查看器先得到概览
+    tiles.clear();
+    const QRectF pyramid = geometry.tileRect(0, 0, 0);
+    for (int z = 0; z <= geometry.maxZoom; ++z) {
+        const qreal scale = geometry.scale(z);
+        const qreal span = TileSize / scale;
+        const int last = (1 << z) - 1;
+        QSet<quint64> seen;
+        for (const QRectF &region : regions) {
+            const QRectF rect = region.adjusted(-1 / scale, -1 / scale, 1 / scale, 1 / scale) & pyramid;
+            if (rect.isEmpty()) {
+                continue;
+            }
+            const int firstX = qBound(0, qFloor((rect.left() - geometry.origin.x()) / span), last);
+            const int lastX = qBound(0, qFloor((rect.right() - geometry.origin.x()) / span), last);
+            const int firstY = qBound(0, qFloor((rect.top() - geometry.origin.y()) / span), last);
+            const int lastY = qBound(0, qFloor((rect.bottom() - geometry.origin.y()) / span), last);
+            for (int y = firstY; y <= lastY; ++y) {
+                for (int x = firstX; x <= lastX; ++x) {
+                    const quint64 key = (quint64(quint32(x)) << 32) | quint32(y);
+                    if (!seen.contains(key)) {
+                        seen.insert(key);
+                        tiles.append(Tile{z, x, y});
+                    }
+                }
+            }
+        }
+    }
+}
+
+QString TilePyramidExporter::tilePath(const Tile &tile) const
+{
+    return QStringLiteral("%1/%2/%3/%4.png").arg(directory).arg(tile.z).arg(tile.x).arg(tile.y);
+}
+
+void TilePyramidExporter::dispatch()
+{
+    // 录制必须在 GUI 线程（图元的 paint 不是线程安全的），回放、编码和写盘交给线程池
+    const int maxInFlight = qMax(1, QThread::idealThreadCount()) + ExtraJobs;
+    const bool hasBackground = scene->backgroundBrush().style() != Qt::NoBrush;
+    while (running && inFlight < maxInFlight && nextTile < tiles.size()) {
+        const Tile tile = tiles.at(nextTile++);
+        const QString path = tilePath(tile);
+        const QRectF rect = geometry.tileRect(tile.z, tile.x, tile.y);
+        // 没有任何图元的瓦片不必渲染，删除可能存在的旧文件即可
+        if (!hasBackground && scene->items(rect, Qt::IntersectsItemBoundingRect).isEmpty()) {
+            QFile::remove(path);
+            ++done;
+            continue;
+        }
+        QPicture picture;
+        QPainter painter(&picture);
+        painter.setRenderHints(QPainter::Antialiasing | QPainter::SmoothPixmapTransform | QPainter::TextAntialiasing);
+        scene->render(&painter, QRectF(0, 0, TileSize, TileSize), rect, Qt::IgnoreAspectRatio);
+        painter.end();
+
+        ++inFlight;
+        QFutureWatcher<QString> *watcher = new QFutureWatcher<QString>(this);
+        connect(watcher, &QFutureWatcher<QString>::finished, this, [this, watcher]() {
+            const QString tileError = watcher->result();
+            watcher->deleteLater();
+            tileDone(tileError);
+        });
+        watcher->setFuture(QtConcurrent::run(writeTile, picture, path));
+    }
+    if (!running) {
+        return;
+    }
+    const int progress = tiles.isEmpty() ? 100 : int(qint64(done) * 100 / tiles.size());
+    if (progress != lastProgress) {
+        lastProgress = progress;
+        emit progressChanged(progress);
+    }
+    if (done == tiles.size()) {
+        finish(QString());
+    }
+}
+
+void TilePyramidExporter::tileDone(const QString &tileError)
+{
+    --inFlight;
+    ++done;
+    if (!running) {
+        return;
+    }
+    if (!tileError.isEmpty()) {
+        finish(tileError);
+        return;
+    }
+    dispatch();
+}
+
+bool TilePyramidExporter::readMetadata(Geometry &geometry, bool &complete, QString &session, quint64 &serial) const
+{
+    QFile file(metadataPath(directory));
+    if (!file.open(QIODevice::ReadOnly)) {
+        return false;
+    }
+    const QJsonObject info = QJsonDocument::fromJson(file.readAll()).object();
+    if (info.value(QStringLiteral("version")).toInt() != MetadataVersion
+        || info.value(QStringLiteral("tileSize")).toInt() != TileSize) {
+        return false;
+    }
+    const QJsonArray origin = info.value(QStringLiteral("origin")).toArray();
+    geometry.origin = QPointF(origin.at(0).toDouble(), origin.at(1).toDouble());
+    geometry.maxZoom = info.value(QStringLiteral("maxZoom")).toInt(-1);
+    complete = info.value(QStringLiteral("complete")).toBool(true); // 早先写的元数据没有该字段，都是完成时写入的
+    session = info.value(QStringLiteral("session")).toString();
+    serial = quint64(info.value(QStringLiteral("serial")).toDouble());
+    return geometry.isValid();
+}
+
+bool TilePyramidExporter::writeMetadata(bool complete) const
+{
+    // 查看器需要的层级、瓦片尺寸和内容范围（最大层级的像素坐标），以及增量导出用的完成标记、会话和序号
+    QJsonObject info;
+    info.insert(QStringLiteral("version"), MetadataVersion);
+    info.insert(QStringLiteral("tileSize"), TileSize);
+    info.insert(QStringLiteral("minZoom"), 0);
+    info.insert(QStringLiteral("maxZoom"), geometry.maxZoom);
+    info.insert(QStringLiteral("origin"), QJsonArray{ geometry.origin.x(), geometry.origin.y() });
+    info.insert(QStringLiteral("bounds"), QJsonArray{ content.left() - geometry.origin.x(), content.top() - geometry.origin.y(),
+                                                      content.width(), content.height() });
+    info.insert(QStringLiteral("session"), changeLog->session().toString());
+    info.insert(QStringLiteral("serial"), double(serialAtStart));
+    info.insert(QStringLiteral("complete"), complete);
+
+    QSaveFile file(metadataPath(directory));
+    if (!file.open(QIODevice::WriteOnly)) {
+        return false;
+    }
+    file.write(QJsonDocument(info).toJson());
+    return file.commit();
+}
+
+void TilePyramidExporter::finish(const QString &error)
+{
+    running = false;
+    QString result = error;
+    if (result.isEmpty() && !writeMetadata(true)) {
+        result = tr("无法写入 %1").arg(metadataPath(directory));
+    }
+    this->error = result;
+    qCInfo(lcIo) << "Tile pyramid export finished," << done << "of" << tiles.size() << "tiles." << result;
+    emit finished(result);
+}
@@ -0,0 +1,81 @@
+#ifndef TILE_PYRAMID_EXPORTER_H
+#define TILE_PYRAMID_EXPORTER_H
+
+#include <QObject>
+#include <QGraphicsScene>
+#include <QPicture>
+#include <QPointF>
+#include <QRectF>
+#include <QVector>
+
+class SceneChangeLog;
+
+// 瓦片金字塔导出：把场景内容写成 <目录>/<z>/<x>/<y>.png，供可缩放的网页查看器使用。
+// 最大层级按 1:1 比例，每降一级缩小一半，第 0 级整个内容落在一块瓦片内；空白瓦片不写文件。
+// GUI 线程逐块录制瓦片，线程池并行回放、编码并写盘。目录中的 tiles.json 记录几何和导出时的变化序号，
+// 开始写瓦片前先标记为未完成，全部写完后才标记完成；再次导出到同一目录时，上次已完成的只重新渲染
+// 与之后变化区域相交的瓦片，否则（含上次取消或失败）按记录的几何删除旧层级目录后全量导出。
+class TilePyramidExporter : public QObject
+{
+    Q_OBJECT
+public:
+    TilePyramidExporter(QGraphicsScene *scene, SceneChangeLog *changeLog, QObject *parent = nullptr);
+
+    // 导出 contentRect（场景坐标）到 directory；目录无法创建时返回 false，原因见 errorString()
+    bool start(const QString &directory, const QRectF &contentRect);
+    void cancel();
+    bool isRunning() const { return running; }
+    bool isIncremental() const { return incremental; }
+    int tileCount() const { return tiles.size(); } // 本次需要处理的瓦片数
+    QString errorString() const { return error; }
+
+    static constexpr int TileSize = 256;
+    static constexpr int ExtraJobs = 2; // 在途瓦片数 = 线程数 + ExtraJobs
+    static constexpr int MetadataVersion = 1;
+
+signals:
+    void progressChanged(int percent);
+    void finished(const QString &error); // error 为空表示成功
+
+private:
+    struct Tile {
+        int z = 0;
+        int x = 0;
+        int y = 0;
+    };
+    // 金字塔的几何：最大层级下 1 场景单位为 1 像素，origin 为第 0 列/行瓦片的左上角
+    struct Geometry {
+        QPointF origin;
+        int maxZoom = -1;
+        bool isValid() const { return maxZoom >= 0; }
+        qreal scale(int z) const;                  // z 级下每场景单位的像素数
+        QRectF tileRect(int z, int x, int y) const; // 瓦片覆盖的场景区域
+        bool covers(const QRectF &rect) const;     // 整个金字塔范围是否包含 rect
+    };
+
+    static Geometry geometryFor(const QRectF &contentRect);
+    bool readMetadata(Geometry &geometry, bool &complete, QString &session, quint64 &serial) const;
+    bool writeMetadata(bool complete) const;
+    void collectTiles(const QVector<QRectF> &regions);
+    QString tilePath(const Tile &tile) const;
+    void dispatch();
+    void tileDone(const QString &tileError);
+    void finish(const QString &error);
+
+    QGraphicsScene *scene;
+    SceneChangeLog *changeLog;
+    QString directory;
+    QRectF content;
+    Geometry geometry;
+    quint64 serialAtStart = 0;
+    bool incremental = false;
+    QVector<Tile> tiles;
+    int nextTile = 0;
+    int inFlight = 0;
+    int done = 0;
+    bool running = false;
+    int lastProgress = -1;
+    QString error;
+};
+
+#endif // TILE_PYRAMID_EXPORTER_H
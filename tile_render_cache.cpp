@@ -0,0 +1,460 @@
+#include "tile_render_cache.h"
+#include "logging_categories.h"
+#include "render_quality.h"
+#include "raster_pyramid_item.h"
+#include "svg_tile_item.h"
+#include "baked_layer_item.h"
+#include "custom_rect_item.h"
+#include "scene_item_events.h"
+#include <QGraphicsScene>
+#include <QStyleOptionGraphicsItem>
+#include <QPainter>
+#include <QPicture>
+#include <QFutureWatcher>
+#include <QtConcurrent>
+#include <QThread>
+#include <QtMath>
+#include <QDebug>
+#include <cmath>
+
+namespace {
+
+constexpr int FractionSteps = 64; // 视口平移小数部分的量化精度
+
+// 工作线程：回放快照得到一块瓦片的各层，只读取传入的数据；没有快照的层为空图片
+QVector<QImage> renderTile(const QVector<QVector<TileRenderCache::Entry>> &layers, const QPointF &origin, qreal dpr)
+{
+    const int size = qCeil(TileRenderCache::TileSize * dpr);
+    QVector<QImage> images;
+    images.reserve(layers.size());
+    for (const QVector<TileRenderCache::Entry> &entries : layers) {
+        if (entries.isEmpty()) {
+            images.append(QImage());
+            continue;
+        }
+        QImage image(size, size, QImage::Format_ARGB32_Premultiplied);
+        image.setDevicePixelRatio(dpr);
+        image.fill(Qt::transparent);
+
+        QPainter painter(&image);
+        painter.setRenderHints(QPainter::Antialiasing | QPainter::SmoothPixmapTransform); // 瓦片始终使用完整质量
+        // 快照已包含档位缩放，回放时只需平移到瓦片原点
+        const QTransform levelToTile = QTransform::fromTranslate(origin.x(), origin.y());
+        for (const TileRenderCache::Entry &entry : entries) {
+            // 每个线程使用自己的 QPicture 副本，回放会修改其内部读取位置
+            QPicture picture;
+            picture.setData(entry.picture.constData(), uint(entry.picture.size()));
+            painter.setTransform(levelToTile);
+            painter.setOpacity(entry.opacity);
+            painter.drawPicture(0, 0, picture);
+        }
+        painter.end();
+        images.append(image);
+    }
+    return images;
+}
+
+} // namespace
+
+TileRenderCache::TileRenderCache(QGraphicsView *view)
+    : QObject(view),
+    view(view)
+{
+    settleTimer.setSingleShot(true);
+    settleTimer.setInterval(LevelSettleMs);
+    connect(&settleTimer, &QTimer::timeout, this, [this]() {
+        this->view->viewport()->update(); // 缩放已停止，重绘时开始渲染新档位
+    });
+}
+
+void TileRenderCache::setEnabled(bool enabled)
+{
+    if (this->enabled == enabled) {
+        return;
+    }
+    this->enabled = enabled;
+    disconnect(sceneConnection);
+    clear();
+    if (enabled && view->scene()) {
+        // 监听 changed 会让场景改为按区域通知视图，但瓦片作废需要知道变化区域；
+        // 经 SceneItemEvents 转发，移除图元只作废它占据的瓦片
+        sceneConnection = connect(SceneItemEvents::of(view->scene()), &SceneItemEvents::changed, this, &TileRenderCache::sceneChanged);
+    }
+    view->viewport()->update();
+    qCDebug(lcView) << "Tile render cache" << (enabled ? "enabled." : "disabled.");
+}
+
+bool TileRenderCache::canRender() const
+{
+    return enabled && view->scene() && view->viewportTransform().type() <= QTransform::TxScale
+           && view->viewportTransform().m11() > 0 && view->viewportTransform().m22() > 0;
+}
+
+void TileRenderCache::clear()
+{
+    tiles.clear();
+    jobs.clear(); // 渲染中的结果回来后会被丢弃
+    snapshots.clear();
+    snapshotScaleKey = 0;
+    pendingTiles.clear();
+    tileBytes = 0;
+}
+
+void TileRenderCache::notePan(int dx, int dy)
+{
+    // 内容向左移动时新内容从右侧进入，预取方向与滚动方向相反
+    panDirection = QPoint(dx < 0 ? 1 : (dx > 0 ? -1 : 0), dy < 0 ? 1 : (dy > 0 ? -1 : 0));
+}
+
+TileRenderCache::Frame TileRenderCache::currentFrame() const
+{
+    const QTransform transform = view->viewportTransform();
+    Frame frame;
+    frame.scale = transform.m11();
+    frame.dpr = view->viewport()->devicePixelRatioF();
+
+    const qreal floorX = std::floor(transform.dx());
+    const qreal floorY = std::floor(transform.dy());
+    int fractionX = qRound((transform.dx() - floorX) * FractionSteps);
+    int fractionY = qRound((transform.dy() - floorY) * FractionSteps);
+    frame.offset = QPoint(int(floorX) + fractionX / FractionSteps, int(floorY) + fractionY / FractionSteps);
+    fractionX %= FractionSteps;
+    fractionY %= FractionSteps;
+    frame.fraction = QPointF(qreal(fractionX) / FractionSteps, qreal(fractionY) / FractionSteps);
+
+    frame.level.scaleKey = qRound64(std::log2(frame.scale) * (1 << 20));
+    frame.level.fractionX = fractionX;
+    frame.level.fractionY = fractionY;
+    frame.level.dprKey = qRound(frame.dpr * 100);
+    return frame;
+}
+
+QRect TileRenderCache::tileViewportRect(const Frame &frame, int x, int y) const
+{
+    return QRect(frame.offset.x() + x * TileSize, frame.offset.y() + y * TileSize, TileSize, TileSize);
+}
+
+QRectF TileRenderCache::tileSceneRect(const Frame &frame, int x, int y) const
+{
+    // 档位像素坐标 = 场景坐标 * 缩放 + 小数平移
+    const qreal left = (x * TileSize - frame.fraction.x()) / frame.scale;
+    const qreal top = (y * TileSize - frame.fraction.y()) / frame.scale;
+    return QRectF(left, top, TileSize / frame.scale, TileSize / frame.scale);
+}
+
+void TileRenderCache::paint(QPainter *painter, const QRegion &exposedRegion)
+{
+    const Frame frame = currentFrame();
+    ++frameCounter;
+
+    // 整个视口范围内的瓦片，渲染排队按视口而不是本次重绘区域计算
+    const QRect viewportRect = view->viewport()->rect();
+    const int firstX = qFloor(qreal(viewportRect.left() - frame.offset.x()) / TileSize);
+    const int lastX = qFloor(qreal(viewportRect.right() - frame.offset.x()) / TileSize);
+    const int firstY = qFloor(qreal(viewportRect.top() - frame.offset.y()) / TileSize);
+    const int lastY = qFloor(qreal(viewportRect.bottom() - frame.offset.y()) / TileSize);
+
+    QVector<QPoint> missing;
+    QRegion liveRegion;
+    for (int y = firstY; y <= lastY; ++y) {
+        for (int x = firstX; x <= lastX; ++x) {
+            const TileKey key{frame.level, x, y};
+            auto it = tiles.find(key);
+            const QRect rect = tileViewportRect(frame, x, y);
+            if (it != tiles.end()) {
+                it->lastUsed = frameCounter;
+                if (exposedRegion.intersects(rect)) {
+                    if (it->layers.size() == 1) {
+                        painter->drawImage(rect.topLeft(), it->layers.first());
+                    } else {
+                        paintLayers(painter, frame, *it, rect);
+                    }
+                }
+                continue;
+            }
+            if (!jobs.contains(key)) {
+                missing.append(QPoint(x, y));
+            }
+            liveRegion += rect;
+        }
+    }
+
+    // 未就绪的瓦片当帧直接绘制场景
+    liveRegion &= exposedRegion;
+    if (!liveRegion.isEmpty()) {
+        const QTransform toScene = view->viewportTransform().inverted();
+        for (const QRect &rect : liveRegion) {
+            view->scene()->render(painter, QRectF(rect), toScene.mapRect(QRectF(rect)), Qt::IgnoreAspectRatio);
+        }
+    }
+
+    // 平移方向上的预取瓦片排在可见瓦片之后
+    if (!panDirection.isNull()) {
+        for (int step = 1; step <= PrefetchTiles; ++step) {
+            if (panDirection.x() != 0) {
+                const int x = panDirection.x() > 0 ? lastX + step : firstX - step;
+                for (int y = firstY; y <= lastY; ++y) {
+                    missing.append(QPoint(x, y));
+                }
+            }
+            if (panDirection.y() != 0) {
+                const int y = panDirection.y() > 0 ? lastY + step : firstY - step;
+                for (int x = firstX; x <= lastX; ++x) {
+                    missing.append(QPoint(x, y));
+                }
+            }
+        }
+    }
+
+    // 连续缩放时每帧都是新档位，等缩放停下后再渲染，避免为中间档位浪费线程
+    if (!hasLastLevel || frame.level != lastLevel) {
+        hasLastLevel = true;
+        lastLevel = frame.level;
+        pendingTiles.clear();
+        settleTimer.start();
+        return;
+    }
+    if (settleTimer.isActive()) {
+        return;
+    }
+    schedule(frame, missing);
+}
+
+bool TileRenderCache::paintsLive(const QGraphicsItem *item)
+{
+    // 这些图元按视图缩放选择自己的瓦片或分辨率，录制成快照会固定在录制时的细节
+    switch (item->type()) {
+    case RasterPyramidItem::Type:
+    case SvgTileItem::Type:
+    case BakedLayerItem::Type:
+        return true;
+    case QGraphicsRectItem::Type: {
+        const CustomRectItem *rectItem = dynamic_cast<const CustomRectItem*>(item);
+        return rectItem && rectItem->hasFillImage();
+    }
+    default:
+        return false;
+    }
+}
+
+QList<QGraphicsItem*> TileRenderCache::tileItems(const Frame &frame, const QRectF &sceneRect) const
+{
+    // 渲染和绘制分层时使用同一套筛选，层数与直接绘制的图元一一对应
+    const qreal margin = 1.0 / frame.scale;
+    QList<QGraphicsItem*> items = view->scene()->items(sceneRect.adjusted(-margin, -margin, margin, margin),
+                                                       Qt::IntersectsItemBoundingRect, Qt::AscendingOrder);
+    items.removeIf([](QGraphicsItem *item) {
+        return !item->isVisible() || (item->flags() & QGraphicsItem::ItemHasNoContents)
+               || item->effectiveOpacity() <= 0.0;
+    });
+    return items;
+}
+
+void TileRenderCache::paintLayers(QPainter *painter, const Frame &frame, const Tile &tile, const QRect &rect)
+{
+    // 瓦片各层之间按叠放次序插入直接绘制的图元；瓦片就绪后场景没有变化，图元列表与渲染时一致
+    const QList<QGraphicsItem*> items = tileItems(frame, tile.sceneRect);
+    int layer = 0;
+    painter->save();
+    painter->setClipRect(rect, Qt::IntersectClip);
+    for (QGraphicsItem *item : items) {
+        if (!paintsLive(item)) {
+            continue;
+        }
+        if (layer < tile.layers.size() && !tile.layers.at(layer).isNull()) {
+            painter->drawImage(rect.topLeft(), tile.layers.at(layer));
+        }
+        ++layer;
+        drawLive(painter, item, tile.sceneRect);
+    }
+    if (layer < tile.layers.size() && !tile.layers.at(layer).isNull()) {
+        painter->drawImage(rect.topLeft(), tile.layers.at(layer));
+    }
+    painter->restore();
+}
+
+void TileRenderCache::drawLive(QPainter *painter, QGraphicsItem *item, const QRectF &exposedSceneRect)
+{
+    QStyleOptionGraphicsItem option;
+    option.exposedRect = item->mapFromScene(exposedSceneRect).boundingRect() & item->boundingRect();
+    option.rect = option.exposedRect.toAlignedRect();
+    painter->save();
+    painter->setTransform(item->sceneTransform() * view->viewportTransform());
+    painter->setOpacity(item->effectiveOpacity());
+    item->paint(painter, &option, view->viewport());
+    painter->restore();
+}
+
+void TileRenderCache::schedule(const Frame &frame, const QVector<QPoint> &tiles)
+{
+    pendingFrame = frame;
+    pendingTiles.clear();
+    for (const QPoint &tile : tiles) {
+        const TileKey key{frame.level, tile.x(), tile.y()};
+        if (!this->tiles.contains(key) && !jobs.contains(key)) {
+            pendingTiles.append(tile);
+        }
+    }
+    // 同时进行的任务数不超过线程数，其余排队；排队内容每帧按当前视口刷新
+    const int maxJobs = qMax(1, QThread::idealThreadCount());
+    while (jobs.size() < maxJobs && !pendingTiles.isEmpty()) {
+        dispatch(pendingFrame, pendingTiles.takeFirst());
+    }
+}
+
+void TileRenderCache::dispatch(const Frame &frame, const QPoint &tile)
+{
+    const TileKey key{frame.level, tile.x(), tile.y()};
+    const QRectF sceneRect = tileSceneRect(frame, tile.x(), tile.y());
+
+    // 在 GUI 线程收集快照（按绘制顺序），工作线程只拿到不可变的数据；直接绘制的图元把快照分成多层
+    const qreal margin = 1.0 / frame.scale;
+    const qreal largeSide = LargeItemTiles * TileSize / frame.scale;
+    QVector<QVector<Entry>> layers(1);
+    for (QGraphicsItem *item : tileItems(frame, sceneRect)) {
+        if (paintsLive(item)) {
+            layers.append(QVector<Entry>());
+            continue;
+        }
+        // 大图元只录制瓦片内的部分，裁剪虚线等按可见区域生成的内容不会覆盖整个图元
+        const QRectF bounds = item->sceneBoundingRect();
+        if (bounds.width() > largeSide || bounds.height() > largeSide) {
+            layers.last().append(record(item, frame.scale, sceneRect.adjusted(-margin, -margin, margin, margin)));
+        } else {
+            layers.last().append(snapshotFor(item, frame));
+        }
+    }
+
+    const quint64 ticket = ++nextTicket;
+    jobs.insert(key, Job{ticket, sceneRect});
+    const QPointF origin(frame.fraction.x() - tile.x() * TileSize, frame.fraction.y() - tile.y() * TileSize);
+
+    QFutureWatcher<QVector<QImage>> *watcher = new QFutureWatcher<QVector<QImage>>(this);
+    connect(watcher, &QFutureWatcher<QVector<QImage>>::finished, this, [this, watcher, key, ticket]() {
+        tileRendered(key, ticket, watcher->result());
+        watcher->deleteLater();
+    });
+    watcher->setFuture(QtConcurrent::run(renderTile, layers, origin, frame.dpr));
+}
+
+void TileRenderCache::tileRendered(const TileKey &key, quint64 ticket, const QVector<QImage> &layers)
+{
+    auto job = jobs.find(key);
+    if (job == jobs.end() || job->ticket != ticket) {
+        return; // 渲染期间该区域已变化，结果作废
+    }
+    const QRectF sceneRect = job->sceneRect;
+    jobs.erase(job);
+
+    qint64 bytes = 0;
+    for (const QImage &layer : layers) {
+        bytes += layer.sizeInBytes();
+    }
+    tiles.insert(key, Tile{layers, sceneRect, frameCounter, bytes});
+    tileBytes += bytes;
+    evictToBudget();
+
+    // 只重绘当前档位下的这块瓦片
+    const Frame frame = currentFrame();
+    if (key.level == frame.level) {
+        view->viewport()->update(tileViewportRect(frame, key.x, key.y));
+    }
+    while (jobs.size() < qMax(1, QThread::idealThreadCount()) && !pendingTiles.isEmpty()) {
+        dispatch(pendingFrame, pendingTiles.takeFirst());
+    }
+}
+
+void TileRenderCache::evictToBudget()
+{
+    // 超出内存上限时淘汰最久未使用的瓦片
+    while (tileBytes > MemoryBudget && !tiles.isEmpty()) {
+        auto oldest = tiles.begin();
+        for (auto it = tiles.begin(); it != tiles.end(); ++it) {
+            if (it->lastUsed < oldest->lastUsed) {
+                oldest = it;
+            }
+        }
+        tileBytes -= oldest->bytes;
+        tiles.erase(oldest);
+    }
+}
+
+TileRenderCache::Entry TileRenderCache::record(QGraphicsItem *item, qreal scale, const QRectF &exposedSceneRect) const
+{
+    // 录制时使用完整质量（交互模式只影响 GUI 线程的实时绘制）；
+    // 世界变换带上档位缩放，图元按缩放选择的细节与直接绘制一致
+    const RenderQuality::FullQualityScope fullQuality;
+    QPicture picture;
+    QPainter painter(&picture);
+    painter.setWorldTransform(item->sceneTransform() * QTransform::fromScale(scale, scale));
+    QStyleOptionGraphicsItem option;
+    option.exposedRect = item->boundingRect();
+    if (!exposedSceneRect.isNull()) {
+        option.exposedRect &= item->mapFromScene(exposedSceneRect).boundingRect();
+    }
+    option.rect = option.exposedRect.toAlignedRect();
+    item->paint(&painter, &option, nullptr);
+    painter.end();
+
+    Entry entry;
+    entry.picture = QByteArray(picture.data(), int(picture.size()));
+    entry.opacity = item->effectiveOpacity();
+    entry.sceneBounds = item->sceneBoundingRect();
+    return entry;
+}
+
+const TileRenderCache::Entry &TileRenderCache::snapshotFor(QGraphicsItem *item, const Frame &frame)
+{
+    // 快照随档位缩放录制，换档位后旧快照全部作废
+    if (frame.level.scaleKey != snapshotScaleKey) {
+        snapshots.clear();
+        snapshotScaleKey = frame.level.scaleKey;
+    }
+    auto it = snapshots.find(item);
+    if (it != snapshots.end()) {
+        return *it;
+    }
+    return *snapshots.insert(item, record(item, frame.scale, QRectF()));
+}
+
+void TileRenderCache::sceneChanged(const QList<QRectF> &region)
+{
+    if (region.isEmpty()) {
+        return;
+    }
+    // 变化区域较多时合并为一个矩形，避免逐个比较
+    QList<QRectF> rects = region;
+    if (rects.size() > 16) {
+        QRectF united;
+        for (const QRectF &rect : region) {
+            united = united.united(rect);
+        }
+        rects = {united};
+    }
+    auto touched = [&rects](const QRectF &bounds) {
+        for (const QRectF &rect : std::as_const(rects)) {
+            // 包含边界比较，零宽/零高的变化区域也要生效
+            if (rect.left() <= bounds.right() && rect.right() >= bounds.left()
+                && rect.top() <= bounds.bottom() && rect.bottom() >= bounds.top()) {
+                return true;
+            }
+        }
+        return false;
+    };
+
+    // 区域内的快照全部作废，包括已删除图元留下的旧快照
+    for (auto it = snapshots.begin(); it != snapshots.end();) {
+        it = touched(it->sceneBounds) ? snapshots.erase(it) : std::next(it);
+    }
+    for (auto it = tiles.begin(); it != tiles.end();) {
+        if (touched(it->sceneRect)) {
+            tileBytes -= it->bytes;
+            it = tiles.erase(it);
+        } else {
+            ++it;
+        }
+    }
+    for (auto it = jobs.begin(); it != jobs.end();) {
+        it = touched(it->sceneRect) ? jobs.erase(it) : std::next(it);
+    }
+}
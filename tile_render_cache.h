@@ -0,0 +1,133 @@
+#ifndef TILE_RENDER_CACHE_H
+#define TILE_RENDER_CACHE_H
+
+#include <QObject>
+#include <QGraphicsView>
+#include <QGraphicsItem>
+#include <QHash>
+#include <QImage>
+#include <QByteArray>
+#include <QTransform>
+#include <QRegion>
+#include <QTimer>
+#include <QVector>
+#include <QPoint>
+
+// 视口瓦片缓存：场景内容按缩放档位栅格化为固定大小的瓦片，由线程池在后台渲染。
+// 每个图元先在 GUI 线程按当前档位的缩放录制成不可变的绘制指令快照（QPicture 数据），工作线程只回放快照；
+// 按缩放调整细节的图元（折线简化、裁剪虚线）因此与直接绘制一致。跨越多块瓦片的大图元按瓦片分别录制。
+// 自带按缩放缓存的图元（栅格底图、SVG、烘焙图层、图片填充矩形）不进快照，每帧按叠放次序直接绘制：
+// 瓦片按这些图元分成若干层，层与层之间插入它们的实时绘制。
+// 场景变化时按区域作废瓦片和快照，尚未就绪的瓦片当帧直接绘制场景，并按平移方向预取。
+class TileRenderCache : public QObject
+{
+    Q_OBJECT
+public:
+    explicit TileRenderCache(QGraphicsView *view);
+
+    void setEnabled(bool enabled);
+    bool isEnabled() const { return enabled; }
+    // 只支持平移和缩放的视图变换
+    bool canRender() const;
+
+    // painter 处于视口坐标：绘制已就绪的瓦片，缺失部分直接绘制场景并安排后台渲染
+    void paint(QPainter *painter, const QRegion &exposedRegion);
+    void notePan(int dx, int dy); // 视图滚动量，用于判断预取方向
+    void clear();
+
+    static constexpr int TileSize = 256;        // 瓦片边长（逻辑像素）
+    static constexpr int PrefetchTiles = 2;     // 平移方向上额外预取的瓦片行/列数
+    static constexpr qint64 MemoryBudget = 128 * 1024 * 1024; // 瓦片缓存上限（字节）
+    static constexpr int LevelSettleMs = 150;   // 缩放停止多久后才开始渲染新档位
+    static constexpr int LargeItemTiles = 2;    // 档位下宽或高超过该瓦片数的图元按瓦片录制，不缓存
+
+    // 单个图元的不可变快照
+    struct Entry {
+        QByteArray picture;     // 档位像素坐标（场景坐标 * 缩放）下录制的绘制指令
+        qreal opacity = 1.0;
+        QRectF sceneBounds;
+    };
+
+    // 自带按缩放缓存、需要每帧直接绘制的图元
+    static bool paintsLive(const QGraphicsItem *item);
+
+private:
+    // 档位：缩放比例、视口平移的小数部分和设备像素比都相同的瓦片才能直接拼接
+    struct Level {
+        qint64 scaleKey = 0;
+        int fractionX = 0;
+        int fractionY = 0;
+        int dprKey = 0;
+        bool operator==(const Level &other) const {
+            return scaleKey == other.scaleKey && fractionX == other.fractionX
+                   && fractionY == other.fractionY && dprKey == other.dprKey;
+        }
+        bool operator!=(const Level &other) const { return !(*this == other); }
+    };
+    struct TileKey {
+        Level level;
+        int x = 0;
+        int y = 0;
+        bool operator==(const TileKey &other) const { return level == other.level && x == other.x && y == other.y; }
+    };
+    friend size_t qHash(const TileKey &key, size_t seed) noexcept
+    {
+        return qHashMulti(seed, key.level.scaleKey, key.level.fractionX, key.level.fractionY,
+                          key.level.dprKey, key.x, key.y);
+    }
+    struct Tile {
+        QVector<QImage> layers; // 被直接绘制的图元分隔开的各层，空层为空图片
+        QRectF sceneRect;
+        quint64 lastUsed = 0;
+        qint64 bytes = 0;
+    };
+    struct Job {
+        quint64 ticket = 0;
+        QRectF sceneRect;
+    };
+    // 当前视图下的档位参数
+    struct Frame {
+        Level level;
+        qreal scale = 1.0;
+        QPointF fraction; // 视口平移的小数部分（已量化）
+        QPoint offset;    // 视口平移的整数部分
+        qreal dpr = 1.0;
+    };
+
+    Frame currentFrame() const;
+    QRect tileViewportRect(const Frame &frame, int x, int y) const;
+    QRectF tileSceneRect(const Frame &frame, int x, int y) const;
+    QList<QGraphicsItem*> tileItems(const Frame &frame, const QRectF &sceneRect) const; // 按绘制顺序
+    Entry record(QGraphicsItem *item, qreal scale, const QRectF &exposedSceneRect) const;
+    const Entry &snapshotFor(QGraphicsItem *item, const Frame &frame);
+    void paintLayers(QPainter *painter, const Frame &frame, const Tile &tile, const QRect &rect);
+    void drawLive(QPainter *painter, QGraphicsItem *item, const QRectF &exposedSceneRect);
+    void schedule(const Frame &frame, const QVector<QPoint> &tiles);
+    void dispatch(const Frame &frame, const QPoint &tile);
+    void tileRendered(const TileKey &key, quint64 ticket, const QVector<QImage> &layers);
+    void evictToBudget();
+    void sceneChanged(const QList<QRectF> &region);
+
+    QGraphicsView *view;
+    bool enabled = false;
+    QMetaObject::Connection sceneConnection;
+
+    QHash<QGraphicsItem*, Entry> snapshots; // 只保存 snapshotScaleKey 档位的快照
+    qint64 snapshotScaleKey = 0;
+    QHash<TileKey, Tile> tiles;
+    QHash<TileKey, Job> jobs; // 渲染中的瓦片
+    qint64 tileBytes = 0;
+    quint64 frameCounter = 0;
+    quint64 nextTicket = 0;
+
+    // 排队等待渲染的瓦片（每次绘制按当前视口重建）
+    Frame pendingFrame;
+    QVector<QPoint> pendingTiles;
+
+    Level lastLevel;
+    bool hasLastLevel = false;
+    QTimer settleTimer;
+    QPoint panDirection; // 新内容进入视口的方向（瓦片坐标的符号）
+};
+
+#endif // TILE_RENDER_CACHE_H